@@ -193,6 +193,18 @@ t_aggspec::agg_str() const {
         case AGGTYPE_PCT_SUM_GRAND_TOTAL: {
             return "pct_sum_grand_total";
         }
+        case AGGTYPE_APPROX_DISTINCT_COUNT: {
+            return "approx_distinct_count";
+        }
+        case AGGTYPE_APPROX_MEDIAN: {
+            return "approx_median";
+        }
+        case AGGTYPE_APPROX_P95: {
+            return "approx_p95";
+        }
+        case AGGTYPE_APPROX_P99: {
+            return "approx_p99";
+        }
         default: {
             PSP_COMPLAIN_AND_ABORT("Unknown agg type");
             return "unknown";
@@ -341,9 +353,15 @@ t_aggspec::get_output_specs(const t_schema& schema) const {
         case AGGTYPE_AND: {
             return mk_col_name_type_vec(name(), DTYPE_BOOL);
         }
-        case AGGTYPE_DISTINCT_COUNT: {
+        case AGGTYPE_DISTINCT_COUNT:
+        case AGGTYPE_APPROX_DISTINCT_COUNT: {
             return mk_col_name_type_vec(name(), DTYPE_UINT32);
         }
+        case AGGTYPE_APPROX_MEDIAN:
+        case AGGTYPE_APPROX_P95:
+        case AGGTYPE_APPROX_P99: {
+            return mk_col_name_type_vec(name(), DTYPE_FLOAT64);
+        }
         default: { PSP_COMPLAIN_AND_ABORT("Unknown agg type"); }
     }
 
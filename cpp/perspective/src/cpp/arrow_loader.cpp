@@ -8,6 +8,9 @@
  */
 
 #include <perspective/arrow_loader.h>
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/parallel_for.h>
+#endif
 
 
 using namespace perspective;
@@ -156,14 +159,50 @@ namespace arrow {
         }
     }
 
-    template <typename T, typename V>
+    std::vector<t_vocab_string>
+    get_vocab_strings(std::shared_ptr<::arrow::StringArray> src) {
+        const int32_t* offsets = src->raw_value_offsets();
+        const uint8_t* values = src->value_data()->data();
+        std::int64_t len = src->length();
+        std::vector<t_vocab_string> strings(len);
+
+        auto hash_strings = [&strings, offsets, values](std::int64_t bidx, std::int64_t eidx) {
+            for (std::int64_t i = bidx; i < eidx; ++i) {
+                std::int32_t sidx = offsets[i];
+                t_uindex es = offsets[i + 1] - sidx;
+                const char* elem = reinterpret_cast<const char*>(values) + sidx;
+                strings[i] = {elem, es, t_vocab::hash_string(elem, es)};
+            }
+        };
+
+#ifdef PSP_PARALLEL_FOR
+        std::int64_t chunk_size = PSP_VOCAB_BULK_CHUNK_SIZE;
+        std::int64_t nchunks = (len + chunk_size - 1) / chunk_size;
+        tbb::parallel_for(0, int(nchunks), 1, [&hash_strings, chunk_size, len](int chunk) {
+            std::int64_t bidx = chunk * chunk_size;
+            hash_strings(bidx, std::min(bidx + chunk_size, len));
+        });
+#else
+        hash_strings(0, len);
+#endif
+
+        return strings;
+    }
+
+    template <typename T>
     void
-    iter_col_copy(std::shared_ptr<t_column> dest, std::shared_ptr<::arrow::Array> src,
-        const int64_t offset, const int64_t len) {
-        std::shared_ptr<T> scol = std::static_pointer_cast<T>(src);
-        const typename T::value_type* vals = scol->raw_values();
-        for (uint32_t i = 0; i < len; i++) {
-            dest->set_nth<V>(offset + i, static_cast<V>(vals[i]));
+    gather_dictionary_indices(std::shared_ptr<t_column> dest, std::shared_ptr<::arrow::Array> src,
+        const std::vector<t_uindex>& remap, const int64_t offset, const int64_t len) {
+        const typename T::value_type* indices = std::static_pointer_cast<T>(src)->raw_values();
+        t_uindex* ids = dest->get_nth<t_uindex>(offset);
+        const t_uindex* table = remap.data();
+        const std::uint64_t dsize = remap.size();
+
+        // Null slots may hold any index, so clamp rather than branch on the
+        // validity bitmap, which `fill_column` applies afterwards.
+        for (int64_t i = 0; i < len; ++i) {
+            std::uint64_t idx = static_cast<std::uint64_t>(indices[i]);
+            ids[i] = table[idx < dsize ? idx : 0];
         }
     }
 
@@ -175,32 +214,35 @@ namespace arrow {
                 auto scol = std::static_pointer_cast<::arrow::DictionaryArray>(src);
                 std::shared_ptr<::arrow::StringArray> dict
                     = std::static_pointer_cast<::arrow::StringArray>(scol->dictionary());
-                const int32_t* offsets = dict->raw_value_offsets();
-                const uint8_t* values = dict->value_data()->data();
-                const std::uint64_t dsize = dict->length();
-
-                t_vocab* vocab = dest->_get_vocab();
-                std::string elem;
-
-                for (std::uint64_t i = 0; i < dsize; ++i) {
-                    std::int32_t bidx = offsets[i];
-                    std::size_t es = offsets[i + 1] - bidx;
-                    elem.assign(reinterpret_cast<const char*>(values) + bidx, es);
-                    vocab->get_interned(elem);
+
+                // Intern the dictionary once, remembering the vocab id of each
+                // dictionary index - the column's vocab may already hold other
+                // strings, and every chunk may have its own dictionary.
+                std::vector<t_uindex> remap(dict->length());
+                dest->_get_vocab()->get_interned_bulk(get_vocab_strings(dict), remap.data());
+
+                if (remap.empty()) {
+                    // An empty dictionary means every row is null
+                    remap.push_back(dest->get_interned(""));
                 }
+
                 auto indices = scol->indices();
                 switch (indices->type()->id()) {
                     case ::arrow::Int8Type::type_id: {
-                        iter_col_copy<::arrow::Int8Array, t_uindex>(dest, indices, offset, len);
+                        gather_dictionary_indices<::arrow::Int8Array>(
+                            dest, indices, remap, offset, len);
                     } break;
                     case ::arrow::Int16Type::type_id: {
-                        iter_col_copy<::arrow::Int16Array, t_uindex>(dest, indices, offset, len);
+                        gather_dictionary_indices<::arrow::Int16Array>(
+                            dest, indices, remap, offset, len);
                     } break;
                     case ::arrow::Int32Type::type_id: {
-                        iter_col_copy<::arrow::Int32Array, t_uindex>(dest, indices, offset, len);
+                        gather_dictionary_indices<::arrow::Int32Array>(
+                            dest, indices, remap, offset, len);
                     } break;
                     case ::arrow::Int64Type::type_id: {
-                         iter_col_copy<::arrow::Int64Array, t_uindex>(dest, indices, offset, len);
+                        gather_dictionary_indices<::arrow::Int64Array>(
+                            dest, indices, remap, offset, len);
                     } break;
                     default:
                         std::stringstream ss;
@@ -213,17 +255,11 @@ namespace arrow {
             case ::arrow::StringType::type_id: {
                 std::shared_ptr<::arrow::StringArray> scol
                     = std::static_pointer_cast<::arrow::StringArray>(src);
-                const int32_t* offsets = scol->raw_value_offsets();
-                const uint8_t* values = scol->value_data()->data();
-
-                std::string elem;
 
-                for (std::uint32_t i = 0; i < len; ++i) {
-                    std::int32_t bidx = offsets[i];
-                    std::size_t es = offsets[i + 1] - bidx;
-                    elem.assign(reinterpret_cast<const char*>(values) + bidx, es);
-                    dest->set_nth(offset + i, elem);
-                }
+                // Intern the strings in place as one batch, which on native
+                // builds dictionary encodes them chunk by chunk before they
+                // reach the vocab.
+                dest->set_strings(offset, get_vocab_strings(scol));
             } break;
             case ::arrow::Int8Type::type_id: {
                 auto scol = std::static_pointer_cast<::arrow::Int8Array>(src);
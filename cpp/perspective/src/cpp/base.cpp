@@ -606,6 +606,14 @@ str_to_aggtype(const std::string& str) {
         return t_aggtype::AGGTYPE_PCT_SUM_PARENT;
     } else if (str == "pct sum grand total" || str == "pct_sum_grand_total") {
         return t_aggtype::AGGTYPE_PCT_SUM_GRAND_TOTAL;
+    } else if (str == "approx distinct count" || str == "approx_distinct_count") {
+        return t_aggtype::AGGTYPE_APPROX_DISTINCT_COUNT;
+    } else if (str == "approx median" || str == "approx_median") {
+        return t_aggtype::AGGTYPE_APPROX_MEDIAN;
+    } else if (str == "approx p95" || str == "approx_p95") {
+        return t_aggtype::AGGTYPE_APPROX_P95;
+    } else if (str == "approx p99" || str == "approx_p99") {
+        return t_aggtype::AGGTYPE_APPROX_P99;
     } else if (str.find("udf_combiner_") != std::string::npos) {
         return t_aggtype::AGGTYPE_UDF_COMBINER;
     } else if (str.find("udf_reducer_") != std::string::npos) {
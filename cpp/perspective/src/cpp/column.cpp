@@ -571,6 +571,22 @@ t_column::set_nth<std::string>(t_uindex idx, std::string elem, t_status status)
     set_nth(idx, elem.c_str(), status);
 }
 
+void
+t_column::set_strings(t_uindex offset, const std::vector<t_vocab_string>& strings) {
+    COLUMN_CHECK_STRCOL();
+    if (strings.empty())
+        return;
+
+    COLUMN_CHECK_ACCESS(offset + strings.size() - 1);
+    m_vocab->get_interned_bulk(strings, m_data->get_nth<t_uindex>(offset));
+
+    if (is_status_enabled()) {
+        for (t_uindex idx = 0, loop_end = strings.size(); idx < loop_end; ++idx) {
+            m_status->set_nth<t_status>(offset + idx, STATUS_VALID);
+        }
+    }
+}
+
 void
 t_column::set_valid(t_uindex idx, bool valid) {
     set_status(idx, valid ? STATUS_VALID : STATUS_INVALID);
@@ -763,6 +779,20 @@ t_column::copy_vocabulary(const t_column* other) {
     COLUMN_CHECK_VALUES();
 }
 
+void
+t_column::clear_vocabulary() {
+    if (!is_vlen_dtype(m_dtype))
+        return;
+
+    if (m_vocab.use_count() > 1) {
+        m_vocab.reset(new t_vocab);
+        m_vocab->init(false);
+        return;
+    }
+
+    m_vocab->clear();
+}
+
 void
 t_column::pprint_vocabulary() const {
     if (!is_vlen_dtype(m_dtype))
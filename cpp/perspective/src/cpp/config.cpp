@@ -197,6 +197,10 @@ t_config::setup(const std::vector<std::string>& detail_columns,
             case AGGTYPE_MUL:
             case AGGTYPE_DISTINCT_COUNT:
             case AGGTYPE_DISTINCT_LEAF:
+            case AGGTYPE_APPROX_DISTINCT_COUNT:
+            case AGGTYPE_APPROX_MEDIAN:
+            case AGGTYPE_APPROX_P95:
+            case AGGTYPE_APPROX_P99:
                 m_has_pkey_agg = true;
                 break;
             default:
@@ -245,6 +249,35 @@ t_config::repr() const {
     return ss.str();
 }
 
+std::string
+t_config::get_filter_signature() const {
+    // Every field is length-prefixed so that no choice of column names or
+    // filter values can make two different configs collide.
+    std::stringstream ss;
+    auto write = [&ss](const std::string& field) { ss << field.size() << ":" << field; };
+
+    ss << "f" << m_fterms.size();
+    if (!m_fterms.empty()) {
+        // Not every constructor sets the combiner, and it is unused without
+        // filters.
+        ss << "/" << m_combiner;
+    }
+    for (const auto& fterm : m_fterms) {
+        write(fterm.get_signature());
+    }
+
+    ss << "c" << m_computed_columns.size();
+    for (const auto& computed : m_computed_columns) {
+        write(std::get<0>(computed));
+        ss << "/" << std::get<1>(computed) << "/" << std::get<2>(computed).size();
+        for (const auto& input : std::get<2>(computed)) {
+            write(input);
+        }
+    }
+
+    return ss.str();
+}
+
 t_uindex
 t_config::get_num_aggregates() const {
     return m_aggregates.size();
@@ -150,8 +150,8 @@ t_ctx_grouped_pkey::get_data(
 
         if (m_has_label && ridx > 0) {
             // Get pkey
-            auto iters = m_tree->get_pkeys_for_leaf(nidx);
-            tree_value.set(m_gstate->get_value(iters.first->m_pkey, grouping_label_col));
+            const auto& pkeys = m_tree->get_pkeys_for_leaf(nidx);
+            tree_value.set(m_gstate->get_value(pkeys.front(), grouping_label_col));
         }
 
         tmpvalues[(ridx - ext.m_srow) * ncols] = tree_value;
@@ -317,10 +317,8 @@ t_ctx_grouped_pkey::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>&
             continue;
 
         if (seen.find(ptidx) == seen.end()) {
-            auto iters = m_tree->get_pkeys_for_leaf(ptidx);
-            for (auto iter = iters.first; iter != iters.second; ++iter) {
-                rval.push_back(iter->m_pkey);
-            }
+            const auto& pkeys = m_tree->get_pkeys_for_leaf(ptidx);
+            rval.insert(rval.end(), pkeys.begin(), pkeys.end());
             seen.insert(ptidx);
         }
 
@@ -330,10 +328,8 @@ t_ctx_grouped_pkey::get_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>&
             if (seen.find(d) != seen.end())
                 continue;
 
-            auto iters = m_tree->get_pkeys_for_leaf(d);
-            for (auto iter = iters.first; iter != iters.second; ++iter) {
-                rval.push_back(iter->m_pkey);
-            }
+            const auto& pkeys = m_tree->get_pkeys_for_leaf(d);
+            rval.insert(rval.end(), pkeys.begin(), pkeys.end());
             seen.insert(d);
         }
     }
@@ -429,10 +425,10 @@ t_ctx_grouped_pkey::get_cell_delta(t_index bidx, t_index eidx) const {
     const auto& deltas = m_tree->get_deltas();
     for (t_index idx = bidx; idx < eidx; ++idx) {
         t_index ptidx = m_traversal->get_tree_index(idx);
-        auto iterators = deltas->get<by_tc_nidx_aggidx>().equal_range(ptidx);
-        for (auto iter = iterators.first; iter != iterators.second; ++iter) {
-            rval.push_back(
-                t_cellupd(idx, iter->m_aggidx + 1, iter->m_old_value, iter->m_new_value));
+        std::pair<t_uindex, t_uindex> range = deltas->equal_range(ptidx);
+        for (t_uindex didx = range.first; didx < range.second; ++didx) {
+            rval.push_back(t_cellupd(idx, deltas->colidx(didx) + 1, deltas->old_value(didx),
+                deltas->new_value(didx)));
         }
     }
     return rval;
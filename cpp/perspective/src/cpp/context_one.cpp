@@ -13,6 +13,7 @@
 #include <perspective/context_one.h>
 #include <perspective/extract_aggregate.h>
 #include <perspective/filter.h>
+#include <perspective/filter_utils.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/tree_context_common.h>
 #include <perspective/logtime.h>
@@ -77,6 +78,10 @@ t_ctx1::open(t_index idx) {
     if (idx >= t_index(m_traversal->size()))
         return 0;
 
+    if (m_gstate) {
+        m_tree->clean_child_aggregates(m_traversal->get_tree_index(idx), *m_gstate);
+    }
+
     t_index retval = m_traversal->expand_node(m_sortby, idx);
     m_rows_changed = (retval > 0);
     return retval;
@@ -216,12 +221,59 @@ t_ctx1::notify(const t_data_table& flattened, const t_data_table& delta,
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     psp_log_time(repr() + " notify.enter");
-    notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
-        m_config.get_sortby_pairs(), m_sortby, flattened, delta, prev, current, transitions,
-        existed, m_config, *m_gstate);
+    t_mask msk_prev, msk_curr;
+    const t_mask* prev_mask = nullptr;
+    const t_mask* curr_mask = nullptr;
+
+    if (m_config.has_filters()) {
+        msk_prev = filter_table_for_config(prev, m_config, m_filter_cache.get());
+        msk_curr = filter_table_for_config(current, m_config, m_filter_cache.get());
+        prev_mask = &msk_prev;
+        curr_mask = &msk_curr;
+    }
+
+    m_tree->set_lazy_aggregates(get_agg_visibility());
+    auto update = update_sparse_tree(m_tree, m_config.get_aggregates(),
+        m_config.get_sortby_pairs(), flattened, delta, prev, current, transitions, existed,
+        m_config, *m_gstate, prev_mask, curr_mask);
+    {
+        t_stats_timer timer(m_stats, STATS_STAGE_TRAVERSAL, flattened.size());
+        update_sparse_traversal(m_tree, m_traversal, true, update, m_sortby);
+    }
+    m_tree->set_lazy_aggregates(nullptr);
     psp_log_time(repr() + " notify.exit");
 }
 
+t_sparse_tree_update
+t_ctx1::notify_tree(const t_data_table& flattened, const t_data_table& delta,
+    const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
+    const t_data_table& existed) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    t_mask msk_prev, msk_curr;
+    const t_mask* prev_mask = nullptr;
+    const t_mask* curr_mask = nullptr;
+
+    if (m_config.has_filters()) {
+        msk_prev = filter_table_for_config(prev, m_config, m_filter_cache.get());
+        msk_curr = filter_table_for_config(current, m_config, m_filter_cache.get());
+        prev_mask = &msk_prev;
+        curr_mask = &msk_curr;
+    }
+
+    return update_sparse_tree(m_tree, m_config.get_aggregates(), m_config.get_sortby_pairs(),
+        flattened, delta, prev, current, transitions, existed, m_config, *m_gstate, prev_mask,
+        curr_mask);
+}
+
+void
+t_ctx1::notify_traversal(const t_sparse_tree_update& update) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    t_stats_timer timer(m_stats, STATS_STAGE_TRAVERSAL);
+    update_sparse_traversal(m_tree, m_traversal, true, update, m_sortby);
+}
+
 void
 t_ctx1::step_begin() {
     PSP_TRACE_SENTINEL();
@@ -234,7 +286,9 @@ t_ctx1::step_end() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_minmax = m_tree->get_min_max();
-    sort_by(m_sortby);
+    if (!m_sortby.empty()) {
+        m_traversal->update_sort_by(m_config, m_sortby, *(m_tree.get()));
+    }
     if (m_depth_set) {
         set_depth(m_depth);
     }
@@ -281,6 +335,7 @@ t_ctx1::reset_sortby() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = std::vector<t_sortspec>();
+    m_traversal->invalidate_sort();
 }
 
 void
@@ -289,6 +344,7 @@ t_ctx1::sort_by(const std::vector<t_sortspec>& sortby) {
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = sortby;
     if (m_sortby.empty()) {
+        m_traversal->invalidate_sort();
         return;
     }
     m_traversal->sort_by(m_config, sortby, *(m_tree.get()));
@@ -301,6 +357,9 @@ t_ctx1::set_depth(t_depth depth) {
     if (m_config.get_num_rpivots() == 0)
         return;
     depth = std::min<t_depth>(m_config.get_num_rpivots() - 1, depth);
+    if (m_gstate) {
+        m_tree->clean_aggregates_to_depth(depth + 1, *m_gstate);
+    }
     t_index retval = 0;
     retval = m_traversal->set_depth(m_sortby, depth);
     m_rows_changed = (retval > 0);
@@ -392,6 +451,36 @@ void
 t_ctx1::set_minmax_enabled(bool enabled_state) {
     m_features[CTX_FEAT_MINMAX] = enabled_state;
     m_tree->set_minmax_enabled(enabled_state);
+    if (enabled_state && m_gstate) {
+        m_tree->clean_aggregates_to_depth(m_config.get_num_rpivots(), *m_gstate);
+    }
+}
+
+void
+t_ctx1::set_lazy_aggregates_enabled(bool enabled_state) {
+    m_features[CTX_FEAT_LAZY_AGGREGATES] = enabled_state;
+    if (!enabled_state && m_gstate) {
+        m_tree->clean_aggregates_to_depth(m_config.get_num_rpivots(), *m_gstate);
+    }
+}
+
+std::function<bool(t_uindex)>
+t_ctx1::get_agg_visibility() const {
+    if (!m_features[CTX_FEAT_LAZY_AGGREGATES]) {
+        return nullptr;
+    }
+
+    return [this](t_uindex nidx) {
+        if (nidx == 0) {
+            return true;
+        }
+
+        if (m_depth_set && m_tree->get_depth(nidx) <= m_depth + 1) {
+            return true;
+        }
+
+        return m_traversal->is_tree_node_expanded(m_tree->get_parent_idx(nidx));
+    };
 }
 
 std::vector<t_minmax>
@@ -442,15 +531,20 @@ std::vector<t_uindex>
 t_ctx1::get_rows_changed() {
     std::vector<t_uindex> rows;
     const auto& deltas = m_tree->get_deltas();
-    t_uindex eidx = t_uindex(m_traversal->size());
+    t_index prev_nidx = INVALID_INDEX;
 
-    for (t_uindex idx = 0; idx < eidx; ++idx) {
-        t_index ptidx = m_traversal->get_tree_index(idx);
-        // Retrieve delta from storage and check if the row has been changed
-        auto iterators = deltas->get<by_tc_nidx_aggidx>().equal_range(ptidx);
-        bool unique_ridx = std::find(rows.begin(), rows.end(), idx) == rows.end();
-        if ((iterators.first != iterators.second) && unique_ridx)
-            rows.push_back(idx);
+    // Deltas are ordered by node, so each changed node is looked up once.
+    for (t_uindex didx = 0, loop_end = deltas->size(); didx < loop_end; ++didx) {
+        t_index nidx = deltas->key(didx);
+        if (nidx == prev_nidx) {
+            continue;
+        }
+
+        prev_nidx = nidx;
+        t_index ridx = m_traversal->tree_index_lookup(nidx, 0);
+        if (ridx != INVALID_INDEX) {
+            rows.push_back(ridx);
+        }
     }
 
     std::sort(rows.begin(), rows.end());
@@ -464,14 +558,25 @@ t_ctx1::get_cell_delta(t_index bidx, t_index eidx) const {
     eidx = std::min(eidx, t_index(m_traversal->size()));
     std::vector<t_cellupd> rval;
     const auto& deltas = m_tree->get_deltas();
-    for (t_index idx = bidx; idx < eidx; ++idx) {
-        t_index ptidx = m_traversal->get_tree_index(idx);
-        auto iterators = deltas->get<by_tc_nidx_aggidx>().equal_range(ptidx);
-        for (auto iter = iterators.first; iter != iterators.second; ++iter) {
-            rval.push_back(
-                t_cellupd(idx, iter->m_aggidx + 1, iter->m_old_value, iter->m_new_value));
+    t_index prev_nidx = INVALID_INDEX;
+    t_index ridx = INVALID_INDEX;
+
+    for (t_uindex didx = 0, loop_end = deltas->size(); didx < loop_end; ++didx) {
+        t_index nidx = deltas->key(didx);
+        if (nidx != prev_nidx) {
+            prev_nidx = nidx;
+            ridx = m_traversal->tree_index_lookup(nidx, bidx);
+        }
+
+        if (ridx != INVALID_INDEX && ridx < eidx) {
+            rval.push_back(t_cellupd(ridx, deltas->colidx(didx) + 1, deltas->old_value(didx),
+                deltas->new_value(didx)));
         }
     }
+
+    // In row order, and by column within a row as the deltas are.
+    std::stable_sort(rval.begin(), rval.end(),
+        [](const t_cellupd& a, const t_cellupd& b) { return a.row < b.row; });
     return rval;
 }
 
@@ -484,6 +589,88 @@ t_ctx1::reset() {
     m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
 }
 
+std::string
+t_ctx1::get_tree_signature() const {
+    // Every field is length-prefixed so that no choice of column names or
+    // filter values can make two different configs collide.
+    std::stringstream ss;
+    auto write = [&ss](const std::string& field) { ss << field.size() << ":" << field; };
+
+    ss << "p" << m_config.get_row_pivots().size();
+    for (const auto& pivot : m_config.get_row_pivots()) {
+        write(pivot.colname());
+        ss << "/" << pivot.mode();
+    }
+
+    ss << "a" << m_config.get_aggregates().size();
+    for (const auto& aggspec : m_config.get_aggregates()) {
+        write(aggspec.name());
+        write(aggspec.disp_name());
+        ss << "/" << aggspec.agg() << "/" << aggspec.get_sort_type();
+        switch (aggspec.agg()) {
+            case AGGTYPE_SCALED_DIV:
+            case AGGTYPE_SCALED_ADD:
+            case AGGTYPE_SCALED_MUL: {
+                // Only scaled aggregates initialize their weights.
+                ss << "/" << aggspec.get_agg_one_idx() << "/" << aggspec.get_agg_two_idx()
+                   << "/" << aggspec.get_agg_one_weight() << "/"
+                   << aggspec.get_agg_two_weight();
+            } break;
+            default: break;
+        }
+        for (const auto& dep : aggspec.get_dependencies()) {
+            write(dep.name());
+            ss << "/" << dep.type();
+            if (dep.type() == DEPTYPE_SCALAR) {
+                ss << "/" << dep.imm().m_type;
+                write(dep.imm().to_string(true));
+            }
+        }
+    }
+
+    ss << "s";
+    for (const auto& sortby : m_config.get_sortby_pairs()) {
+        write(sortby.first);
+        write(sortby.second);
+    }
+
+    ss << "f";
+    write(m_config.get_filter_signature());
+
+    ss << "t" << m_config.get_totals();
+    return ss.str();
+}
+
+std::shared_ptr<t_stree>
+t_ctx1::get_tree() const {
+    return m_tree;
+}
+
+void
+t_ctx1::set_tree(std::shared_ptr<t_stree> tree) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_tree = tree;
+    if (m_gstate) {
+        m_tree->clean_aggregates_to_depth(m_config.get_num_rpivots(), *m_gstate);
+    }
+    m_traversal = std::shared_ptr<t_traversal>(new t_traversal(m_tree));
+}
+
+std::vector<t_path>
+t_ctx1::get_expansion_state() const {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    return ctx_get_expansion_state(m_tree, m_traversal);
+}
+
+void
+t_ctx1::set_expansion_state(const std::vector<t_path>& paths) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    ctx_set_expansion_state(*this, HEADER_ROW, m_tree, m_traversal, paths);
+}
+
 void
 t_ctx1::reset_step_state() {
     m_rows_changed = false;
@@ -518,6 +705,9 @@ t_minmax
 t_ctx1::get_agg_min_max(t_uindex aggidx, t_depth depth) const {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    if (m_gstate) {
+        m_tree->clean_aggregates_to_depth(depth, *m_gstate);
+    }
     return m_tree->get_agg_min_max(aggidx, depth);
 }
 
@@ -525,8 +715,10 @@ void
 t_ctx1::notify(const t_data_table& flattened) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_tree->set_lazy_aggregates(get_agg_visibility());
     notify_sparse_tree(m_tree, m_traversal, true, m_config.get_aggregates(),
         m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_gstate);
+    m_tree->set_lazy_aggregates(nullptr);
 }
 
 void
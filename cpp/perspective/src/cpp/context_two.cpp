@@ -15,6 +15,10 @@
 #include <perspective/tree_context_common.h>
 #include <perspective/logtime.h>
 #include <perspective/traversal.h>
+#include <perspective/filter_utils.h>
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+#include <tbb/parallel_for.h>
+#endif
 
 namespace perspective {
 
@@ -350,6 +354,7 @@ t_ctx2::sort_by(const std::vector<t_sortspec>& sortby) {
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = sortby;
     if (m_sortby.empty()) {
+        m_rtraversal->invalidate_sort();
         return;
     }
     m_rtraversal->sort_by(m_config, sortby, *(rtree().get()), this);
@@ -360,6 +365,23 @@ t_ctx2::reset_sortby() {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     m_sortby = std::vector<t_sortspec>();
+    m_rtraversal->invalidate_sort();
+}
+
+void
+t_ctx2::update_row_sort() {
+    // Sort values read through a column path also depend on the column
+    // tree, so rows whose own aggregates did not change can still move.
+    auto num_aggs = static_cast<t_index>(m_config.get_num_aggregates());
+    bool totals_before = m_config.get_totals() == TOTALS_BEFORE;
+    for (const auto& sortspec : m_sortby) {
+        if (sortspec.m_agg_index >= 0 && !(totals_before && sortspec.m_agg_index < num_aggs)) {
+            m_rtraversal->invalidate_sort();
+            break;
+        }
+    }
+
+    m_rtraversal->update_sort_by(m_config, m_sortby, *(rtree().get()), this);
 }
 
 void
@@ -367,29 +389,66 @@ t_ctx2::notify(const t_data_table& flattened, const t_data_table& delta,
     const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
     const t_data_table& existed) {
     psp_log_time(repr() + " notify.enter");
-    for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end; ++tree_idx) {
+
+    // Every tree applies the same filter, so it is only evaluated once.
+    t_mask msk_prev, msk_curr;
+    const t_mask* prev_mask = nullptr;
+    const t_mask* curr_mask = nullptr;
+
+    if (m_config.has_filters()) {
+        msk_prev = filter_table_for_config(prev, m_config, m_filter_cache.get());
+        msk_curr = filter_table_for_config(current, m_config, m_filter_cache.get());
+        prev_mask = &msk_prev;
+        curr_mask = &msk_curr;
+    }
+
+    notify_trees([&](t_uindex tree_idx) {
         if (is_rtree_idx(tree_idx)) {
             notify_sparse_tree(rtree(), m_rtraversal, true, m_config.get_aggregates(),
                 m_config.get_sortby_pairs(), m_sortby, flattened, delta, prev, current,
-                transitions, existed, m_config, *m_gstate);
+                transitions, existed, m_config, *m_gstate, prev_mask, curr_mask);
         } else if (is_ctree_idx(tree_idx)) {
             notify_sparse_tree(ctree(), m_ctraversal, true, m_config.get_aggregates(),
                 m_config.get_sortby_pairs(), m_column_sortby, flattened, delta, prev, current,
-                transitions, existed, m_config, *m_gstate);
+                transitions, existed, m_config, *m_gstate, prev_mask, curr_mask);
         } else {
             notify_sparse_tree(m_trees[tree_idx], std::shared_ptr<t_traversal>(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
                 std::vector<t_sortspec>(), flattened, delta, prev, current, transitions,
-                existed, m_config, *m_gstate);
+                existed, m_config, *m_gstate, prev_mask, curr_mask);
         }
-    }
+    });
 
     if (!m_sortby.empty()) {
-        sort_by(m_sortby);
+        t_stats_timer timer(m_stats, STATS_STAGE_TRAVERSAL, flattened.size());
+        update_row_sort();
     }
     psp_log_time(repr() + " notify.exit");
 }
 
+void
+t_ctx2::notify_trees(const std::function<void(t_uindex)>& notify_tree) {
+    t_uindex num_trees = m_trees.size();
+
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+    // Each update only writes its own tree and traversal, and shares read
+    // access to the port tables - unless it would copy Python objects into
+    // its strand tables, whose refcounts need the GIL.
+    const auto& types = m_schema.m_types;
+    bool has_objects = std::find(types.begin(), types.end(), DTYPE_OBJECT) != types.end();
+
+    if (num_trees > 1 && !has_objects) {
+        tbb::parallel_for(
+            0, int(num_trees), 1, [&notify_tree](int tree_idx) { notify_tree(tree_idx); });
+        return;
+    }
+#endif
+
+    for (t_uindex tree_idx = 0; tree_idx < num_trees; ++tree_idx) {
+        notify_tree(tree_idx);
+    }
+}
+
 t_uindex
 t_ctx2::calc_translated_colidx(t_uindex n_aggs, t_uindex cidx) const {
     switch (m_config.get_totals()) {
@@ -709,27 +768,14 @@ t_ctx2::get_step_delta(t_index bidx, t_index eidx) {
     auto ext = sanitize_get_data_extents(
         ctx_nrows, ctx_ncols, start_row, end_row, start_col, end_col);
 
-    std::vector<std::pair<t_uindex, t_uindex>> cells;
-
-    for (t_index ridx = ext.m_srow; ridx < ext.m_erow; ++ridx) {
-        for (t_uindex cidx = 1; cidx < end_col; ++cidx) {
-            cells.push_back(std::pair<t_index, t_index>(ridx, cidx));
-        }
-    }
-
-    auto cells_info = resolve_cells(cells);
-
-    for (const auto& c : cells_info) {
-        if (c.m_idx < 0)
-            continue;
-
+    for (const auto& c : get_changed_cells(ext.m_srow, ext.m_erow)) {
         const auto& deltas = m_trees[c.m_treenum]->get_deltas();
 
-        auto iterators = deltas->get<by_tc_nidx_aggidx>().equal_range(c.m_idx);
+        std::pair<t_uindex, t_uindex> range = deltas->equal_range(c.m_idx);
 
-        for (auto iter = iterators.first; iter != iterators.second; ++iter) {
-            updvec.push_back(
-                t_cellupd(c.m_ridx, c.m_cidx, iter->m_old_value, iter->m_new_value));
+        for (t_uindex didx = range.first; didx < range.second; ++didx) {
+            updvec.push_back(t_cellupd(
+                c.m_ridx, c.m_cidx, deltas->old_value(didx), deltas->new_value(didx)));
         }
     }
 
@@ -753,33 +799,118 @@ t_ctx2::get_row_delta() {
 
 std::vector<t_uindex>
 t_ctx2::get_rows_changed() {
-    t_uindex nrows = get_row_count();
-    t_uindex ncols = get_num_view_columns();
     std::vector<t_uindex> rows;
-    std::vector<std::pair<t_uindex, t_uindex>> cells;
 
-    // get cells and imbue with additional information
-    for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
-        for (t_uindex cidx = 1; cidx < ncols; ++cidx) {
-            cells.push_back(std::pair<t_uindex, t_uindex>(ridx, cidx));
+    for (const auto& c : get_changed_cells(0, get_row_count())) {
+        if (rows.empty() || rows.back() != c.m_ridx) {
+            rows.push_back(c.m_ridx);
         }
     }
 
-    auto cells_info = resolve_cells(cells);
+    return rows;
+}
 
-    for (const auto& c : cells_info) {
-        if (c.m_idx < 0)
-            continue;
-        const auto& deltas = m_trees[c.m_treenum]->get_deltas();
-        auto iterators = deltas->get<by_tc_nidx_aggidx>().equal_range(c.m_idx);
-        auto ridx = c.m_ridx;
-        bool unique_ridx = std::find(rows.begin(), rows.end(), ridx) == rows.end();
-        if ((iterators.first != iterators.second) && unique_ridx)
-            rows.push_back(ridx);
+std::vector<t_cellinfo>
+t_ctx2::get_changed_cells(t_index bidx, t_index eidx) const {
+    std::vector<t_cellinfo> rval;
+    t_index n_aggs = m_config.get_num_aggregates();
+
+    if (n_aggs == 0) {
+        return rval;
     }
 
-    std::sort(rows.begin(), rows.end());
-    return rows;
+    // The first view column of each column traversal index that has any.
+    std::vector<t_index> c_tvindices = get_ctraversal_indices();
+    t_index c_offset = m_config.get_totals() == TOTALS_HIDDEN ? 1 : 0;
+    t_uindex ncols = get_num_view_columns();
+    tsl::hopscotch_map<t_index, t_uindex> c_first_cidx;
+
+    for (t_index tidx = c_offset, loop_end = c_tvindices.size(); tidx < loop_end; ++tidx) {
+        c_first_cidx[c_tvindices[tidx]] = (tidx - c_offset) * n_aggs + 1;
+    }
+
+    auto push_cells = [&](t_index ridx, t_index c_ptidx, t_depth treenum, t_index nidx) {
+        if (ridx == INVALID_INDEX || ridx < bidx || ridx >= eidx || c_ptidx == INVALID_INDEX) {
+            return;
+        }
+
+        auto iter = c_first_cidx.find(m_ctraversal->tree_index_lookup(c_ptidx, 0));
+        if (iter == c_first_cidx.end()) {
+            return;
+        }
+
+        for (t_index agg_idx = 0; agg_idx < n_aggs; ++agg_idx) {
+            t_uindex cidx = iter->second + agg_idx;
+            if (cidx < ncols) {
+                rval.push_back(t_cellinfo(nidx, treenum, agg_idx, ridx, cidx));
+            }
+        }
+    };
+
+    // The first row is always resolved in the column tree, and the total
+    // column in the row tree. Otherwise a node of tree `treenum` is the cell
+    // whose row is its ancestor at depth `treenum`, and whose column is the
+    // rest of its path.
+    t_depth last = m_trees.size() - 1;
+    std::vector<t_tscalar> path;
+
+    for (t_depth treenum = 0; treenum <= last; ++treenum) {
+        const auto& tree = m_trees[treenum];
+        const auto& deltas = tree->get_deltas();
+        t_index prev_nidx = INVALID_INDEX;
+
+        for (t_uindex didx = 0, loop_end = deltas->size(); didx < loop_end; ++didx) {
+            t_index nidx = deltas->key(didx);
+            if (nidx == prev_nidx) {
+                continue;
+            }
+
+            prev_nidx = nidx;
+
+            if (!tree->node_exists(nidx)) {
+                continue;
+            }
+
+            if (treenum == 0) {
+                push_cells(0, nidx, treenum, nidx);
+                continue;
+            }
+
+            t_depth depth = tree->get_depth(nidx);
+
+            if (depth <= treenum) {
+                if (treenum == last && nidx != 0) {
+                    push_cells(m_rtraversal->tree_index_lookup(nidx, 0), 0, treenum, nidx);
+                }
+                continue;
+            }
+
+            path.clear();
+            t_index r_ptidx = nidx;
+            for (; depth > treenum; --depth) {
+                path.push_back(tree->get_value(r_ptidx));
+                r_ptidx = tree->get_parent_idx(r_ptidx);
+            }
+
+            t_index c_ptidx = ctree()->resolve_path(0, path);
+
+            if (treenum != last) {
+                path.clear();
+                tree->get_path(r_ptidx, path);
+                r_ptidx = rtree()->resolve_path(0, path);
+            }
+
+            if (r_ptidx != INVALID_INDEX) {
+                push_cells(m_rtraversal->tree_index_lookup(r_ptidx, 0), c_ptidx, treenum, nidx);
+            }
+        }
+    }
+
+    std::sort(rval.begin(), rval.end(), [](const t_cellinfo& a, const t_cellinfo& b) {
+        return a.m_ridx < b.m_ridx || (a.m_ridx == b.m_ridx && a.m_cidx < b.m_cidx);
+    });
+
+    return rval;
 }
 
 std::vector<t_minmax>
@@ -879,21 +1010,30 @@ t_ctx2::has_deltas() const {
 
 void
 t_ctx2::notify(const t_data_table& flattened) {
-    for (t_uindex tree_idx = 0, loop_end = m_trees.size(); tree_idx < loop_end; ++tree_idx) {
+    t_mask msk;
+    const t_mask* mask = nullptr;
+
+    if (m_config.has_filters()) {
+        msk = filter_table_for_config(flattened, m_config);
+        mask = &msk;
+    }
+
+    notify_trees([&](t_uindex tree_idx) {
         if (is_rtree_idx(tree_idx)) {
             notify_sparse_tree(rtree(), m_rtraversal, true, m_config.get_aggregates(),
-                m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_gstate);
+                m_config.get_sortby_pairs(), m_sortby, flattened, m_config, *m_gstate, mask);
         } else if (is_ctree_idx(tree_idx)) {
             notify_sparse_tree(ctree(), m_ctraversal, true, m_config.get_aggregates(),
-                m_config.get_sortby_pairs(), m_column_sortby, flattened, m_config, *m_gstate);
+                m_config.get_sortby_pairs(), m_column_sortby, flattened, m_config, *m_gstate,
+                mask);
         } else {
             notify_sparse_tree(m_trees[tree_idx], std::shared_ptr<t_traversal>(0), false,
                 m_config.get_aggregates(), m_config.get_sortby_pairs(),
-                std::vector<t_sortspec>(), flattened, m_config, *m_gstate);
+                std::vector<t_sortspec>(), flattened, m_config, *m_gstate, mask);
         }
-    }
+    });
      if (!m_sortby.empty()) {
-        sort_by(m_sortby);
+        update_row_sort();
     }
 }
 
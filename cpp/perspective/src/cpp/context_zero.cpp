@@ -18,12 +18,55 @@
 
 namespace perspective {
 
+namespace {
+// Nulls may carry arbitrary data, so they are canonicalized before being
+// counted as a column's extreme.
+t_tscalar
+min_max_value(const t_tscalar& v) {
+    if (v.is_valid())
+        return v;
+    return v.m_status == STATUS_CLEAR ? mkclear(v.get_dtype()) : mknull(v.get_dtype());
+}
+
+void
+min_max_add(t_minmax& mm, const t_tscalar& value) {
+    t_tscalar v = min_max_value(value);
+    if (mm.m_min_count == 0 || v < mm.m_min) {
+        mm.m_min = v;
+        mm.m_min_count = 1;
+    } else if (v == mm.m_min) {
+        ++mm.m_min_count;
+    }
+
+    if (mm.m_max_count == 0 || v > mm.m_max) {
+        mm.m_max = v;
+        mm.m_max_count = 1;
+    } else if (v == mm.m_max) {
+        ++mm.m_max_count;
+    }
+}
+
+// Returns false if the last occurrence of the min or max was removed.
+bool
+min_max_remove(t_minmax& mm, const t_tscalar& value) {
+    t_tscalar v = min_max_value(value);
+    if (v == mm.m_min && --mm.m_min_count == 0)
+        return false;
+    if (v == mm.m_max && --mm.m_max_count == 0)
+        return false;
+    return true;
+}
+} // namespace
+
 t_ctx0::t_ctx0() {}
 
 t_ctx0::t_ctx0(const t_schema& schema, const t_config& config)
     : t_ctxbase<t_ctx0>(schema, config)
     , m_minmax(m_config.get_num_columns())
+    , m_minmax_stale(m_config.get_num_columns(), true)
+    , m_minmax_tracked(false)
     , m_has_delta(false)
+    , m_owns_traversal(true)
 
 {}
 
@@ -45,7 +88,8 @@ t_ctx0::step_begin() {
     m_delta_pkeys.clear();
     m_rows_changed = false;
     m_columns_changed = false;
-    m_traversal->step_begin();
+    if (m_owns_traversal)
+        m_traversal->step_begin();
 }
 
 void
@@ -54,37 +98,8 @@ t_ctx0::step_end() {
         return;
     }
 
-    m_traversal->step_end();
-#ifndef PSP_ENABLE_WASM
-    t_uindex ncols = m_config.get_num_columns();
-    std::vector<t_minmax> rval(ncols);
-
-    auto pkeys = m_traversal->get_pkeys();
-    auto stbl = m_gstate->get_table();
-
-#ifdef PSP_PARALLEL_FOR
-    tbb::parallel_for(0, int(ncols), 1,
-        [&rval, &stbl, pkeys, this](int colidx)
-#else
-    for (t_uindex colidx = 0; colidx < ncols; ++colidx)
-#endif
-        {
-            auto colname = m_config.col_at(colidx);
-
-            if (stbl->get_dtype(colname) != DTYPE_STR) {
-                auto v = m_gstate->reduce<std::function<std::pair<t_tscalar, t_tscalar>(
-                    const std::vector<t_tscalar>&)>>(pkeys, colname, get_vec_min_max);
-
-                rval[colidx].m_min = v.first;
-                rval[colidx].m_max = v.second;
-            }
-        }
-#ifdef PSP_PARALLEL_FOR
-    );
-#endif
-
-    m_minmax = rval;
-#endif
+    if (m_owns_traversal)
+        m_traversal->step_end();
 }
 
 t_index
@@ -179,11 +194,20 @@ void
 t_ctx0::sort_by(const std::vector<t_sortspec>& sortby) {
     if (sortby.empty())
         return;
+    // Copy a shared traversal before changing its order.
+    if (m_traversal.use_count() > 1) {
+        m_traversal = m_traversal->clone();
+        m_owns_traversal = true;
+    }
     m_traversal->sort_by(m_gstate, m_config, sortby);
 }
 
 void
 t_ctx0::reset_sortby() {
+    if (m_traversal.use_count() > 1) {
+        m_traversal = m_traversal->clone();
+        m_owns_traversal = true;
+    }
     m_traversal->sort_by(m_gstate, m_config, std::vector<t_sortspec>());
 }
 
@@ -274,42 +298,37 @@ t_ctx0::get_cell_delta(t_index bidx, t_index eidx) const {
         for (t_index idx = 0, loop_end = pkey_vec.size(); idx < loop_end; ++idx) {
             const t_tscalar& pkey = pkey_vec[idx];
             t_index row = bidx + idx;
-            std::pair<t_zcdeltas::index<by_zc_pkey_colidx>::type::iterator,
-                t_zcdeltas::index<by_zc_pkey_colidx>::type::iterator>
-                iters = m_deltas->get<by_zc_pkey_colidx>().equal_range(pkey);
-            for (t_zcdeltas::index<by_zc_pkey_colidx>::type::iterator iter = iters.first;
-                 iter != iters.second; ++iter) {
+            std::pair<t_uindex, t_uindex> range = m_deltas->equal_range(pkey);
+            for (t_uindex didx = range.first; didx < range.second; ++didx) {
                 t_cellupd cellupd;
                 cellupd.row = row;
-                cellupd.column = iter->m_colidx;
-                cellupd.old_value = iter->m_old_value;
-                cellupd.new_value = iter->m_new_value;
+                cellupd.column = m_deltas->colidx(didx);
+                cellupd.old_value = m_deltas->old_value(didx);
+                cellupd.new_value = m_deltas->new_value(didx);
                 rval.push_back(cellupd);
             }
         }
     } else {
-        for (t_zcdeltas::index<by_zc_pkey_colidx>::type::iterator iter
-             = m_deltas->get<by_zc_pkey_colidx>().begin();
-             iter != m_deltas->get<by_zc_pkey_colidx>().end(); ++iter) {
-            if (prev_pkey != iter->m_pkey) {
-                pkeys.insert(iter->m_pkey);
-                prev_pkey = iter->m_pkey;
+        t_uindex ndeltas = m_deltas->size();
+        for (t_uindex didx = 0; didx < ndeltas; ++didx) {
+            const t_tscalar& pkey = m_deltas->key(didx);
+            if (prev_pkey != pkey) {
+                pkeys.insert(pkey);
+                prev_pkey = pkey;
             }
         }
 
         tsl::hopscotch_map<t_tscalar, t_index> r_indices;
         m_traversal->get_row_indices(pkeys, r_indices);
 
-        for (t_zcdeltas::index<by_zc_pkey_colidx>::type::iterator iter
-             = m_deltas->get<by_zc_pkey_colidx>().begin();
-             iter != m_deltas->get<by_zc_pkey_colidx>().end(); ++iter) {
-            t_index row = r_indices[iter->m_pkey];
+        for (t_uindex didx = 0; didx < ndeltas; ++didx) {
+            t_index row = r_indices[m_deltas->key(didx)];
             if (bidx <= row && row <= eidx) {
                 t_cellupd cellupd;
                 cellupd.row = row;
-                cellupd.column = iter->m_colidx;
-                cellupd.old_value = iter->m_old_value;
-                cellupd.new_value = iter->m_new_value;
+                cellupd.column = m_deltas->colidx(didx);
+                cellupd.old_value = m_deltas->old_value(didx);
+                cellupd.new_value = m_deltas->new_value(didx);
                 rval.push_back(cellupd);
             }
         }
@@ -368,11 +387,44 @@ t_ctx0::get_sort_by() const {
     return m_traversal->get_sort_by();
 }
 
+std::string
+t_ctx0::get_traversal_signature() const {
+    std::stringstream ss;
+    auto sortby = m_traversal->get_sort_by();
+    ss << "s" << sortby.size();
+    for (const auto& sort : sortby) {
+        auto colname = t_ftrav::get_sortby_colname(m_config, sort);
+        ss << "/" << sort.m_sort_type << "/" << colname.size() << ":" << colname;
+    }
+    ss << m_config.get_filter_signature();
+    return ss.str();
+}
+
+std::shared_ptr<t_ftrav>
+t_ctx0::get_traversal() const {
+    return m_traversal;
+}
+
+void
+t_ctx0::set_traversal(std::shared_ptr<t_ftrav> traversal) {
+    m_traversal = traversal;
+    invalidate_min_max();
+    m_owns_traversal = false;
+    // Every row in the traversal is new to this context, as in `notify`.
+    m_has_delta = true;
+}
+
+void
+t_ctx0::set_traversal_owner(bool owner) {
+    m_owns_traversal = owner;
+}
+
 void
 t_ctx0::reset() {
-    m_traversal->reset();
+    if (m_owns_traversal)
+        m_traversal->reset();
     m_deltas = std::make_shared<t_zcdeltas>();
-    m_minmax = std::vector<t_minmax>(m_config.get_num_columns());
+    invalidate_min_max();
     m_has_delta = false;
 }
 
@@ -406,9 +458,31 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
     const t_column* existed_col = existed_sptr.get();
 
     bool delete_encountered = false;
+
+    update_min_max(flattened, prev, curr, existed);
+
+    if (!m_owns_traversal) {
+        // The owner of the shared traversal has already applied these rows
+        // to it, so only this context's deltas are left to calculate.
+        for (t_uindex idx = 0; idx < nrecs; ++idx) {
+            t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
+            std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
+            if (static_cast<t_op>(op_) == OP_DELETE) {
+                delete_encountered = true;
+            }
+            add_delta_pkey(pkey);
+        }
+
+        calc_step_delta(flattened, prev, curr, transitions);
+        m_has_delta = !m_deltas->empty() || m_delta_pkeys.size() > 0 || delete_encountered;
+        psp_log_time(repr() + " notify.shared_path.exit");
+        return;
+    }
+
     if (m_config.has_filters()) {
-        t_mask msk_prev = filter_table_for_config(prev, m_config);
-        t_mask msk_curr = filter_table_for_config(curr, m_config);
+        t_mask msk_prev = filter_table_for_config(prev, m_config, m_filter_cache.get());
+        t_mask msk_curr = filter_table_for_config(curr, m_config, m_filter_cache.get());
+        auto traversal_begin = t_stats::t_clock::now();
 
         for (t_uindex idx = 0; idx < nrecs; ++idx) {
             t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
@@ -444,17 +518,20 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
             // add the pkey for updated rows
             add_delta_pkey(pkey);
         }
+        m_stats.record(STATS_STAGE_TRAVERSAL, traversal_begin, nrecs);
         psp_log_time(repr() + " notify.has_filter_path.updated_traversal");
 
         // calculate deltas
         calc_step_delta(flattened, prev, curr, transitions);
-        m_has_delta = m_deltas->size() > 0 || m_delta_pkeys.size() > 0 || delete_encountered;
+        m_has_delta = !m_deltas->empty() || m_delta_pkeys.size() > 0 || delete_encountered;
 
         psp_log_time(repr() + " notify.has_filter_path.exit");
 
         return;
     }
 
+    auto traversal_begin = t_stats::t_clock::now();
+
     for (t_uindex idx = 0; idx < nrecs; ++idx) {
         t_tscalar pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx));
         std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
@@ -480,11 +557,12 @@ t_ctx0::notify(const t_data_table& flattened, const t_data_table& delta,
         add_delta_pkey(pkey);
     }
 
+    m_stats.record(STATS_STAGE_TRAVERSAL, traversal_begin, nrecs);
     psp_log_time(repr() + " notify.no_filter_path.updated_traversal");
 
     // calculate deltas
     calc_step_delta(flattened, prev, curr, transitions);
-    m_has_delta = m_deltas->size() > 0 || m_delta_pkeys.size() > 0 || delete_encountered;
+    m_has_delta = !m_deltas->empty() || m_delta_pkeys.size() > 0 || delete_encountered;
 
     psp_log_time(repr() + " notify.no_filter_path.exit");
 }
@@ -503,6 +581,10 @@ t_ctx0::notify(const t_data_table& flattened) {
     const t_column* op_col = op_sptr.get();
 
     m_has_delta = true;
+    invalidate_min_max();
+
+    if (!m_owns_traversal)
+        return;
 
     if (m_config.has_filters()) {
         t_mask msk = filter_table_for_config(flattened, m_config);
@@ -542,6 +624,11 @@ t_ctx0::notify(const t_data_table& flattened) {
 void
 t_ctx0::calc_step_delta(const t_data_table& flattened, const t_data_table& prev,
     const t_data_table& curr, const t_data_table& transitions) {
+    // Nothing reads the cell deltas of a context that has not enabled them.
+    if (!get_deltas_enabled()) {
+        return;
+    }
+
     t_uindex nrows = flattened.size();
 
     PSP_VERBOSE_ASSERT(prev.size() == nrows, "Shape violation detected");
@@ -566,13 +653,13 @@ t_ctx0::calc_step_delta(const t_data_table& flattened, const t_data_table& prev,
                 case VALUE_TRANSITION_NVEQ_FT:
                 case VALUE_TRANSITION_NEQ_FT:
                 case VALUE_TRANSITION_NEQ_TDT: {
-                    m_deltas->insert(t_zcdelta(get_interned_tscalar(pkey_col->get_scalar(ridx)),
-                        cidx, mknone(), get_interned_tscalar(ccol->get_scalar(ridx))));
+                    m_deltas->insert(get_interned_tscalar(pkey_col->get_scalar(ridx)), cidx,
+                        mknone(), get_interned_tscalar(ccol->get_scalar(ridx)));
                 } break;
                 case VALUE_TRANSITION_NEQ_TT: {
-                    m_deltas->insert(t_zcdelta(get_interned_tscalar(pkey_col->get_scalar(ridx)),
-                        cidx, get_interned_tscalar(pcol->get_scalar(ridx)),
-                        get_interned_tscalar(ccol->get_scalar(ridx))));
+                    m_deltas->insert(get_interned_tscalar(pkey_col->get_scalar(ridx)), cidx,
+                        get_interned_tscalar(pcol->get_scalar(ridx)),
+                        get_interned_tscalar(ccol->get_scalar(ridx)));
                 } break;
                 default: {}
             }
@@ -590,14 +677,122 @@ t_ctx0::add_delta_pkey(t_tscalar pkey) {
     m_delta_pkeys.insert(pkey);
 }
 
+void
+t_ctx0::update_min_max(const t_data_table& flattened, const t_data_table& prev,
+    const t_data_table& curr, const t_data_table& existed) {
+    if (!m_minmax_tracked)
+        return;
+
+    t_uindex ncols = m_config.get_num_columns();
+    bool any_tracked = false;
+    for (t_uindex colidx = 0; colidx < ncols; ++colidx) {
+        any_tracked = any_tracked || !m_minmax_stale[colidx];
+    }
+
+    if (!any_tracked)
+        return;
+
+    t_uindex nrecs = flattened.size();
+    const t_column* op_col = flattened.get_const_column("psp_op").get();
+    const t_column* existed_col = existed.get_const_column("psp_existed").get();
+
+    // Whether each row was in this context before the update, and is after.
+    std::vector<bool> in_prev(nrecs);
+    std::vector<bool> in_curr(nrecs);
+
+    bool has_filters = m_config.has_filters();
+    t_mask msk_prev;
+    t_mask msk_curr;
+    if (has_filters) {
+        msk_prev = filter_table_for_config(prev, m_config, m_filter_cache.get());
+        msk_curr = filter_table_for_config(curr, m_config, m_filter_cache.get());
+    }
+
+    for (t_uindex idx = 0; idx < nrecs; ++idx) {
+        t_op op = static_cast<t_op>(*(op_col->get_nth<std::uint8_t>(idx)));
+        bool existed = *(existed_col->get_nth<bool>(idx));
+        in_prev[idx] = existed && (!has_filters || msk_prev.get(idx));
+        in_curr[idx] = op == OP_INSERT && (!has_filters || msk_curr.get(idx));
+    }
+
+    for (t_uindex colidx = 0; colidx < ncols; ++colidx) {
+        if (m_minmax_stale[colidx])
+            continue;
+
+        const std::string& colname = m_config.col_at(colidx);
+        const t_column* pcol = prev.get_const_column(colname).get();
+        const t_column* ccol = curr.get_const_column(colname).get();
+        if (ccol->get_dtype() == DTYPE_STR)
+            continue;
+
+        t_minmax& mm = m_minmax[colidx];
+
+        // Adding first means an unchanged extreme is never exhausted.
+        for (t_uindex idx = 0; idx < nrecs; ++idx) {
+            if (in_curr[idx]) {
+                min_max_add(mm, ccol->get_scalar(idx));
+            }
+
+            if (in_prev[idx] && !min_max_remove(mm, pcol->get_scalar(idx))) {
+                m_minmax_stale[colidx] = true;
+                break;
+            }
+        }
+    }
+}
+
+void
+t_ctx0::invalidate_min_max() {
+    m_minmax_stale.assign(m_config.get_num_columns(), true);
+}
+
+void
+t_ctx0::recompute_min_max(t_uindex colidx) const {
+    t_minmax mm;
+    std::vector<t_tscalar> data;
+    m_gstate->read_column(m_config.col_at(colidx), m_traversal->get_pkeys(), data);
+
+    for (const auto& v : data) {
+        min_max_add(mm, v);
+    }
+
+    m_minmax[colidx] = mm;
+    m_minmax_stale[colidx] = false;
+}
+
+/**
+ * @brief Returns the min and max of each non-string column, over the rows
+ * in this context. Nothing is tracked until the first call, after which
+ * the extrema are maintained as rows are updated and only recomputed for
+ * columns whose min or max has been removed.
+ *
+ * @return std::vector<t_minmax>
+ */
 std::vector<t_minmax>
 t_ctx0::get_min_max() const {
+    m_minmax_tracked = true;
+
+    auto stbl = m_gstate->get_table();
+    for (t_uindex colidx = 0, ncols = m_config.get_num_columns(); colidx < ncols; ++colidx) {
+        if (!m_minmax_stale[colidx])
+            continue;
+
+        if (stbl->get_dtype(m_config.col_at(colidx)) == DTYPE_STR) {
+            m_minmax[colidx] = t_minmax();
+            m_minmax_stale[colidx] = false;
+            continue;
+        }
+
+        recompute_min_max(colidx);
+    }
+
     return m_minmax;
 }
 
 void
 t_ctx0::reset_step_state() {
-    m_traversal->reset_step_state();
+    if (m_owns_traversal)
+        m_traversal->reset_step_state();
 }
 
 void
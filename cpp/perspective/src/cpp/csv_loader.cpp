@@ -0,0 +1,712 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/csv_loader.h>
+#include <perspective/column.h>
+#include <perspective/vocab.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/parallel_for.h>
+#endif
+
+namespace perspective {
+namespace csv {
+
+namespace {
+
+const t_csv_field EMPTY_FIELD = {"", 0, false};
+
+inline bool
+is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Read the field at `p`, leaving `p` past the delimiter that ends it - or
+// past `end`, after the last field of the row.
+inline void
+read_field(const char*& p, const char* end, t_csv_field& field) {
+    field.m_escaped = false;
+
+    if (p < end && *p == '"') {
+        const char* q = p + 1;
+        while (q < end) {
+            q = static_cast<const char*>(std::memchr(q, '"', end - q));
+            if (q == nullptr) {
+                q = end;
+                break;
+            }
+
+            if (q + 1 < end && q[1] == '"') {
+                field.m_escaped = true;
+                q += 2;
+                continue;
+            }
+
+            break;
+        }
+
+        field.m_data = p + 1;
+        field.m_size = q - field.m_data;
+
+        // Skip anything between the closing quote and the delimiter.
+        p = q < end ? q + 1 : end;
+        while (p < end && *p != ',') {
+            ++p;
+        }
+        ++p;
+        return;
+    }
+
+    const char* q = static_cast<const char*>(std::memchr(p, ',', end - p));
+    if (q == nullptr) {
+        q = end;
+    }
+
+    field.m_data = p;
+    field.m_size = q - p;
+    p = q + 1;
+}
+
+std::string
+unescape(const t_csv_field& field) {
+    std::string rval(field.m_data, field.m_size);
+    if (field.m_escaped) {
+        t_uindex out = 0;
+        for (t_uindex i = 0; i < rval.size(); ++i, ++out) {
+            rval[out] = rval[i];
+            if (rval[i] == '"' && i + 1 < rval.size() && rval[i + 1] == '"') {
+                ++i;
+            }
+        }
+        rval.resize(out);
+    }
+    return rval;
+}
+
+bool
+parse_int64(const t_csv_field& field, std::int64_t& out) {
+    const char* p = field.m_data;
+    const char* end = p + field.m_size;
+    bool negative = p != end && *p == '-';
+    if (p != end && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+
+    if (p == end) {
+        return false;
+    }
+
+    std::uint64_t limit = negative ? static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + 1
+                                   : std::numeric_limits<std::int64_t>::max();
+    std::uint64_t rval = 0;
+    for (; p != end; ++p) {
+        if (!is_digit(*p)) {
+            return false;
+        }
+
+        std::uint64_t digit = *p - '0';
+        if (rval > (limit - digit) / 10) {
+            return false;
+        }
+        rval = rval * 10 + digit;
+    }
+
+    out = negative ? static_cast<std::int64_t>(0 - rval) : static_cast<std::int64_t>(rval);
+    return true;
+}
+
+// Decimal numbers with an optional exponent - not hex, `inf` or `nan`.
+bool
+parse_double(const t_csv_field& field, double& out) {
+    const char* p = field.m_data;
+    const char* end = p + field.m_size;
+    if (p != end && (*p == '-' || *p == '+')) {
+        ++p;
+    }
+
+    t_uindex digits = 0;
+    while (p != end && is_digit(*p)) {
+        ++p;
+        ++digits;
+    }
+
+    if (p != end && *p == '.') {
+        ++p;
+        while (p != end && is_digit(*p)) {
+            ++p;
+            ++digits;
+        }
+    }
+
+    if (digits == 0) {
+        return false;
+    }
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p != end && (*p == '-' || *p == '+')) {
+            ++p;
+        }
+
+        if (p == end || !is_digit(*p)) {
+            return false;
+        }
+
+        while (p != end && is_digit(*p)) {
+            ++p;
+        }
+    }
+
+    if (p != end) {
+        return false;
+    }
+
+    // The field is always followed by a delimiter, quote, line ending or
+    // the terminating null, so `strtod` stops at its end.
+    out = std::strtod(field.m_data, nullptr);
+    return true;
+}
+
+bool
+parse_bool(const t_csv_field& field, bool& out) {
+    const char* s = field.m_data;
+    if (field.m_size == 4 && (std::strncmp(s, "true", 4) == 0 || std::strncmp(s, "True", 4) == 0
+                                 || std::strncmp(s, "TRUE", 4) == 0)) {
+        out = true;
+        return true;
+    }
+
+    if (field.m_size == 5 && (std::strncmp(s, "false", 5) == 0 || std::strncmp(s, "False", 5) == 0
+                                 || std::strncmp(s, "FALSE", 5) == 0)) {
+        out = false;
+        return true;
+    }
+
+    return false;
+}
+
+// The dtype of a single non-empty field - anything that is not a boolean or
+// a number is `DTYPE_STR`, and may be a datestring.
+t_dtype
+infer_dtype(const t_csv_field& field) {
+    bool bval;
+    std::int64_t ival;
+    double fval;
+    if (parse_bool(field, bval)) {
+        return DTYPE_BOOL;
+    } else if (parse_int64(field, ival)) {
+        bool is_int32 = ival >= std::numeric_limits<std::int32_t>::min()
+            && ival <= std::numeric_limits<std::int32_t>::max();
+        return is_int32 ? DTYPE_INT32 : DTYPE_INT64;
+    } else if (parse_double(field, fval)) {
+        return DTYPE_FLOAT64;
+    }
+
+    return DTYPE_STR;
+}
+
+/**
+ * Write `field` into row `idx` of `col`, or clear it if `field` is empty.
+ *
+ * If the value does not fit the column, return the dtype the column must be
+ * promoted to if `promote`, otherwise leave it null.
+ */
+t_dtype
+parse_cell(const t_csv_field& field, t_dtype dtype, t_date_format format, t_column& col,
+    t_uindex idx, bool promote) {
+    if (field.m_size == 0) {
+        col.clear(idx);
+        return DTYPE_NONE;
+    }
+
+    switch (dtype) {
+        case DTYPE_INT32:
+        case DTYPE_INT64: {
+            std::int64_t ival;
+            double fval;
+            if (parse_int64(field, ival)) {
+                if (dtype == DTYPE_INT64) {
+                    col.set_nth<std::int64_t>(idx, ival);
+                    return DTYPE_NONE;
+                }
+
+                if (ival >= std::numeric_limits<std::int32_t>::min()
+                    && ival <= std::numeric_limits<std::int32_t>::max()) {
+                    col.set_nth<std::int32_t>(idx, static_cast<std::int32_t>(ival));
+                    return DTYPE_NONE;
+                }
+            } else if (!promote && parse_double(field, fval)) {
+                // Truncate, as updates from other formats do.
+                if (dtype == DTYPE_INT64) {
+                    col.set_nth<std::int64_t>(idx, static_cast<std::int64_t>(fval));
+                } else {
+                    col.set_nth<std::int32_t>(idx, static_cast<std::int32_t>(fval));
+                }
+                return DTYPE_NONE;
+            }
+        } break;
+        case DTYPE_FLOAT32:
+        case DTYPE_FLOAT64: {
+            double fval;
+            if (parse_double(field, fval)) {
+                if (dtype == DTYPE_FLOAT64) {
+                    col.set_nth<double>(idx, fval);
+                } else {
+                    col.set_nth<float>(idx, static_cast<float>(fval));
+                }
+                return DTYPE_NONE;
+            }
+        } break;
+        case DTYPE_BOOL: {
+            bool bval;
+            if (parse_bool(field, bval)) {
+                col.set_nth<bool>(idx, bval);
+                return DTYPE_NONE;
+            }
+        } break;
+        case DTYPE_DATE:
+        case DTYPE_TIME: {
+            // Without a format common to the column, try each in turn.
+            t_parsed_date parsed;
+            bool is_valid = format == DATE_FORMAT_NONE
+                ? t_date_parser().parse(field.m_data, field.m_size, parsed)
+                : t_date_parser::parse(field.m_data, field.m_size, format, parsed);
+            if (is_valid) {
+                if (dtype == DTYPE_TIME) {
+                    col.set_nth<std::int64_t>(idx, t_date_parser::to_timestamp(parsed));
+                    return DTYPE_NONE;
+                }
+
+                if (parsed.m_has_time && promote) {
+                    return DTYPE_TIME;
+                }
+
+                col.set_nth<t_date>(idx, t_date_parser::to_date(parsed));
+                return DTYPE_NONE;
+            }
+        } break;
+        default: { break; }
+    }
+
+    if (promote) {
+        t_dtype promoted = join_dtypes(dtype, infer_dtype(field));
+        return promoted == dtype ? DTYPE_STR : promoted;
+    }
+
+    col.clear(idx);
+    return DTYPE_NONE;
+}
+
+} // end anonymous namespace
+
+t_dtype
+join_dtypes(t_dtype a, t_dtype b) {
+    if (a == DTYPE_NONE || a == b) {
+        return b;
+    } else if (b == DTYPE_NONE) {
+        return a;
+    }
+
+    bool a_numeric = a == DTYPE_INT32 || a == DTYPE_INT64 || a == DTYPE_FLOAT64;
+    bool b_numeric = b == DTYPE_INT32 || b == DTYPE_INT64 || b == DTYPE_FLOAT64;
+    if (a_numeric && b_numeric) {
+        return a == DTYPE_FLOAT64 || b == DTYPE_FLOAT64 ? DTYPE_FLOAT64 : DTYPE_INT64;
+    }
+
+    bool a_date = a == DTYPE_DATE || a == DTYPE_TIME;
+    bool b_date = b == DTYPE_DATE || b == DTYPE_TIME;
+    if (a_date && b_date) {
+        return DTYPE_TIME;
+    }
+
+    return DTYPE_STR;
+}
+
+CsvLoader::CsvLoader() {}
+
+CsvLoader::~CsvLoader() {}
+
+void
+CsvLoader::initialize(std::string data) {
+    m_data = std::move(data);
+    split_rows();
+    infer_types();
+
+    m_table = std::make_shared<t_data_table>(t_schema(m_names, m_types));
+    m_table->init();
+    m_table->extend(m_row_starts.size());
+
+    // Parse every column, then parse again any column promoted to fit
+    // values its inferred type could not.
+    std::vector<t_uindex> cidxs(m_names.size());
+    for (t_uindex cidx = 0; cidx < cidxs.size(); ++cidx) {
+        cidxs[cidx] = cidx;
+    }
+
+    while (!cidxs.empty()) {
+        std::vector<std::shared_ptr<t_column>> cols;
+        std::vector<t_date_format> formats;
+        for (t_uindex cidx : cidxs) {
+            cols.push_back(m_table->get_column(m_names[cidx]));
+            formats.push_back(m_date_formats[cidx]);
+        }
+
+        std::vector<t_dtype> promotions = parse_columns(cidxs, cols, formats, true);
+        std::vector<t_uindex> promoted;
+        for (t_uindex k = 0; k < cidxs.size(); ++k) {
+            if (promotions[k] == DTYPE_NONE) {
+                continue;
+            }
+
+            t_uindex cidx = cidxs[k];
+            m_types[cidx] = join_dtypes(m_types[cidx], promotions[k]);
+            m_table->promote_column(m_names[cidx], m_types[cidx], 0, false);
+            promoted.push_back(cidx);
+        }
+
+        cidxs.swap(promoted);
+    }
+}
+
+void
+CsvLoader::split_rows() {
+    const char* base = m_data.c_str();
+    t_uindex size = m_data.size();
+    t_uindex nchunks = std::max<t_uindex>(
+        1, (size + PSP_CSV_SPLIT_CHUNK_SIZE - 1) / PSP_CSV_SPLIT_CHUNK_SIZE);
+
+    // Whether each chunk starts inside quotes follows from the number of
+    // quotes before it, so chunks can look for line endings independently.
+    std::vector<t_uindex> quotes(nchunks);
+    std::vector<std::vector<t_uindex>> line_ends(nchunks);
+
+    auto count_quotes = [&](int chunk) {
+        t_uindex bidx = chunk * PSP_CSV_SPLIT_CHUNK_SIZE;
+        t_uindex eidx = std::min(size, bidx + PSP_CSV_SPLIT_CHUNK_SIZE);
+        quotes[chunk] = std::count(base + bidx, base + eidx, '"');
+    };
+
+#ifdef PSP_PARALLEL_FOR
+    tbb::parallel_for(0, int(nchunks), 1, count_quotes, tbb::auto_partitioner());
+#else
+    for (t_uindex chunk = 0; chunk < nchunks; ++chunk) {
+        count_quotes(chunk);
+    }
+#endif
+
+    std::vector<std::uint8_t> starts_quoted(nchunks);
+    bool quoted = false;
+    for (t_uindex chunk = 0; chunk < nchunks; ++chunk) {
+        starts_quoted[chunk] = quoted;
+        quoted = quoted != (quotes[chunk] % 2 == 1);
+    }
+
+    auto find_line_ends = [&](int chunk) {
+        t_uindex bidx = chunk * PSP_CSV_SPLIT_CHUNK_SIZE;
+        t_uindex eidx = std::min(size, bidx + PSP_CSV_SPLIT_CHUNK_SIZE);
+        bool in_quotes = starts_quoted[chunk];
+        for (t_uindex idx = bidx; idx < eidx; ++idx) {
+            char c = base[idx];
+            if (c == '"') {
+                in_quotes = !in_quotes;
+            } else if (c == '\n' && !in_quotes) {
+                line_ends[chunk].push_back(idx);
+            }
+        }
+    };
+
+#ifdef PSP_PARALLEL_FOR
+    tbb::parallel_for(0, int(nchunks), 1, find_line_ends, tbb::auto_partitioner());
+#else
+    for (t_uindex chunk = 0; chunk < nchunks; ++chunk) {
+        find_line_ends(chunk);
+    }
+#endif
+
+    // Skip a byte order mark, and blank lines.
+    t_uindex start = size >= 3 && std::memcmp(base, "\xEF\xBB\xBF", 3) == 0 ? 3 : 0;
+    auto add_row = [&](t_uindex end) {
+        t_uindex row_end = end > start && base[end - 1] == '\r' ? end - 1 : end;
+        if (row_end > start) {
+            m_row_starts.push_back(start);
+            m_row_ends.push_back(row_end);
+        }
+        start = end + 1;
+    };
+
+    for (const auto& chunk_line_ends : line_ends) {
+        for (t_uindex end : chunk_line_ends) {
+            add_row(end);
+        }
+    }
+    add_row(size);
+
+    if (m_row_starts.empty()) {
+        PSP_COMPLAIN_AND_ABORT("Cannot load a CSV without a header row.");
+    }
+
+    // The first row names the columns.
+    std::vector<t_csv_field> fields;
+    read_row(0, std::numeric_limits<t_uindex>::max(), fields);
+    for (const t_csv_field& field : fields) {
+        m_names.push_back(unescape(field));
+    }
+
+    if (m_names[0].empty()) {
+        m_names[0] = "_";
+    }
+
+    m_row_starts.erase(m_row_starts.begin());
+    m_row_ends.erase(m_row_ends.begin());
+}
+
+void
+CsvLoader::read_row(t_uindex ridx, t_uindex max_fields, std::vector<t_csv_field>& fields) const {
+    const char* base = m_data.c_str();
+    const char* p = base + m_row_starts[ridx];
+    const char* end = base + m_row_ends[ridx];
+    fields.clear();
+    while (p <= end && fields.size() < max_fields) {
+        t_csv_field field;
+        read_field(p, end, field);
+        fields.push_back(field);
+    }
+}
+
+void
+CsvLoader::infer_types() {
+    t_uindex ncols = m_names.size();
+    t_uindex nsample = std::min(PSP_CSV_INFER_ROWS, static_cast<t_uindex>(m_row_starts.size()));
+    std::vector<t_dtype> types(ncols, DTYPE_NONE);
+    std::vector<std::vector<std::string>> datestrings(ncols);
+    std::vector<t_csv_field> fields;
+
+    for (t_uindex ridx = 0; ridx < nsample; ++ridx) {
+        read_row(ridx, ncols, fields);
+        for (t_uindex cidx = 0; cidx < fields.size(); ++cidx) {
+            if (fields[cidx].m_size == 0) {
+                continue;
+            }
+
+            t_dtype dtype = infer_dtype(fields[cidx]);
+            if (dtype == DTYPE_STR) {
+                datestrings[cidx].push_back(unescape(fields[cidx]));
+            } else {
+                types[cidx] = join_dtypes(types[cidx], dtype);
+            }
+        }
+    }
+
+    m_date_formats.assign(ncols, DATE_FORMAT_NONE);
+    for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
+        if (!datestrings[cidx].empty()) {
+            // Strings are either datestrings in one format, or strings.
+            t_date_parser parser;
+            t_date_format format = parser.detect_format(datestrings[cidx]);
+            t_dtype dtype = format == DATE_FORMAT_NONE ? DTYPE_STR : DTYPE_DATE;
+            for (const std::string& datestring : datestrings[cidx]) {
+                t_parsed_date parsed;
+                if (dtype == DTYPE_DATE && parser.parse(datestring.c_str(), datestring.size(), parsed)
+                    && parsed.m_has_time) {
+                    dtype = DTYPE_TIME;
+                    break;
+                }
+            }
+
+            m_date_formats[cidx] = format;
+            types[cidx] = join_dtypes(types[cidx], dtype);
+        }
+
+        // Columns with no values at all are strings.
+        m_types.push_back(types[cidx] == DTYPE_NONE ? DTYPE_STR : types[cidx]);
+    }
+}
+
+t_date_format
+CsvLoader::detect_date_format(t_uindex cidx) const {
+    if (m_date_formats[cidx] != DATE_FORMAT_NONE) {
+        return m_date_formats[cidx];
+    }
+
+    t_uindex nsample = std::min(PSP_CSV_INFER_ROWS, static_cast<t_uindex>(m_row_starts.size()));
+    std::vector<std::string> datestrings;
+    std::vector<t_csv_field> fields;
+    for (t_uindex ridx = 0; ridx < nsample; ++ridx) {
+        read_row(ridx, cidx + 1, fields);
+        if (cidx < fields.size() && fields[cidx].m_size > 0) {
+            datestrings.push_back(unescape(fields[cidx]));
+        }
+    }
+
+    t_date_parser parser;
+    return parser.detect_format(datestrings);
+}
+
+std::vector<t_dtype>
+CsvLoader::parse_columns(const std::vector<t_uindex>& cidxs,
+    const std::vector<std::shared_ptr<t_column>>& cols,
+    const std::vector<t_date_format>& formats, bool promote) const {
+    t_uindex ntargets = cidxs.size();
+    t_uindex nrows = m_row_starts.size();
+    t_uindex nchunks = (nrows + PSP_CSV_PARSE_CHUNK_SIZE - 1) / PSP_CSV_PARSE_CHUNK_SIZE;
+    t_uindex max_fields = *std::max_element(cidxs.begin(), cidxs.end()) + 1;
+
+    // Strings are interned in bulk once every row is read - the strings
+    // that needed unescaping are kept until then, per chunk.
+    std::vector<t_dtype> dtypes(ntargets);
+    std::vector<std::vector<t_vocab_string>> strings(ntargets);
+    for (t_uindex k = 0; k < ntargets; ++k) {
+        dtypes[k] = cols[k]->get_dtype();
+        if (dtypes[k] == DTYPE_STR) {
+            strings[k].resize(nrows);
+        }
+    }
+
+    std::vector<std::deque<std::string>> unescaped(nchunks);
+    std::vector<t_dtype> promotions(nchunks * ntargets, DTYPE_NONE);
+
+    auto parse_chunk = [&](int chunk) {
+        std::vector<t_csv_field> fields;
+        t_uindex bidx = chunk * PSP_CSV_PARSE_CHUNK_SIZE;
+        t_uindex eidx = std::min(nrows, bidx + PSP_CSV_PARSE_CHUNK_SIZE);
+        for (t_uindex ridx = bidx; ridx < eidx; ++ridx) {
+            read_row(ridx, max_fields, fields);
+            for (t_uindex k = 0; k < ntargets; ++k) {
+                t_csv_field field = cidxs[k] < fields.size() ? fields[cidxs[k]] : EMPTY_FIELD;
+                if (dtypes[k] == DTYPE_STR) {
+                    if (field.m_escaped) {
+                        unescaped[chunk].push_back(unescape(field));
+                        field.m_data = unescaped[chunk].back().c_str();
+                        field.m_size = unescaped[chunk].back().size();
+                    }
+
+                    strings[k][ridx] = {field.m_data, field.m_size,
+                        t_vocab::hash_string(field.m_data, field.m_size)};
+                    continue;
+                }
+
+                t_dtype promotion
+                    = parse_cell(field, dtypes[k], formats[k], *cols[k], ridx, promote);
+                t_dtype& chunk_promotion = promotions[chunk * ntargets + k];
+                chunk_promotion = join_dtypes(chunk_promotion, promotion);
+            }
+        }
+    };
+
+#ifdef PSP_PARALLEL_FOR
+    tbb::parallel_for(0, int(nchunks), 1, parse_chunk, tbb::auto_partitioner());
+#else
+    for (t_uindex chunk = 0; chunk < nchunks; ++chunk) {
+        parse_chunk(chunk);
+    }
+#endif
+
+    std::vector<t_dtype> rval(ntargets, DTYPE_NONE);
+    for (t_uindex k = 0; k < ntargets; ++k) {
+        if (dtypes[k] == DTYPE_STR) {
+            cols[k]->set_strings(0, strings[k]);
+            for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
+                if (strings[k][ridx].m_size == 0) {
+                    cols[k]->clear(ridx);
+                }
+            }
+            continue;
+        }
+
+        for (t_uindex chunk = 0; chunk < nchunks; ++chunk) {
+            rval[k] = join_dtypes(rval[k], promotions[chunk * ntargets + k]);
+        }
+    }
+
+    return rval;
+}
+
+void
+CsvLoader::fill_table(t_data_table& tbl, const std::string& index, std::uint32_t offset,
+    std::uint32_t limit, bool is_update) {
+    bool implicit_index = false;
+    const t_schema& schema = tbl.get_schema();
+
+    for (t_uindex cidx = 0; cidx < m_names.size(); ++cidx) {
+        const std::string& name = m_names[cidx];
+
+        if (name == "__INDEX__") {
+            implicit_index = true;
+            std::shared_ptr<t_column> pkey_col_sptr
+                = tbl.add_column_sptr("psp_pkey", m_types[cidx], true);
+            fill_column(tbl, pkey_col_sptr, "psp_pkey", cidx, is_update);
+            tbl.clone_column("psp_pkey", "psp_okey");
+            continue;
+        } else if (schema.has_column(name)) {
+            fill_column(tbl, tbl.get_column(name), name, cidx, is_update);
+        }
+    }
+
+    // Fill index column - recreated every time a `t_data_table` is created.
+    if (!implicit_index) {
+        if (index == "") {
+            // Use row number as index if not explicitly provided or provided with
+            // `__INDEX__`
+            auto key_col = tbl.add_column("psp_pkey", DTYPE_INT32, true);
+            auto okey_col = tbl.add_column("psp_okey", DTYPE_INT32, true);
+
+            for (std::uint32_t ridx = 0; ridx < tbl.size(); ++ridx) {
+                key_col->set_nth<std::int32_t>(ridx, (ridx + offset) % limit);
+                okey_col->set_nth<std::int32_t>(ridx, (ridx + offset) % limit);
+            }
+        } else {
+            tbl.clone_column(index, "psp_pkey");
+            tbl.clone_column(index, "psp_okey");
+        }
+    }
+}
+
+void
+CsvLoader::fill_column(t_data_table& tbl, std::shared_ptr<t_column> col, const std::string& name,
+    t_uindex cidx, bool is_update) {
+    if (col->get_dtype() == m_types[cidx]) {
+        col = m_table->get_column(m_names[cidx]);
+        tbl.set_column(name, col);
+    } else {
+        parse_columns({cidx}, {col}, {detect_date_format(cidx)}, false);
+    }
+
+    // Null values in an update unset the cell, rather than clearing it.
+    if (is_update) {
+        for (t_uindex ridx = 0, loop_end = col->size(); ridx < loop_end; ++ridx) {
+            if (!col->is_valid(ridx)) {
+                col->unset(ridx);
+            }
+        }
+    }
+}
+
+std::uint32_t
+CsvLoader::row_count() const {
+    return m_row_starts.size();
+}
+
+std::vector<std::string>
+CsvLoader::names() const {
+    return m_names;
+}
+
+std::vector<t_dtype>
+CsvLoader::types() const {
+    return m_types;
+}
+
+} // namespace csv
+} // namespace perspective
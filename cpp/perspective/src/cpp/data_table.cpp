@@ -316,6 +316,15 @@ t_data_table::flatten() const {
     return flattened;
 }
 
+void
+t_data_table::flatten(t_data_table& flattened) const {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(is_pkey_table(), "Not a pkeyed table");
+    PSP_VERBOSE_ASSERT(flattened.size() == 0, "Flattening into a non-empty table");
+    flatten_body<t_data_table*>(&flattened);
+}
+
 bool
 t_data_table::is_pkey_table() const {
     PSP_TRACE_SENTINEL();
@@ -755,6 +764,13 @@ t_data_table::reset() {
     init();
 }
 
+void
+t_data_table::clear_vocabularies() {
+    for (t_uindex idx = 0, loop_end = m_columns.size(); idx < loop_end; ++idx) {
+        m_columns[idx]->clear_vocabulary();
+    }
+}
+
 std::vector<t_tscalar>
 t_data_table::get_scalvec() const {
     auto nrows = size();
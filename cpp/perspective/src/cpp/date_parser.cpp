@@ -7,39 +7,423 @@
  *
  */
 
-#include <sstream>
 #include <perspective/first.h>
 #include <perspective/date_parser.h>
-#include <locale>
-#include <iomanip>
+#include <ctime>
 
 namespace perspective {
 
-// Milliseconds & timezones are not currently handled
-const std::string t_date_parser::VALID_FORMATS[12]
-    = {"%Y%m%dT%H%M%S", // ISO "%Y%m%dT%H%M%S%F%q"
-        "%Y-%m-%dT%H:%M:%S",
-        "%Y-%m-%d %H:%M:%S",     // ISO extended
-        "%A, %d %b %Y %H:%M:%S", // RFC 0822
-        "%Y-%m-%d\\%H:%M:%S"
-        "%m-%d-%Y",
-        "%m/%d/%Y", "%m-%d-%Y", "%m %d %Y", "%m/%d/%Y", "%m/%d/%y", "%d %m %Y"};
+namespace {
 
-t_date_parser::t_date_parser() {}
+const char* MONTH_NAMES[12] = {"january", "february", "march", "april", "may", "june", "july",
+    "august", "september", "october", "november", "december"};
+
+const char* WEEKDAY_NAMES[7]
+    = {"monday", "tuesday", "wednesday", "thursday", "friday", "saturday", "sunday"};
+
+inline bool
+is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline char
+to_lower(char c) {
+    return c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c;
+}
+
+// Read exactly `n` digits.
+inline bool
+read_digits(const char*& p, const char* end, t_uindex n, std::int32_t& out) {
+    if (static_cast<t_uindex>(end - p) < n)
+        return false;
+
+    std::int32_t rval = 0;
+    for (t_uindex i = 0; i < n; ++i) {
+        if (!is_digit(p[i]))
+            return false;
+        rval = rval * 10 + (p[i] - '0');
+    }
+
+    p += n;
+    out = rval;
+    return true;
+}
+
+// Read one or two digits.
+inline bool
+read_short(const char*& p, const char* end, std::int32_t& out) {
+    if (p == end || !is_digit(*p))
+        return false;
+
+    out = *p++ - '0';
+    if (p != end && is_digit(*p)) {
+        out = out * 10 + (*p++ - '0');
+    }
+
+    return true;
+}
+
+inline bool
+read_char(const char*& p, const char* end, char c) {
+    if (p == end || *p != c)
+        return false;
+    ++p;
+    return true;
+}
+
+// Match `word` case-insensitively, and at least its first three letters.
+inline bool
+read_name(const char*& p, const char* end, const char* word) {
+    const char* q = p;
+    t_uindex matched = 0;
+    while (q != end && word[matched] != '\0' && to_lower(*q) == word[matched]) {
+        ++q;
+        ++matched;
+    }
+
+    if (matched < 3 || (q != end && ((*q >= 'a' && *q <= 'z') || (*q >= 'A' && *q <= 'Z'))))
+        return false;
+
+    p = q;
+    return true;
+}
+
+inline bool
+is_leap_year(std::int32_t year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar.
+std::int64_t
+days_from_civil(std::int64_t year, std::int64_t month, std::int64_t day) {
+    year -= month <= 2;
+    std::int64_t era = (year >= 0 ? year : year - 399) / 400;
+    std::int64_t yoe = year - era * 400;
+    std::int64_t doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+// `Z`, `UTC`, `GMT`, or an offset of [+-]HH, [+-]HHMM or [+-]HH:MM.
+bool
+parse_zone(const char*& p, const char* end, t_parsed_date& out) {
+    if (p == end)
+        return true;
+
+    if (*p == 'Z' || *p == 'z') {
+        ++p;
+        out.m_has_offset = true;
+        return true;
+    }
+
+    if (end - p >= 3) {
+        char a = to_lower(p[0]), b = to_lower(p[1]), c = to_lower(p[2]);
+        if ((a == 'u' && b == 't' && c == 'c') || (a == 'g' && b == 'm' && c == 't')) {
+            p += 3;
+            out.m_has_offset = true;
+            return true;
+        }
+    }
+
+    if (*p != '+' && *p != '-')
+        return false;
+
+    std::int32_t sign = *p++ == '-' ? -1 : 1;
+    std::int32_t hours, minutes = 0;
+    if (!read_digits(p, end, 2, hours))
+        return false;
+
+    if (p != end) {
+        read_char(p, end, ':');
+        if (!read_digits(p, end, 2, minutes))
+            return false;
+    }
+
+    if (hours > 23 || minutes > 59)
+        return false;
+
+    out.m_has_offset = true;
+    out.m_offset_minutes = sign * (hours * 60 + minutes);
+    return true;
+}
+
+// HH:MM[:SS[.fff]], or HHMMSS[.fff] if `basic`, then an optional zone.
+bool
+parse_time(const char*& p, const char* end, bool basic, t_parsed_date& out) {
+    if (!read_digits(p, end, 2, out.m_hour))
+        return false;
+
+    if (basic) {
+        if (!read_digits(p, end, 2, out.m_minute) || !read_digits(p, end, 2, out.m_second))
+            return false;
+    } else {
+        if (!read_char(p, end, ':') || !read_digits(p, end, 2, out.m_minute))
+            return false;
+
+        if (read_char(p, end, ':') && !read_digits(p, end, 2, out.m_second))
+            return false;
+    }
+
+    if (read_char(p, end, '.') || read_char(p, end, ',')) {
+        // Any number of fractional digits, truncated to milliseconds
+        if (p == end || !is_digit(*p))
+            return false;
+
+        std::int32_t scale = 100;
+        while (p != end && is_digit(*p)) {
+            out.m_millisecond += (*p++ - '0') * scale;
+            scale /= 10;
+        }
+    }
+
+    if (out.m_hour > 23 || out.m_minute > 59 || out.m_second > 59)
+        return false;
+
+    out.m_has_time = true;
+    read_char(p, end, ' ');
+    return parse_zone(p, end, out);
+}
+
+// An optional time after a date, separated by `T` or a space if `allow_t`.
+inline bool
+parse_trailing_time(const char*& p, const char* end, bool allow_t, t_parsed_date& out) {
+    if (p == end)
+        return true;
+
+    if (!read_char(p, end, ' ') && !(allow_t && (read_char(p, end, 'T') || read_char(p, end, 't'))))
+        return false;
+
+    return parse_time(p, end, false, out);
+}
+
+bool
+parse_iso(const char* p, const char* end, t_parsed_date& out) {
+    if (!read_digits(p, end, 4, out.m_year) || p == end)
+        return false;
+
+    char sep = *p;
+    if ((sep != '-' && sep != '/') || !read_char(p, end, sep))
+        return false;
+
+    if (!read_short(p, end, out.m_month) || !read_char(p, end, sep)
+        || !read_short(p, end, out.m_day))
+        return false;
+
+    return parse_trailing_time(p, end, true, out) && p == end;
+}
+
+bool
+parse_iso_basic(const char* p, const char* end, t_parsed_date& out) {
+    if (!read_digits(p, end, 4, out.m_year) || !read_digits(p, end, 2, out.m_month)
+        || !read_digits(p, end, 2, out.m_day))
+        return false;
+
+    if (p == end)
+        return true;
+
+    if (!read_char(p, end, 'T') && !read_char(p, end, 't'))
+        return false;
+
+    return parse_time(p, end, true, out) && p == end;
+}
+
+bool
+parse_rfc822(const char* p, const char* end, t_parsed_date& out) {
+    if (p != end && !is_digit(*p)) {
+        bool found = false;
+        for (const char* weekday : WEEKDAY_NAMES) {
+            if (read_name(p, end, weekday)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found || !read_char(p, end, ',') || !read_char(p, end, ' '))
+            return false;
+    }
+
+    if (!read_short(p, end, out.m_day) || !read_char(p, end, ' '))
+        return false;
+
+    out.m_month = 0;
+    for (std::int32_t month = 0; month < 12; ++month) {
+        if (read_name(p, end, MONTH_NAMES[month])) {
+            out.m_month = month + 1;
+            break;
+        }
+    }
+
+    if (out.m_month == 0 || !read_char(p, end, ' ') || !read_digits(p, end, 4, out.m_year))
+        return false;
+
+    return parse_trailing_time(p, end, false, out) && p == end;
+}
+
+bool
+parse_us(const char* p, const char* end, t_parsed_date& out) {
+    if (!read_short(p, end, out.m_month) || p == end)
+        return false;
+
+    char sep = *p;
+    if ((sep != '/' && sep != '-' && sep != ' ') || !read_char(p, end, sep))
+        return false;
+
+    if (!read_short(p, end, out.m_day) || !read_char(p, end, sep))
+        return false;
+
+    if (!read_digits(p, end, 4, out.m_year)) {
+        // Two digit years are 1969 - 2068, as with `%y`.
+        if (!read_digits(p, end, 2, out.m_year) || (p != end && is_digit(*p)))
+            return false;
+        out.m_year += out.m_year < 69 ? 2000 : 1900;
+    }
+
+    return parse_trailing_time(p, end, false, out) && p == end;
+}
+
+bool
+parse_dmy(const char* p, const char* end, t_parsed_date& out) {
+    if (!read_short(p, end, out.m_day) || !read_char(p, end, ' ')
+        || !read_short(p, end, out.m_month) || !read_char(p, end, ' ')
+        || !read_digits(p, end, 4, out.m_year))
+        return false;
+
+    return parse_trailing_time(p, end, false, out) && p == end;
+}
+
+} // end anonymous namespace
+
+t_date_parser::t_date_parser()
+    : m_format(DATE_FORMAT_NONE) {}
 
 bool
 t_date_parser::is_valid(std::string const& datestring) {
-    for (const std::string& fmt : VALID_FORMATS) {
-        if (fmt != "") {
-            std::tm t = {};
-            std::stringstream ss(datestring);
-            ss.imbue(std::locale::classic());
-            ss >> std::get_time(&t, fmt.c_str());
-            if (!ss.fail()) {
-                return true;
+    t_parsed_date parsed;
+    for (std::int32_t format = 0; format < DATE_FORMAT_NONE; ++format) {
+        if (parse(datestring.c_str(), datestring.size(), static_cast<t_date_format>(format),
+                parsed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+t_date_format
+t_date_parser::detect_format(const std::vector<std::string>& sample) {
+    t_parsed_date parsed;
+    m_format = DATE_FORMAT_NONE;
+    for (std::int32_t format = 0; format < DATE_FORMAT_NONE; ++format) {
+        bool matched = false;
+        bool fits = true;
+        for (const std::string& s : sample) {
+            if (s.empty())
+                continue;
+
+            if (!parse(s.c_str(), s.size(), static_cast<t_date_format>(format), parsed)) {
+                fits = false;
+                break;
             }
+
+            matched = true;
         }
+
+        if (matched && fits) {
+            m_format = static_cast<t_date_format>(format);
+            break;
+        }
+    }
+
+    return m_format;
+}
+
+t_date_format
+t_date_parser::get_format() const {
+    return m_format;
+}
+
+bool
+t_date_parser::parse(const char* s, t_uindex size, t_parsed_date& out) const {
+    if (m_format != DATE_FORMAT_NONE)
+        return parse(s, size, m_format, out);
+
+    for (std::int32_t format = 0; format < DATE_FORMAT_NONE; ++format) {
+        if (parse(s, size, static_cast<t_date_format>(format), out))
+            return true;
     }
+
     return false;
 }
-} // end namespace perspective
\ No newline at end of file
+
+bool
+t_date_parser::parse(const char* s, t_uindex size, t_date_format format, t_parsed_date& out) {
+    const char* p = s;
+    const char* end = s + size;
+    while (p != end && *p == ' ')
+        ++p;
+    while (end != p && *(end - 1) == ' ')
+        --end;
+
+    out = t_parsed_date();
+
+    bool parsed;
+    switch (format) {
+        case DATE_FORMAT_ISO: {
+            parsed = parse_iso(p, end, out);
+        } break;
+        case DATE_FORMAT_ISO_BASIC: {
+            parsed = parse_iso_basic(p, end, out);
+        } break;
+        case DATE_FORMAT_RFC822: {
+            parsed = parse_rfc822(p, end, out);
+        } break;
+        case DATE_FORMAT_US: {
+            parsed = parse_us(p, end, out);
+        } break;
+        case DATE_FORMAT_DMY: {
+            parsed = parse_dmy(p, end, out);
+        } break;
+        default: { parsed = false; } break;
+    }
+
+    if (!parsed || out.m_month < 1 || out.m_month > 12 || out.m_day < 1)
+        return false;
+
+    std::int32_t month_days = CUMULATIVE_DAYS[is_leap_year(out.m_year)][out.m_month]
+        - CUMULATIVE_DAYS[is_leap_year(out.m_year)][out.m_month - 1];
+
+    return out.m_day <= month_days;
+}
+
+std::int64_t
+t_date_parser::to_timestamp(const t_parsed_date& parsed) {
+    std::int64_t seconds;
+    if (parsed.m_has_offset || parsed.m_year < 1900) {
+        // Years before 1900 are taken as UTC, as `mktime` may not handle them.
+        seconds = days_from_civil(parsed.m_year, parsed.m_month, parsed.m_day) * 86400
+            + parsed.m_hour * 3600 + parsed.m_minute * 60 + parsed.m_second
+            - parsed.m_offset_minutes * 60;
+
+        // `datetime.min` is the start of the epoch.
+        if (seconds == days_from_civil(1, 1, 1) * 86400)
+            return 0;
+    } else {
+        std::tm t = {};
+        t.tm_year = parsed.m_year - 1900;
+        t.tm_mon = parsed.m_month - 1;
+        t.tm_mday = parsed.m_day;
+        t.tm_hour = parsed.m_hour;
+        t.tm_min = parsed.m_minute;
+        t.tm_sec = parsed.m_second;
+        t.tm_isdst = -1;
+        seconds = static_cast<std::int64_t>(std::mktime(&t));
+    }
+
+    return seconds * 1000 + parsed.m_millisecond;
+}
+
+t_date
+t_date_parser::to_date(const t_parsed_date& parsed) {
+    return t_date(parsed.m_year, parsed.m_month - 1, parsed.m_day);
+}
+
+} // end namespace perspective
@@ -10,6 +10,7 @@
 #include <perspective/emscripten.h>
 #include <perspective/arrow_loader.h>
 #include <perspective/arrow_writer.h>
+#include <perspective/csv_loader.h>
 
 using namespace emscripten;
 using namespace perspective;
@@ -1021,6 +1022,7 @@ namespace binding {
         t_op op,
         bool is_update,
         bool is_arrow,
+        bool is_csv,
         t_uindex port_id) {
         bool table_initialized = has_value(table);
         std::shared_ptr<t_pool> pool;
@@ -1040,6 +1042,7 @@ namespace binding {
         std::vector<std::string> column_names;
         std::vector<t_dtype> data_types;
         arrow::ArrowLoader loader;
+        csv::CsvLoader csv_loader;
         std::uintptr_t ptr;
 
         // Determine metadata
@@ -1108,6 +1111,19 @@ namespace binding {
                 column_names = loader.names();
                 data_types = loader.types();
             }
+        } else if (is_csv && !is_delete) {
+            csv_loader.initialize(accessor.as<std::string>());
+
+            // Always use the `Table` column names and data types on update,
+            // parsing the CSV again into any that differ.
+            if (table_initialized && is_update) {
+                auto schema = gnode->get_output_schema().drop({"psp_okey"});
+                column_names = schema.columns();
+                data_types = schema.types();
+            } else {
+                column_names = csv_loader.names();
+                data_types = csv_loader.types();
+            }
         } else if (is_update || is_delete) {
             t_val names = accessor["names"];
             t_val types = accessor["types"];
@@ -1146,6 +1162,8 @@ namespace binding {
         std::uint32_t row_count = 0;
         if (is_arrow) {
             row_count = loader.row_count();
+        } else if (is_csv) {
+            row_count = csv_loader.row_count();
         } else {
             row_count = accessor["row_count"].as<std::int32_t>();
         }
@@ -1155,6 +1173,8 @@ namespace binding {
         data_table.extend(row_count);
         if (is_arrow) {
             loader.fill_table(data_table, index, offset, limit, is_update);
+        } else if (is_csv) {
+            csv_loader.fill_table(data_table, index, offset, limit, is_update);
         } else {
             _fill_data(data_table, accessor, input_schema, index, offset, limit, is_update);
         }
@@ -1369,6 +1389,10 @@ namespace binding {
             view_config->set_column_pivot_depth(config["column_pivot_depth"].as<std::int32_t>());
         }
 
+        if (has_value(config["lazy_aggregates"])) {
+            view_config->set_lazy_aggregates(config["lazy_aggregates"].as<bool>());
+        }
+
         return view_config;
     }
 
@@ -1432,6 +1456,7 @@ namespace binding {
 
         ctx1->init();
         ctx1->sort_by(sortspec);
+        ctx1->set_lazy_aggregates_enabled(view_config->get_lazy_aggregates());
 
         auto pool = table->get_pool();
         auto gnode = table->get_gnode();
@@ -1634,6 +1659,10 @@ EMSCRIPTEN_BINDINGS(perspective) {
         .function("remove_port", &Table::remove_port)
         .function("get_id", &Table::get_id)
         .function("get_pool", &Table::get_pool)
+        .function("get_stats", &Table::get_stats)
+        .function("reset_stats", &Table::reset_stats)
+        .function("set_trace_enabled", &Table::set_trace_enabled)
+        .function("get_trace_json", &Table::get_trace_json)
         .function("get_gnode", &Table::get_gnode);
     /******************************************************************************
      *
@@ -1667,7 +1696,8 @@ EMSCRIPTEN_BINDINGS(perspective) {
         .function("get_sort", &View<t_ctx0>::get_sort)
         .function("get_step_delta", &View<t_ctx0>::get_step_delta)
         .function("get_column_dtype", &View<t_ctx0>::get_column_dtype)
-        .function("is_column_only", &View<t_ctx0>::is_column_only);
+        .function("is_column_only", &View<t_ctx0>::is_column_only)
+        .function("get_stats", &View<t_ctx0>::get_stats);
 
     class_<View<t_ctx1>>("View_ctx1")
         .constructor<
@@ -1698,7 +1728,8 @@ EMSCRIPTEN_BINDINGS(perspective) {
         .function("get_sort", &View<t_ctx1>::get_sort)
         .function("get_step_delta", &View<t_ctx1>::get_step_delta)
         .function("get_column_dtype", &View<t_ctx1>::get_column_dtype)
-        .function("is_column_only", &View<t_ctx1>::is_column_only);
+        .function("is_column_only", &View<t_ctx1>::is_column_only)
+        .function("get_stats", &View<t_ctx1>::get_stats);
 
     class_<View<t_ctx2>>("View_ctx2")
         .constructor<
@@ -1730,7 +1761,8 @@ EMSCRIPTEN_BINDINGS(perspective) {
         .function("get_row_path", &View<t_ctx2>::get_row_path)
         .function("get_step_delta", &View<t_ctx2>::get_step_delta)
         .function("get_column_dtype", &View<t_ctx2>::get_column_dtype)
-        .function("is_column_only", &View<t_ctx2>::is_column_only);
+        .function("is_column_only", &View<t_ctx2>::is_column_only)
+        .function("get_stats", &View<t_ctx2>::get_stats);
 
     /******************************************************************************
      *
@@ -1837,7 +1869,11 @@ EMSCRIPTEN_BINDINGS(perspective) {
         .smart_ptr<std::shared_ptr<t_pool>>("shared_ptr<t_pool>")
         .function("unregister_gnode", &t_pool::unregister_gnode)
         .function("_process", &t_pool::_process)
-        .function("set_update_delegate", &t_pool::set_update_delegate);
+        .function("set_update_delegate", &t_pool::set_update_delegate)
+        .function("get_stats", &t_pool::get_stats)
+        .function("reset_stats", &t_pool::reset_stats)
+        .function("set_trace_enabled", &t_pool::set_trace_enabled)
+        .function("get_trace_json", &t_pool::get_trace_json);
 
     /******************************************************************************
      *
@@ -1897,6 +1933,10 @@ EMSCRIPTEN_BINDINGS(perspective) {
         "std::map<std::string, std::string>");
     register_map<std::string, std::map<std::string, std::string>>(
         "std::map<std::string, std::map<std::string, std::string>>");
+    register_map<std::string, double>(
+        "std::map<std::string, double>");
+    register_map<std::string, std::map<std::string, double>>(
+        "std::map<std::string, std::map<std::string, double>>");
 
     /******************************************************************************
      *
@@ -69,7 +69,11 @@ extract_aggregate(
         case AGGTYPE_JOIN:
         case AGGTYPE_IDENTITY:
         case AGGTYPE_DISTINCT_COUNT:
-        case AGGTYPE_DISTINCT_LEAF: {
+        case AGGTYPE_DISTINCT_LEAF:
+        case AGGTYPE_APPROX_DISTINCT_COUNT:
+        case AGGTYPE_APPROX_MEDIAN:
+        case AGGTYPE_APPROX_P95:
+        case AGGTYPE_APPROX_P99: {
             t_tscalar rval = aggcol->get_scalar(ridx);
             return rval;
         } break;
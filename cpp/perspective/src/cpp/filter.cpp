@@ -9,9 +9,45 @@
 
 #include <perspective/first.h>
 #include <perspective/filter.h>
+#include <cstring>
 
 namespace perspective {
 
+namespace {
+// Writes `value` so that two scalars write the same string exactly when
+// they are equal - `t_tscalar::to_string` keeps only 6 significant digits
+// of a float, so floats are written as their bits.
+void
+write_scalar_signature(std::stringstream& ss, const t_tscalar& value) {
+    ss << "/" << static_cast<std::int32_t>(value.m_type) << "/"
+       << static_cast<std::int32_t>(value.m_status);
+    if (value.m_status != STATUS_VALID)
+        return;
+
+    switch (value.m_type) {
+        case DTYPE_FLOAT64: {
+            double v = value.get<double>();
+            std::uint64_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            ss << ":" << bits;
+        } break;
+        case DTYPE_FLOAT32: {
+            float v = value.get<float>();
+            std::uint32_t bits;
+            std::memcpy(&bits, &v, sizeof(bits));
+            ss << ":" << bits;
+        } break;
+        case DTYPE_TIME: {
+            ss << ":" << value.to_int64();
+        } break;
+        default: {
+            std::string field = value.to_string();
+            ss << ":" << field.size() << ":" << field;
+        } break;
+    }
+}
+} // namespace
+
 t_fterm::t_fterm() {}
 
 t_fterm::t_fterm(const std::string& colname, t_filter_op op, t_tscalar threshold,
@@ -81,6 +117,20 @@ t_fterm::get_expr() const {
     return ss.str();
 }
 
+std::string
+t_fterm::get_signature() const {
+    // Length-prefixed, so that no choice of column name or values can make
+    // two different terms collide.
+    std::stringstream ss;
+    ss << m_colname.size() << ":" << m_colname << "/" << m_op << "/" << m_negated;
+    write_scalar_signature(ss, m_threshold);
+    ss << "/" << m_bag.size();
+    for (const auto& value : m_bag) {
+        write_scalar_signature(ss, value);
+    }
+    return ss.str();
+}
+
 t_filter::t_filter()
     : m_mode(SELECT_MODE_ALL) {}
 
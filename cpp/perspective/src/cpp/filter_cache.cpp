@@ -0,0 +1,143 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/filter_cache.h>
+#include <tsl/hopscotch_set.h>
+#include <map>
+#include <sstream>
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+#include <tbb/parallel_for.h>
+#endif
+
+namespace perspective {
+
+void
+t_filter_cache::build(const std::vector<const t_config*>& configs,
+    const std::vector<const t_data_table*>& tables) {
+    PSP_TRACE_SENTINEL();
+    m_masks.clear();
+
+    struct t_term {
+        std::string m_key;
+        t_filter_op m_combiner;
+        t_fterm m_fterm;
+    };
+
+    // The distinct terms, by the column they filter.
+    std::map<std::string, std::vector<t_term>> columns;
+    tsl::hopscotch_set<std::string> keys;
+
+    for (const t_config* config : configs) {
+        t_filter_op combiner = config->get_combiner();
+        if (!config->has_filters()
+            || (combiner != FILTER_OP_AND && combiner != FILTER_OP_OR)) {
+            continue;
+        }
+
+        for (const auto& fterm : config->get_fterms()) {
+            std::string key = get_term_key(combiner, fterm);
+            if (keys.insert(key).second) {
+                columns[fterm.m_colname].push_back(t_term{key, combiner, fterm});
+            }
+        }
+    }
+
+    if (columns.empty())
+        return;
+
+    std::vector<std::pair<const t_data_table*, const std::vector<t_term>*>> tasks;
+    bool has_objects = false;
+    for (const t_data_table* tbl : tables) {
+        const auto& types = tbl->get_schema().m_types;
+        has_objects
+            = has_objects || std::find(types.begin(), types.end(), DTYPE_OBJECT) != types.end();
+        for (const auto& column : columns) {
+            tasks.push_back(std::make_pair(tbl, &column.second));
+        }
+    }
+
+    std::vector<std::vector<t_mask>> masks(tasks.size());
+    auto evaluate = [&tasks, &masks](t_uindex taskidx) {
+        const t_data_table* tbl = tasks[taskidx].first;
+        for (const t_term& term : *tasks[taskidx].second) {
+            masks[taskidx].push_back(
+                tbl->filter_cpp(term.m_combiner, std::vector<t_fterm>{term.m_fterm}));
+        }
+    };
+
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+    if (tasks.size() > 1 && !has_objects) {
+        tbb::parallel_for(0, int(tasks.size()), 1, [&evaluate](int taskidx) { evaluate(taskidx); });
+    } else {
+        for (t_uindex taskidx = 0, loop_end = tasks.size(); taskidx < loop_end; ++taskidx) {
+            evaluate(taskidx);
+        }
+    }
+#else
+    for (t_uindex taskidx = 0, loop_end = tasks.size(); taskidx < loop_end; ++taskidx) {
+        evaluate(taskidx);
+    }
+#endif
+
+    for (t_uindex taskidx = 0, loop_end = tasks.size(); taskidx < loop_end; ++taskidx) {
+        auto& table_masks = m_masks[tasks[taskidx].first];
+        const auto& terms = *tasks[taskidx].second;
+        for (t_uindex idx = 0, terms_end = terms.size(); idx < terms_end; ++idx) {
+            table_masks[terms[idx].m_key] = std::move(masks[taskidx][idx]);
+        }
+    }
+}
+
+void
+t_filter_cache::clear() {
+    m_masks.clear();
+}
+
+bool
+t_filter_cache::filter(const t_data_table& tbl, const t_config& config, t_mask& mask) const {
+    auto table_masks = m_masks.find(&tbl);
+    if (table_masks == m_masks.end())
+        return false;
+
+    t_filter_op combiner = config.get_combiner();
+    const auto& fterms = config.get_fterms();
+    if (fterms.empty())
+        return false;
+
+    std::vector<const t_mask*> term_masks;
+    term_masks.reserve(fterms.size());
+    for (const auto& fterm : fterms) {
+        auto iter = table_masks->second.find(get_term_key(combiner, fterm));
+        if (iter == table_masks->second.end())
+            return false;
+        term_masks.push_back(&iter->second);
+    }
+
+    t_mask rval = *term_masks[0];
+    for (t_uindex idx = 1, loop_end = term_masks.size(); idx < loop_end; ++idx) {
+        if (combiner == FILTER_OP_AND) {
+            rval &= *term_masks[idx];
+        } else {
+            rval |= *term_masks[idx];
+        }
+    }
+
+    mask = std::move(rval);
+    return true;
+}
+
+std::string
+t_filter_cache::get_term_key(t_filter_op combiner, const t_fterm& fterm) {
+    std::stringstream ss;
+    ss << combiner << "/" << fterm.get_signature();
+    return ss.str();
+}
+
+} // end namespace perspective
@@ -30,6 +30,37 @@ t_ftrav::init() {
     m_index = std::make_shared<std::vector<t_mselem>>();
 }
 
+std::shared_ptr<t_ftrav>
+t_ftrav::clone() const {
+    auto rval = std::make_shared<t_ftrav>();
+    rval->m_sortby = m_sortby;
+    rval->m_index->reserve(m_index->size());
+
+    for (const t_mselem& elem : *m_index) {
+        t_mselem copy(elem);
+        copy.m_pkey = rval->m_symtable.get_interned_tscalar(elem.m_pkey);
+        for (auto& value : copy.m_row) {
+            value = rval->m_symtable.get_interned_tscalar(value);
+        }
+        rval->m_pkeyidx[copy.m_pkey] = rval->m_index->size();
+        rval->m_index->push_back(copy);
+    }
+
+    return rval;
+}
+
+std::string
+t_ftrav::get_sortby_colname(const t_config& config, const t_sortspec& sort) {
+    // maintain backwards compatibility
+    std::string colname;
+    if (sort.m_colname != "") {
+        colname = config.get_sort_by(sort.m_colname);
+    } else {
+        colname = config.col_at(sort.m_agg_index);
+    }
+    return config.get_sort_by(colname);
+}
+
 std::vector<t_tscalar>
 t_ftrav::get_all_pkeys(const std::vector<std::pair<t_uindex, t_uindex>>& cells) const {
     // assumes the code calling this has already validated
@@ -98,18 +129,13 @@ t_ftrav::get_pkey(t_index idx) const {
 void
 t_ftrav::fill_sort_elem(std::shared_ptr<const t_gstate> gstate, const t_config& config,
     t_tscalar pkey, t_mselem& out_elem) {
-    out_elem.m_pkey = pkey;
+    // The traversal may outlive the context that interned `pkey`, if it is
+    // shared between contexts, so it keeps its own copy.
+    out_elem.m_pkey = m_symtable.get_interned_tscalar(pkey);
     t_index sortby_size = m_sortby.size();
     out_elem.m_row.reserve(sortby_size);
     for (const t_sortspec& sort : m_sortby) {
-        // maintain backwards compatibility
-        std::string colname;
-        if (sort.m_colname != "") {
-            colname = config.get_sort_by(sort.m_colname);
-        } else {
-            colname = config.col_at(sort.m_agg_index);
-        }
-        const std::string& sortby_colname = config.get_sort_by(colname);
+        std::string sortby_colname = get_sortby_colname(config, sort);
         out_elem.m_row.push_back(
             m_symtable.get_interned_tscalar(gstate->get(pkey, sortby_colname)));
     }
@@ -122,13 +148,7 @@ t_ftrav::fill_sort_elem(std::shared_ptr<const t_gstate> gstate, const t_config&
     t_index sortby_size = m_sortby.size();
     out_elem.m_row.reserve(sortby_size);
     for (const t_sortspec& sort : m_sortby) {
-        std::string colname;
-        if (sort.m_colname != "") {
-            colname = config.get_sort_by(sort.m_colname);
-        } else {
-            colname = config.col_at(sort.m_agg_index);
-        }
-        const std::string& sortby_colname = config.get_sort_by(colname);
+        std::string sortby_colname = get_sortby_colname(config, sort);
         out_elem.m_row.push_back(
             get_interned_tscalar(row.at(config.get_colidx(sortby_colname))));
     }
@@ -22,6 +22,13 @@
 
 namespace perspective {
 
+namespace {
+
+// `m_arena` slots
+const t_uindex ARENA_SLOT_FLATTENED = 0;
+
+} // namespace
+
 t_tscalar
 calc_delta(t_value_transition trans, t_tscalar oval, t_tscalar nval) {
     return nval.difference(oval);
@@ -77,6 +84,7 @@ t_gnode::init() {
 
     m_gstate = std::make_shared<t_gstate>(m_input_schema, m_output_schema);
     m_gstate->init();
+    m_filter_cache = std::make_shared<t_filter_cache>();
 
     // Create and store the main input port, which is always port 0. The next
     // input port will be port 1, and so on
@@ -257,7 +265,13 @@ t_gnode::_process_table(t_uindex port_id) {
     }
 
     m_was_updated = true;
-    flattened = input_port->get_table()->flatten();
+    {
+        t_stats_timer timer(m_stats, STATS_STAGE_FLATTEN);
+        flattened = m_arena.get_table(
+            ARENA_SLOT_FLATTENED, input_port->get_table()->get_schema());
+        input_port->get_flattened(*flattened);
+        timer.set_rows(flattened->size());
+    }
 
     PSP_GNODE_VERIFY_TABLE(flattened);
     PSP_GNODE_VERIFY_TABLE(get_table());
@@ -266,18 +280,24 @@ t_gnode::_process_table(t_uindex port_id) {
 
     std::vector<t_rlookup> row_lookup(flattened_num_rows);
     t_column* pkey_col = flattened->get_column("psp_pkey").get();
-    
-    for (t_uindex idx = 0; idx < flattened_num_rows; ++idx) {
-        // See if each primary key in flattened already exist in the dataset
-        t_tscalar pkey = pkey_col->get_scalar(idx);
-        row_lookup[idx] = m_gstate->lookup(pkey);
+
+    {
+        t_stats_timer timer(m_stats, STATS_STAGE_LOOKUP, flattened_num_rows);
+        for (t_uindex idx = 0; idx < flattened_num_rows; ++idx) {
+            // See if each primary key in flattened already exist in the dataset
+            t_tscalar pkey = pkey_col->get_scalar(idx);
+            row_lookup[idx] = m_gstate->lookup(pkey);
+        }
     }
 
     // first update - master table is empty
     if (m_gstate->mapping_size() == 0) {
         // Update context from state first - computes columns during update
         _update_contexts_from_state(flattened);
-        m_gstate->update_master_table(flattened.get());
+        {
+            t_stats_timer timer(m_stats, STATS_STAGE_UPDATE_MASTER, flattened_num_rows);
+            m_gstate->update_master_table(flattened.get());
+        }
         m_oports[PSP_PORT_FLATTENED]->set_table(flattened);
         release_inputs();
         release_outputs();
@@ -307,27 +327,33 @@ t_gnode::_process_table(t_uindex port_id) {
     _process_state.m_transitions_data_table = m_oports[PSP_PORT_TRANSITIONS]->get_table();
     _process_state.m_existed_data_table = m_oports[PSP_PORT_EXISTED]->get_table();
     
-    // Add computed columns to transitions_data_table
-    _add_all_computed_columns(
-        _process_state.m_transitions_data_table,
-        DTYPE_UINT8);
-
-    // Recompute values for flattened and m_state->get_table
-    _recompute_all_columns(
-        get_table_sptr(),
-        _process_state.m_flattened_data_table,
-        _process_state.m_lookup);
-
-    // Clear delta, prev, current, transitions, existed on EACH call.
-    _process_state.clear_transitional_data_tables();
-
-    // compute values on transitional tables before reserve
-    _compute_all_columns(
-        {
-            _process_state.m_delta_data_table,
-            _process_state.m_prev_data_table,
-            _process_state.m_current_data_table
-        });
+    {
+        t_stats_timer timer(m_stats, STATS_STAGE_COMPUTED_COLUMNS, flattened_num_rows);
+
+        // Add computed columns to transitions_data_table
+        _add_all_computed_columns(
+            _process_state.m_transitions_data_table,
+            DTYPE_UINT8);
+
+        // Recompute values for flattened and m_state->get_table
+        _recompute_all_columns(
+            get_table_sptr(),
+            _process_state.m_flattened_data_table,
+            _process_state.m_lookup);
+
+        // Clear delta, prev, current, transitions, existed on EACH call.
+        _process_state.clear_transitional_data_tables();
+
+        // compute values on transitional tables before reserve
+        _compute_all_columns(
+            {
+                _process_state.m_delta_data_table,
+                _process_state.m_prev_data_table,
+                _process_state.m_current_data_table
+            });
+    }
+
+    auto process_columns_begin = t_stats::t_clock::now();
 
     // And re-reserved for the amount of data in `flattened`
     _process_state.reserve_transitional_data_tables(flattened_num_rows);
@@ -340,6 +366,19 @@ t_gnode::_process_table(t_uindex port_id) {
 
     // Reconcile column names - only attempt to process valid computed columns
     std::vector<std::string> column_names = get_output_schema().m_columns;
+
+    // Transitional values are only written for columns that some context
+    // reads - the master table is still updated from `flattened` for every
+    // column. Object columns are always processed, as that releases the
+    // references `flattened` holds to unchanged values.
+    std::set<std::string> transitional_columns = _get_transitional_columns();
+    const t_schema& flattened_schema = flattened->get_schema();
+    column_names.erase(std::remove_if(column_names.begin(), column_names.end(),
+                           [&transitional_columns, &flattened_schema](const std::string& cname) {
+                               return transitional_columns.count(cname) == 0
+                                   && flattened_schema.get_dtype(cname) != DTYPE_OBJECT;
+                           }),
+        column_names.end());
     std::vector<std::string> valid_computed_columns;
     valid_computed_columns.reserve(
         m_computed_column_map.m_computed_columns.size());
@@ -426,13 +465,18 @@ t_gnode::_process_table(t_uindex port_id) {
 #ifdef PSP_PARALLEL_FOR
     );
 #endif
-    // After transitional tables are written, compute their values
-    _compute_all_columns(
-        {
-            _process_state.m_delta_data_table,
-            _process_state.m_prev_data_table,
-            _process_state.m_current_data_table
-        });
+    m_stats.record(STATS_STAGE_PROCESS_COLUMNS, process_columns_begin, flattened_num_rows);
+
+    {
+        // After transitional tables are written, compute their values
+        t_stats_timer timer(m_stats, STATS_STAGE_COMPUTED_COLUMNS, flattened_num_rows);
+        _compute_all_columns(
+            {
+                _process_state.m_delta_data_table,
+                _process_state.m_prev_data_table,
+                _process_state.m_current_data_table
+            });
+    }
 
     /**
      * After all columns have been processed (transitional tables written into),
@@ -444,6 +488,7 @@ t_gnode::_process_table(t_uindex port_id) {
      * `OP_DELETE`. If there are any `OP_DELETE`s, the next step returns a
      * new `t_data_table` with the deleted rows masked out.
      */
+    auto update_master_begin = t_stats::t_clock::now();
     std::shared_ptr<t_data_table> flattened_masked;
 
     if (existed_mask.count() == _process_state.m_flattened_data_table->size()) {
@@ -463,6 +508,7 @@ t_gnode::_process_table(t_uindex port_id) {
     #endif
 
     m_gstate->update_master_table(flattened_masked.get());
+    m_stats.record(STATS_STAGE_UPDATE_MASTER, update_master_begin, flattened_num_rows);
 
     #ifdef PSP_GNODE_VERIFY
     {
@@ -585,11 +631,19 @@ t_gnode::process(t_uindex port_id) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "Cannot `process` on an uninited gnode.");
 
+    auto begin = t_stats::t_clock::now();
+    std::uint64_t flattened_rows = m_stats.get_record(STATS_STAGE_FLATTEN).m_rows;
+
     t_process_table_result result = _process_table(port_id);
 
     if (result.m_flattened_data_table) {
         notify_contexts(*result.m_flattened_data_table);
     } 
+
+    if (m_was_updated) {
+        m_stats.record(STATS_STAGE_PROCESS, begin,
+            m_stats.get_record(STATS_STAGE_FLATTEN).m_rows - flattened_rows);
+    }
     
     // Whether the user should be notified - False if process_table exited
     // early, True otherwise.
@@ -652,8 +706,7 @@ t_gnode::promote_column(const std::string& name, t_dtype new_type) {
 
     for (auto& iter : m_input_ports) {
         std::shared_ptr<t_port> input_port = iter.second;
-        std::shared_ptr<t_data_table> input_table = input_port->get_table();
-        input_table->promote_column(name, new_type, 0, false);
+        input_port->promote_column(name, new_type);
     }
 
     m_output_schema.retype_column(name, new_type);
@@ -675,6 +728,7 @@ t_gnode::set_ctx_state(void* ptr) {
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     CTX_T* ctx = static_cast<CTX_T*>(ptr);
     ctx->set_state(m_gstate);
+    ctx->set_filter_cache(m_filter_cache);
 }
 
 void
@@ -682,6 +736,15 @@ t_gnode::_update_contexts_from_state(std::shared_ptr<t_data_table> tbl) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
 
+    // Each shared tree is rebuilt by the first of its contexts, and adopted
+    // by the rest.
+    for (auto& kv : m_shared_trees) {
+        kv.second.m_tree.reset();
+    }
+
+    // Likewise each shared traversal is reset and rebuilt by its owner only.
+    _assign_traversal_owners();
+
     for (auto& kv : m_contexts) {
         auto& ctxh = kv.second;
         switch (ctxh.m_ctx_type) {
@@ -693,7 +756,11 @@ t_gnode::_update_contexts_from_state(std::shared_ptr<t_data_table> tbl) {
             case ONE_SIDED_CONTEXT: {
                 auto ctx = static_cast<t_ctx1*>(ctxh.m_ctx);
                 ctx->reset();
-                update_context_from_state<t_ctx1>(ctx, tbl);
+                if (_share_context_tree(kv.first, ctx)) {
+                    ctx->step_end();
+                } else {
+                    update_context_from_state<t_ctx1>(ctx, tbl);
+                }
             } break;
             case ZERO_SIDED_CONTEXT: {
                 auto ctx = static_cast<t_ctx0*>(ctxh.m_ctx);
@@ -752,6 +819,7 @@ t_gnode::_register_context(const std::string& name, t_ctx_type type, std::int64_
     void* ptr_ = reinterpret_cast<void*>(ptr);
     t_ctx_handle ch(ptr_, type);
     m_contexts[name] = ch;
+    _get_context_stats(ch)->set_trace_enabled(m_stats.get_trace_enabled());
 
     bool should_update = m_gstate->mapping_size() > 0;
 
@@ -780,8 +848,11 @@ t_gnode::_register_context(const std::string& name, t_ctx_type type, std::int64_
             ctx->reset();
             computed_columns = ctx->get_config().get_computed_columns();
             m_computed_column_map.add_computed_columns(computed_columns);
-            if (should_update)
+            if (_share_context_tree(name, ctx)) {
+                ctx->step_end();
+            } else if (should_update) {
                 update_context_from_state<t_ctx1>(ctx, flattened);
+            }
         } break;
         case ZERO_SIDED_CONTEXT: {
             set_ctx_state<t_ctx0>(ptr_);
@@ -789,8 +860,11 @@ t_gnode::_register_context(const std::string& name, t_ctx_type type, std::int64_
             ctx->reset();
             computed_columns = ctx->get_config().get_computed_columns();
             m_computed_column_map.add_computed_columns(computed_columns);
-            if (should_update)
+            if (_share_flat_traversal(ctx)) {
+                ctx->step_end();
+            } else if (should_update) {
                 update_context_from_state<t_ctx0>(ctx, flattened);
+            }
         } break;
         case GROUPED_PKEY_CONTEXT: {
             set_ctx_state<t_ctx0>(ptr_);
@@ -842,6 +916,7 @@ t_gnode::_unregister_context(const std::string& name) {
                 computed_column_names.push_back(std::get<0>(c));
             }
             m_computed_column_map.remove_computed_columns(computed_column_names);
+            _release_context_tree(name);
         } break;
         case ZERO_SIDED_CONTEXT: {
             t_ctx0* ctx = static_cast<t_ctx0*>(ctxh.m_ctx);
@@ -869,23 +944,266 @@ t_gnode::_unregister_context(const std::string& name) {
     m_contexts.erase(name);
 }
 
+bool
+t_gnode::_share_context_tree(const std::string& name, t_ctx1* ctx) {
+    if (ctx->get_deltas_enabled())
+        return false;
+
+    auto key = ctx->get_tree_signature();
+    auto& shared = m_shared_trees[key];
+
+    if (m_shared_tree_keys.find(name) == m_shared_tree_keys.end()) {
+        shared.m_contexts.push_back(name);
+        m_shared_tree_keys[name] = key;
+    }
+
+    if (shared.m_tree && shared.m_tree != ctx->get_tree()) {
+        ctx->set_tree(shared.m_tree);
+        return true;
+    }
+
+    shared.m_tree = ctx->get_tree();
+    return false;
+}
+
+void
+t_gnode::_release_context_tree(const std::string& name) {
+    auto key = m_shared_tree_keys.find(name);
+    if (key == m_shared_tree_keys.end())
+        return;
+
+    auto shared = m_shared_trees.find(key->second);
+    auto& contexts = shared->second.m_contexts;
+    contexts.erase(std::remove(contexts.begin(), contexts.end(), name), contexts.end());
+    if (contexts.empty()) {
+        m_shared_trees.erase(shared);
+    }
+
+    m_shared_tree_keys.erase(key);
+}
+
+void
+t_gnode::unshare_context_tree(const std::string& name) {
+    PSP_TRACE_SENTINEL();
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    auto key = m_shared_tree_keys.find(name);
+    if (key == m_shared_tree_keys.end())
+        return;
+
+    bool is_shared = m_shared_trees[key->second].m_contexts.size() > 1;
+    _release_context_tree(name);
+
+    if (!is_shared)
+        return;
+
+    // Rebuild a private tree from the current state, as `register_context`
+    // would for a new context.
+    t_ctx1* ctx = m_contexts[name].get<t_ctx1>();
+    auto expansion_state = ctx->get_expansion_state();
+    ctx->reset();
+    if (m_gstate->mapping_size() > 0) {
+        update_context_from_state<t_ctx1>(ctx, m_gstate->get_pkeyed_table());
+    }
+    ctx->set_expansion_state(expansion_state);
+}
+
+void
+t_gnode::_assign_traversal_owners() {
+    std::set<const t_ftrav*> owned;
+    for (const auto& kv : m_contexts) {
+        if (kv.second.get_type() != ZERO_SIDED_CONTEXT)
+            continue;
+        auto ctx = kv.second.get<t_ctx0>();
+        ctx->set_traversal_owner(owned.insert(ctx->get_traversal().get()).second);
+    }
+}
+
+std::set<std::string>
+t_gnode::_get_transitional_columns() const {
+    std::set<std::string> rval{"psp_pkey", "psp_op"};
+
+    auto add_config = [&rval](const t_config& config) {
+        for (const auto& piv : config.get_pivots()) {
+            rval.insert(piv.colname());
+            rval.insert(config.get_sort_by(piv.colname()));
+        }
+
+        for (const auto& aggspec : config.get_aggregates()) {
+            for (const auto& dep : aggspec.get_dependencies()) {
+                if (dep.type() == DEPTYPE_COLUMN) {
+                    rval.insert(dep.name());
+                }
+            }
+        }
+
+        for (const auto& fterm : config.get_fterms()) {
+            rval.insert(fterm.m_colname);
+        }
+
+        for (const auto& name : config.get_column_names()) {
+            rval.insert(name);
+        }
+    };
+
+    for (const auto& kv : m_contexts) {
+        const t_ctx_handle& ctxh = kv.second;
+        switch (ctxh.get_type()) {
+            case TWO_SIDED_CONTEXT: {
+                add_config(ctxh.get<t_ctx2>()->get_config());
+            } break;
+            case ONE_SIDED_CONTEXT: {
+                add_config(ctxh.get<t_ctx1>()->get_config());
+            } break;
+            case ZERO_SIDED_CONTEXT: {
+                add_config(ctxh.get<t_ctx0>()->get_config());
+            } break;
+            // Rebuilt from the master table on each update.
+            case GROUPED_PKEY_CONTEXT: break;
+            default: { PSP_COMPLAIN_AND_ABORT("Unexpected context type"); } break;
+        }
+    }
+
+    for (const auto& computed : m_computed_column_map.m_computed_columns) {
+        rval.insert(computed.first);
+        for (const auto& name : std::get<2>(computed.second)) {
+            rval.insert(name);
+        }
+    }
+
+    return rval;
+}
+
+bool
+t_gnode::_share_flat_traversal(t_ctx0* ctx) {
+    auto key = ctx->get_traversal_signature();
+    for (const auto& kv : m_contexts) {
+        if (kv.second.get_type() != ZERO_SIDED_CONTEXT)
+            continue;
+        auto other = kv.second.get<t_ctx0>();
+        if (other != ctx && other->get_traversal_signature() == key) {
+            ctx->set_traversal(other->get_traversal());
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+t_gnode::notify_shared_contexts(
+    const t_data_table& flattened, const std::vector<t_ctx_handle>& ctxhs) {
+    const t_data_table& delta = *(m_oports[PSP_PORT_DELTA]->get_table().get());
+    const t_data_table& prev = *(m_oports[PSP_PORT_PREV]->get_table().get());
+    const t_data_table& current = *(m_oports[PSP_PORT_CURRENT]->get_table().get());
+    const t_data_table& transitions = *(m_oports[PSP_PORT_TRANSITIONS]->get_table().get());
+    const t_data_table& existed = *(m_oports[PSP_PORT_EXISTED]->get_table().get());
+
+    if (ctxhs[0].get_type() == ZERO_SIDED_CONTEXT) {
+        // The traversal's owner comes first, and the rest read through it.
+        for (const auto& ctxh : ctxhs) {
+            notify_context<t_ctx0>(ctxh.get<t_ctx0>(), flattened, delta, prev, current,
+                transitions, existed);
+        }
+        return;
+    }
+
+    t_sparse_tree_update update;
+
+    for (t_uindex idx = 0, loop_end = ctxhs.size(); idx < loop_end; ++idx) {
+        t_ctx1* ctx = ctxhs[idx].get<t_ctx1>();
+        t_stats& stats = ctx->get_stats();
+
+        ctx->step_begin();
+        {
+            // The tree update is charged to the first context only.
+            t_stats_timer timer(stats, STATS_STAGE_NOTIFY, flattened.size());
+            if (idx == 0) {
+                update = ctx->notify_tree(flattened, delta, prev, current, transitions, existed);
+            }
+            ctx->notify_traversal(update);
+        }
+        {
+            t_stats_timer timer(stats, STATS_STAGE_STEP_END);
+            ctx->step_end();
+        }
+    }
+}
+
 void
 t_gnode::notify_contexts(const t_data_table& flattened) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
     psp_log_time(repr() + "notify_contexts.enter");
-    t_index num_ctx = m_contexts.size();
-    std::vector<t_ctx_handle> ctxhvec(num_ctx);
 
-    t_index ctxh_count = 0;
+    // Contexts sharing a tree or traversal are notified together, in
+    // order, as a single group.
+    _assign_traversal_owners();
+
+    auto get_group_key = [this](const std::string& name, const t_ctx_handle& ctxh) {
+        std::stringstream ss;
+        switch (ctxh.get_type()) {
+            case ONE_SIDED_CONTEXT: {
+                auto key = m_shared_tree_keys.find(name);
+                if (key != m_shared_tree_keys.end()) {
+                    ss << "1" << key->second;
+                }
+            } break;
+            case ZERO_SIDED_CONTEXT: {
+                ss << "0" << ctxh.get<t_ctx0>()->get_traversal().get();
+            } break;
+            default: break;
+        }
+        return ss.str();
+    };
+
+    std::vector<std::vector<t_ctx_handle>> ctxhvec;
+    std::map<std::string, t_uindex> shared_groups;
+
     for (std::map<std::string, t_ctx_handle>::const_iterator iter = m_contexts.begin(); iter != m_contexts.end();
          ++iter) {
-        ctxhvec[ctxh_count] = iter->second;
-        ctxh_count++;
+        auto key = get_group_key(iter->first, iter->second);
+        if (!key.empty()) {
+            auto group = shared_groups.find(key);
+            if (group != shared_groups.end()) {
+                ctxhvec[group->second].push_back(iter->second);
+                continue;
+            }
+            shared_groups[key] = ctxhvec.size();
+        }
+        ctxhvec.push_back(std::vector<t_ctx_handle>{iter->second});
+    }
+
+    t_index num_ctx = ctxhvec.size();
+
+    // Each filter term is evaluated once for the update, however many
+    // contexts use it, before any context is notified.
+    std::vector<const t_config*> configs;
+    for (const auto& kv : m_contexts) {
+        const t_ctx_handle& ctxh = kv.second;
+        switch (ctxh.get_type()) {
+            case TWO_SIDED_CONTEXT: {
+                configs.push_back(&ctxh.get<t_ctx2>()->get_config());
+            } break;
+            case ONE_SIDED_CONTEXT: {
+                configs.push_back(&ctxh.get<t_ctx1>()->get_config());
+            } break;
+            case ZERO_SIDED_CONTEXT: {
+                configs.push_back(&ctxh.get<t_ctx0>()->get_config());
+            } break;
+            default: break;
+        }
     }
 
+    m_filter_cache->build(configs,
+        std::vector<const t_data_table*>{m_oports[PSP_PORT_PREV]->get_table().get(),
+            m_oports[PSP_PORT_CURRENT]->get_table().get()});
+
     auto notify_context_helper = [this, &ctxhvec, &flattened](t_index ctxidx) {
-        const t_ctx_handle& ctxh = ctxhvec[ctxidx];
+        if (ctxhvec[ctxidx].size() > 1) {
+            notify_shared_contexts(flattened, ctxhvec[ctxidx]);
+            return;
+        }
+
+        const t_ctx_handle& ctxh = ctxhvec[ctxidx][0];
         switch (ctxh.get_type()) {
             case TWO_SIDED_CONTEXT: {
                 notify_context<t_ctx2>(flattened, ctxh);
@@ -903,20 +1221,86 @@ t_gnode::notify_contexts(const t_data_table& flattened) {
         }
     };
 
-    #ifdef PSP_PARALLEL_FOR
-    tbb::parallel_for(0, int(num_ctx), 1,
-        [&notify_context_helper](int ctxidx)
-    #else
-    for (t_index ctxidx = 0; ctxidx < num_ctx; ++ctxidx)
-    #endif
-        { notify_context_helper(ctxidx); }
-    #ifdef PSP_PARALLEL_FOR
-        );
-    #endif
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+    // Contexts only share read access to `m_gstate` and the output port
+    // tables, so they can be notified on tbb's shared thread pool - unless
+    // they would copy Python objects, whose refcounts need the GIL.
+    const auto& types = m_output_schema.m_types;
+    bool has_objects = std::find(types.begin(), types.end(), DTYPE_OBJECT) != types.end();
+
+    if (num_ctx > 1 && !has_objects) {
+        intern_filter_thresholds(flattened);
+        tbb::parallel_for(0, int(num_ctx), 1,
+            [&notify_context_helper](int ctxidx) { notify_context_helper(ctxidx); });
+        m_filter_cache->clear();
+        psp_log_time(repr() + "notify_contexts.exit");
+        return;
+    }
+#endif
 
+    for (t_index ctxidx = 0; ctxidx < num_ctx; ++ctxidx) {
+        notify_context_helper(ctxidx);
+    }
+
+    m_filter_cache->clear();
     psp_log_time(repr() + "notify_contexts.exit");
 }
 
+void
+t_gnode::intern_filter_thresholds(const t_data_table& flattened) {
+    std::vector<t_fterm> fterms;
+
+    for (const auto& kv : m_contexts) {
+        const t_ctx_handle& ctxh = kv.second;
+        const t_config* config = nullptr;
+
+        switch (ctxh.get_type()) {
+            case TWO_SIDED_CONTEXT: {
+                config = &(ctxh.get<t_ctx2>()->get_config());
+            } break;
+            case ONE_SIDED_CONTEXT: {
+                config = &(ctxh.get<t_ctx1>()->get_config());
+            } break;
+            case ZERO_SIDED_CONTEXT: {
+                config = &(ctxh.get<t_ctx0>()->get_config());
+            } break;
+            case GROUPED_PKEY_CONTEXT: {
+                config = &(ctxh.get<t_ctx_grouped_pkey>()->get_config());
+            } break;
+            default: { PSP_COMPLAIN_AND_ABORT("Unexpected context type"); } break;
+        }
+
+        if (config->get_fmode() != FMODE_SIMPLE_CLAUSES)
+            continue;
+
+        for (const auto& fterm : config->get_fterms()) {
+            if (fterm.m_use_interned)
+                fterms.push_back(fterm);
+        }
+    }
+
+    if (fterms.empty())
+        return;
+
+    std::vector<const t_data_table*> tables{&flattened,
+        m_oports[PSP_PORT_PREV]->get_table().get(),
+        m_oports[PSP_PORT_CURRENT]->get_table().get()};
+
+    for (const t_data_table* tbl : tables) {
+        const t_schema& schema = tbl->get_schema();
+        for (const auto& fterm : fterms) {
+            if (!schema.has_column(fterm.m_colname)
+                || schema.get_dtype(fterm.m_colname) != DTYPE_STR)
+                continue;
+
+            // `filter_cpp` interns through a `const_cast`, which only reads
+            // the vocab once the threshold is already present.
+            auto col = const_cast<t_data_table*>(tbl)->get_column(fterm.m_colname);
+            col->get_interned(fterm.m_threshold.get_char_ptr());
+        }
+    }
+}
+
 /******************************************************************************
  *
  * Computed Column Operations
@@ -1143,6 +1527,63 @@ t_gnode::get_trees() {
     return rval;
 }
 
+t_stats*
+t_gnode::_get_context_stats(const t_ctx_handle& ctxh) const {
+    switch (ctxh.get_type()) {
+        case TWO_SIDED_CONTEXT: {
+            return &(ctxh.get<t_ctx2>()->get_stats());
+        } break;
+        case ONE_SIDED_CONTEXT: {
+            return &(ctxh.get<t_ctx1>()->get_stats());
+        } break;
+        case ZERO_SIDED_CONTEXT: {
+            return &(ctxh.get<t_ctx0>()->get_stats());
+        } break;
+        case GROUPED_PKEY_CONTEXT: {
+            return &(ctxh.get<t_ctx_grouped_pkey>()->get_stats());
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected context type"); } break;
+    }
+    return nullptr;
+}
+
+std::map<std::string, std::map<std::string, double>>
+t_gnode::get_stats() const {
+    std::map<std::string, std::map<std::string, double>> rval;
+    m_stats.summarize("", rval);
+    for (const auto& kv : m_contexts) {
+        _get_context_stats(kv.second)->summarize(kv.first + ".", rval);
+    }
+    return rval;
+}
+
+void
+t_gnode::reset_stats() {
+    m_stats.reset();
+    for (const auto& kv : m_contexts) {
+        _get_context_stats(kv.second)->reset();
+    }
+}
+
+void
+t_gnode::set_trace_enabled(bool enabled) {
+    m_stats.set_trace_enabled(enabled);
+    for (const auto& kv : m_contexts) {
+        _get_context_stats(kv.second)->set_trace_enabled(enabled);
+    }
+}
+
+void
+t_gnode::write_trace_events(std::ostream& os, bool& first) const {
+    m_stats.write_trace_events(os, "gnode " + std::to_string(m_id), m_id, 0, first);
+    // Contexts may be notified in parallel, so give each its own track.
+    t_uindex tid = 1;
+    for (const auto& kv : m_contexts) {
+        _get_context_stats(kv.second)->write_trace_events(os, kv.first, m_id, tid, first);
+        ++tid;
+    }
+}
+
 void
 t_gnode::set_id(t_uindex id) {
     m_id = id;
@@ -1232,6 +1673,12 @@ void
 t_gnode::reset() {
     std::vector<std::string> rval;
 
+    for (auto& kv : m_shared_trees) {
+        kv.second.m_tree.reset();
+    }
+
+    _assign_traversal_owners();
+
     for (const auto& kv : m_contexts) {
         auto ctxh = kv.second;
         switch (ctxh.m_ctx_type) {
@@ -1242,6 +1689,7 @@ t_gnode::reset() {
             case ONE_SIDED_CONTEXT: {
                 auto ctx = reinterpret_cast<t_ctx1*>(ctxh.m_ctx);
                 ctx->reset();
+                _share_context_tree(kv.first, ctx);
             } break;
             case ZERO_SIDED_CONTEXT: {
                 auto ctx = reinterpret_cast<t_ctx0*>(ctxh.m_ctx);
@@ -1262,7 +1710,7 @@ void
 t_gnode::clear_input_ports() {
     for (auto& iter : m_input_ports) {
         std::shared_ptr<t_port> input_port = iter.second;
-        input_port->get_table()->clear();
+        input_port->clear();
     }
 }
 
@@ -36,20 +36,14 @@ t_gstate::init() {
     m_table->init();
     m_pkcol = m_table->get_column("psp_pkey");
     m_opcol = m_table->get_column("psp_op");
+    m_mapping.set_vocab(m_pkcol->_get_vocab());
     m_init = true;
 }
 
 t_rlookup
 t_gstate::lookup(t_tscalar pkey) const {
     t_rlookup rval(0, false);
-
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-
-    if (iter == m_mapping.end())
-        return rval;
-
-    rval.m_idx = iter->second;
-    rval.m_exists = true;
+    rval.m_exists = m_mapping.find(pkey, rval.m_idx);
     return rval;
 }
 
@@ -60,52 +54,62 @@ t_gstate::_mark_deleted(t_uindex idx) {
 
 void
 t_gstate::erase(const t_tscalar& pkey) {
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
+    t_uindex idx;
 
-    if (iter == m_mapping.end()) {
+    if (!m_mapping.erase(pkey, idx)) {
         return;
     }
 
     auto columns = m_table->get_columns();
 
-    t_uindex idx = iter->second;
-
     for (auto c : columns) {
         c->clear(idx);
     }
 
-    m_mapping.erase(iter);
     _mark_deleted(idx);
 }
 
 t_uindex
 t_gstate::lookup_or_create(const t_tscalar& pkey) {
-    auto pkey_ = m_symtable.get_interned_tscalar(pkey);
-    t_mapping::const_iterator iter = m_mapping.find(pkey_);
-
-    if (iter != m_mapping.end()) {
-        return iter->second;
+    t_uindex idx;
+    t_uindex id = 0;
+    bool keyed_by_id = m_mapping.is_keyed_by_id(pkey);
+
+    // String keys are looked up by their id in the vocabulary of `m_pkcol`,
+    // which new rows are written with.
+    if (keyed_by_id) {
+        id = m_pkcol->_get_vocab()->get_interned(pkey.get_char_ptr());
+        if (m_mapping.find_id(id, idx)) {
+            return idx;
+        }
+    } else if (m_mapping.find(pkey, idx)) {
+        return idx;
     }
 
     if (!m_free.empty()) {
         t_free_items::const_iterator iter = m_free.begin();
-        t_uindex idx = *iter;
+        idx = *iter;
         m_free.erase(iter);
-        m_mapping[pkey_] = idx;
-        return idx;
+    } else {
+        idx = m_table->num_rows();
+        if (idx >= m_table->get_capacity() - 1) {
+            m_table->reserve(std::max(
+                idx + 1, static_cast<t_uindex>(m_table->get_capacity() * PSP_TABLE_GROW_RATIO)));
+        }
+
+        m_table->set_size(idx + 1);
+        m_opcol->set_nth<std::uint8_t>(idx, OP_INSERT);
     }
 
-    t_uindex nrows = m_table->num_rows();
-    if (nrows >= m_table->get_capacity() - 1) {
-        m_table->reserve(std::max(
-            nrows + 1, static_cast<t_uindex>(m_table->get_capacity() * PSP_TABLE_GROW_RATIO)));
+    if (keyed_by_id) {
+        m_pkcol->set_nth<t_uindex>(idx, id);
+        m_mapping.set_id(id, idx);
+    } else {
+        m_pkcol->set_scalar(idx, pkey);
+        m_mapping.set(pkey, idx);
     }
 
-    m_table->set_size(nrows + 1);
-    m_opcol->set_nth<std::uint8_t>(nrows, OP_INSERT);
-    m_pkcol->set_scalar(nrows, pkey);
-    m_mapping[pkey_] = nrows;
-    return nrows;
+    return idx;
 }
 
 void
@@ -140,6 +144,7 @@ t_gstate::fill_master_table(const t_data_table* flattened) {
 #endif
     m_pkcol = master_table->get_column("psp_pkey");
     m_opcol = master_table->get_column("psp_op");
+    m_mapping.set_vocab(m_pkcol->_get_vocab());
 
     master_table->set_capacity(flattened->get_capacity());
     master_table->set_size(flattened->size());
@@ -151,10 +156,14 @@ t_gstate::fill_master_table(const t_data_table* flattened) {
 
         switch (op) {
             case OP_INSERT: {
-                // Write new primary keys into `m_mapping`
-                m_mapping[m_symtable.get_interned_tscalar(pkey)] = idx;
+                // Write new primary keys into `m_mapping` - `m_pkcol` is a
+                // clone, so string keys already have their ids in its vocab.
+                if (m_mapping.is_keyed_by_id(pkey)) {
+                    m_mapping.set_id(*(m_pkcol->get_nth<t_uindex>(idx)), idx);
+                } else {
+                    m_mapping.set(pkey, idx);
+                }
                 m_opcol->set_nth<std::uint8_t>(idx, OP_INSERT);
-                m_pkcol->set_scalar(idx, pkey);
             } break;
             case OP_DELETE: {
                 _mark_deleted(idx);
@@ -196,9 +205,8 @@ t_gstate::update_master_table(const t_data_table* flattened) {
                 // Lookup/create the row index in `m_table` based on pkey
                 master_table_indexes[idx] = lookup_or_create(pkey);
 
-                // Write the op and pkey to `m_table`
+                // Write the op to `m_table`
                 m_opcol->set_nth<std::uint8_t>(master_table_indexes[idx], OP_INSERT);
-                m_pkcol->set_scalar(master_table_indexes[idx], pkey);
             } break;
             case OP_DELETE: {
                 // Actually erase the specified pkey from the master table here
@@ -336,10 +344,10 @@ void
 t_gstate::pprint() const {
     std::vector<t_uindex> indices(m_mapping.size());
     t_uindex idx = 0;
-    for (t_mapping::const_iterator iter = m_mapping.begin(); iter != m_mapping.end(); ++iter) {
-        indices[idx] = iter->second;
+    m_mapping.for_each([&indices, &idx](const t_tscalar& pkey, t_uindex ridx) {
+        indices[idx] = ridx;
         ++idx;
-    }
+    });
     m_table->pprint(indices);
 }
 
@@ -347,9 +355,7 @@ t_mask
 t_gstate::get_cpp_mask() const {
     t_uindex sz = m_table->size();
     t_mask msk(sz);
-    for (t_mapping::const_iterator iter = m_mapping.begin(); iter != m_mapping.end(); ++iter) {
-        msk.set(iter->second, true);
-    }
+    m_mapping.for_each([&msk](const t_tscalar& pkey, t_uindex ridx) { msk.set(ridx, true); });
     return msk;
 }
 
@@ -372,9 +378,9 @@ t_gstate::read_column(const std::string& colname, const std::vector<t_tscalar>&
     std::vector<t_tscalar> rval(num);
 
     for (t_index idx = 0; idx < num; ++idx) {
-        t_mapping::const_iterator iter = m_mapping.find(pkeys[idx]);
-        if (iter != m_mapping.end()) {
-            rval[idx].set(col_->get_scalar(iter->second));
+        t_uindex ridx;
+        if (m_mapping.find(pkeys[idx], ridx)) {
+            rval[idx].set(col_->get_scalar(ridx));
         }
     }
 
@@ -396,9 +402,9 @@ t_gstate::read_column(const std::string& colname, const std::vector<t_tscalar>&
 
     std::vector<double> rval;
     for (t_index idx = 0; idx < num; ++idx) {
-        t_mapping::const_iterator iter = m_mapping.find(pkeys[idx]);
-        if (iter != m_mapping.end()) {
-            auto tscalar = col_->get_scalar(iter->second);
+        t_uindex ridx;
+        if (m_mapping.find(pkeys[idx], ridx)) {
+            auto tscalar = col_->get_scalar(ridx);
             if (include_nones || tscalar.is_valid()) {
                 rval.push_back(tscalar.to_double());
             }
@@ -409,10 +415,10 @@ t_gstate::read_column(const std::string& colname, const std::vector<t_tscalar>&
 
 t_tscalar
 t_gstate::get(t_tscalar pkey, const std::string& colname) const {
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-    if (iter != m_mapping.end()) {
+    t_uindex ridx;
+    if (m_mapping.find(pkey, ridx)) {
         std::shared_ptr<const t_column> col = m_table->get_const_column(colname);
-        return col->get_scalar(iter->second);
+        return col->get_scalar(ridx);
     }
 
     return t_tscalar();
@@ -423,10 +429,9 @@ t_gstate::get_row(t_tscalar pkey) const {
     auto columns = m_table->get_const_columns();
     std::vector<t_tscalar> rval(columns.size());
 
-    t_mapping::const_iterator iter = m_mapping.find(pkey);
-    PSP_VERBOSE_ASSERT(iter != m_mapping.end(), "Reached end");
-
-    t_uindex ridx = iter->second;
+    t_uindex ridx = 0;
+    bool exists = m_mapping.find(pkey, ridx);
+    PSP_VERBOSE_ASSERT(exists, "Reached end");
     t_uindex idx = 0;
 
     for (auto c : columns) {
@@ -444,9 +449,9 @@ t_gstate::is_unique(
     value = mknone();
 
     for (const auto& pkey : pkeys) {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter != m_mapping.end()) {
-            auto tmp = col_->get_scalar(iter->second);
+        t_uindex ridx;
+        if (m_mapping.find(pkey, ridx)) {
+            auto tmp = col_->get_scalar(ridx);
             if (!value.is_none() && value != tmp)
                 return false;
             value = tmp;
@@ -465,9 +470,9 @@ t_gstate::apply(const std::vector<t_tscalar>& pkeys, const std::string& colname,
     value = mknone();
 
     for (const auto& pkey : pkeys) {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter != m_mapping.end()) {
-            auto tmp = col_->get_scalar(iter->second);
+        t_uindex ridx;
+        if (m_mapping.find(pkey, ridx)) {
+            auto tmp = col_->get_scalar(ridx);
             bool done = fn(tmp, value);
             if (done) {
                 value = tmp;
@@ -488,13 +493,14 @@ t_dtype
 t_gstate::get_pkey_dtype() const {
     if (m_mapping.empty())
         return DTYPE_STR;
-    auto iter = m_mapping.begin();
-    return iter->first.get_dtype();
+    return m_mapping.get_pkey_dtype();
 }
 
 std::shared_ptr<t_data_table>
 t_gstate::get_sorted_pkeyed_table() const {
-    std::map<t_tscalar, t_uindex> ordered(m_mapping.begin(), m_mapping.end());
+    std::map<t_tscalar, t_uindex> ordered;
+    m_mapping.for_each(
+        [&ordered](const t_tscalar& pkey, t_uindex ridx) { ordered[pkey] = ridx; });
     auto sch = m_input_schema.drop({"psp_op"});
     auto rv = std::make_shared<t_data_table>(sch, 0);
     rv->init();
@@ -614,19 +620,19 @@ t_gstate::_get_pkeyed_table(const t_schema& schema, const t_mask& mask) const {
         }
 
         t_uindex oidx = 0;
-        for (const auto& kv : m_mapping) {
-            if (mask.get(kv.second)) {
-                order[oidx] = std::make_pair(kv.first, mapping[kv.second]);
+        m_mapping.for_each([&order, &oidx, &mask, &mapping](const t_tscalar& pkey, t_uindex ridx) {
+            if (mask.get(ridx)) {
+                order[oidx] = std::make_pair(pkey, mapping[ridx]);
                 ++oidx;
             }
-        }
+        });
     } else // enable_pkeyed_table_mask_fix
     {
         t_uindex oidx = 0;
-        for (const auto& kv : m_mapping) {
-            order[oidx] = kv;
+        m_mapping.for_each([&order, &oidx](const t_tscalar& pkey, t_uindex ridx) {
+            order[oidx] = std::make_pair(pkey, ridx);
             ++oidx;
-        }
+        });
     }
 
     std::sort(order.begin(), order.end(),
@@ -691,12 +697,12 @@ t_gstate::get_row_data_pkeys(const std::vector<t_tscalar>& pkeys) const {
     auto none = mknone();
 
     for (const auto& pkey : pkeys) {
-        t_mapping::const_iterator iter = m_mapping.find(pkey);
-        if (iter == m_mapping.end())
+        t_uindex ridx;
+        if (!m_mapping.find(pkey, ridx))
             continue;
 
         for (t_uindex cidx = 0; cidx < ncols; ++cidx) {
-            auto v = columns[cidx]->get_scalar(iter->second);
+            auto v = columns[cidx]->get_scalar(ridx);
             if (v.is_valid()) {
                 rval.push_back(v);
             } else {
@@ -709,7 +715,7 @@ t_gstate::get_row_data_pkeys(const std::vector<t_tscalar>& pkeys) const {
 
 bool
 t_gstate::has_pkey(t_tscalar pkey) const {
-    return m_mapping.find(pkey) != m_mapping.end();
+    return m_mapping.contains(pkey);
 }
 
 std::vector<t_tscalar>
@@ -722,7 +728,7 @@ t_gstate::has_pkeys(const std::vector<t_tscalar>& pkeys) const {
 
     for (const auto& p : pkeys) {
         t_tscalar tval;
-        tval.set(m_mapping.find(p) != m_mapping.end());
+        tval.set(m_mapping.contains(p));
         rval[idx].set(tval);
         ++idx;
     }
@@ -734,10 +740,10 @@ std::vector<t_tscalar>
 t_gstate::get_pkeys() const {
     std::vector<t_tscalar> rval(m_mapping.size());
     t_uindex idx = 0;
-    for (const auto& kv : m_mapping) {
-        rval[idx].set(kv.first);
+    m_mapping.for_each([&rval, &idx](const t_tscalar& pkey, t_uindex ridx) {
+        rval[idx].set(pkey);
         ++idx;
-    }
+    });
     return rval;
 }
 
@@ -771,7 +777,9 @@ t_gstate::mapping_size() const {
 void
 t_gstate::reset() {
     m_table->reset();
-    m_mapping.clear();
+    m_pkcol = m_table->get_column("psp_pkey");
+    m_opcol = m_table->get_column("psp_op");
+    m_mapping.set_vocab(m_pkcol->_get_vocab());
     m_free.clear();
 }
 
@@ -781,9 +789,9 @@ t_gstate::get_value(const t_tscalar& pkey, const std::string& colname) const {
     const t_column* col_ = col.get();
     t_tscalar rval = mknone();
 
-    auto iter = m_mapping.find(pkey);
-    if (iter != m_mapping.end()) {
-        rval.set(col_->get_scalar(iter->second));
+    t_uindex ridx;
+    if (m_mapping.find(pkey, ridx)) {
+        rval.set(col_->get_scalar(ridx));
     }
 
     return rval;
@@ -0,0 +1,217 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/pkey_mapping.h>
+#include <algorithm>
+
+namespace perspective {
+
+t_pkey_mapping::t_pkey_mapping()
+    : m_dense(true)
+    , m_dense_dtype(DTYPE_NONE)
+    , m_base(0)
+    , m_size(0)
+    , m_vocab(nullptr) {}
+
+void
+t_pkey_mapping::set_vocab(t_vocab* vocab) {
+    clear();
+    m_vocab = vocab;
+}
+
+void
+t_pkey_mapping::set_id(t_uindex id, t_uindex idx) {
+    if (m_dense_dtype != DTYPE_STR) {
+        m_dense_dtype = DTYPE_STR;
+        m_base = 0;
+        m_rows.clear();
+    }
+
+    if (id >= m_rows.size()) {
+        m_rows.resize(id + 1, PSP_PKEY_MAPPING_ABSENT);
+    }
+
+    if (m_rows[id] == PSP_PKEY_MAPPING_ABSENT) {
+        ++m_size;
+    }
+
+    m_rows[id] = idx;
+}
+
+void
+t_pkey_mapping::set(const t_tscalar& pkey, t_uindex idx) {
+    if (is_keyed_by_id(pkey)) {
+        set_id(m_vocab->get_interned(pkey.get_char_ptr()), idx);
+        return;
+    }
+
+    if (m_dense && m_size == 0) {
+        t_dtype dtype = pkey.get_dtype();
+        if ((dtype == DTYPE_INT64 || dtype == DTYPE_INT32) && pkey.m_status == STATUS_VALID) {
+            m_dense_dtype = dtype;
+            m_base = get_dense_key(pkey);
+            m_rows.clear();
+        } else {
+            to_sparse();
+        }
+    }
+
+    if (m_dense && (!is_dense_key(pkey) || !reserve_dense(get_dense_key(pkey)))) {
+        to_sparse();
+    }
+
+    if (!m_dense) {
+        m_map[m_symtable.get_interned_tscalar(pkey)] = idx;
+        return;
+    }
+
+    t_uindex offset = get_dense_offset(pkey);
+    if (m_rows[offset] == PSP_PKEY_MAPPING_ABSENT) {
+        ++m_size;
+    }
+
+    m_rows[offset] = idx;
+}
+
+bool
+t_pkey_mapping::erase(const t_tscalar& pkey, t_uindex& idx) {
+    if (!m_dense) {
+        auto iter = m_map.find(pkey);
+        if (iter == m_map.end())
+            return false;
+        idx = iter->second;
+        m_map.erase(iter);
+        return true;
+    }
+
+    if (!is_dense_key(pkey))
+        return false;
+
+    t_uindex offset = get_dense_offset(pkey);
+    if (offset >= m_rows.size() || m_rows[offset] == PSP_PKEY_MAPPING_ABSENT)
+        return false;
+
+    // A string keeps its id in the vocabulary, in case it is added back.
+    idx = m_rows[offset];
+    m_rows[offset] = PSP_PKEY_MAPPING_ABSENT;
+    --m_size;
+
+    // Twice as sparse as `set` allows, so that erasing one key from an array
+    // `set` just filled does not move every key into the hash map.
+    if (m_dense_dtype != DTYPE_STR && m_size > 0
+        && m_rows.size()
+            > 2 * std::max(PSP_DENSE_PKEY_MIN_SPAN, PSP_DENSE_PKEY_SPARSITY * m_size)) {
+        to_sparse();
+    }
+
+    return true;
+}
+
+void
+t_pkey_mapping::clear() {
+    m_dense = true;
+    m_dense_dtype = DTYPE_NONE;
+    m_base = 0;
+    m_rows.clear();
+    m_size = 0;
+    m_map.clear();
+}
+
+t_uindex
+t_pkey_mapping::size() const {
+    return m_dense ? m_size : m_map.size();
+}
+
+bool
+t_pkey_mapping::empty() const {
+    return size() == 0;
+}
+
+bool
+t_pkey_mapping::is_dense() const {
+    return m_dense;
+}
+
+t_dtype
+t_pkey_mapping::get_pkey_dtype() const {
+    PSP_VERBOSE_ASSERT(!empty(), "Empty mapping has no pkey dtype");
+    return m_dense ? m_dense_dtype : m_map.begin()->first.get_dtype();
+}
+
+t_tscalar
+t_pkey_mapping::get_string_key(t_uindex id) const {
+    t_tscalar rval;
+    rval.set(m_vocab->unintern_c(id));
+    return rval;
+}
+
+t_tscalar
+t_pkey_mapping::make_dense_key(std::int64_t key) const {
+    t_tscalar rval;
+    if (m_dense_dtype == DTYPE_INT64) {
+        rval.set(key);
+    } else {
+        rval.set(static_cast<std::int32_t>(key));
+    }
+    return rval;
+}
+
+bool
+t_pkey_mapping::reserve_dense(std::int64_t key) {
+    t_uindex max_span = std::max(PSP_DENSE_PKEY_MIN_SPAN, PSP_DENSE_PKEY_SPARSITY * (m_size + 1));
+
+    if (key >= m_base) {
+        std::uint64_t offset = static_cast<std::uint64_t>(key) - static_cast<std::uint64_t>(m_base);
+        if (offset < m_rows.size())
+            return true;
+
+        if (offset >= max_span)
+            return false;
+
+        m_rows.resize(offset + 1, PSP_PKEY_MAPPING_ABSENT);
+        return true;
+    }
+
+    std::uint64_t shift = static_cast<std::uint64_t>(m_base) - static_cast<std::uint64_t>(key);
+    if (shift >= max_span || shift + m_rows.size() > max_span)
+        return false;
+
+    // Leave as much room again below `key`, so that keys arriving in
+    // descending order move the array a logarithmic number of times -
+    // though never so much that erasing a key would leave it too sparse.
+    std::uint64_t span = shift + m_rows.size();
+    std::uint64_t room = std::max(PSP_DENSE_PKEY_MIN_SPAN, PSP_DENSE_PKEY_SPARSITY * m_size);
+    std::int64_t lowest = m_dense_dtype == DTYPE_INT64 ? std::numeric_limits<std::int64_t>::min()
+                                                       : std::numeric_limits<std::int32_t>::min();
+    std::uint64_t slack = room > span ? std::min(span, room - span) : 0;
+    slack = std::min(slack, static_cast<std::uint64_t>(key) - static_cast<std::uint64_t>(lowest));
+
+    m_rows.insert(m_rows.begin(), shift + slack, PSP_PKEY_MAPPING_ABSENT);
+    m_base = static_cast<std::int64_t>(static_cast<std::uint64_t>(key) - slack);
+    return true;
+}
+
+void
+t_pkey_mapping::to_sparse() {
+    if (!m_dense)
+        return;
+
+    // String keys point into the vocabulary, which may move them
+    m_map.reserve(m_size);
+    for_each([this](const t_tscalar& pkey, t_uindex idx) {
+        m_map[m_symtable.get_interned_tscalar(pkey)] = idx;
+    });
+
+    m_dense = false;
+    std::vector<t_uindex>().swap(m_rows);
+    m_size = 0;
+}
+
+} // end namespace perspective
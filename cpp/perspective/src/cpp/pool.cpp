@@ -15,6 +15,7 @@
 #include <perspective/env_vars.h>
 #include <thread>
 #include <chrono>
+#include <sstream>
 
 namespace perspective {
 
@@ -331,6 +332,55 @@ t_pool::get_gnodes_last_updated() {
     return rv;
 }
 
+std::map<std::string, std::map<std::string, double>>
+t_pool::get_stats() {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    std::map<std::string, std::map<std::string, double>> rv;
+
+    for (t_uindex idx = 0, loop_end = m_gnodes.size(); idx < loop_end; ++idx) {
+        if (!m_gnodes[idx])
+            continue;
+
+        std::string prefix = "gnode_" + std::to_string(idx) + ".";
+        for (const auto& kv : m_gnodes[idx]->get_stats()) {
+            rv[prefix + kv.first] = kv.second;
+        }
+    }
+    return rv;
+}
+
+void
+t_pool::reset_stats() {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    for (auto& g : m_gnodes) {
+        if (g)
+            g->reset_stats();
+    }
+}
+
+void
+t_pool::set_trace_enabled(bool enabled) {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    for (auto& g : m_gnodes) {
+        if (g)
+            g->set_trace_enabled(enabled);
+    }
+}
+
+std::string
+t_pool::get_trace_json() {
+    std::lock_guard<std::mutex> lg(m_mtx);
+    std::stringstream ss;
+    bool first = true;
+    ss << "{\"traceEvents\":[";
+    for (auto& g : m_gnodes) {
+        if (g)
+            g->write_trace_events(ss, first);
+    }
+    ss << "],\"displayTimeUnit\":\"ns\"}";
+    return ss.str();
+}
+
 t_gnode*
 t_pool::get_gnode(t_uindex idx) {
     std::lock_guard<std::mutex> lg(m_mtx);
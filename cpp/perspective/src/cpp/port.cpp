@@ -12,11 +12,19 @@
 
 namespace perspective {
 
+t_port_staged_rows::t_port_staged_rows()
+    : m_delete_idx(0)
+    , m_insert_idx(0)
+    , m_has_delete(false)
+    , m_has_insert(false) {}
+
 t_port::t_port(t_port_mode mode, const t_schema& schema)
-    : m_schema(schema)
+    : m_mode(mode)
+    , m_schema(schema)
     , m_init(false)
     , m_table(nullptr)
-    , m_prevsize(0) {
+    , m_prevsize(0)
+    , m_coalesced(true) {
     LOG_CONSTRUCTOR("t_port");
 }
 
@@ -28,6 +36,7 @@ t_port::init() {
     m_table = std::make_shared<t_data_table>(
         "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
     m_table->init();
+    reset_staged();
     m_init = true;
 }
 
@@ -40,16 +49,183 @@ void
 t_port::set_table(std::shared_ptr<t_data_table> table) {
     m_table = nullptr;
     m_table = table;
+    reset_staged();
+
+    // Rows in a table set from outside the port are not staged.
+    m_coalesced = m_table->size() == 0;
 }
 
 void
 t_port::send(std::shared_ptr<const t_data_table> table) {
-    m_table->append(*table.get());
+    send(*table.get());
 }
 
 void
 t_port::send(const t_data_table& table) {
+    if (m_coalesced && can_coalesce(table)) {
+        coalesce(table);
+        return;
+    }
+
     m_table->append(table);
+    m_coalesced = false;
+}
+
+bool
+t_port::can_coalesce(const t_data_table& table) const {
+    if (m_mode != PORT_MODE_PKEYED || table.size() > PSP_PORT_COALESCE_MAX_ROWS)
+        return false;
+
+    // Python objects are reference counted as they are written into the
+    // table, so overwriting a staged object in place would leak it.
+    for (const auto& cname : table.get_schema().m_columns) {
+        if (table.get_dtype(cname) == DTYPE_OBJECT)
+            return false;
+    }
+
+    return true;
+}
+
+void
+t_port::coalesce(const t_data_table& table) {
+    t_uindex num_rows = table.size();
+    if (num_rows == 0)
+        return;
+
+    const t_schema& schema = table.get_schema();
+    const t_column* pkey_col = table.get_const_column("psp_pkey").get();
+    const t_column* op_col = table.get_const_column("psp_op").get();
+
+    t_uindex base = m_table->size();
+
+    // Rows of `table` that open a new staged row, in order.
+    std::vector<t_uindex> appended;
+
+    // (row in `table`, row in `m_table`) pairs whose valid cells are written
+    // over an already staged insert, in arrival order.
+    std::vector<std::pair<t_uindex, t_uindex>> overwrites;
+
+    for (t_uindex idx = 0; idx < num_rows; ++idx) {
+        t_tscalar pkey = m_symtable->get_interned_tscalar(pkey_col->get_scalar(idx));
+        t_op op = static_cast<t_op>(*(op_col->get_nth<std::uint8_t>(idx)));
+        t_port_staged_rows& staged = m_staged[pkey];
+
+        switch (op) {
+            case OP_INSERT: {
+                if (staged.m_has_insert) {
+                    overwrites.push_back(std::make_pair(idx, staged.m_insert_idx));
+                } else {
+                    staged.m_insert_idx = base + appended.size();
+                    staged.m_has_insert = true;
+                    appended.push_back(idx);
+                }
+            } break;
+            case OP_DELETE: {
+                // A delete discards everything staged for the pkey before it;
+                // the discarded insert row is left behind in `m_table` but is
+                // no longer referenced by `m_staged`.
+                staged.m_has_insert = false;
+                if (!staged.m_has_delete) {
+                    staged.m_delete_idx = base + appended.size();
+                    staged.m_has_delete = true;
+                    appended.push_back(idx);
+                }
+            } break;
+            default: { PSP_COMPLAIN_AND_ABORT("Unknown OP"); }
+        }
+    }
+
+    if (!appended.empty()) {
+        m_table->extend(base + appended.size());
+
+        for (const auto& cname : schema.m_columns) {
+            m_table->get_column(cname)->copy(
+                table.get_const_column(cname).get(), appended, base);
+        }
+    }
+
+    for (const auto& cname : schema.m_columns) {
+        if (cname == "psp_pkey" || cname == "psp_op")
+            continue;
+
+        const t_column* scol = table.get_const_column(cname).get();
+        t_column* dcol = m_table->get_column(cname).get();
+
+        for (const auto& overwrite : overwrites) {
+            if (*(scol->get_nth_status(overwrite.first)) == STATUS_INVALID)
+                continue;
+            dcol->set_scalar(overwrite.second, scol->get_scalar(overwrite.first));
+        }
+    }
+}
+
+void
+t_port::get_flattened(t_data_table& flattened) const {
+    if (!m_coalesced) {
+        m_table->flatten(flattened);
+        return;
+    }
+
+    std::vector<std::pair<t_tscalar, const t_port_staged_rows*>> staged;
+    staged.reserve(m_staged.size());
+
+    for (const auto& kv : m_staged) {
+        staged.push_back(std::make_pair(kv.first, &kv.second));
+    }
+
+    // Only the distinct staged primary keys are sorted, rather than every
+    // row sent to the port. String pkeys are sorted by their id in the
+    // staging table's vocab, as `t_data_table::flatten` sorts them.
+    const t_column* pkey_col = m_table->get_const_column("psp_pkey").get();
+    if (pkey_col->get_dtype() == DTYPE_STR) {
+        auto pkey_id = [pkey_col](const t_port_staged_rows* rows) {
+            t_uindex idx = rows->m_has_delete ? rows->m_delete_idx : rows->m_insert_idx;
+            return *(pkey_col->get_nth<t_uindex>(idx));
+        };
+
+        std::sort(staged.begin(), staged.end(),
+            [&pkey_id](const std::pair<t_tscalar, const t_port_staged_rows*>& a,
+                const std::pair<t_tscalar, const t_port_staged_rows*>& b) {
+                return pkey_id(a.second) < pkey_id(b.second);
+            });
+    } else {
+        std::sort(staged.begin(), staged.end(),
+            [](const std::pair<t_tscalar, const t_port_staged_rows*>& a,
+                const std::pair<t_tscalar, const t_port_staged_rows*>& b) {
+                return a.first < b.first;
+            });
+    }
+
+    std::vector<t_uindex> indices;
+    indices.reserve(staged.size() * 2);
+
+    for (const auto& kv : staged) {
+        if (kv.second->m_has_delete) {
+            indices.push_back(kv.second->m_delete_idx);
+        }
+
+        if (kv.second->m_has_insert) {
+            indices.push_back(kv.second->m_insert_idx);
+        }
+    }
+
+    flattened.extend(indices.size());
+
+    // Columns may have been promoted since `m_schema` was set.
+    for (const auto& cname : m_table->get_schema().m_columns) {
+        flattened.get_column(cname)->copy(
+            m_table->get_const_column(cname).get(), indices, 0);
+    }
+}
+
+void
+t_port::promote_column(const std::string& name, t_dtype new_type) {
+    m_table->promote_column(name, new_type, 0, false);
+
+    // Staged keys were interned with the previous pkey type.
+    if (name == "psp_pkey" && m_table->size() > 0) {
+        m_coalesced = false;
+    }
 }
 
 t_schema
@@ -70,6 +246,7 @@ t_port::release()
     m_table = std::make_shared<t_data_table>(
         "", "", m_schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
     m_table->init();
+    reset_staged();
 
     m_prevsize = size;
 }
@@ -83,10 +260,14 @@ t_port::release_or_clear()
 
     t_uindex size = m_table->size();
 
-    if (static_cast<double>(size) < 0.4 * double(m_prevsize)) {
-        m_table->clear();
-    } else {
+    // Keep the staging table's storage for the next update, unless this
+    // update was far larger than the one before it.
+    if (static_cast<double>(size) > 4.0 * double(m_prevsize)) {
         release();
+    } else {
+        m_table->clear();
+        m_table->clear_vocabularies();
+        reset_staged();
     }
 
     m_prevsize = size;
@@ -98,6 +279,14 @@ t_port::clear() {
         return;
     
     m_table->clear();
+    reset_staged();
+}
+
+void
+t_port::reset_staged() {
+    m_staged.clear();
+    m_symtable.reset(new t_symtable());
+    m_coalesced = true;
 }
 
 } // end namespace perspective
@@ -0,0 +1,336 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/sketch.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace perspective {
+
+namespace {
+
+// 2^12 registers, for a standard error of 1.04 / sqrt(4096), about 1.6%
+const std::uint32_t HLL_PRECISION = 12;
+const std::uint32_t HLL_REGISTERS = 1 << HLL_PRECISION;
+
+// A sparse sketch takes 4 bytes per set register, a dense one 1 byte per
+// register.
+const t_uindex HLL_SPARSE_MAX = HLL_REGISTERS / 4;
+
+// Bounds the number of centroids a digest keeps to about this many.
+const double TDIGEST_COMPRESSION = 100;
+const t_uindex TDIGEST_BUFFER_SIZE = 5 * TDIGEST_COMPRESSION;
+
+// `hash_value` does not mix its low bits into its high ones, which pick
+// the register.
+std::uint64_t
+mix_hash(std::uint64_t hash) {
+    hash += 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+    return hash ^ (hash >> 31);
+}
+
+} // namespace
+
+t_hll::t_hll() {}
+
+void
+t_hll::add(const t_tscalar& value) {
+    add_hash(mix_hash(hash_value(value)));
+}
+
+void
+t_hll::add_hash(std::uint64_t hash) {
+    std::uint32_t idx = static_cast<std::uint32_t>(hash >> (64 - HLL_PRECISION));
+
+    // The guard bit bounds the rank at 64 - HLL_PRECISION + 1.
+    std::uint64_t rest = (hash << HLL_PRECISION) | (1ULL << (HLL_PRECISION - 1));
+    std::uint8_t rank = 1;
+    while (!(rest & (1ULL << 63))) {
+        rest <<= 1;
+        ++rank;
+    }
+
+    set_register(idx, rank);
+}
+
+std::uint8_t
+t_hll::get_register(std::uint32_t idx) const {
+    if (!m_registers.empty()) {
+        return m_registers[idx];
+    }
+
+    auto iter = std::lower_bound(m_sparse.begin(), m_sparse.end(), idx,
+        [](std::uint32_t entry, std::uint32_t idx) { return (entry >> 8) < idx; });
+
+    if (iter != m_sparse.end() && (*iter >> 8) == idx) {
+        return *iter & 0xff;
+    }
+
+    return 0;
+}
+
+void
+t_hll::set_register(std::uint32_t idx, std::uint8_t rank) {
+    if (!m_registers.empty()) {
+        m_registers[idx] = std::max(m_registers[idx], rank);
+        return;
+    }
+
+    auto iter = std::lower_bound(m_sparse.begin(), m_sparse.end(), idx,
+        [](std::uint32_t entry, std::uint32_t idx) { return (entry >> 8) < idx; });
+
+    if (iter != m_sparse.end() && (*iter >> 8) == idx) {
+        if ((*iter & 0xff) < rank) {
+            *iter = (idx << 8) | rank;
+        }
+        return;
+    }
+
+    m_sparse.insert(iter, (idx << 8) | rank);
+    if (m_sparse.size() > HLL_SPARSE_MAX) {
+        to_dense();
+    }
+}
+
+void
+t_hll::to_dense() {
+    m_registers.assign(HLL_REGISTERS, 0);
+    for (auto entry : m_sparse) {
+        m_registers[entry >> 8] = entry & 0xff;
+    }
+
+    std::vector<std::uint32_t>().swap(m_sparse);
+}
+
+void
+t_hll::merge(const t_hll& other) {
+    if (other.m_registers.empty()) {
+        for (auto entry : other.m_sparse) {
+            set_register(entry >> 8, entry & 0xff);
+        }
+        return;
+    }
+
+    if (m_registers.empty()) {
+        to_dense();
+    }
+
+    for (std::uint32_t idx = 0; idx < HLL_REGISTERS; ++idx) {
+        m_registers[idx] = std::max(m_registers[idx], other.m_registers[idx]);
+    }
+}
+
+bool
+t_hll::covers(const t_hll& other) const {
+    if (other.m_registers.empty()) {
+        for (auto entry : other.m_sparse) {
+            if (get_register(entry >> 8) < (entry & 0xff)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    for (std::uint32_t idx = 0; idx < HLL_REGISTERS; ++idx) {
+        if (get_register(idx) < other.m_registers[idx]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+t_hll::clear() {
+    std::vector<std::uint32_t>().swap(m_sparse);
+    std::vector<std::uint8_t>().swap(m_registers);
+}
+
+double
+t_hll::estimate() const {
+    double m = HLL_REGISTERS;
+    double sum = 0;
+    t_uindex zeros = 0;
+
+    if (m_registers.empty()) {
+        zeros = HLL_REGISTERS - m_sparse.size();
+        sum = zeros;
+        for (auto entry : m_sparse) {
+            sum += std::ldexp(1.0, -static_cast<int>(entry & 0xff));
+        }
+    } else {
+        for (auto rank : m_registers) {
+            sum += std::ldexp(1.0, -static_cast<int>(rank));
+            zeros += rank == 0;
+        }
+    }
+
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double raw = alpha * m * m / sum;
+
+    // Linear counting is the more accurate while registers remain unset.
+    if (raw <= 2.5 * m && zeros > 0) {
+        return m * std::log(m / zeros);
+    }
+
+    return raw;
+}
+
+t_tdigest::t_tdigest()
+    : m_min(std::numeric_limits<double>::infinity())
+    , m_max(-std::numeric_limits<double>::infinity()) {}
+
+void
+t_tdigest::add(double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+
+    add_centroid(t_centroid(value, 1));
+}
+
+void
+t_tdigest::add_centroid(const t_centroid& centroid) {
+    m_min = std::min(m_min, centroid.first);
+    m_max = std::max(m_max, centroid.first);
+    m_buffer.push_back(centroid);
+    if (m_buffer.size() >= TDIGEST_BUFFER_SIZE) {
+        compress();
+    }
+}
+
+void
+t_tdigest::merge(const t_tdigest& other) {
+    for (const auto& centroid : other.m_centroids) {
+        add_centroid(centroid);
+    }
+
+    for (const auto& centroid : other.m_buffer) {
+        add_centroid(centroid);
+    }
+
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+void
+t_tdigest::clear() {
+    std::vector<t_centroid>().swap(m_centroids);
+    std::vector<t_centroid>().swap(m_buffer);
+    m_min = std::numeric_limits<double>::infinity();
+    m_max = -std::numeric_limits<double>::infinity();
+}
+
+void
+t_tdigest::compress() {
+    if (m_buffer.empty()) {
+        return;
+    }
+
+    m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+    std::sort(m_buffer.begin(), m_buffer.end());
+
+    double total = 0;
+    for (const auto& centroid : m_buffer) {
+        total += centroid.second;
+    }
+
+    // Neighbouring centroids merge while their combined weight stays within
+    // 4 * total * q * (1 - q) / compression at both ends of the span they
+    // cover, so that centroids near the tails stay small.
+    std::vector<t_centroid> centroids;
+    t_centroid current = m_buffer[0];
+    double weight_before = 0;
+
+    for (t_uindex idx = 1, loop_end = m_buffer.size(); idx < loop_end; ++idx) {
+        const t_centroid& next = m_buffer[idx];
+        double proposed = current.second + next.second;
+        double q0 = weight_before / total;
+        double q2 = (weight_before + proposed) / total;
+        double limit = 4 * total * std::min(q0 * (1 - q0), q2 * (1 - q2)) / TDIGEST_COMPRESSION;
+
+        if (proposed <= limit) {
+            current.first += (next.first - current.first) * next.second / proposed;
+            current.second = proposed;
+        } else {
+            weight_before += current.second;
+            centroids.push_back(current);
+            current = next;
+        }
+    }
+
+    centroids.push_back(current);
+    std::swap(m_centroids, centroids);
+    m_buffer.clear();
+}
+
+bool
+t_tdigest::empty() const {
+    return m_centroids.empty() && m_buffer.empty();
+}
+
+double
+t_tdigest::quantile(double q) const {
+    if (!m_buffer.empty()) {
+        t_tdigest compressed(*this);
+        compressed.compress();
+        return compressed.quantile(q);
+    }
+
+    if (m_centroids.empty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    if (m_centroids.size() == 1) {
+        return m_centroids[0].first;
+    }
+
+    double total = 0;
+    for (const auto& centroid : m_centroids) {
+        total += centroid.second;
+    }
+
+    // Each centroid's mean sits at the middle of its weight - interpolate
+    // between neighbouring means, and between the outer means and the
+    // extremes.
+    double target = std::max(0.0, std::min(1.0, q)) * total;
+    const t_centroid& first = m_centroids.front();
+    const t_centroid& last = m_centroids.back();
+
+    if (target < first.second / 2) {
+        return m_min + (first.first - m_min) * target / (first.second / 2);
+    }
+
+    if (target > total - last.second / 2) {
+        return m_max - (m_max - last.first) * (total - target) / (last.second / 2);
+    }
+
+    double weight_before = 0;
+    for (t_uindex idx = 0, loop_end = m_centroids.size() - 1; idx < loop_end; ++idx) {
+        const t_centroid& left = m_centroids[idx];
+        const t_centroid& right = m_centroids[idx + 1];
+        double left_center = weight_before + left.second / 2;
+        double right_center = weight_before + left.second + right.second / 2;
+
+        if (target <= right_center) {
+            double t = (target - left_center) / (right_center - left_center);
+            return left.first + t * (right.first - left.first);
+        }
+
+        weight_before += left.second;
+    }
+
+    return last.first;
+}
+
+} // end namespace perspective
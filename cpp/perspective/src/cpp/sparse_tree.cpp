@@ -28,9 +28,160 @@
 #include <perspective/filter_utils.h>
 #include <perspective/context_two.h>
 #include <set>
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+#include <tbb/parallel_for.h>
+#endif
 
 namespace perspective {
 
+namespace {
+
+// `t_stree::m_arena` slots
+const t_uindex ARENA_SLOT_STRANDS = 0;
+const t_uindex ARENA_SLOT_AGGS = 1;
+
+// The strands of a strand table that share a path, as the node of a
+// `t_dtree` over it would group them.
+struct t_strand_group {
+    t_uindex m_pidx;
+    t_depth m_depth;
+    t_tscalar m_value;
+    t_uindex m_first_row;
+    std::vector<t_uindex> m_rows;
+    std::map<t_tscalar, t_uindex> m_children;
+};
+
+// Sum `icolumn` into `ocolumn` for each group, as `t_aggimpl_sum` would -
+// reducing the rows of each leaf group, and rolling up the children of
+// the rest. Children are always grouped after their parents.
+template <typename RAW_DATA_T, typename ROLLING_T>
+void
+sum_strand_groups(
+    const std::vector<t_strand_group>& groups, const t_column& icolumn, t_column& ocolumn) {
+    for (t_uindex gidx = groups.size(); gidx-- > 0;) {
+        const t_strand_group& group = groups[gidx];
+        ROLLING_T value = 0;
+
+        for (auto ridx : group.m_rows) {
+            value += *(icolumn.get_nth<RAW_DATA_T>(ridx));
+        }
+
+        for (const auto& child : group.m_children) {
+            value += *(ocolumn.get_nth<ROLLING_T>(child.second));
+        }
+
+        ocolumn.set_nth<ROLLING_T>(gidx, value);
+    }
+}
+
+bool
+is_summable_dtype(t_dtype dtype) {
+    switch (dtype) {
+        case DTYPE_INT64:
+        case DTYPE_INT32:
+        case DTYPE_INT16:
+        case DTYPE_INT8:
+        case DTYPE_UINT64:
+        case DTYPE_UINT32:
+        case DTYPE_UINT16:
+        case DTYPE_UINT8:
+        case DTYPE_FLOAT64:
+        case DTYPE_FLOAT32:
+        case DTYPE_BOOL: {
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+void
+sum_strand_groups(
+    const std::vector<t_strand_group>& groups, const t_column& icolumn, t_column& ocolumn) {
+    switch (icolumn.get_dtype()) {
+        case DTYPE_INT64: {
+            sum_strand_groups<std::int64_t, std::int64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_INT32: {
+            sum_strand_groups<std::int32_t, std::int64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_INT16: {
+            sum_strand_groups<std::int16_t, std::int64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_INT8: {
+            sum_strand_groups<std::int8_t, std::int64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_UINT64: {
+            sum_strand_groups<std::uint64_t, std::uint64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_UINT32: {
+            sum_strand_groups<std::uint32_t, std::uint64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_UINT16: {
+            sum_strand_groups<std::uint16_t, std::uint64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_BOOL:
+        case DTYPE_UINT8: {
+            sum_strand_groups<std::uint8_t, std::uint64_t>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_FLOAT64: {
+            sum_strand_groups<double, double>(groups, icolumn, ocolumn);
+        } break;
+        case DTYPE_FLOAT32: {
+            sum_strand_groups<float, double>(groups, icolumn, ocolumn);
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unexpected dtype"); }
+    }
+}
+
+bool
+is_sketch_agg(t_aggtype agg) {
+    switch (agg) {
+        case AGGTYPE_APPROX_DISTINCT_COUNT:
+        case AGGTYPE_APPROX_MEDIAN:
+        case AGGTYPE_APPROX_P95:
+        case AGGTYPE_APPROX_P99: {
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+double
+get_sketch_quantile(t_aggtype agg) {
+    switch (agg) {
+        case AGGTYPE_APPROX_MEDIAN: {
+            return 0.5;
+        }
+        case AGGTYPE_APPROX_P95: {
+            return 0.95;
+        }
+        case AGGTYPE_APPROX_P99: {
+            return 0.99;
+        }
+        default: { PSP_COMPLAIN_AND_ABORT("Not a quantile aggregate"); }
+    }
+
+    return 0;
+}
+
+// How the current update changes the sketches of a node - rebuilt from
+// scratch, by merging those of its `m_changed` children, or by adding the
+// values of newly added pkeys.
+struct t_sketch_update {
+    t_sketch_update()
+        : m_rebuild(false)
+        , m_changed(false) {}
+
+    bool m_rebuild;
+    bool m_changed;
+    std::vector<t_uindex> m_children;
+    std::vector<t_tscalar> m_pkeys;
+};
+
+} // end anonymous namespace
+
 t_tscalar
 get_dominant(std::vector<t_tscalar>& values) {
     if (values.empty())
@@ -79,9 +230,14 @@ t_stree::t_stree(const std::vector<t_pivot>& pivots, const std::vector<t_aggspec
     , m_schema(schema)
     , m_cur_aggidx(1)
     , m_minmax(aggspecs.size())
-    , m_has_delta(false) {
+    , m_has_delta(false)
+    , m_has_sketches(false) {
     auto g_agg_str = cfg.get_grand_agg_str();
     m_grand_agg_str = g_agg_str.empty() ? "Grand Aggregate" : g_agg_str;
+
+    for (const auto& spec : aggspecs) {
+        m_has_sketches |= is_sketch_agg(spec.agg());
+    }
 }
 
 t_stree::~t_stree() {
@@ -104,13 +260,12 @@ t_stree::repr() const {
 
 void
 t_stree::init() {
-    m_nodes = std::make_shared<t_treenodes>();
-    m_idxpkey = std::make_shared<t_idxpkey>();
-    m_idxleaf = std::make_shared<t_idxleaf>();
+    m_nodes.clear();
+    m_members.clear();
 
     t_tscalar value = m_symtable.get_interned_tscalar(m_grand_agg_str.c_str());
     t_tnode node(0, root_pidx(), value, 0, value, 1, 0);
-    m_nodes->insert(node);
+    m_nodes.insert(node);
 
     std::vector<std::string> columns;
     std::vector<t_dtype> dtypes;
@@ -132,6 +287,8 @@ t_stree::init() {
     m_aggregates->set_size(capacity);
 
     m_aggcols = std::vector<const t_column*>(columns.size());
+    m_hlls = std::vector<std::vector<t_hll>>(columns.size());
+    m_tdigests = std::vector<std::vector<t_tdigest>>(columns.size());
 
     for (t_uindex idx = 0, loop_end = columns.size(); idx < loop_end; ++idx) {
         m_aggcols[idx] = m_aggregates->get_const_column(columns[idx]).get();
@@ -144,16 +301,12 @@ t_stree::init() {
 
 t_tscalar
 t_stree::get_value(t_index idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Reached end iterator");
-    return iter->m_value;
+    return m_nodes.get_value(idx);
 }
 
 t_tscalar
 t_stree::get_sortby_value(t_index idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Reached end iterator");
-    return iter->m_sort_value;
+    return m_nodes.get_sort_value(idx);
 }
 
 void
@@ -306,20 +459,24 @@ t_stree::build_strand_table_common(const t_data_table& flattened,
 std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>>
 t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& delta,
     const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
-    const std::vector<t_aggspec>& aggspecs, const t_config& config) const {
+    const std::vector<t_aggspec>& aggspecs, const t_config& config, const t_mask* prev_mask,
+    const t_mask* curr_mask) {
 
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
 
     auto rv = build_strand_table_common(flattened, aggspecs, config);
 
+    if (m_has_sketches) {
+        record_sketch_changes(flattened, prev, current, aggspecs);
+    }
+
     // strand table
-    std::shared_ptr<t_data_table> strands = std::make_shared<t_data_table>(rv.m_strand_schema);
-    strands->init();
+    std::shared_ptr<t_data_table> strands
+        = m_arena.get_table(ARENA_SLOT_STRANDS, rv.m_strand_schema);
 
     // strand table
-    std::shared_ptr<t_data_table> aggs = std::make_shared<t_data_table>(rv.m_aggschema);
-    aggs->init();
+    std::shared_ptr<t_data_table> aggs = m_arena.get_table(ARENA_SLOT_AGGS, rv.m_aggschema);
 
     std::shared_ptr<const t_column> pkey_col = flattened.get_const_column("psp_pkey");
     std::shared_ptr<const t_column> op_col = flattened.get_const_column("psp_op");
@@ -368,19 +525,26 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
 
     t_column* spkey = strands->get_column("psp_pkey").get();
 
+    bool has_filters = config.has_filters();
+
     t_mask msk_prev, msk_curr;
 
-    if (config.has_filters()) {
-        msk_prev = filter_table_for_config(prev, config);
-        msk_curr = filter_table_for_config(current, config);
-    }
+    if (has_filters) {
+        if (!prev_mask) {
+            msk_prev = filter_table_for_config(prev, config);
+            prev_mask = &msk_prev;
+        }
 
-    bool has_filters = config.has_filters();
+        if (!curr_mask) {
+            msk_curr = filter_table_for_config(current, config);
+            curr_mask = &msk_curr;
+        }
+    }
 
     if (has_filters) {
         for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
-            bool filter_prev = msk_prev.get(idx);
-            bool filter_curr = msk_curr.get(idx);
+            bool filter_prev = prev_mask->get(idx);
+            bool filter_curr = curr_mask->get(idx);
 
             t_tscalar pkey = pkey_col->get_scalar(idx);
             std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
@@ -453,19 +617,19 @@ t_stree::build_strand_table(const t_data_table& flattened, const t_data_table& d
 // notably pivot changed rows will be added
 std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>>
 t_stree::build_strand_table(const t_data_table& flattened,
-    const std::vector<t_aggspec>& aggspecs, const t_config& config) const {
+    const std::vector<t_aggspec>& aggspecs, const t_config& config, const t_mask* mask) {
     PSP_TRACE_SENTINEL();
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
 
     auto rv = build_strand_table_common(flattened, aggspecs, config);
+    m_sketch_changed_pkeys.clear();
 
     // strand table
-    std::shared_ptr<t_data_table> strands = std::make_shared<t_data_table>(rv.m_strand_schema);
-    strands->init();
+    std::shared_ptr<t_data_table> strands
+        = m_arena.get_table(ARENA_SLOT_STRANDS, rv.m_strand_schema);
 
     // strand table
-    std::shared_ptr<t_data_table> aggs = std::make_shared<t_data_table>(rv.m_aggschema);
-    aggs->init();
+    std::shared_ptr<t_data_table> aggs = m_arena.get_table(ARENA_SLOT_AGGS, rv.m_aggschema);
 
     std::shared_ptr<const t_column> pkey_col = flattened.get_const_column("psp_pkey");
 
@@ -505,16 +669,17 @@ t_stree::build_strand_table(const t_data_table& flattened,
 
     t_column* spkey = strands->get_column("psp_pkey").get();
 
+    bool has_filters = config.has_filters();
+
     t_mask msk;
 
-    if (config.has_filters()) {
+    if (has_filters && !mask) {
         msk = filter_table_for_config(flattened, config);
+        mask = &msk;
     }
 
-    bool has_filters = config.has_filters();
-
     for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
-        bool filter = !has_filters || msk.get(idx);
+        bool filter = !has_filters || mask->get(idx);
         t_tscalar pkey = pkey_col->get_scalar(idx);
         std::uint8_t op_ = *(op_col->get_nth<std::uint8_t>(idx));
         t_op op = static_cast<t_op>(op_);
@@ -549,6 +714,43 @@ t_stree::build_strand_table(const t_data_table& flattened,
         strands, aggs);
 }
 
+void
+t_stree::record_sketch_changes(const t_data_table& flattened, const t_data_table& prev,
+    const t_data_table& current, const std::vector<t_aggspec>& aggspecs) {
+    m_sketch_changed_pkeys.clear();
+
+    // Compared by value, as a column left out of a partial update reads as
+    // cleared in the transitions.
+    std::vector<std::pair<const t_column*, const t_column*>> cols;
+    for (const auto& spec : aggspecs) {
+        if (is_sketch_agg(spec.agg())) {
+            const std::string& colname = spec.get_dependencies()[0].name();
+            cols.emplace_back(prev.get_const_column(colname).get(),
+                current.get_const_column(colname).get());
+        }
+    }
+
+    std::shared_ptr<const t_column> pkey_col = flattened.get_const_column("psp_pkey");
+    std::shared_ptr<const t_column> op_col = flattened.get_const_column("psp_op");
+
+    for (t_uindex idx = 0, loop_end = flattened.size(); idx < loop_end; ++idx) {
+        if (static_cast<t_op>(*(op_col->get_nth<std::uint8_t>(idx))) == OP_DELETE) {
+            continue;
+        }
+
+        for (const auto& col : cols) {
+            t_tscalar prev_value = col.first->get_scalar(idx);
+            t_tscalar cur_value = col.second->get_scalar(idx);
+            if (prev_value.is_valid() != cur_value.is_valid()
+                || (cur_value.is_valid() && prev_value != cur_value)) {
+                m_sketch_changed_pkeys.insert(
+                    m_symtable.get_interned_tscalar(pkey_col->get_scalar(idx)));
+                break;
+            }
+        }
+    }
+}
+
 bool
 t_stree::pivots_changed(t_value_transition t) const {
 
@@ -558,12 +760,16 @@ t_stree::pivots_changed(t_value_transition t) const {
 
 void
 t_stree::populate_pkey_idx(const t_dtree_ctx& ctx, const t_dtree& dtree, t_uindex dptidx,
-    t_uindex sptidx, t_uindex ndepth, t_idxpkey& new_idx_pkey) {
+    t_uindex sptidx, t_uindex ndepth) {
     if (ndepth == dtree.last_level()) {
         auto pkey_col = ctx.get_pkey_col();
         auto strand_count_col = ctx.get_strand_count_col();
         auto liters = ctx.get_leaf_iterators(dptidx);
 
+        std::vector<t_tscalar> added;
+        std::vector<t_tscalar> removed;
+        bool changed = false;
+
         for (auto lfiter = liters.first; lfiter != liters.second; ++lfiter) {
 
             auto lfidx = *lfiter;
@@ -571,24 +777,311 @@ t_stree::populate_pkey_idx(const t_dtree_ctx& ctx, const t_dtree& dtree, t_uinde
             auto strand_count = *(strand_count_col->get_nth<std::int8_t>(lfidx));
 
             if (strand_count > 0) {
-                t_stpkey s(sptidx, pkey);
-                new_idx_pkey.insert(s);
+                added.push_back(pkey);
             }
 
             if (strand_count < 0) {
-                remove_pkey(sptidx, pkey);
+                removed.push_back(pkey);
+            }
+
+            changed |= strand_count == 0 && m_sketch_changed_pkeys.count(pkey) > 0;
+        }
+
+        if (m_has_sketches) {
+            record_sketch_update(sptidx, added, removed, changed);
+        }
+
+        m_members.update_pkeys(sptidx, added, removed);
+    }
+}
+
+void
+t_stree::record_sketch_update(t_uindex sptidx, const std::vector<t_tscalar>& added,
+    const std::vector<t_tscalar>& removed, bool changed) {
+    // A pkey removed and added back was changed in place, and one added
+    // again is only new to the sketches if its sketched values changed.
+    bool lost = false;
+    if (!removed.empty()) {
+        tsl::hopscotch_set<t_tscalar, t_stvalue_hash, t_stvalue_equal> readded(
+            added.begin(), added.end());
+        for (const auto& pkey : removed) {
+            if (readded.count(pkey) == 0) {
+                lost = true;
+                break;
+            }
+        }
+    }
+
+    std::vector<t_tscalar> appended;
+    for (const auto& pkey : added) {
+        if (!m_members.has_pkey(sptidx, pkey)) {
+            appended.push_back(pkey);
+        } else if (m_sketch_changed_pkeys.count(pkey) > 0) {
+            changed = true;
+        }
+    }
+
+    // Values cannot be taken back out of a sketch, so a leaf which lost a
+    // pkey is rebuilt, along with every ancestor - marked now, as the leaf
+    // may be dropped before the aggregates are updated. A leaf which changed
+    // a pkey is rebuilt too, but its ancestors may only need to merge it.
+    if (lost) {
+        m_sketch_appends.erase(sptidx);
+        m_sketch_changes.erase(sptidx);
+        for (t_uindex nidx = sptidx, rpidx = root_pidx(); nidx != rpidx;
+             nidx = m_nodes.get_parent(nidx)) {
+            if (!m_sketch_rebuilds.insert(nidx).second) {
+                break;
             }
         }
+    } else if (m_sketch_rebuilds.find(sptidx) != m_sketch_rebuilds.end()) {
+        return;
+    } else if (changed) {
+        m_sketch_appends.erase(sptidx);
+        m_sketch_changes.insert(sptidx);
+    } else if (!appended.empty() && m_sketch_changes.find(sptidx) == m_sketch_changes.end()) {
+        auto& pkeys = m_sketch_appends[sptidx];
+        pkeys.insert(pkeys.end(), appended.begin(), appended.end());
     }
 }
 
 void
-t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
+t_stree::update_sketches(const t_agg_update_info& info, const t_gstate& gstate) {
+    std::vector<t_uindex> columns;
+    for (t_uindex idx : info.m_dst_topo_sorted) {
+        if (is_sketch_agg(info.m_aggspecs[idx].agg())) {
+            columns.push_back(idx);
+            m_hlls[idx].resize(m_cur_aggidx);
+            m_tdigests[idx].resize(m_cur_aggidx);
+        }
+    }
+
+    t_uindex rpidx = root_pidx();
+    tsl::hopscotch_map<t_uindex, t_sketch_update> updates;
+
+    for (auto nidx : m_sketch_rebuilds) {
+        updates[nidx].m_rebuild = true;
+    }
+
+    for (auto nidx : m_newids) {
+        updates[nidx].m_rebuild = true;
+    }
+
+    for (auto lfidx : m_sketch_changes) {
+        if (!m_nodes.exists(lfidx)) {
+            continue;
+        }
+
+        updates[lfidx].m_changed = true;
+        for (t_uindex cidx = lfidx, ancidx = m_nodes.get_parent(lfidx); ancidx != rpidx;
+             cidx = ancidx, ancidx = m_nodes.get_parent(ancidx)) {
+            auto& update = updates[ancidx];
+            update.m_children.push_back(cidx);
+            if (update.m_changed) {
+                break;
+            }
+
+            update.m_changed = true;
+        }
+    }
+
+    for (const auto& appended : m_sketch_appends) {
+        if (!m_nodes.exists(appended.first)) {
+            continue;
+        }
+
+        for (t_uindex ancidx = appended.first; ancidx != rpidx;
+             ancidx = m_nodes.get_parent(ancidx)) {
+            auto& update = updates[ancidx];
+            if (!update.m_rebuild) {
+                update.m_pkeys.insert(
+                    update.m_pkeys.end(), appended.second.begin(), appended.second.end());
+            }
+        }
+    }
+
+    // Deepest first, so children are rebuilt before their parents merge them.
+    std::vector<std::pair<t_uindex, t_uindex>> nodes;
+    nodes.reserve(updates.size());
+    for (const auto& update : updates) {
+        if (m_nodes.exists(update.first)) {
+            nodes.emplace_back(m_nodes.get_depth(update.first), update.first);
+        }
+    }
+
+    std::sort(nodes.begin(), nodes.end(), std::greater<std::pair<t_uindex, t_uindex>>());
+
+    std::vector<t_tscalar> values;
+    std::vector<double> numbers;
+    t_hll previous;
+
+    for (auto idx : columns) {
+        const t_aggspec& spec = info.m_aggspecs[idx];
+        const std::string& colname = spec.get_dependencies()[0].name();
+        bool is_hll = spec.agg() == AGGTYPE_APPROX_DISTINCT_COUNT;
+
+        // The ancestors of changed leaves whose distinct count sketches lost
+        // a register, which must be rebuilt from their children.
+        tsl::hopscotch_set<t_uindex> shrunk;
+
+        for (const auto& node : nodes) {
+            t_uindex nidx = node.second;
+            t_uindex aggidx = m_nodes.get_aggidx(nidx);
+            const t_sketch_update& update = updates.find(nidx)->second;
+            bool leaf = is_leaf(nidx);
+
+            // A t-digest cannot tell whether a changed child's old values
+            // still count, so its ancestors are always rebuilt.
+            bool rebuild = update.m_rebuild
+                || (update.m_changed && (leaf || !is_hll || shrunk.count(nidx) > 0));
+            bool merge_children = rebuild && !leaf;
+            const std::vector<t_tscalar>& pkeys
+                = rebuild ? m_members.get_pkeys(nidx) : update.m_pkeys;
+
+            if (is_hll) {
+                t_hll& hll = m_hlls[idx][aggidx];
+                bool fold = update.m_changed && !update.m_rebuild;
+
+                if (fold && leaf) {
+                    previous = hll;
+                }
+
+                if (rebuild) {
+                    hll.clear();
+                }
+
+                if (merge_children) {
+                    for (auto cidx : m_nodes.get_children(nidx)) {
+                        hll.merge(m_hlls[idx][m_nodes.get_aggidx(cidx)]);
+                    }
+                } else {
+                    // The changed children's sketches only gained registers.
+                    if (fold && !leaf) {
+                        for (auto cidx : update.m_children) {
+                            hll.merge(m_hlls[idx][m_nodes.get_aggidx(cidx)]);
+                        }
+                    }
+
+                    gstate.read_column(colname, pkeys, values);
+                    for (const auto& value : values) {
+                        hll.add(value);
+                    }
+                }
+
+                if (fold && leaf && !hll.covers(previous)) {
+                    for (t_uindex ancidx = m_nodes.get_parent(nidx); ancidx != rpidx;
+                         ancidx = m_nodes.get_parent(ancidx)) {
+                        if (!shrunk.insert(ancidx).second) {
+                            break;
+                        }
+                    }
+                }
+            } else {
+                t_tdigest& digest = m_tdigests[idx][aggidx];
 
+                if (rebuild) {
+                    digest.clear();
+                }
+
+                if (merge_children) {
+                    for (auto cidx : m_nodes.get_children(nidx)) {
+                        digest.merge(m_tdigests[idx][m_nodes.get_aggidx(cidx)]);
+                    }
+                } else {
+                    gstate.read_column(colname, pkeys, numbers, false);
+                    for (auto number : numbers) {
+                        digest.add(number);
+                    }
+                }
+
+                digest.compress();
+            }
+        }
+    }
+
+    m_sketch_appends.clear();
+    m_sketch_rebuilds.clear();
+    m_sketch_changes.clear();
+}
+
+void
+t_stree::begin_shape_update(t_index root_nstrands) {
     m_newids.clear();
     m_newleaves.clear();
     m_tree_unification_records.clear();
+    m_sketch_appends.clear();
+    m_sketch_rebuilds.clear();
+    m_sketch_changes.clear();
+
+    root_nstrands += m_nodes.get_nstrands(0);
+    m_nodes.set_nstrands(0, root_nstrands);
+
+    t_tree_unify_rec unif_rec(0, 0, 0, root_nstrands);
+    m_tree_unification_records.push_back(unif_rec);
+}
+
+t_index
+t_stree::update_child_shape(t_uindex pidx, const t_tscalar& value,
+    const t_tscalar& sortby_value, t_depth depth, bool is_leaf, std::int64_t nstrands,
+    t_uindex src_ridx) {
+    t_index existing = m_nodes.find_child(pidx, value);
+
+    if (existing == INVALID_INDEX && nstrands < 0) {
+        return INVALID_INDEX;
+    }
+
+    if (existing == INVALID_INDEX) {
+        // create node and enqueue
+        t_uindex sptidx = genidx();
+        t_uindex aggsize = m_aggregates->size();
+        if (sptidx == aggsize) {
+            double scale = 1.3;
+            t_uindex new_size = scale * aggsize;
+            m_aggregates->extend(new_size);
+        }
+
+        t_uindex dst_ridx = gen_aggidx();
+
+        t_tnode node(sptidx, pidx, value, depth, sortby_value, nstrands, dst_ridx);
+
+        m_newids.insert(sptidx);
+
+        if (is_leaf) {
+            m_newleaves.insert(sptidx);
+        }
+
+        bool inserted = m_nodes.insert(node);
+        if (!inserted) {
+            std::cout << "failed to insert " << node << std::endl;
+        }
+        PSP_VERBOSE_ASSERT(inserted, "Failed to insert node");
+        t_tree_unify_rec unif_rec(sptidx, src_ridx, dst_ridx, nstrands);
+        m_tree_unification_records.push_back(unif_rec);
+        return sptidx;
+    }
+
+    // update node
+    m_nodes.set_sort_value(existing, sortby_value);
+
+    t_uindex dst_ridx = m_nodes.get_aggidx(existing);
+
+    nstrands = m_nodes.get_nstrands(existing) + nstrands;
+
+    t_tree_unify_rec unif_rec(existing, src_ridx, dst_ridx, nstrands);
+    m_tree_unification_records.push_back(unif_rec);
+
+    m_nodes.set_nstrands(existing, nstrands);
+    return existing;
+}
+
+void
+t_stree::end_shape_update() {
+    mark_zero_desc();
+    m_nodes.sort_children();
+}
 
+void
+t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
     const std::shared_ptr<const t_column> scount
         = ctx.get_aggtable().get_const_column("psp_strand_count_sum");
 
@@ -601,23 +1094,14 @@ t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
     t_filter filter;
 
     // update root
-    auto root_iter = m_nodes->get<by_idx>().find(0);
-    auto root_node = *root_iter;
-    t_index root_nstrands = *(scount->get_nth<t_index>(0)) + root_node.m_nstrands;
-    root_node.set_nstrands(root_nstrands);
-    m_nodes->get<by_idx>().replace(root_iter, root_node);
-
-    t_tree_unify_rec unif_rec(0, 0, 0, root_nstrands);
-    m_tree_unification_records.push_back(unif_rec);
-
-    t_idxpkey new_idx_pkey;
+    begin_shape_update(*(scount->get_nth<t_index>(0)));
 
     for (auto dptidx : dtree.dfs()) {
-        t_uindex sptidx = 0;
+        t_index sptidx = 0;
         t_depth ndepth = dtree.get_depth(dptidx);
 
         if (dptidx == 0) {
-            populate_pkey_idx(ctx, dtree, dptidx, sptidx, ndepth, new_idx_pkey);
+            populate_pkey_idx(ctx, dtree, dptidx, sptidx, ndepth);
             continue;
         }
 
@@ -629,109 +1113,254 @@ t_stree::update_shape_from_static(const t_dtree_ctx& ctx) {
         t_tscalar sortby_value
             = m_symtable.get_interned_tscalar(dtree.get_sortby_value(filter, dptidx));
 
-        t_uindex src_ridx = dptidx;
-
-        auto iter = m_nodes->get<by_pidx_hash>().find(std::make_tuple(p_sptidx, value));
-
         auto nstrands = *(scount->get_nth<std::int64_t>(dptidx));
 
-        if (iter == m_nodes->get<by_pidx_hash>().end() && nstrands < 0) {
+        sptidx = update_child_shape(p_sptidx, value, sortby_value, ndepth,
+            ndepth == dtree.last_level(), nstrands, dptidx);
+
+        if (sptidx == INVALID_INDEX) {
             continue;
         }
 
-        if (iter == m_nodes->get<by_pidx_hash>().end()) {
-            // create node and enqueue
-            sptidx = genidx();
-            t_uindex aggsize = m_aggregates->size();
-            if (sptidx == aggsize) {
-                double scale = 1.3;
-                t_uindex new_size = scale * aggsize;
-                m_aggregates->extend(new_size);
-            }
+        populate_pkey_idx(ctx, dtree, dptidx, sptidx, ndepth);
+        nmap[dptidx] = sptidx;
+    }
+
+    end_shape_update();
+}
+
+bool
+t_stree::can_update_shape_from_strands(
+    const t_data_table& strand_deltas, const std::vector<t_aggspec>& aggspecs) const {
+    for (const auto& spec : aggspecs) {
+        if (spec.is_non_delta()) {
+            return false;
+        }
 
-            t_uindex dst_ridx = gen_aggidx();
+        switch (spec.agg()) {
+            case AGGTYPE_SUM:
+            case AGGTYPE_PCT_SUM_PARENT:
+            case AGGTYPE_PCT_SUM_GRAND_TOTAL: {
+                const std::string& colname = spec.get_dependencies()[0].name();
+                if (!is_summable_dtype(strand_deltas.get_const_column(colname)->get_dtype())) {
+                    return false;
+                }
+            } break;
+            default:
+                break;
+        }
+    }
 
-            t_tnode node(sptidx, p_sptidx, value, ndepth, sortby_value, nstrands, dst_ridx);
+    return true;
+}
 
-            m_newids.insert(sptidx);
+std::shared_ptr<t_data_table>
+t_stree::update_shape_from_strands(const t_data_table& strands,
+    const t_data_table& strand_deltas, const std::vector<t_aggspec>& aggspecs,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby) {
+    std::map<std::string, std::string> sortby_columns;
+    for (const auto& sortby : tree_sortby) {
+        sortby_columns[sortby.first] = sortby.second;
+    }
 
-            if (ndepth == dtree.last_level()) {
-                m_newleaves.insert(sptidx);
-            }
+    t_uindex npivots = m_pivots.size();
+    std::vector<const t_column*> pivot_columns(npivots);
+    std::vector<const t_column*> sortby_columns_by_depth(npivots);
+
+    for (t_uindex pidx = 0; pidx < npivots; ++pidx) {
+        const std::string& colname = m_pivots[pidx].colname();
+        auto siter = sortby_columns.find(colname);
+        pivot_columns[pidx] = strands.get_const_column(colname).get();
+        sortby_columns_by_depth[pidx] = siter == sortby_columns.end()
+            ? pivot_columns[pidx]
+            : strands.get_const_column(siter->second).get();
+    }
 
-            auto insert_pair = m_nodes->insert(node);
-            if (!insert_pair.second) {
-                auto failed_because = *(insert_pair.first);
-                std::cout << "failed because of " << failed_because << std::endl;
+    // Group the strands by path, with the children of each group ordered
+    // by value, as `t_dtree` does.
+    std::vector<t_strand_group> groups(1);
+    groups[0].m_pidx = INVALID_INDEX;
+    groups[0].m_depth = 0;
+    groups[0].m_first_row = 0;
+
+    t_uindex nrows = strands.size();
+
+    for (t_uindex ridx = 0; ridx < nrows; ++ridx) {
+        t_uindex gidx = 0;
+        for (t_uindex pidx = 0; pidx < npivots; ++pidx) {
+            t_tscalar value = pivot_columns[pidx]->get_scalar(ridx);
+            auto citer = groups[gidx].m_children.find(value);
+            if (citer != groups[gidx].m_children.end()) {
+                gidx = citer->second;
+                continue;
             }
-            PSP_VERBOSE_ASSERT(insert_pair.second, "Failed to insert node");
-            t_tree_unify_rec unif_rec(sptidx, src_ridx, dst_ridx, nstrands);
-            m_tree_unification_records.push_back(unif_rec);
-        } else {
-            sptidx = iter->m_idx;
 
-            // update node
-            t_tnode node = *iter;
-            node.set_sort_value(sortby_value);
+            t_uindex cidx = groups.size();
+            groups[gidx].m_children[value] = cidx;
 
-            t_uindex dst_ridx = node.m_aggidx;
+            t_strand_group child;
+            child.m_pidx = gidx;
+            child.m_depth = pidx + 1;
+            child.m_value = value;
+            child.m_first_row = ridx;
+            groups.push_back(child);
+            gidx = cidx;
+        }
 
-            nstrands = node.m_nstrands + nstrands;
+        groups[gidx].m_rows.push_back(ridx);
+    }
 
-            t_tree_unify_rec unif_rec(sptidx, src_ridx, dst_ridx, nstrands);
-            m_tree_unification_records.push_back(unif_rec);
+    t_uindex ngroups = groups.size();
 
-            sptidx = iter->m_idx;
-            node.set_nstrands(nstrands);
-            PSP_VERBOSE_ASSERT(m_nodes->get<by_pidx_hash>().replace(iter, node), ,
-                "Failed to replace"); // middle argument ignored
-        }
+    t_schema delta_schema = strand_deltas.get_schema();
+    std::vector<std::string> columns;
+    std::vector<t_dtype> dtypes;
 
-        populate_pkey_idx(ctx, dtree, dptidx, sptidx, ndepth, new_idx_pkey);
-        nmap[dptidx] = sptidx;
+    for (const auto& spec : aggspecs) {
+        for (const auto& ci : spec.get_output_specs(delta_schema)) {
+            PSP_VERBOSE_ASSERT(ci.m_type != DTYPE_NONE, "NULL type encountered");
+            columns.push_back(ci.m_name);
+            dtypes.push_back(ci.m_type);
+        }
     }
 
-    auto biter = new_idx_pkey.get<by_idx_pkey>().begin();
-    auto eiter = new_idx_pkey.get<by_idx_pkey>().end();
+    auto aggtable = std::make_shared<t_data_table>(t_schema(columns, dtypes), ngroups);
+    aggtable->init();
+    aggtable->set_size(ngroups);
 
-    for (auto iter = biter; iter != eiter; ++iter) {
-        t_stpkey s(iter->m_idx, iter->m_pkey);
-        m_idxpkey->insert(s);
+    for (const auto& spec : aggspecs) {
+        switch (spec.agg()) {
+            case AGGTYPE_SUM:
+            case AGGTYPE_PCT_SUM_PARENT:
+            case AGGTYPE_PCT_SUM_GRAND_TOTAL: {
+                auto icolumn
+                    = strand_deltas.get_const_column(spec.get_dependencies()[0].name());
+                if (icolumn->size() > 0) {
+                    sum_strand_groups(groups, *icolumn, *(aggtable->get_column(spec.name())));
+                }
+            } break;
+            default:
+                break;
+        }
     }
 
-    mark_zero_desc();
-}
+    const t_column* pkey_col = strands.get_const_column("psp_pkey").get();
+    const t_column* strand_count_col = strand_deltas.get_const_column("psp_strand_count").get();
 
-void
-t_stree::mark_zero_desc() {
-    auto zeros = zero_strands();
-    std::set<t_uindex> z_desc;
+    std::vector<std::int64_t> nstrands(ngroups, 0);
+    for (t_uindex gidx = ngroups; gidx-- > 0;) {
+        for (auto ridx : groups[gidx].m_rows) {
+            nstrands[gidx] += *(strand_count_col->get_nth<std::int8_t>(ridx));
+        }
 
-    for (auto z : zeros) {
-        auto d = get_descendents(z);
-        std::copy(d.begin(), d.end(), std::inserter(z_desc, z_desc.end()));
+        for (const auto& child : groups[gidx].m_children) {
+            nstrands[gidx] += nstrands[child.second];
+        }
     }
 
-    for (auto n : z_desc) {
-        auto iter = m_nodes->get<by_idx>().find(n);
-        auto node = *iter;
-        node.set_nstrands(0);
-        m_nodes->get<by_idx>().replace(iter, node);
-    }
-}
+    begin_shape_update(nstrands[0]);
 
-void
-t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate) {
-    const t_data_table& src_aggtable = ctx.get_aggtable();
+    // Apply the groups depth first, in value order, as `update_shape_from_static`
+    // applies the nodes of a `t_dtree`.
+    std::vector<t_uindex> sptidxs(ngroups, 0);
+    std::vector<t_uindex> pending{0};
+    std::vector<t_tscalar> added;
+    std::vector<t_tscalar> removed;
 
-    t_agg_update_info agg_update_info;
-    t_schema aggschema = m_aggregates->get_schema();
+    while (!pending.empty()) {
+        t_uindex gidx = pending.back();
+        pending.pop_back();
 
-    for (auto colname : aggschema.m_columns) {
-        agg_update_info.m_src.push_back(src_aggtable.get_const_column(colname).get());
-        agg_update_info.m_dst.push_back(m_aggregates->get_column(colname).get());
-        agg_update_info.m_aggspecs.push_back(ctx.get_aggspec(colname));
-    }
+        const t_strand_group& group = groups[gidx];
+        for (auto citer = group.m_children.rbegin(); citer != group.m_children.rend();
+             ++citer) {
+            pending.push_back(citer->second);
+        }
+
+        t_index sptidx = 0;
+        if (gidx != 0) {
+            t_tscalar value = m_symtable.get_interned_tscalar(group.m_value);
+            t_tscalar sortby_value = m_symtable.get_interned_tscalar(
+                sortby_columns_by_depth[group.m_depth - 1]->get_scalar(group.m_first_row));
+
+            sptidx = update_child_shape(sptidxs[group.m_pidx], value, sortby_value,
+                group.m_depth, group.m_depth == npivots, nstrands[gidx], gidx);
+
+            if (sptidx == INVALID_INDEX) {
+                continue;
+            }
+
+            sptidxs[gidx] = sptidx;
+        }
+
+        if (group.m_depth == npivots) {
+            added.clear();
+            removed.clear();
+            bool changed = false;
+
+            for (auto ridx : group.m_rows) {
+                auto strand_count = *(strand_count_col->get_nth<std::int8_t>(ridx));
+                auto pkey = m_symtable.get_interned_tscalar(pkey_col->get_scalar(ridx));
+
+                if (strand_count > 0) {
+                    added.push_back(pkey);
+                }
+
+                if (strand_count < 0) {
+                    removed.push_back(pkey);
+                }
+
+                changed |= strand_count == 0 && m_sketch_changed_pkeys.count(pkey) > 0;
+            }
+
+            if (m_has_sketches) {
+                record_sketch_update(sptidx, added, removed, changed);
+            }
+
+            m_members.update_pkeys(sptidx, added, removed);
+        }
+    }
+
+    end_shape_update();
+    return aggtable;
+}
+
+void
+t_stree::mark_zero_desc() {
+    auto zeros = zero_strands();
+    std::set<t_uindex> z_desc;
+
+    for (auto z : zeros) {
+        auto d = get_descendents(z);
+        std::copy(d.begin(), d.end(), std::inserter(z_desc, z_desc.end()));
+    }
+
+    for (auto n : z_desc) {
+        m_nodes.set_nstrands(n, 0);
+    }
+}
+
+void
+t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate) {
+    update_aggs(ctx.get_aggtable(), ctx.get_aggspecs(), gstate);
+}
+
+t_agg_update_info
+t_stree::get_agg_update_info(
+    const t_data_table* src_aggtable, const std::vector<t_aggspec>& aggspecs) const {
+    t_agg_update_info agg_update_info;
+    t_schema aggschema = m_aggregates->get_schema();
+
+    for (auto colname : aggschema.m_columns) {
+        auto spec = std::find_if(aggspecs.begin(), aggspecs.end(),
+            [&colname](const t_aggspec& s) { return s.name() == colname; });
+        PSP_VERBOSE_ASSERT(spec != aggspecs.end(), "Failed to find aggspec");
+
+        agg_update_info.m_src.push_back(
+            src_aggtable ? src_aggtable->get_const_column(colname).get() : nullptr);
+        agg_update_info.m_dst.push_back(m_aggregates->get_column(colname).get());
+        agg_update_info.m_aggspecs.push_back(*spec);
+    }
 
     auto is_col_scaled_aggregate = [&](int col_idx) -> bool {
         int agg_type = agg_update_info.m_aggspecs[col_idx].agg();
@@ -781,55 +1410,300 @@ t_stree::update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate)
         }
     }
 
+    return agg_update_info;
+}
+
+std::vector<t_uindex>
+t_stree::get_lazy_agg_columns(const t_agg_update_info& info) const {
+    std::vector<t_uindex> lazy_cols;
+
+    for (t_uindex idx : info.m_dst_topo_sorted) {
+        switch (info.m_aggspecs[idx].agg()) {
+            case AGGTYPE_SCALED_DIV:
+            case AGGTYPE_SCALED_ADD:
+            case AGGTYPE_SCALED_MUL: {
+                return std::vector<t_uindex>();
+            }
+            case AGGTYPE_MEAN:
+            case AGGTYPE_WEIGHTED_MEAN:
+            case AGGTYPE_UNIQUE:
+            case AGGTYPE_OR:
+            case AGGTYPE_ANY:
+            case AGGTYPE_MEDIAN:
+            case AGGTYPE_JOIN:
+            case AGGTYPE_DOMINANT:
+            case AGGTYPE_FIRST:
+            case AGGTYPE_LAST:
+            case AGGTYPE_AND:
+            case AGGTYPE_SUM_NOT_NULL:
+            case AGGTYPE_SUM_ABS:
+            case AGGTYPE_ABS_SUM:
+            case AGGTYPE_MUL:
+            case AGGTYPE_DISTINCT_COUNT:
+            case AGGTYPE_DISTINCT_LEAF: {
+                lazy_cols.push_back(idx);
+            } break;
+            default:
+                break;
+        }
+    }
+
+    return lazy_cols;
+}
+
+void
+t_stree::update_aggs(const t_data_table& src_aggtable, const std::vector<t_aggspec>& aggspecs,
+    const t_gstate& gstate) {
+    t_agg_update_info agg_update_info = get_agg_update_info(&src_aggtable, aggspecs);
+
+    std::vector<t_uindex> lazy_cols;
+    if (m_agg_visible && !m_features.at(CTX_FEAT_MINMAX)) {
+        lazy_cols = get_lazy_agg_columns(agg_update_info);
+    }
+
+    std::vector<const t_tree_unify_rec*> records;
+    std::vector<const t_tree_unify_rec*> hidden;
+    records.reserve(m_tree_unification_records.size());
+
     for (const auto& r : m_tree_unification_records) {
         if (!node_exists(r.m_sptidx)) {
             continue;
         }
 
+        if (!lazy_cols.empty() && !m_agg_visible(r.m_sptidx)) {
+            hidden.push_back(&r);
+        } else {
+            records.push_back(&r);
+        }
+    }
+
+    if (m_has_sketches) {
+        update_sketches(agg_update_info, gstate);
+    }
+
+    apply_unification_records(agg_update_info, records, gstate);
+
+    if (!m_dirty_aggs.empty()) {
+        for (const t_tree_unify_rec* r : records) {
+            t_uindex depth = m_nodes.get_depth(r->m_sptidx);
+            if (depth < m_dirty_aggs.size()) {
+                m_dirty_aggs[depth].erase(r->m_sptidx);
+            }
+        }
+    }
+
+    if (hidden.empty()) {
+        return;
+    }
+
+    // Nodes the traversal does not show only update the aggregates that
+    // cannot be recomputed from their pkeys later.
+    std::vector<t_uindex> eager_cols;
+    for (t_uindex idx : agg_update_info.m_dst_topo_sorted) {
+        if (std::find(lazy_cols.begin(), lazy_cols.end(), idx) == lazy_cols.end()) {
+            eager_cols.push_back(idx);
+        }
+    }
+
+    std::swap(agg_update_info.m_dst_topo_sorted, eager_cols);
+    apply_unification_records(agg_update_info, hidden, gstate);
+
+    for (const t_tree_unify_rec* r : hidden) {
+        t_uindex depth = m_nodes.get_depth(r->m_sptidx);
+        if (depth >= m_dirty_aggs.size()) {
+            m_dirty_aggs.resize(depth + 1);
+        }
+        m_dirty_aggs[depth].insert(r->m_sptidx);
+    }
+}
+
+void
+t_stree::apply_unification_records(t_agg_update_info& info,
+    const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate) {
+    if (info.m_dst_topo_sorted.empty()) {
+        return;
+    }
+
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+    if (records.size() * info.m_dst_topo_sorted.size() >= PSP_PARALLEL_AGG_MIN_UPDATES) {
+        update_aggs_parallel(info, records, gstate);
+        return;
+    }
+#endif
+
+    for (const t_tree_unify_rec* r : records) {
         update_agg_table(
-            r.m_sptidx, agg_update_info, r.m_daggidx, r.m_saggidx, r.m_nstrands, gstate);
+            r->m_sptidx, info, r->m_daggidx, r->m_saggidx, r->m_nstrands, gstate);
+    }
+}
+
+void
+t_stree::set_lazy_aggregates(std::function<bool(t_uindex)> is_visible) {
+    m_agg_visible = is_visible;
+}
+
+void
+t_stree::clean_aggregates(const std::vector<t_uindex>& nidxs, const t_gstate& gstate) {
+    std::vector<t_uindex> dirty;
+    if (m_dirty_aggs.empty()) {
+        return;
+    }
+
+    for (auto nidx : nidxs) {
+        if (!m_nodes.exists(nidx)) {
+            continue;
+        }
+
+        t_uindex depth = m_nodes.get_depth(nidx);
+        if (depth < m_dirty_aggs.size() && m_dirty_aggs[depth].erase(nidx) > 0) {
+            dirty.push_back(nidx);
+        }
+    }
+
+    if (dirty.empty()) {
+        return;
+    }
+
+    // Deferred aggregates never read a source table.
+    t_agg_update_info info = get_agg_update_info(nullptr, m_aggspecs);
+    info.m_dst_topo_sorted = get_lazy_agg_columns(info);
+
+    for (auto nidx : dirty) {
+        for (t_uindex idx : info.m_dst_topo_sorted) {
+            t_tscalar new_value = mknone();
+            t_tscalar old_value = mknone();
+            update_agg_column(nidx, info, idx, 0, m_nodes.get_aggidx(nidx),
+                m_nodes.get_nstrands(nidx), gstate, old_value, new_value);
+        }
+    }
+}
+
+void
+t_stree::clean_child_aggregates(t_uindex nidx, const t_gstate& gstate) {
+    if (m_dirty_aggs.empty()) {
+        return;
+    }
+
+    clean_aggregates(m_nodes.get_children(nidx), gstate);
+}
+
+void
+t_stree::clean_aggregates_to_depth(t_depth depth, const t_gstate& gstate) {
+    std::vector<t_uindex> dirty;
+    for (t_uindex didx = 0, loop_end = std::min<t_uindex>(depth + 1, m_dirty_aggs.size());
+         didx < loop_end; ++didx) {
+        dirty.insert(dirty.end(), m_dirty_aggs[didx].begin(), m_dirty_aggs[didx].end());
+    }
+
+    clean_aggregates(dirty, gstate);
+}
+
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+void
+t_stree::update_aggs_parallel(const t_agg_update_info& info,
+    const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate) {
+    // Aggregate columns only read their own destination column, except for
+    // scaled aggregates which read the columns they combine, and aggregates
+    // that intern strings into `m_symtable`. Partition the rest across
+    // threads, and run those serially once the others are complete.
+    std::vector<t_uindex> parallel_cols;
+    std::vector<t_uindex> serial_cols;
+
+    for (t_uindex idx : info.m_dst_topo_sorted) {
+        switch (info.m_aggspecs[idx].agg()) {
+            case AGGTYPE_SCALED_DIV:
+            case AGGTYPE_SCALED_ADD:
+            case AGGTYPE_SCALED_MUL:
+            case AGGTYPE_UNIQUE:
+            case AGGTYPE_JOIN:
+            case AGGTYPE_DISTINCT_LEAF: {
+                serial_cols.push_back(idx);
+            } break;
+            default: {
+                if (info.m_dst[idx]->get_dtype() == DTYPE_OBJECT) {
+                    serial_cols.push_back(idx);
+                } else {
+                    parallel_cols.push_back(idx);
+                }
+            } break;
+        }
+    }
+
+    bool deltas_enabled = m_features.at(CTX_FEAT_DELTA);
+    t_uindex ncols = parallel_cols.size();
+    std::vector<t_tcdeltas> col_deltas(ncols);
+    std::vector<std::uint8_t> col_has_delta(ncols, false);
+
+    auto update_column = [&](t_uindex idx, t_tcdeltas* deltas, bool& has_delta) {
+        for (const t_tree_unify_rec* r : records) {
+            t_tscalar new_value = mknone();
+            t_tscalar old_value = mknone();
+
+            update_agg_column(r->m_sptidx, info, idx, r->m_daggidx, r->m_saggidx,
+                r->m_nstrands, gstate, old_value, new_value);
+
+            bool val_neq = old_value != new_value;
+            has_delta = has_delta || val_neq;
+            if (deltas_enabled && val_neq) {
+                deltas->insert(r->m_sptidx, idx, old_value, new_value);
+            }
+        }
+    };
+
+    tbb::parallel_for(0, int(ncols), 1, [&](int i) {
+        bool has_delta = false;
+        update_column(parallel_cols[i], &col_deltas[i], has_delta);
+        col_has_delta[i] = has_delta;
+    });
+
+    for (t_uindex i = 0; i < ncols; ++i) {
+        m_has_delta = m_has_delta || col_has_delta[i];
+        m_deltas->insert(col_deltas[i]);
+    }
+
+    for (t_uindex idx : serial_cols) {
+        bool has_delta = false;
+        update_column(idx, m_deltas.get(), has_delta);
+        m_has_delta = m_has_delta || has_delta;
     }
 }
+#endif
 
 t_uindex
 t_stree::genidx() {
+    if (!m_node_freelist.empty()) {
+        t_uindex rval = m_node_freelist.back();
+        m_node_freelist.pop_back();
+        return rval;
+    }
+
     return m_curidx++;
 }
 
 std::vector<t_uindex>
 t_stree::get_children(t_uindex idx) const {
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(idx);
-
-    t_uindex nchild = std::distance(iterators.first, iterators.second);
-
-    std::vector<t_uindex> temp(nchild);
-
-    t_index count = 0;
-    for (iter_by_pidx iter = iterators.first; iter != iterators.second; ++iter) {
-        temp[count] = iter->m_idx;
-        ++count;
-    }
-    return temp;
+    return m_nodes.get_children(idx);
 }
 
 t_uindex
 t_stree::size() const {
-    return m_nodes->size();
+    return m_nodes.size();
 }
 
 void
 t_stree::get_child_nodes(t_uindex idx, t_tnodevec& nodes) const {
-    t_index num_children = get_num_children(idx);
-    t_tnodevec temp(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    std::copy(iterators.first, iterators.second, temp.begin());
+    const auto& children = m_nodes.get_children(idx);
+    t_tnodevec temp;
+    temp.reserve(children.size());
+    for (auto cidx : children) {
+        temp.push_back(m_nodes.get(cidx));
+    }
     std::swap(nodes, temp);
 }
 
 t_uindex
 t_stree::get_num_children(t_uindex ptidx) const {
-    auto iterators = m_nodes->get<by_pidx>().equal_range(ptidx);
-    return std::distance(iterators.first, iterators.second);
+    return m_nodes.get_children(ptidx).size();
 }
 
 t_uindex
@@ -854,440 +1728,474 @@ t_stree::gen_aggidx() {
 void
 t_stree::update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_ridx,
     t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate) {
+    bool deltas_enabled = m_features.at(CTX_FEAT_DELTA);
     for (t_uindex idx : info.m_dst_topo_sorted) {
-        const t_column* src = info.m_src[idx];
-        t_column* dst = info.m_dst[idx];
-        const t_aggspec& spec = info.m_aggspecs[idx];
         t_tscalar new_value = mknone();
         t_tscalar old_value = mknone();
 
-        switch (spec.agg()) {
-            case AGGTYPE_PCT_SUM_PARENT:
-            case AGGTYPE_PCT_SUM_GRAND_TOTAL:
-            case AGGTYPE_SUM: {
-                t_tscalar src_scalar = src->get_scalar(src_ridx);
-                t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
-                old_value.set(dst_scalar);
-                new_value.set(dst_scalar.add(src_scalar));
-                if (old_value.is_nan()) // is_nan returns false for non-float types
-                {
-                    // if we previously had a NaN, add can't make it finite again; recalculate
-                    // entire sum in case it is now finite
-                    auto pkeys = get_pkeys(nidx);
-                    std::vector<double> values;
-                    gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
-                    new_value.set(std::accumulate(values.begin(), values.end(), double(0)));
-                }
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_COUNT: {
-                if (nidx == 0) {
-                    new_value.set(nstrands - 1);
-                } else {
-                    new_value.set(nstrands);
-                }
-
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_MEAN: {
-                auto pkeys = get_pkeys(nidx);
-                std::vector<double> values;
+        update_agg_column(
+            nidx, info, idx, src_ridx, dst_ridx, nstrands, gstate, old_value, new_value);
 
-                gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values, false);
+        bool val_neq = old_value != new_value;
 
-                auto nr = std::accumulate(values.begin(), values.end(), double(0));
-                double dr = values.size();
+        m_has_delta = m_has_delta || val_neq;
+        if (deltas_enabled && val_neq) {
+            m_deltas->insert(nidx, idx, old_value, new_value);
+        }
+    }
+}
 
-                std::pair<double, double>* dst_pair
-                    = dst->get_nth<std::pair<double, double>>(dst_ridx);
+void
+t_stree::update_agg_column(t_uindex nidx, const t_agg_update_info& info, t_uindex idx,
+    t_uindex src_ridx, t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate,
+    t_tscalar& old_value, t_tscalar& new_value) {
+    const t_column* src = info.m_src[idx];
+    t_column* dst = info.m_dst[idx];
+    const t_aggspec& spec = info.m_aggspecs[idx];
+
+    switch (spec.agg()) {
+        case AGGTYPE_PCT_SUM_PARENT:
+        case AGGTYPE_PCT_SUM_GRAND_TOTAL:
+        case AGGTYPE_SUM: {
+            t_tscalar src_scalar = src->get_scalar(src_ridx);
+            t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
+            old_value.set(dst_scalar);
+            new_value.set(dst_scalar.add(src_scalar));
+            if (old_value.is_nan()) // is_nan returns false for non-float types
+            {
+                // if we previously had a NaN, add can't make it finite again; recalculate
+                // entire sum in case it is now finite
+                auto pkeys = get_pkeys(nidx);
+                std::vector<double> values;
+                gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
+                new_value.set(std::accumulate(values.begin(), values.end(), double(0)));
+            }
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_COUNT: {
+            if (nidx == 0) {
+                new_value.set(nstrands - 1);
+            } else {
+                new_value.set(nstrands);
+            }
 
-                old_value.set(dst_pair->first / dst_pair->second);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_MEAN: {
+            auto pkeys = get_pkeys(nidx);
+            std::vector<double> values;
 
-                dst_pair->first = nr;
-                dst_pair->second = dr;
+            gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values, false);
 
-                dst->set_valid(dst_ridx, true);
+            auto nr = std::accumulate(values.begin(), values.end(), double(0));
+            double dr = values.size();
 
-                new_value.set(nr / dr);
-            } break;
-            case AGGTYPE_WEIGHTED_MEAN: {
-                auto pkeys = get_pkeys(nidx);
+            std::pair<double, double>* dst_pair
+                = dst->get_nth<std::pair<double, double>>(dst_ridx);
 
-                double nr = 0;
-                double dr = 0;
-                std::vector<t_tscalar> values;
-                std::vector<t_tscalar> weights;
+            old_value.set(dst_pair->first / dst_pair->second);
 
-                gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
-                gstate.read_column(spec.get_dependencies()[1].name(), pkeys, weights);
+            dst_pair->first = nr;
+            dst_pair->second = dr;
 
-                auto weights_it = weights.begin();
-                auto values_it = values.begin();
+            dst->set_valid(dst_ridx, true);
 
-                for (; weights_it != weights.end() && values_it != values.end();
-                     ++weights_it, ++values_it) {
-                    if (weights_it->is_valid() && values_it->is_valid() && !weights_it->is_nan()
-                        && !values_it->is_nan()) {
-                        nr += weights_it->to_double() * values_it->to_double();
-                        dr += weights_it->to_double();
-                    }
+            new_value.set(nr / dr);
+        } break;
+        case AGGTYPE_WEIGHTED_MEAN: {
+            auto pkeys = get_pkeys(nidx);
+
+            double nr = 0;
+            double dr = 0;
+            std::vector<t_tscalar> values;
+            std::vector<t_tscalar> weights;
+
+            gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
+            gstate.read_column(spec.get_dependencies()[1].name(), pkeys, weights);
+
+            auto weights_it = weights.begin();
+            auto values_it = values.begin();
+
+            for (; weights_it != weights.end() && values_it != values.end();
+                 ++weights_it, ++values_it) {
+                if (weights_it->is_valid() && values_it->is_valid() && !weights_it->is_nan()
+                    && !values_it->is_nan()) {
+                    nr += weights_it->to_double() * values_it->to_double();
+                    dr += weights_it->to_double();
                 }
+            }
 
-                std::pair<double, double>* dst_pair
-                    = dst->get_nth<std::pair<double, double>>(dst_ridx);
-                old_value.set(dst_pair->first / dst_pair->second);
+            std::pair<double, double>* dst_pair
+                = dst->get_nth<std::pair<double, double>>(dst_ridx);
+            old_value.set(dst_pair->first / dst_pair->second);
 
-                dst_pair->first = nr;
-                dst_pair->second = dr;
+            dst_pair->first = nr;
+            dst_pair->second = dr;
 
-                bool valid = (dr != 0);
-                dst->set_valid(dst_ridx, valid);
-                new_value.set(nr / dr);
-            } break;
-            case AGGTYPE_UNIQUE: {
-                auto pkeys = get_pkeys(nidx);
-                old_value.set(dst->get_scalar(dst_ridx));
+            bool valid = (dr != 0);
+            dst->set_valid(dst_ridx, valid);
+            new_value.set(nr / dr);
+        } break;
+        case AGGTYPE_UNIQUE: {
+            auto pkeys = get_pkeys(nidx);
+            old_value.set(dst->get_scalar(dst_ridx));
 
-                bool is_unique
-                    = gstate.is_unique(pkeys, spec.get_dependencies()[0].name(), new_value);
+            bool is_unique
+                = gstate.is_unique(pkeys, spec.get_dependencies()[0].name(), new_value);
 
-                if (new_value.m_type == DTYPE_STR) {
-                    if (is_unique) {
-                        new_value = m_symtable.get_interned_tscalar(new_value);
-                    } else {
-                        new_value = m_symtable.get_interned_tscalar("-");
-                    }
-                    dst->set_scalar(dst_ridx, new_value);
+            if (new_value.m_type == DTYPE_STR) {
+                if (is_unique) {
+                    new_value = m_symtable.get_interned_tscalar(new_value);
                 } else {
-                    if (is_unique) {
-                        dst->set_scalar(dst_ridx, new_value);
-                    } else {
-                        dst->set_valid(dst_ridx, false);
-                        new_value = old_value;
-                    }
+                    new_value = m_symtable.get_interned_tscalar("-");
                 }
-            } break;
-            case AGGTYPE_OR:
-            case AGGTYPE_ANY: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
-                gstate.apply(pkeys, spec.get_dependencies()[0].name(), new_value,
-                    [](const t_tscalar& row_value, t_tscalar& output) {
-                        if (row_value) {
-                            output.set(row_value);
-                            return true;
-                        }
-                        return false;
-                    });
-
                 dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_MEDIAN: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
-
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            if (values.size() == 0) {
-                                return t_tscalar();
-                            } else if (values.size() == 1) {
-                                return values[0];
-                            } else {
-                                std::vector<t_tscalar>::iterator middle
-                                    = values.begin() + (values.size() / 2);
-
-                                std::nth_element(values.begin(), middle, values.end());
-
-                                return *middle;
-                            }
-                        }));
-
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_JOIN: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
-
-                new_value.set(gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(
-                    pkeys, spec.get_dependencies()[0].name(),
-                    [this](std::vector<t_tscalar>& values) {
-                        std::set<t_tscalar> vset;
-                        for (const auto& v : values) {
-                            vset.insert(v);
-                        }
+            } else {
+                if (is_unique) {
+                    dst->set_scalar(dst_ridx, new_value);
+                } else {
+                    dst->set_valid(dst_ridx, false);
+                    new_value = old_value;
+                }
+            }
+        } break;
+        case AGGTYPE_OR:
+        case AGGTYPE_ANY: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+            gstate.apply(pkeys, spec.get_dependencies()[0].name(), new_value,
+                [](const t_tscalar& row_value, t_tscalar& output) {
+                    if (row_value) {
+                        output.set(row_value);
+                        return true;
+                    }
+                    return false;
+                });
 
-                        std::stringstream ss;
-                        for (std::set<t_tscalar>::const_iterator iter = vset.begin();
-                             iter != vset.end(); ++iter) {
-                            ss << *iter << ", ";
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_MEDIAN: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+
+            new_value.set(
+                gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        if (values.size() == 0) {
+                            return t_tscalar();
+                        } else if (values.size() == 1) {
+                            return values[0];
+                        } else {
+                            std::vector<t_tscalar>::iterator middle
+                                = values.begin() + (values.size() / 2);
+
+                            std::nth_element(values.begin(), middle, values.end());
+
+                            return *middle;
                         }
-                        return m_symtable.get_interned_tscalar(ss.str().c_str());
                     }));
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_SCALED_DIV: {
-                const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
-                const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_JOIN: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+
+            new_value.set(gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(
+                pkeys, spec.get_dependencies()[0].name(),
+                [this](std::vector<t_tscalar>& values) {
+                    std::set<t_tscalar> vset;
+                    for (const auto& v : values) {
+                        vset.insert(v);
+                    }
 
-                t_column* dst = info.m_dst[idx];
-                old_value.set(dst->get_scalar(dst_ridx));
+                    std::stringstream ss;
+                    for (std::set<t_tscalar>::const_iterator iter = vset.begin();
+                         iter != vset.end(); ++iter) {
+                        ss << *iter << ", ";
+                    }
+                    return m_symtable.get_interned_tscalar(ss.str().c_str());
+                }));
 
-                double agg1 = src_1->get_scalar(dst_ridx).to_double();
-                double agg2 = src_2->get_scalar(dst_ridx).to_double();
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_SCALED_DIV: {
+            const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
+            const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                double w1 = spec.get_agg_one_weight();
-                double w2 = spec.get_agg_two_weight();
+            t_column* dst = info.m_dst[idx];
+            old_value.set(dst->get_scalar(dst_ridx));
 
-                double v = (agg1 * w1) / (agg2 * w2);
+            double agg1 = src_1->get_scalar(dst_ridx).to_double();
+            double agg2 = src_2->get_scalar(dst_ridx).to_double();
 
-                new_value.set(v);
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_SCALED_ADD: {
+            double w1 = spec.get_agg_one_weight();
+            double w2 = spec.get_agg_two_weight();
 
-                const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
-                const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
+            double v = (agg1 * w1) / (agg2 * w2);
 
-                t_column* dst = info.m_dst[idx];
-                old_value.set(dst->get_scalar(dst_ridx));
-
-                double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
-                    + (src_2->get_scalar(dst_ridx).to_double() * spec.get_agg_two_weight());
+            new_value.set(v);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_SCALED_ADD: {
 
-                new_value.set(v);
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_SCALED_MUL: {
-                const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
-                const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
+            const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
+            const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                t_column* dst = info.m_dst[idx];
-                old_value.set(dst->get_scalar(dst_ridx));
+            t_column* dst = info.m_dst[idx];
+            old_value.set(dst->get_scalar(dst_ridx));
 
-                double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
-                    * (src_2->get_scalar(dst_ridx).to_double() * spec.get_agg_two_weight());
+            double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
+                + (src_2->get_scalar(dst_ridx).to_double() * spec.get_agg_two_weight());
 
-                new_value.set(v);
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_DOMINANT: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+            new_value.set(v);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_SCALED_MUL: {
+            const t_column* src_1 = info.m_dst[spec.get_agg_one_idx()];
+            const t_column* src_2 = info.m_dst[spec.get_agg_two_idx()];
 
-                new_value.set(gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(
-                    pkeys, spec.get_dependencies()[0].name(),
-                    [](std::vector<t_tscalar>& values) { return get_dominant(values); }));
+            t_column* dst = info.m_dst[idx];
+            old_value.set(dst->get_scalar(dst_ridx));
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_FIRST:
-            case AGGTYPE_LAST: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                new_value.set(first_last_helper(nidx, spec, gstate));
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_AND: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+            double v = (src_1->get_scalar(dst_ridx).to_double() * spec.get_agg_one_weight())
+                * (src_2->get_scalar(dst_ridx).to_double() * spec.get_agg_two_weight());
 
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            t_tscalar rval;
-                            rval.set(true);
-
-                            for (const auto& v : values) {
-                                if (!v) {
-                                    rval.set(false);
-                                    break;
-                                }
-                            }
-                            return rval;
-                        }));
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_LAST_VALUE: {
-                t_tscalar src_scalar = src->get_scalar(src_ridx);
-                t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
+            new_value.set(v);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_DOMINANT: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
 
-                old_value.set(dst_scalar);
-                new_value.set(src_scalar);
+            new_value.set(gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(
+                pkeys, spec.get_dependencies()[0].name(),
+                [](std::vector<t_tscalar>& values) { return get_dominant(values); }));
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_HIGH_WATER_MARK: {
-                t_tscalar src_scalar = src->get_scalar(src_ridx);
-                t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_FIRST:
+        case AGGTYPE_LAST: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            new_value.set(first_last_helper(nidx, spec, gstate));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_AND: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
 
-                old_value.set(dst_scalar);
-                new_value.set(src_scalar);
+            new_value.set(
+                gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        t_tscalar rval;
+                        rval.set(true);
 
-                if (dst_scalar.is_valid()) {
-                    new_value.set(std::max(dst_scalar, src_scalar));
-                }
+                        for (const auto& v : values) {
+                            if (!v) {
+                                rval.set(false);
+                                break;
+                            }
+                        }
+                        return rval;
+                    }));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_LAST_VALUE: {
+            t_tscalar src_scalar = src->get_scalar(src_ridx);
+            t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_LOW_WATER_MARK: {
-                t_tscalar src_scalar = src->get_scalar(src_ridx);
-                t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
+            old_value.set(dst_scalar);
+            new_value.set(src_scalar);
 
-                old_value.set(dst_scalar);
-                new_value.set(src_scalar);
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_HIGH_WATER_MARK: {
+            t_tscalar src_scalar = src->get_scalar(src_ridx);
+            t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
 
-                if (dst_scalar.is_valid()) {
-                    new_value.set(std::min(dst_scalar, src_scalar));
-                }
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_UDF_COMBINER:
-            case AGGTYPE_UDF_REDUCER: {
-                // these will be filled in later
-            } break;
-            case AGGTYPE_SUM_NOT_NULL: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+            old_value.set(dst_scalar);
+            new_value.set(src_scalar);
 
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            if (values.empty()) {
-                                return mknone();
-                            }
+            if (dst_scalar.is_valid()) {
+                new_value.set(std::max(dst_scalar, src_scalar));
+            }
 
-                            t_tscalar rval;
-                            rval.set(std::uint64_t(0));
-                            rval.m_type = values[0].m_type;
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_LOW_WATER_MARK: {
+            t_tscalar src_scalar = src->get_scalar(src_ridx);
+            t_tscalar dst_scalar = dst->get_scalar(dst_ridx);
 
-                            for (const auto& v : values) {
-                                if (v.is_nan())
-                                    continue;
-                                rval = rval.add(v);
-                            }
+            old_value.set(dst_scalar);
+            new_value.set(src_scalar);
 
-                            return rval;
-                        }));
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_SUM_ABS: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+            if (dst_scalar.is_valid()) {
+                new_value.set(std::min(dst_scalar, src_scalar));
+            }
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_UDF_COMBINER:
+        case AGGTYPE_UDF_REDUCER: {
+            // these will be filled in later
+        } break;
+        case AGGTYPE_SUM_NOT_NULL: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+
+            new_value.set(
+                gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        if (values.empty()) {
+                            return mknone();
+                        }
 
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            if (values.empty()) {
-                                return mknone();
-                            }
+                        t_tscalar rval;
+                        rval.set(std::uint64_t(0));
+                        rval.m_type = values[0].m_type;
 
-                            t_tscalar rval;
-                            rval.set(std::uint64_t(0));
-                            rval.m_type = values[0].m_type;
-                            for (const auto& v : values) {
-                                rval = rval.add(v.abs());
-                            }
-                            return rval;
-                        }));
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_ABS_SUM: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
-                std::vector<double> values;
-                gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
-                double sum = std::accumulate(values.begin(), values.end(), double(0));
-                new_value.set(std::abs(sum));
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_MUL: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
-                new_value.set(
-                    gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            if (values.size() == 0) {
-                                return t_tscalar();
-                            } else if (values.size() == 1) {
-                                return values[0];
-                            } else {
-                                t_tscalar v = values[0];
-                                for (t_uindex vidx = 1, vloop_end = values.size();
-                                     vidx < vloop_end; ++vidx) {
-                                    v = v.mul(values[vidx]);
-                                }
-                                return v;
-                            }
-                        }));
+                        for (const auto& v : values) {
+                            if (v.is_nan())
+                                continue;
+                            rval = rval.add(v);
+                        }
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_DISTINCT_COUNT: {
-                old_value.set(dst->get_scalar(dst_ridx));
-                auto pkeys = get_pkeys(nidx);
+                        return rval;
+                    }));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_SUM_ABS: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+
+            new_value.set(
+                gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        if (values.empty()) {
+                            return mknone();
+                        }
 
-                new_value.set(
-                    gstate.reduce<std::function<std::uint32_t(std::vector<t_tscalar>&)>>(pkeys,
-                        spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
-                            tsl::hopscotch_set<t_tscalar> vset;
-                            for (const auto& v : values) {
-                                vset.insert(v);
+                        t_tscalar rval;
+                        rval.set(std::uint64_t(0));
+                        rval.m_type = values[0].m_type;
+                        for (const auto& v : values) {
+                            rval = rval.add(v.abs());
+                        }
+                        return rval;
+                    }));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_ABS_SUM: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+            std::vector<double> values;
+            gstate.read_column(spec.get_dependencies()[0].name(), pkeys, values);
+            double sum = std::accumulate(values.begin(), values.end(), double(0));
+            new_value.set(std::abs(sum));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_MUL: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+            new_value.set(
+                gstate.reduce<std::function<t_tscalar(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        if (values.size() == 0) {
+                            return t_tscalar();
+                        } else if (values.size() == 1) {
+                            return values[0];
+                        } else {
+                            t_tscalar v = values[0];
+                            for (t_uindex vidx = 1, vloop_end = values.size();
+                                 vidx < vloop_end; ++vidx) {
+                                v = v.mul(values[vidx]);
                             }
-                            std::uint32_t rv = vset.size();
-                            return rv;
-                        }));
+                            return v;
+                        }
+                    }));
 
-                dst->set_scalar(dst_ridx, new_value);
-            } break;
-            case AGGTYPE_DISTINCT_LEAF: {
-                auto pkeys = get_pkeys(nidx);
-                old_value.set(dst->get_scalar(dst_ridx));
-                bool skip = false;
-                bool is_unique
-                    = gstate.is_unique(pkeys, spec.get_dependencies()[0].name(), new_value);
-
-                if (is_leaf(nidx) && is_unique) {
-                    if (new_value.m_type == DTYPE_STR) {
-                        new_value = m_symtable.get_interned_tscalar(new_value);
-                    }
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_DISTINCT_COUNT: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            auto pkeys = get_pkeys(nidx);
+
+            new_value.set(
+                gstate.reduce<std::function<std::uint32_t(std::vector<t_tscalar>&)>>(pkeys,
+                    spec.get_dependencies()[0].name(), [](std::vector<t_tscalar>& values) {
+                        tsl::hopscotch_set<t_tscalar> vset;
+                        for (const auto& v : values) {
+                            vset.insert(v);
+                        }
+                        std::uint32_t rv = vset.size();
+                        return rv;
+                    }));
+
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_DISTINCT_LEAF: {
+            auto pkeys = get_pkeys(nidx);
+            old_value.set(dst->get_scalar(dst_ridx));
+            bool skip = false;
+            bool is_unique
+                = gstate.is_unique(pkeys, spec.get_dependencies()[0].name(), new_value);
+
+            if (is_leaf(nidx) && is_unique) {
+                if (new_value.m_type == DTYPE_STR) {
+                    new_value = m_symtable.get_interned_tscalar(new_value);
+                }
+            } else {
+                if (new_value.m_type == DTYPE_STR) {
+                    new_value = m_symtable.get_interned_tscalar("");
                 } else {
-                    if (new_value.m_type == DTYPE_STR) {
-                        new_value = m_symtable.get_interned_tscalar("");
-                    } else {
-                        dst->set_valid(dst_ridx, false);
-                        new_value = old_value;
-                        skip = true;
-                    }
+                    dst->set_valid(dst_ridx, false);
+                    new_value = old_value;
+                    skip = true;
                 }
-                if (!skip)
-                    dst->set_scalar(dst_ridx, new_value);
-            } break;
-            default: { PSP_COMPLAIN_AND_ABORT("Not implemented"); }
-        } // end switch
-
-        bool val_neq = old_value != new_value;
-
-        m_has_delta = m_has_delta || val_neq;
-        bool deltas_enabled = m_features.at(CTX_FEAT_DELTA);
-        if (deltas_enabled && val_neq) {
-            m_deltas->insert(t_tcdelta(nidx, idx, old_value, new_value));
-        }
+            }
+            if (!skip)
+                dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_APPROX_DISTINCT_COUNT: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            new_value.set(
+                static_cast<std::uint32_t>(std::llround(m_hlls[idx][dst_ridx].estimate())));
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        case AGGTYPE_APPROX_MEDIAN:
+        case AGGTYPE_APPROX_P95:
+        case AGGTYPE_APPROX_P99: {
+            old_value.set(dst->get_scalar(dst_ridx));
+            const t_tdigest& digest = m_tdigests[idx][dst_ridx];
+
+            if (digest.empty()) {
+                new_value.clear();
+            } else {
+                new_value.set(digest.quantile(get_sketch_quantile(spec.agg())));
+            }
 
-    } // end for
+            dst->set_scalar(dst_ridx, new_value);
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Not implemented"); }
+    } // end switch
 }
 
 std::vector<t_uindex>
-t_stree::zero_strands() const {
-    auto iterators = m_nodes->get<by_nstrands>().equal_range(0);
+t_stree::updated_ids() const {
     std::vector<t_uindex> rval;
-
-    for (auto& iter = iterators.first; iter != iterators.second; ++iter) {
-        rval.push_back(iter->m_idx);
+    rval.reserve(m_tree_unification_records.size());
+    for (const auto& r : m_tree_unification_records) {
+        if (m_nodes.exists(r.m_sptidx)) {
+            rval.push_back(r.m_sptidx);
+        }
     }
     return rval;
 }
 
+std::vector<t_uindex>
+t_stree::zero_strands() const {
+    return m_nodes.get_zero_strands();
+}
+
 std::set<t_uindex>
 t_stree::non_zero_leaves(const std::vector<t_uindex>& zero_strands) const {
     return non_zero_ids(m_newleaves, zero_strands);
@@ -1319,12 +2227,11 @@ t_stree::non_zero_ids(
 
 t_uindex
 t_stree::get_parent_idx(t_uindex ptidx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(ptidx);
-    if (iter == m_nodes->get<by_idx>().end()) {
+    if (!m_nodes.exists(ptidx)) {
         std::cout << "Failed in tree => " << repr() << std::endl;
         PSP_VERBOSE_ASSERT(false, "Did not find node");
     }
-    return iter->m_pidx;
+    return m_nodes.get_parent(ptidx);
 }
 
 std::vector<t_uindex>
@@ -1343,16 +2250,13 @@ t_stree::get_ancestry(t_uindex idx) const {
 
 t_index
 t_stree::get_sibling_idx(t_index p_ptidx, t_index p_nchild, t_uindex c_ptidx) const {
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(p_ptidx);
-    iter_by_pidx c_iter = m_nodes->project<by_pidx>(m_nodes->get<by_idx>().find(c_ptidx));
-    return std::distance(iterators.first, c_iter);
+    return m_nodes.get_sibling_idx(c_ptidx);
 }
 
 t_uindex
 t_stree::get_aggidx(t_uindex idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Failed in get_aggidx");
-    return iter->m_aggidx;
+    PSP_VERBOSE_ASSERT(m_nodes.exists(idx), "Failed in get_aggidx");
+    return m_nodes.get_aggidx(idx);
 }
 
 std::shared_ptr<const t_data_table>
@@ -1367,9 +2271,8 @@ t_stree::_get_aggtable() {
 
 t_stree::t_tnode
 t_stree::get_node(t_uindex idx) const {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Failed in get_node");
-    return *iter;
+    PSP_VERBOSE_ASSERT(m_nodes.exists(idx), "Failed in get_node");
+    return m_nodes.get(idx);
 }
 
 void
@@ -1380,9 +2283,8 @@ t_stree::get_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
         return;
 
     while (1) {
-        iter_by_idx iter = m_nodes->get<by_idx>().find(curidx);
-        rval.push_back(iter->m_value);
-        curidx = iter->m_pidx;
+        rval.push_back(m_nodes.get_value(curidx));
+        curidx = m_nodes.get_parent(curidx);
         if (curidx == 0) {
             break;
         }
@@ -1392,13 +2294,7 @@ t_stree::get_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
 
 t_uindex
 t_stree::resolve_child(t_uindex root, const t_tscalar& datum) const {
-    auto iter = m_nodes->get<by_pidx_hash>().find(std::make_tuple(root, datum));
-
-    if (iter == m_nodes->get<by_pidx_hash>().end()) {
-        return INVALID_INDEX;
-    }
-
-    return iter->m_idx;
+    return m_nodes.find_child(root, datum);
 }
 
 void
@@ -1410,12 +2306,23 @@ t_stree::clear_aggregates(const std::vector<t_uindex>& indices) {
         }
     }
 
+    if (m_has_sketches) {
+        for (t_uindex idx = 0, loop_end = m_hlls.size(); idx < loop_end; ++idx) {
+            for (auto aggidx : indices) {
+                if (aggidx < m_hlls[idx].size()) {
+                    m_hlls[idx][aggidx].clear();
+                    m_tdigests[idx][aggidx].clear();
+                }
+            }
+        }
+    }
+
     m_agg_freelist.insert(std::end(m_agg_freelist), std::begin(indices), std::end(indices));
 }
 
 void
 t_stree::drop_zero_strands() {
-    auto iterators = m_nodes->get<by_nstrands>().equal_range(0);
+    auto zeros = m_nodes.get_zero_strands();
 
     std::vector<t_uindex> leaves;
 
@@ -1423,100 +2330,105 @@ t_stree::drop_zero_strands() {
 
     std::vector<t_uindex> node_ids;
 
-    for (auto iter = iterators.first; iter != iterators.second; ++iter) {
-        if (iter->m_depth == lst)
-            leaves.push_back(iter->m_idx);
-        node_ids.push_back(iter->m_aggidx);
+    for (auto nidx : zeros) {
+        if (m_nodes.get_depth(nidx) == lst)
+            leaves.push_back(nidx);
+        node_ids.push_back(m_nodes.get_aggidx(nidx));
     }
 
     clear_aggregates(node_ids);
 
+    std::map<t_uindex, std::vector<t_uindex>> removed;
     for (auto nidx : leaves) {
         auto ancestry = get_ancestry(nidx);
 
         for (auto ancidx : ancestry) {
             if (ancidx == nidx)
                 continue;
-            remove_leaf(ancidx, nidx);
+            removed[ancidx].push_back(nidx);
         }
     }
 
-    auto iterators2 = m_nodes->get<by_nstrands>().equal_range(0);
+    for (const auto& anc : removed) {
+        m_members.remove_leaves(anc.first, anc.second);
+    }
 
-    m_nodes->get<by_nstrands>().erase(iterators2.first, iterators2.second);
+    if (!m_dirty_aggs.empty()) {
+        for (auto nidx : zeros) {
+            t_uindex depth = m_nodes.get_depth(nidx);
+            if (depth < m_dirty_aggs.size()) {
+                m_dirty_aggs[depth].erase(nidx);
+            }
+        }
+    }
+
+    m_members.erase(zeros);
+    m_nodes.erase(zeros);
+
+    // The traversals drop these ids before the next update reuses them.
+    m_node_freelist.insert(std::end(m_node_freelist), std::begin(zeros), std::end(zeros));
 }
 
 void
 t_stree::add_pkey(t_uindex idx, t_tscalar pkey) {
-    t_stpkey s(idx, pkey);
-    m_idxpkey->insert(s);
+    m_members.add_pkey(idx, pkey);
 }
 
 void
 t_stree::remove_pkey(t_uindex idx, t_tscalar pkey) {
-    auto iter = m_idxpkey->get<by_idx_pkey>().find(std::make_tuple(idx, pkey));
-
-    if (iter == m_idxpkey->get<by_idx_pkey>().end())
-        return;
-
-    m_idxpkey->get<by_idx_pkey>().erase(iter);
+    std::vector<t_tscalar> added;
+    std::vector<t_tscalar> removed{pkey};
+    m_members.update_pkeys(idx, added, removed);
 }
 
 void
 t_stree::add_leaf(t_uindex nidx, t_uindex lfidx) {
-    t_stleaves s(nidx, lfidx);
-    m_idxleaf->insert(s);
+    m_members.add_leaf(nidx, lfidx);
 }
 
 void
 t_stree::remove_leaf(t_uindex nidx, t_uindex lfidx) {
-    auto iter = m_idxleaf->get<by_idx_lfidx>().find(std::make_tuple(nidx, lfidx));
-
-    if (iter == m_idxleaf->get<by_idx_lfidx>().end())
-        return;
-
-    m_idxleaf->get<by_idx_lfidx>().erase(iter);
+    m_members.remove_leaves(nidx, std::vector<t_uindex>{lfidx});
 }
 
-t_by_idx_pkey_ipair
+const std::vector<t_tscalar>&
 t_stree::get_pkeys_for_leaf(t_uindex idx) const {
-    return m_idxpkey->get<by_idx_pkey>().equal_range(idx);
+    return m_members.get_pkeys(idx);
 }
 
 std::vector<t_tscalar>
 t_stree::get_pkeys(t_uindex idx) const {
-    std::vector<t_tscalar> rval;
-    std::vector<t_uindex> leaves = get_leaves(idx);
+    if (is_leaf(idx)) {
+        return m_members.get_pkeys(idx);
+    }
 
+    const auto& leaves = m_members.get_leaves(idx);
+    t_uindex npkeys = 0;
     for (auto leaf : leaves) {
-        auto iters = get_pkeys_for_leaf(leaf);
-        for (auto iter = iters.first; iter != iters.second; ++iter) {
-            rval.push_back(iter->m_pkey);
-        }
+        npkeys += m_members.get_pkeys(leaf).size();
+    }
+
+    std::vector<t_tscalar> rval;
+    rval.reserve(npkeys);
+    for (auto leaf : leaves) {
+        const auto& pkeys = m_members.get_pkeys(leaf);
+        rval.insert(rval.end(), pkeys.begin(), pkeys.end());
     }
     return rval;
 }
 
 std::vector<t_uindex>
 t_stree::get_leaves(t_uindex idx) const {
-    std::vector<t_uindex> rval;
-
     if (is_leaf(idx)) {
-        rval.push_back(idx);
-        return rval;
+        return std::vector<t_uindex>{idx};
     }
 
-    auto iters = m_idxleaf->get<by_idx_lfidx>().equal_range(idx);
-    for (auto iter = iters.first; iter != iters.second; ++iter) {
-        rval.push_back(iter->m_lfidx);
-    }
-    return rval;
+    return m_members.get_leaves(idx);
 }
 
 t_depth
 t_stree::get_depth(t_uindex ptidx) const {
-    auto iter = m_nodes->get<by_idx>().find(ptidx);
-    return iter->m_depth;
+    return m_nodes.get_depth(ptidx);
 }
 
 void
@@ -1550,29 +2462,16 @@ t_stree::get_drd_indices(
 
 std::vector<t_uindex>
 t_stree::get_child_idx(t_uindex idx) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<t_uindex> children(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    while (iterators.first != iterators.second) {
-        children[count] = iterators.first->m_idx;
-        ++count;
-        ++iterators.first;
-    }
-    return children;
+    return m_nodes.get_children(idx);
 }
 
 std::vector<std::pair<t_index, t_index>>
 t_stree::get_child_idx_depth(t_uindex idx) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<std::pair<t_index, t_index>> children(num_children);
-    auto iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    while (iterators.first != iterators.second) {
-        children[count]
-            = std::pair<t_index, t_index>(iterators.first->m_idx, iterators.first->m_depth);
-        ++count;
-        ++iterators.first;
+    const auto& child_idx = m_nodes.get_children(idx);
+    std::vector<std::pair<t_index, t_index>> children;
+    children.reserve(child_idx.size());
+    for (auto cidx : child_idx) {
+        children.push_back(std::pair<t_index, t_index>(cidx, m_nodes.get_depth(cidx)));
     }
     return children;
 }
@@ -1598,9 +2497,8 @@ t_stree::last_level() const {
 
 bool
 t_stree::is_leaf(t_uindex nidx) const {
-    auto iter = m_nodes->get<by_idx>().find(nidx);
-    PSP_VERBOSE_ASSERT(iter != m_nodes->get<by_idx>().end(), "Did not find node");
-    return iter->m_depth == last_level();
+    PSP_VERBOSE_ASSERT(m_nodes.exists(nidx), "Did not find node");
+    return m_nodes.get_depth(nidx) == last_level();
 }
 
 std::vector<t_uindex>
@@ -1634,12 +2532,11 @@ t_stree::resolve_path(t_uindex root, const std::vector<t_tscalar>& path) const {
         return curidx;
 
     for (t_index i = path.size() - 1; i >= 0; i--) {
-        iter_by_pidx_hash iter
-            = m_nodes->get<by_pidx_hash>().find(std::make_tuple(curidx, path[i]));
-        if (iter == m_nodes->get<by_pidx_hash>().end()) {
+        t_index child = m_nodes.find_child(curidx, path[i]);
+        if (child == INVALID_INDEX) {
             return INVALID_INDEX;
         }
-        curidx = iter->m_idx;
+        curidx = child;
     }
 
     return curidx;
@@ -1716,14 +2613,8 @@ t_stree::get_aggregate(t_index idx, t_index aggnum) const {
 
 void
 t_stree::get_child_indices(t_index idx, std::vector<t_index>& out_data) const {
-    t_index num_children = get_num_children(idx);
-    std::vector<t_index> temp(num_children);
-    t_by_pidx_ipair iterators = m_nodes->get<by_pidx>().equal_range(idx);
-    t_index count = 0;
-    for (iter_by_pidx iter = iterators.first; iter != iterators.second; ++iter) {
-        temp[count] = iter->m_idx;
-        ++count;
-    }
+    const auto& children = m_nodes.get_children(idx);
+    std::vector<t_index> temp(children.begin(), children.end());
     std::swap(out_data, temp);
 }
 
@@ -1735,7 +2626,21 @@ t_stree::clear_deltas() {
 
 void
 t_stree::clear() {
-    m_nodes->clear();
+    m_nodes.clear();
+    m_node_freelist.clear();
+    m_dirty_aggs.clear();
+    m_sketch_appends.clear();
+    m_sketch_rebuilds.clear();
+    m_sketch_changes.clear();
+
+    for (auto& hlls : m_hlls) {
+        hlls.clear();
+    }
+
+    for (auto& digests : m_tdigests) {
+        digests.clear();
+    }
+
     clear_deltas();
 }
 
@@ -1761,19 +2666,23 @@ t_stree::set_feature_state(t_ctx_feature feature, bool state) {
 
 t_minmax
 t_stree::get_agg_min_max(t_uindex aggidx, t_depth depth) const {
-    auto iterators = m_nodes->get<by_depth>().equal_range(depth);
-    return get_agg_min_max(iterators.first, iterators.second, aggidx);
+    std::vector<t_uindex> nodes;
+    for (auto nidx : m_nodes.get_ids()) {
+        if (m_nodes.get_depth(nidx) == depth) {
+            nodes.push_back(nidx);
+        }
+    }
+    return get_agg_min_max(nodes.begin(), nodes.end(), aggidx);
 }
 
 std::vector<t_minmax>
 t_stree::get_min_max() const {
     t_uindex naggs = m_aggspecs.size();
     std::vector<t_minmax> rval(naggs);
-    for (t_uindex cidx = 0; cidx < naggs; ++cidx) {
+    const auto& nodes = m_nodes.get_ids();
 
-        auto biter = m_nodes->get<by_idx>().begin();
-        auto eiter = m_nodes->get<by_idx>().end();
-        rval[cidx] = get_agg_min_max(biter, eiter, cidx);
+    for (t_uindex cidx = 0; cidx < naggs; ++cidx) {
+        rval[cidx] = get_agg_min_max(nodes.begin(), nodes.end(), cidx);
     }
     return rval;
 }
@@ -1833,8 +2742,7 @@ t_stree::first_last_helper(t_uindex nidx, const t_aggspec& spec, const t_gstate&
 
 bool
 t_stree::node_exists(t_uindex idx) {
-    iter_by_idx iter = m_nodes->get<by_idx>().find(idx);
-    return iter != m_nodes->get<by_idx>().end();
+    return m_nodes.exists(idx);
 }
 
 t_data_table*
@@ -1842,9 +2750,9 @@ t_stree::get_aggtable() {
     return m_aggregates.get();
 }
 
-std::pair<iter_by_idx, bool>
+bool
 t_stree::insert_node(const t_tnode& node) {
-    return m_nodes->insert(node);
+    return m_nodes.insert(node);
 }
 
 bool
@@ -1860,9 +2768,8 @@ t_stree::get_sortby_path(t_uindex idx, std::vector<t_tscalar>& rval) const {
         return;
 
     while (1) {
-        iter_by_idx iter = m_nodes->get<by_idx>().find(curidx);
-        rval.push_back(iter->m_sort_value);
-        curidx = iter->m_pidx;
+        rval.push_back(m_nodes.get_sort_value(curidx));
+        curidx = m_nodes.get_parent(curidx);
         if (curidx == 0) {
             break;
         }
@@ -35,18 +35,6 @@ t_stnode::set_sort_value(t_tscalar sv) {
     m_sort_value.set(sv);
 }
 
-t_stpkey::t_stpkey(t_uindex idx, t_tscalar pkey)
-    : m_idx(idx)
-    , m_pkey(pkey) {}
-
-t_stpkey::t_stpkey() {}
-
-t_stleaves::t_stleaves(t_uindex idx, t_uindex lfidx)
-    : m_idx(idx)
-    , m_lfidx(lfidx) {}
-
-t_stleaves::t_stleaves() {}
-
 t_cellinfo::t_cellinfo() {}
 
 t_cellinfo::t_cellinfo(
@@ -0,0 +1,425 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/sparse_tree_nodes.h>
+#include <boost/functional/hash.hpp>
+#include <algorithm>
+#include <iterator>
+
+namespace perspective {
+
+std::size_t
+t_stvalue_hash::operator()(const t_tscalar& value) const {
+    t_tscalar normalized = value;
+    if (value.m_type == DTYPE_FLOAT64 && value.m_data.m_float64 == 0) {
+        normalized.m_data.m_float64 = 0;
+    } else if (value.m_type == DTYPE_FLOAT32 && value.m_data.m_float32 == 0) {
+        normalized.m_data.m_uint64 = 0;
+    }
+
+    return hash_value(normalized);
+}
+
+std::size_t
+t_stvalue_hash::operator()(t_uindex value) const {
+    return std::hash<t_uindex>()(value);
+}
+
+std::size_t
+t_stnode_store::t_child_key_hash::operator()(const t_child_key& key) const {
+    std::size_t seed = 0;
+    boost::hash_combine(seed, key.first);
+    boost::hash_combine(seed, t_stvalue_hash()(key.second));
+    return seed;
+}
+
+bool
+t_stnode_store::t_child_key_equal::operator()(
+    const t_child_key& lhs, const t_child_key& rhs) const {
+    return lhs.first == rhs.first && t_stvalue_equal()(lhs.second, rhs.second);
+}
+
+t_stnode_store::t_stnode_store()
+    : m_size(0) {}
+
+t_uindex
+t_stnode_store::size() const {
+    return m_size;
+}
+
+const std::vector<t_uindex>&
+t_stnode_store::get_ids() const {
+    return m_ids;
+}
+
+void
+t_stnode_store::clear() {
+    m_exists.clear();
+    m_pidx.clear();
+    m_depth.clear();
+    m_value.clear();
+    m_sort_value.clear();
+    m_nstrands.clear();
+    m_aggidx.clear();
+    m_size = 0;
+    m_ids.clear();
+    m_id_pos.clear();
+    m_child_index.clear();
+    m_children.clear();
+    m_unsorted.clear();
+    m_zero_strands.clear();
+}
+
+bool
+t_stnode_store::exists(t_uindex idx) const {
+    return idx < m_exists.size() && m_exists[idx];
+}
+
+bool
+t_stnode_store::insert(const t_stnode& node) {
+    t_uindex idx = node.m_idx;
+    if (exists(idx))
+        return false;
+
+    t_child_key key(node.m_pidx, node.m_value);
+    if (m_child_index.find(key) != m_child_index.end())
+        return false;
+
+    if (idx >= m_exists.size()) {
+        t_uindex new_size = idx + 1;
+        m_exists.resize(new_size, 0);
+        m_pidx.resize(new_size);
+        m_depth.resize(new_size);
+        m_value.resize(new_size);
+        m_sort_value.resize(new_size);
+        m_nstrands.resize(new_size);
+        m_aggidx.resize(new_size);
+        m_id_pos.resize(new_size);
+    }
+
+    m_exists[idx] = 1;
+    m_pidx[idx] = node.m_pidx;
+    m_depth[idx] = node.m_depth;
+    m_value[idx].set(node.m_value);
+    m_sort_value[idx].set(node.m_sort_value);
+    m_nstrands[idx] = node.m_nstrands;
+    m_aggidx[idx] = node.m_aggidx;
+    ++m_size;
+
+    m_id_pos[idx] = m_ids.size();
+    m_ids.push_back(idx);
+
+    m_child_index[key] = idx;
+    set_zero(idx, node.m_nstrands == 0);
+
+    // Children mostly arrive in order, so only those which do not are
+    // sorted later. While any sibling is out of place, the last sibling is
+    // not necessarily the greatest, so every new child is treated as out of
+    // place.
+    auto& siblings = m_children[node.m_pidx];
+    if (!siblings.empty()
+        && (m_unsorted.find(node.m_pidx) != m_unsorted.end()
+            || !child_precedes(siblings.back(), idx))) {
+        mark_unsorted(node.m_pidx, idx);
+    }
+
+    siblings.push_back(idx);
+    return true;
+}
+
+void
+t_stnode_store::erase(const std::vector<t_uindex>& indices) {
+    tsl::hopscotch_set<t_uindex> parents;
+    for (auto idx : indices) {
+        PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+        m_child_index.erase(t_child_key(m_pidx[idx], m_value[idx]));
+        m_exists[idx] = 0;
+        --m_size;
+
+        t_uindex last = m_ids.back();
+        m_ids[m_id_pos[idx]] = last;
+        m_id_pos[last] = m_id_pos[idx];
+        m_ids.pop_back();
+
+        m_zero_strands.erase(idx);
+        m_children.erase(idx);
+        m_unsorted.erase(idx);
+        parents.insert(m_pidx[idx]);
+    }
+
+    for (auto pidx : parents) {
+        if (m_children.find(pidx) == m_children.end())
+            continue;
+
+        auto& children = m_children[pidx];
+        children.erase(std::remove_if(children.begin(), children.end(),
+                           [this](t_uindex idx) { return !m_exists[idx]; }),
+            children.end());
+
+        if (children.empty()) {
+            m_children.erase(pidx);
+            m_unsorted.erase(pidx);
+        }
+    }
+}
+
+t_stnode
+t_stnode_store::get(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return t_stnode(idx, m_pidx[idx], m_value[idx], m_depth[idx], m_sort_value[idx],
+        m_nstrands[idx], m_aggidx[idx]);
+}
+
+t_uindex
+t_stnode_store::get_parent(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_pidx[idx];
+}
+
+std::uint8_t
+t_stnode_store::get_depth(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_depth[idx];
+}
+
+const t_tscalar&
+t_stnode_store::get_value(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_value[idx];
+}
+
+const t_tscalar&
+t_stnode_store::get_sort_value(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_sort_value[idx];
+}
+
+t_uindex
+t_stnode_store::get_nstrands(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_nstrands[idx];
+}
+
+t_uindex
+t_stnode_store::get_aggidx(t_uindex idx) const {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    return m_aggidx[idx];
+}
+
+void
+t_stnode_store::set_nstrands(t_uindex idx, t_uindex nstrands) {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    m_nstrands[idx] = nstrands;
+    set_zero(idx, nstrands == 0);
+}
+
+void
+t_stnode_store::set_sort_value(t_uindex idx, const t_tscalar& sort_value) {
+    PSP_VERBOSE_ASSERT(exists(idx), "Did not find node");
+    bool moved = m_sort_value[idx] < sort_value || sort_value < m_sort_value[idx];
+    m_sort_value[idx].set(sort_value);
+    if (moved && m_children.at(m_pidx[idx]).size() > 1) {
+        mark_unsorted(m_pidx[idx], idx);
+    }
+}
+
+t_index
+t_stnode_store::find_child(t_uindex pidx, const t_tscalar& value) const {
+    auto iter = m_child_index.find(t_child_key(pidx, value));
+    if (iter == m_child_index.end())
+        return INVALID_INDEX;
+    return iter->second;
+}
+
+const std::vector<t_uindex>&
+t_stnode_store::get_children(t_uindex pidx) const {
+    static const std::vector<t_uindex> empty;
+
+    auto unsorted = m_unsorted.find(pidx);
+    if (unsorted != m_unsorted.end()) {
+        sort_children(pidx, unsorted->second);
+        m_unsorted.erase(unsorted);
+    }
+
+    auto iter = m_children.find(pidx);
+    return iter == m_children.end() ? empty : iter->second;
+}
+
+t_uindex
+t_stnode_store::get_sibling_idx(t_uindex idx) const {
+    const auto& siblings = get_children(get_parent(idx));
+    auto iter = std::lower_bound(siblings.begin(), siblings.end(), idx,
+        [this](t_uindex lhs, t_uindex rhs) { return child_precedes(lhs, rhs); });
+
+    if (iter == siblings.end() || *iter != idx) {
+        iter = std::find(siblings.begin(), siblings.end(), idx);
+    }
+
+    return std::distance(siblings.begin(), iter);
+}
+
+std::vector<t_uindex>
+t_stnode_store::get_zero_strands() const {
+    std::vector<t_uindex> rval(m_zero_strands.begin(), m_zero_strands.end());
+    std::sort(rval.begin(), rval.end());
+    return rval;
+}
+
+void
+t_stnode_store::sort_children() const {
+    for (auto iter = m_unsorted.begin(); iter != m_unsorted.end(); ++iter) {
+        sort_children(iter->first, iter->second);
+    }
+    m_unsorted.clear();
+}
+
+bool
+t_stnode_store::child_precedes(t_uindex lhs, t_uindex rhs) const {
+    if (m_sort_value[lhs] < m_sort_value[rhs])
+        return true;
+    if (m_sort_value[rhs] < m_sort_value[lhs])
+        return false;
+    return m_value[lhs] < m_value[rhs];
+}
+
+// The children not in `unsorted` are still in order, so only the rest
+// need sorting before the two are merged.
+void
+t_stnode_store::sort_children(t_uindex pidx, const std::vector<t_uindex>& unsorted) const {
+    if (m_children.find(pidx) == m_children.end())
+        return;
+
+    auto& children = m_children[pidx];
+    auto precedes = [this](t_uindex lhs, t_uindex rhs) { return child_precedes(lhs, rhs); };
+
+    if (unsorted.size() * 2 >= children.size()) {
+        std::sort(children.begin(), children.end(), precedes);
+        return;
+    }
+
+    tsl::hopscotch_set<t_uindex> moved(unsorted.begin(), unsorted.end());
+    std::vector<t_uindex> in_order;
+    std::vector<t_uindex> out_of_order;
+    in_order.reserve(children.size());
+
+    for (auto idx : children) {
+        if (moved.find(idx) == moved.end()) {
+            in_order.push_back(idx);
+        } else {
+            out_of_order.push_back(idx);
+        }
+    }
+
+    std::sort(out_of_order.begin(), out_of_order.end(), precedes);
+    children.clear();
+    std::merge(in_order.begin(), in_order.end(), out_of_order.begin(), out_of_order.end(),
+        std::back_inserter(children), precedes);
+}
+
+void
+t_stnode_store::mark_unsorted(t_uindex pidx, t_uindex idx) {
+    m_unsorted[pidx].push_back(idx);
+}
+
+void
+t_stnode_store::set_zero(t_uindex idx, bool zero) {
+    if (zero) {
+        m_zero_strands.insert(idx);
+    } else {
+        m_zero_strands.erase(idx);
+    }
+}
+
+void
+t_stmembership::clear() {
+    m_pkeys.clear();
+    m_leaves.clear();
+}
+
+void
+t_stmembership::add_pkey(t_uindex idx, const t_tscalar& pkey) {
+    if (idx >= m_pkeys.size()) {
+        m_pkeys.resize(idx + 1);
+    }
+
+    m_pkeys[idx].insert(pkey);
+}
+
+void
+t_stmembership::update_pkeys(t_uindex idx, const std::vector<t_tscalar>& added,
+    const std::vector<t_tscalar>& removed) {
+    if (added.empty() && removed.empty())
+        return;
+
+    if (idx >= m_pkeys.size()) {
+        m_pkeys.resize(idx + 1);
+    }
+
+    auto& pkeys = m_pkeys[idx];
+    for (const auto& pkey : removed) {
+        pkeys.erase(pkey);
+    }
+
+    for (const auto& pkey : added) {
+        pkeys.insert(pkey);
+    }
+}
+
+const std::vector<t_tscalar>&
+t_stmembership::get_pkeys(t_uindex idx) const {
+    static const std::vector<t_tscalar> empty;
+    return idx < m_pkeys.size() ? m_pkeys[idx].get() : empty;
+}
+
+bool
+t_stmembership::has_pkey(t_uindex idx, const t_tscalar& pkey) const {
+    return idx < m_pkeys.size() && m_pkeys[idx].contains(pkey);
+}
+
+void
+t_stmembership::add_leaf(t_uindex nidx, t_uindex lfidx) {
+    if (nidx >= m_leaves.size()) {
+        m_leaves.resize(nidx + 1);
+    }
+
+    m_leaves[nidx].insert(lfidx);
+}
+
+void
+t_stmembership::remove_leaves(t_uindex nidx, const std::vector<t_uindex>& lfidxs) {
+    if (nidx >= m_leaves.size())
+        return;
+
+    auto& leaves = m_leaves[nidx];
+    for (auto lfidx : lfidxs) {
+        leaves.erase(lfidx);
+    }
+}
+
+const std::vector<t_uindex>&
+t_stmembership::get_leaves(t_uindex nidx) const {
+    static const std::vector<t_uindex> empty;
+    return nidx < m_leaves.size() ? m_leaves[nidx].get() : empty;
+}
+
+void
+t_stmembership::erase(const std::vector<t_uindex>& indices) {
+    for (auto idx : indices) {
+        if (idx < m_pkeys.size()) {
+            m_pkeys[idx] = t_stmember_set<t_tscalar>();
+        }
+
+        if (idx < m_leaves.size()) {
+            m_leaves[idx] = t_stmember_set<t_uindex>();
+        }
+    }
+}
+
+} // end namespace perspective
@@ -0,0 +1,242 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/stats.h>
+#include <algorithm>
+#include <iomanip>
+
+namespace perspective {
+
+namespace {
+// All trace timestamps are relative to process start so that events from
+// different gnodes and contexts line up in a single trace.
+const t_stats::t_clock::time_point STATS_EPOCH = t_stats::t_clock::now();
+
+std::uint64_t
+stats_ns_since(t_stats::t_clock::time_point from, t_stats::t_clock::time_point to) {
+    if (to < from)
+        return 0;
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+}
+
+void
+write_json_string(std::ostream& os, const std::string& s) {
+    os << '"';
+    for (char c : s) {
+        switch (c) {
+            case '"': {
+                os << "\\\"";
+            } break;
+            case '\\': {
+                os << "\\\\";
+            } break;
+            default: {
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    os << ' ';
+                } else {
+                    os << c;
+                }
+            }
+        }
+    }
+    os << '"';
+}
+} // namespace
+
+std::string
+stats_stage_to_str(t_stats_stage stage) {
+    switch (stage) {
+        case STATS_STAGE_PROCESS: {
+            return "process";
+        } break;
+        case STATS_STAGE_FLATTEN: {
+            return "flatten";
+        } break;
+        case STATS_STAGE_LOOKUP: {
+            return "lookup";
+        } break;
+        case STATS_STAGE_PROCESS_COLUMNS: {
+            return "process_columns";
+        } break;
+        case STATS_STAGE_COMPUTED_COLUMNS: {
+            return "computed_columns";
+        } break;
+        case STATS_STAGE_UPDATE_MASTER: {
+            return "update_master";
+        } break;
+        case STATS_STAGE_NOTIFY: {
+            return "notify";
+        } break;
+        case STATS_STAGE_STEP_END: {
+            return "step_end";
+        } break;
+        case STATS_STAGE_TRAVERSAL: {
+            return "traversal";
+        } break;
+        default: { PSP_COMPLAIN_AND_ABORT("Unknown stats stage"); }
+    }
+    return "";
+}
+
+t_stats_record::t_stats_record()
+    : m_count(0)
+    , m_rows(0)
+    , m_total_ns(0)
+    , m_max_ns(0) {
+    m_histogram.fill(0);
+}
+
+void
+t_stats_record::record(std::uint64_t ns, t_uindex rows) {
+    ++m_count;
+    m_rows += rows;
+    m_total_ns += ns;
+    m_max_ns = std::max(m_max_ns, ns);
+
+    t_uindex bucket = 0;
+    while (ns > 1 && bucket < PSP_STATS_NUM_BUCKETS - 1) {
+        ns >>= 1;
+        ++bucket;
+    }
+    ++m_histogram[bucket];
+}
+
+double
+t_stats_record::percentile_ns(double p) const {
+    if (m_count == 0)
+        return 0;
+
+    std::uint64_t target = static_cast<std::uint64_t>(p * m_count);
+    std::uint64_t seen = 0;
+    for (t_uindex bucket = 0; bucket < PSP_STATS_NUM_BUCKETS; ++bucket) {
+        seen += m_histogram[bucket];
+        if (seen > target) {
+            return std::min(
+                static_cast<double>(std::uint64_t(1) << (bucket + 1)),
+                static_cast<double>(m_max_ns));
+        }
+    }
+    return static_cast<double>(m_max_ns);
+}
+
+t_stats::t_stats()
+    : m_dropped_events(0)
+    , m_trace_enabled(false) {}
+
+void
+t_stats::record(t_stats_stage stage, t_clock::time_point begin, t_uindex rows) {
+    auto end = t_clock::now();
+    std::uint64_t ns = stats_ns_since(begin, end);
+    m_records[stage].record(ns, rows);
+
+    if (!m_trace_enabled)
+        return;
+
+    if (m_events.size() >= PSP_STATS_MAX_TRACE_EVENTS) {
+        ++m_dropped_events;
+        return;
+    }
+
+    t_stats_event event;
+    event.m_stage = stage;
+    event.m_begin_ns = stats_ns_since(STATS_EPOCH, begin);
+    event.m_duration_ns = ns;
+    event.m_rows = rows;
+    m_events.push_back(event);
+}
+
+const t_stats_record&
+t_stats::get_record(t_stats_stage stage) const {
+    return m_records[stage];
+}
+
+void
+t_stats::summarize(const std::string& prefix,
+    std::map<std::string, std::map<std::string, double>>& summary) const {
+    for (t_uindex sidx = 0; sidx < STATS_STAGE_LAST; ++sidx) {
+        const t_stats_record& rec = m_records[sidx];
+        if (rec.m_count == 0)
+            continue;
+
+        auto& out = summary[prefix + stats_stage_to_str(static_cast<t_stats_stage>(sidx))];
+        out["count"] = static_cast<double>(rec.m_count);
+        out["rows"] = static_cast<double>(rec.m_rows);
+        out["total_ns"] = static_cast<double>(rec.m_total_ns);
+        out["mean_ns"] = static_cast<double>(rec.m_total_ns) / rec.m_count;
+        out["max_ns"] = static_cast<double>(rec.m_max_ns);
+        out["p50_ns"] = rec.percentile_ns(0.5);
+        out["p99_ns"] = rec.percentile_ns(0.99);
+    }
+}
+
+void
+t_stats::write_trace_events(std::ostream& os, const std::string& name, t_uindex pid,
+    t_uindex tid, bool& first) const {
+    if (m_events.empty())
+        return;
+
+    if (!first)
+        os << ",";
+    first = false;
+    os << std::fixed << std::setprecision(3);
+
+    os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << tid
+       << ",\"args\":{\"name\":";
+    write_json_string(os, name);
+    os << "}}";
+
+    for (const auto& event : m_events) {
+        os << ",{\"name\":\"" << stats_stage_to_str(event.m_stage)
+           << "\",\"cat\":\"perspective\",\"ph\":\"X\",\"pid\":" << pid << ",\"tid\":" << tid
+           << ",\"ts\":" << event.m_begin_ns / 1000.0 << ",\"dur\":" << event.m_duration_ns / 1000.0
+           << ",\"args\":{\"rows\":" << event.m_rows << "}}";
+    }
+
+    if (m_dropped_events > 0) {
+        os << ",{\"name\":\"dropped_events\",\"ph\":\"i\",\"s\":\"t\",\"pid\":" << pid
+           << ",\"tid\":" << tid << ",\"ts\":" << m_events.back().m_begin_ns / 1000.0
+           << ",\"args\":{\"count\":" << m_dropped_events << "}}";
+    }
+}
+
+void
+t_stats::reset() {
+    m_records = std::array<t_stats_record, STATS_STAGE_LAST>();
+    m_events.clear();
+    m_dropped_events = 0;
+}
+
+void
+t_stats::set_trace_enabled(bool enabled) {
+    m_trace_enabled = enabled;
+}
+
+bool
+t_stats::get_trace_enabled() const {
+    return m_trace_enabled;
+}
+
+t_stats_timer::t_stats_timer(t_stats& stats, t_stats_stage stage, t_uindex rows)
+    : m_stats(stats)
+    , m_stage(stage)
+    , m_rows(rows)
+    , m_begin(t_stats::t_clock::now()) {}
+
+t_stats_timer::~t_stats_timer() {
+    m_stats.record(m_stage, m_begin, m_rows);
+}
+
+void
+t_stats_timer::set_rows(t_uindex rows) {
+    m_rows = rows;
+}
+
+} // end namespace perspective
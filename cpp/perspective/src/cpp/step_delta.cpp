@@ -12,20 +12,6 @@
 
 namespace perspective {
 
-// Deltas for various contexts
-
-t_zcdelta::t_zcdelta(t_tscalar pkey, t_index colidx, t_tscalar old_value, t_tscalar new_value)
-    : m_pkey(pkey)
-    , m_colidx(colidx)
-    , m_old_value(old_value)
-    , m_new_value(new_value) {}
-
-t_tcdelta::t_tcdelta(t_uindex nidx, t_uindex aggidx, t_tscalar old_value, t_tscalar new_value)
-    : m_nidx(nidx)
-    , m_aggidx(aggidx)
-    , m_old_value(old_value)
-    , m_new_value(new_value) {}
-
 t_cellupd::t_cellupd(
     t_index row, t_index column, const t_tscalar& old_value, const t_tscalar& new_value)
     : row(row)
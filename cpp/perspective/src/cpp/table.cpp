@@ -211,6 +211,39 @@ Table::remove_port(t_uindex port_id) {
     m_gnode->remove_input_port(port_id);
 }
 
+std::map<std::string, std::map<std::string, double>>
+Table::get_stats() const {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(m_gnode_set, "Cannot get stats from a gnode that does not exist.");
+    return m_gnode->get_stats();
+}
+
+void
+Table::reset_stats() {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(m_gnode_set, "Cannot reset stats on a gnode that does not exist.");
+    m_gnode->reset_stats();
+}
+
+void
+Table::set_trace_enabled(bool enabled) {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(m_gnode_set, "Cannot trace a gnode that does not exist.");
+    m_gnode->set_trace_enabled(enabled);
+}
+
+std::string
+Table::get_trace_json() const {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    PSP_VERBOSE_ASSERT(m_gnode_set, "Cannot get trace from a gnode that does not exist.");
+    std::stringstream ss;
+    bool first = true;
+    ss << "{\"traceEvents\":[";
+    m_gnode->write_trace_events(ss, first);
+    ss << "],\"displayTimeUnit\":\"ns\"}";
+    return ss.str();
+}
+
 void
 Table::calculate_offset(std::uint32_t row_count) {
     m_offset = (m_offset + row_count) % m_limit;
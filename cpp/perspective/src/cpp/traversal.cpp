@@ -32,7 +32,8 @@ t_vdnode::t_vdnode(bool expanded, bool has_children)
     , m_has_children(has_children) {}
 
 t_traversal::t_traversal(std::shared_ptr<const t_stree> tree)
-    : m_tree(tree) {
+    : m_tree(tree)
+    , m_sort_valid(false) {
     t_stnode_vec rchildren;
     tree->get_child_nodes(0, rchildren);
     populate_root_children(rchildren);
@@ -40,29 +41,35 @@ t_traversal::t_traversal(std::shared_ptr<const t_stree> tree)
 
 void
 t_traversal::populate_root_children(const t_stnode_vec& rchildren) {
-    m_nodes = std::make_shared<std::vector<t_tvnode>>(rchildren.size() + 1);
+    m_nodes.clear();
+    invalidate_sort();
 
     // Initialize root
-    (*m_nodes)[0].m_expanded = true;
-    (*m_nodes)[0].m_depth = 0;
-    (*m_nodes)[0].m_rel_pidx = INVALID_INDEX;
-    (*m_nodes)[0].m_tnid = 0;
-    (*m_nodes)[0].m_ndesc = rchildren.size();
-    (*m_nodes)[0].m_nchild = rchildren.size();
-
-    t_index count = 1;
+    std::vector<t_tvnode> root(1);
+    root[0].m_expanded = true;
+    root[0].m_depth = 0;
+    root[0].m_rel_pidx = INVALID_INDEX;
+    root[0].m_tnid = 0;
+    root[0].m_ndesc = rchildren.size();
+    root[0].m_nchild = rchildren.size();
+    m_nodes.insert(0, root, INVALID_INDEX);
+
+    std::vector<t_tvnode> children(rchildren.size());
+    t_index count = 0;
 
     for (t_stnode_vec::const_iterator iter = rchildren.begin(); iter != rchildren.end();
          ++iter) {
-        t_tvnode& cnode = (*m_nodes)[count];
+        t_tvnode& cnode = children[count];
         cnode.m_expanded = false;
         cnode.m_depth = 1;
-        cnode.m_rel_pidx = count;
+        cnode.m_rel_pidx = count + 1;
         cnode.m_tnid = iter->m_idx;
         cnode.m_ndesc = 0;
         cnode.m_nchild = 0;
         count += 1;
     }
+
+    m_nodes.insert(1, children, m_nodes.handle_at(0));
 }
 
 void
@@ -74,7 +81,8 @@ t_traversal::populate_root_children(std::shared_ptr<const t_stree> tree) {
 
 t_index
 t_traversal::expand_node(t_index exp_idx) {
-    t_tvnode& exp_tvnode = (*m_nodes)[exp_idx];
+    t_index exp_handle = m_nodes.handle_at(exp_idx);
+    t_tvnode& exp_tvnode = m_nodes.node(exp_handle);
 
     if (exp_tvnode.m_expanded) {
         return 0;
@@ -98,25 +106,34 @@ t_traversal::expand_node(t_index exp_idx) {
         count += 1;
     }
 
+    // Children are in tree order.
+    if (m_sort_valid) {
+        m_unsorted_parents.insert(exp_tvnode.m_tnid);
+    }
+
     // Update node being expanded
     exp_tvnode.m_expanded = !tchildren.empty();
-    ;
     exp_tvnode.m_ndesc += n_changed;
     exp_tvnode.m_nchild = n_changed;
 
     // insert children of node into the traversal
-    m_nodes->insert(m_nodes->begin() + exp_idx + 1, children.begin(), children.end());
+    m_nodes.insert(exp_idx + 1, children, exp_handle);
 
     // update ancestors about their new descendents
-    update_ancestors(exp_idx, n_changed);
-    update_sucessors(exp_idx, n_changed);
+    update_ancestors(exp_handle, n_changed);
 
     return n_changed;
 }
 
 t_index
 t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx, t_ctx2* ctx2) {
-    t_tvnode& exp_tvnode = (*m_nodes)[exp_idx];
+    return expand_node(sortby, exp_idx, m_nodes.handle_at(exp_idx), ctx2);
+}
+
+t_index
+t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
+    t_index exp_handle, t_ctx2* ctx2) {
+    t_tvnode& exp_tvnode = m_nodes.node(exp_handle);
 
     if (exp_tvnode.m_expanded) {
         return 0;
@@ -159,6 +176,10 @@ t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
             sorted_idx[i] = i;
     }
 
+    if (m_sort_valid && sortby != m_sorted_by) {
+        m_unsorted_parents.insert(exp_tvnode.m_tnid);
+    }
+
     std::vector<t_tvnode> children = std::vector<t_tvnode>(n_changed);
     count = 0;
     for (t_index idx = 0, loop_end = sorted_idx.size(); idx < loop_end; ++idx) {
@@ -178,18 +199,18 @@ t_traversal::expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
     exp_tvnode.m_nchild = n_changed;
 
     // insert children of node into the traversal
-    m_nodes->insert(m_nodes->begin() + exp_idx + 1, children.begin(), children.end());
+    m_nodes.insert(exp_idx + 1, children, exp_handle);
 
     // update ancestors about their new descendents
-    update_ancestors(exp_idx, n_changed);
-    update_sucessors(exp_idx, n_changed);
+    update_ancestors(exp_handle, n_changed);
 
     return n_changed;
 }
 
 t_index
 t_traversal::collapse_node(t_index idx) {
-    t_tvnode& node = (*m_nodes)[idx];
+    t_index handle = m_nodes.handle_at(idx);
+    t_tvnode& node = m_nodes.node(handle);
 
     if (!node.m_expanded) {
         return 0;
@@ -201,18 +222,17 @@ t_traversal::collapse_node(t_index idx) {
     t_index bidx = idx + 1;
     t_index eidx = bidx + n_changed;
 
-    // remove entries from traversal
-    m_nodes->erase(m_nodes->begin() + bidx, m_nodes->begin() + eidx);
-
     // Update node being collapsed
     node.m_expanded = false;
     node.m_ndesc -= n_changed;
     node.m_nchild = 0;
 
+    // remove entries from traversal
+    m_nodes.erase(bidx, eidx);
+
     // update ancestors about removal of their
     // descendents
-    update_ancestors(idx, -n_changed);
-    update_sucessors(idx, -n_changed);
+    update_ancestors(handle, -n_changed);
 
     return n_changed;
 }
@@ -228,116 +248,106 @@ t_traversal::add_node(const std::vector<t_sortspec>& sortby,
 
     if (static_cast<t_index>(tv_indices.size()) == insert_level_idx) {
         t_index p_tvidx = tv_indices.back();
-        const t_tvnode& p_tvnode = (*m_nodes)[p_tvidx];
+        t_index p_handle = m_nodes.handle_at(p_tvidx);
+        t_tvnode& p_tvnode = m_nodes.node(p_handle);
         t_index p_ptidx = p_tvnode.m_tnid;
         t_index p_nchild = p_tvnode.m_nchild + 1;
         t_index c_ptidx = indices[insert_level_idx];
         t_uindex cidx = m_tree->get_sibling_idx(p_ptidx, p_nchild, c_ptidx);
         cidx = std::min(p_tvnode.m_nchild, cidx);
-        t_index cur_cidx = p_tvidx + 1;
-        for (t_uindex idx = 0; idx < cidx; ++idx) {
-            cur_cidx += (1 + (*m_nodes)[cur_cidx].m_ndesc);
+        t_index cur_cidx = p_tvidx + 1 + cidx;
+
+        // Skip over the subtrees of expanded siblings.
+        if (p_tvnode.m_ndesc != p_tvnode.m_nchild) {
+            cur_cidx = p_tvidx + 1;
+            for (t_uindex idx = 0; idx < cidx; ++idx) {
+                cur_cidx += (1 + m_nodes.node(m_nodes.handle_at(cur_cidx)).m_ndesc);
+            }
         }
 
-        (*m_nodes)[p_tvidx].m_nchild += 1;
+        p_tvnode.m_nchild += 1;
 
-        t_depth depth = get_depth(p_tvidx) + 1;
-        t_tvnode new_node;
-        fill_travnode(&new_node, false, depth, cur_cidx - p_tvidx, 0, c_ptidx);
-        auto insert_iter = m_nodes->begin() + cur_cidx;
-        m_nodes->insert(insert_iter, new_node);
-        update_ancestors(cur_cidx, 1);
-        update_sucessors(cur_cidx, 1);
+        // The new child is placed in tree order.
+        mark_unsorted(p_ptidx, c_ptidx);
+
+        t_depth depth = p_tvnode.m_depth + 1;
+        std::vector<t_tvnode> new_node(1);
+        fill_travnode(&new_node[0], false, depth, cur_cidx - p_tvidx, 0, c_ptidx);
+        m_nodes.insert(cur_cidx, new_node, p_handle);
+        update_ancestors(m_nodes.find(c_ptidx), 1);
     }
 }
 
-t_index
-t_traversal::update_ancestors(t_index nidx, t_index n_changed) {
-    if (nidx == 0)
-        return 0;
+void
+t_traversal::mark_unsorted(const std::vector<t_uindex>& tnids) {
+    if (!m_sort_valid)
+        return;
 
-    t_index pidx = nidx - (*m_nodes)[nidx].m_rel_pidx;
-    while (pidx > INVALID_INDEX) {
-        t_tvnode& node = (*m_nodes)[pidx];
-        node.m_ndesc += n_changed;
-        if (pidx == 0) {
-            pidx = INVALID_INDEX;
-        } else {
-            pidx = pidx - node.m_rel_pidx;
-        }
+    for (auto tnid : tnids) {
+        if (tnid == 0)
+            continue;
+        mark_unsorted(m_tree->get_parent_idx(tnid), tnid);
     }
-    return 0;
 }
 
-t_index
-t_traversal::update_sucessors(t_index nidx, t_index n_changed) {
-    t_tvnode* c_node = &((*m_nodes)[nidx]);
-
-    while (c_node->m_depth > 0) {
-        t_index pidx = nidx - c_node->m_rel_pidx;
-
-        const t_tvnode& p_node = (*m_nodes)[pidx];
-
-        t_index p_nchild = p_node.m_nchild;
-        t_index coffset = 1;
+void
+t_traversal::mark_unsorted(t_index parent_tnid, t_index child_tnid) {
+    if (!m_sort_valid)
+        return;
+    m_unsorted_children[parent_tnid].insert(child_tnid);
+}
 
-        for (int i = 0; i < p_nchild; i++) {
-            t_index curr_cidx = pidx + coffset;
-            t_tvnode& child_node = (*m_nodes)[curr_cidx];
-            if (curr_cidx > nidx) {
-                child_node.m_rel_pidx += n_changed;
-            }
-            if (child_node.m_expanded) {
-                coffset = coffset + child_node.m_ndesc + 1;
-            } else {
-                coffset += 1;
-            }
-        }
+void
+t_traversal::invalidate_sort() {
+    m_sort_valid = false;
+    m_sorted_by.clear();
+    m_unsorted_children.clear();
+    m_unsorted_parents.clear();
+}
 
-        nidx = pidx;
-        c_node = &((*m_nodes)[nidx]);
+void
+t_traversal::update_ancestors(t_index handle, t_index n_changed) {
+    t_index phandle = m_nodes.parent(handle);
+    while (phandle != INVALID_INDEX) {
+        m_nodes.node(phandle).m_ndesc += n_changed;
+        phandle = m_nodes.parent(phandle);
     }
-    return 0;
 }
 
 t_index
 t_traversal::get_tree_index(t_index idx) const {
-    return (*m_nodes)[idx].m_tnid;
+    return m_nodes.node(m_nodes.handle_at(idx)).m_tnid;
 }
 
 t_uindex
 t_traversal::size() const {
-    return m_nodes->size();
+    return m_nodes.size();
 }
 
 t_depth
 t_traversal::get_depth(t_index idx) const {
-    return (*m_nodes)[idx].m_depth;
+    return m_nodes.node(m_nodes.handle_at(idx)).m_depth;
 }
 
 t_index
 t_traversal::get_traversal_index(t_index idx) {
-    t_index rval = INVALID_INDEX;
-
-    for (t_index i = 0, loop_end = m_nodes->size(); i < loop_end; ++i) {
-        if ((*m_nodes)[i].m_tnid == idx) {
-            rval = i;
-            break;
-        }
-    }
-    return rval;
+    t_index handle = m_nodes.find(idx);
+    if (handle == INVALID_INDEX)
+        return INVALID_INDEX;
+    return m_nodes.position(handle);
 }
 
 std::vector<t_vdnode>
 t_traversal::get_view_nodes(t_index bidx, t_index eidx) const {
     std::vector<t_vdnode> vec(eidx - bidx);
+    std::vector<t_index> handles;
+    m_nodes.handles(bidx, eidx, handles);
     for (t_index i = bidx; i < eidx; i++) {
         t_index idx = i - bidx;
-        const t_tvnode& tv_node = (*m_nodes)[i];
+        const t_tvnode& tv_node = m_nodes.node(handles[idx]);
         vec[idx].m_expanded = tv_node.m_expanded;
         vec[idx].m_depth = tv_node.m_depth;
-        t_index tree_idx = get_tree_index(i);
-        vec[idx].m_has_children = m_tree->get_num_children(tree_idx) > 0;
+        vec[idx].m_has_children = m_tree->get_num_children(tv_node.m_tnid) > 0;
     }
     return vec;
 }
@@ -354,14 +364,14 @@ t_traversal::get_expanded_span(const std::vector<t_uindex>& in_ptidxes,
     for (t_index counter = 1, loop_end = in_ptidxes.size(); counter < loop_end; counter++) {
         bool level_node_found = false;
         t_index level_idx = INVALID_INDEX;
-        t_index p_nchild = (*m_nodes)[pidx].m_nchild;
+        t_index p_nchild = m_nodes.node(m_nodes.handle_at(pidx)).m_nchild;
 
         if (counter >= insert_level_idx) {
             p_nchild = p_nchild - 1;
         }
 
         for (t_index cidx = 0; cidx < p_nchild; ++cidx) {
-            t_tvnode& cnode = (*m_nodes)[pidx + coffset];
+            const t_tvnode& cnode = m_nodes.node(m_nodes.handle_at(pidx + coffset));
 
             if (static_cast<t_uindex>(cnode.m_tnid) == in_ptidxes[counter]) {
                 level_node_found = true;
@@ -370,7 +380,7 @@ t_traversal::get_expanded_span(const std::vector<t_uindex>& in_ptidxes,
                 if (cnode.m_expanded) {
                     pidx = pidx + coffset;
                     coffset = 1;
-                    p_nchild = (*m_nodes)[pidx].m_nchild;
+                    p_nchild = cnode.m_nchild;
                     out_indexes.push_back(pidx);
                     break;
                 }
@@ -380,7 +390,7 @@ t_traversal::get_expanded_span(const std::vector<t_uindex>& in_ptidxes,
             }
         }
 
-        if (level_node_found && (!((*m_nodes)[level_idx].m_expanded))) {
+        if (level_node_found && (!(m_nodes.node(m_nodes.handle_at(level_idx)).m_expanded))) {
             out_collpsed_ancestor = level_idx;
             break;
         }
@@ -405,33 +415,33 @@ t_traversal::validate_cells(const std::vector<std::pair<t_uindex, t_uindex>>& ce
 
 t_index
 t_traversal::remove_subtree(t_index idx) {
-    t_tvnode& node = (*m_nodes)[idx];
+    t_index handle = m_nodes.handle_at(idx);
 
     // Calculate span of descendents
-    t_index n_changed = node.m_ndesc + 1;
+    t_index n_changed = m_nodes.node(handle).m_ndesc + 1;
 
     t_index bidx = idx;
     t_index eidx = bidx + n_changed;
 
-    update_sucessors(idx, -n_changed);
-
     // update ancestors about removal of their
     // descendents
-    update_ancestors(idx, -n_changed);
+    update_ancestors(handle, -n_changed);
 
-    t_index pidx = idx - node.m_rel_pidx;
-    (*m_nodes)[pidx].m_nchild -= 1;
+    t_index phandle = m_nodes.parent(handle);
+    if (phandle != INVALID_INDEX) {
+        m_nodes.node(phandle).m_nchild -= 1;
+    }
 
     // remove entries from traversal
-    m_nodes->erase(m_nodes->begin() + bidx, m_nodes->begin() + eidx);
+    m_nodes.erase(bidx, eidx);
 
     return n_changed;
 }
 
 void
 t_traversal::pprint() const {
-    for (t_index idx = 0, loop_end = m_nodes->size(); idx < loop_end; ++idx) {
-        const t_tvnode& node = (*m_nodes)[idx];
+    for (t_index idx = 0, loop_end = m_nodes.size(); idx < loop_end; ++idx) {
+        const t_tvnode node = m_nodes.get_node(idx);
         const t_stnode tnode = m_tree->get_node(node.m_tnid);
         for (t_uindex didx = 0; didx < node.m_depth; didx++) {
             std::cout << "\t";
@@ -445,47 +455,71 @@ t_traversal::pprint() const {
 
 t_tvnode
 t_traversal::get_node(t_index idx) const {
-    return (*m_nodes)[idx];
+    return m_nodes.get_node(idx);
 }
 
 void
 t_traversal::get_leaves(std::vector<t_index>& out_data) const {
-    for (t_index curidx = 0, loop_end = m_nodes->size(); curidx < loop_end; ++curidx) {
-        if (!(*m_nodes)[curidx].m_expanded) {
+    if (m_nodes.size() == 0)
+        return;
+
+    t_index handle = m_nodes.handle_at(0);
+    for (t_index curidx = 0, loop_end = m_nodes.size(); curidx < loop_end; ++curidx) {
+        if (!m_nodes.node(handle).m_expanded) {
             out_data.push_back(curidx);
         }
+        handle = m_nodes.next(handle);
     }
 }
 
 void
 t_traversal::get_child_indices(
     t_index nidx, std::vector<std::pair<t_index, t_index>>& out_data) const {
-    const t_tvnode& tvnode = (*m_nodes)[nidx];
-    t_index nchild = tvnode.m_nchild;
-    t_index coffset = 1;
+    std::vector<std::pair<t_index, t_index>> children;
+    get_child_handles(nidx, m_nodes.handle_at(nidx), children);
+    out_data.reserve(out_data.size() + children.size());
+    for (const auto& child : children) {
+        out_data.push_back(
+            std::pair<t_index, t_index>(child.first, m_nodes.node(child.second).m_tnid));
+    }
+}
+
+void
+t_traversal::get_child_handles(t_index nidx, t_index handle,
+    std::vector<std::pair<t_index, t_index>>& out_data) const {
+    t_index nchild = m_nodes.node(handle).m_nchild;
+    t_index curr_cidx = nidx + 1;
 
-    for (int i = 0; i < nchild; i++) {
-        t_index curr_cidx = nidx + coffset;
-        const t_tvnode& child_node = (*m_nodes)[curr_cidx];
-        out_data.push_back(std::pair<t_index, t_index>(curr_cidx, child_node.m_tnid));
-        coffset = coffset + child_node.m_ndesc + 1;
+    if (nchild > 0) {
+        handle = m_nodes.next(handle);
+    }
+
+    // A child without descendants is followed directly by its next sibling.
+    for (t_index i = 0; i < nchild; i++) {
+        const t_tvnode& child_node = m_nodes.node(handle);
+        out_data.push_back(std::pair<t_index, t_index>(curr_cidx, handle));
+        curr_cidx = curr_cidx + child_node.m_ndesc + 1;
+        if (i + 1 < nchild) {
+            handle = child_node.m_ndesc == 0 ? m_nodes.next(handle) : m_nodes.handle_at(curr_cidx);
+        }
     }
 }
 
 void
 t_traversal::print_stats() {
-    std::cout << "Traversal size => " << m_nodes->size() << std::endl;
+    std::cout << "Traversal size => " << m_nodes.size() << std::endl;
 }
 
 t_index
 t_traversal::get_num_tree_leaves(t_index idx) const {
-    const t_tvnode& node = (*m_nodes)[idx];
+    t_index handle = m_nodes.handle_at(idx);
+    const t_tvnode& node = m_nodes.node(handle);
 
     t_index rval = 0;
 
-    for (t_index curidx = idx + 1, loop_end = idx + node.m_ndesc + 1; curidx < loop_end;
-         ++curidx) {
-        if (!(*m_nodes)[curidx].m_expanded) {
+    for (t_uindex count = 0; count < node.m_ndesc; ++count) {
+        handle = m_nodes.next(handle);
+        if (!m_nodes.node(handle).m_expanded) {
             ++rval;
         }
     }
@@ -508,23 +542,26 @@ t_traversal::post_order(t_index nidx, std::vector<t_index>& out_vec) {
 // Traversal
 t_index
 t_traversal::set_depth(const std::vector<t_sortspec>& sortby, t_depth depth, t_ctx2* ctx2) {
-    std::vector<t_index> pending;
+    // Pending nodes are held by position and handle - expanding a node
+    // only moves the nodes after it, and these are visited last-first.
+    std::vector<std::pair<t_index, t_index>> pending;
     depth = depth + 1;
-    pending.push_back(0);
+    pending.push_back(std::pair<t_index, t_index>(0, m_nodes.handle_at(0)));
     t_index n_changed = 0;
     while (pending.size() > 0) {
-        t_index curidx = pending.back();
+        t_index curidx = pending.back().first;
+        t_index curhandle = pending.back().second;
         pending.pop_back();
-        n_changed += expand_node(sortby, curidx, ctx2);
+        n_changed += expand_node(sortby, curidx, curhandle, ctx2);
         std::vector<std::pair<t_index, t_index>> children;
-        get_child_indices(curidx, children);
+        get_child_handles(curidx, curhandle, children);
         std::vector<t_index> collapse;
         for (t_index idx = 0, loop_end = children.size(); idx < loop_end; ++idx) {
             const std::pair<t_index, t_index>& child = children[idx];
-            const t_tvnode& tv_node = (*m_nodes)[child.first];
+            const t_tvnode& tv_node = m_nodes.node(child.second);
 
             if (tv_node.m_depth < depth) {
-                pending.push_back(child.first);
+                pending.push_back(child);
             } else if (tv_node.m_depth == depth && tv_node.m_expanded) {
                 collapse.push_back(child.first);
             }
@@ -549,7 +586,7 @@ t_traversal::get_flattened_tree(t_index idx, t_depth stop_depth) const {
     while (!queue.empty()) {
         t_index hidx = queue.front();
         queue.pop();
-        const t_tvnode& c_node = (*m_nodes)[hidx];
+        const t_tvnode& c_node = m_nodes.node(m_nodes.handle_at(hidx));
         t_depth curdepth = c_node.m_depth;
         t_ftreenode rnode;
         rnode.m_idx = c_node.m_tnid;
@@ -561,7 +598,7 @@ t_traversal::get_flattened_tree(t_index idx, t_depth stop_depth) const {
             t_index curr_cidx = hidx + 1;
             std::vector<t_index> children(nchild);
             for (int cidx = 0; cidx < nchild; cidx++) {
-                const t_tvnode& child_node = (*m_nodes)[curr_cidx];
+                const t_tvnode& child_node = m_nodes.node(m_nodes.handle_at(curr_cidx));
                 children[cidx] = curr_cidx;
                 if (child_node.m_expanded) {
                     curr_cidx = curr_cidx + child_node.m_ndesc + 1;
@@ -585,14 +622,12 @@ t_traversal::get_flattened_tree(t_index idx, t_depth stop_depth) const {
 
 t_index
 t_traversal::tree_index_lookup(t_index idx, t_index bidx) const {
-    t_index tvidx = INVALID_INDEX;
-    for (t_index i = bidx, loop_end = m_nodes->size(); i < loop_end; ++i) {
-        if ((*m_nodes)[i].m_tnid == idx) {
-            tvidx = i;
-            break;
-        }
-    }
-    return tvidx;
+    t_index handle = m_nodes.find(idx);
+    if (handle == INVALID_INDEX)
+        return INVALID_INDEX;
+
+    t_index tvidx = m_nodes.position(handle);
+    return tvidx >= bidx ? tvidx : INVALID_INDEX;
 }
 
 void
@@ -600,52 +635,45 @@ t_traversal::get_node_ancestors(t_index nidx, std::vector<t_index>& ancestors) c
     if (nidx == 0)
         return;
 
-    t_index pidx = nidx - (*m_nodes)[nidx].m_rel_pidx;
-    while (pidx > INVALID_INDEX) {
-        ancestors.push_back(pidx);
-        const t_tvnode& node = (*m_nodes)[pidx];
-        if (pidx == 0) {
-            pidx = INVALID_INDEX;
-        } else {
-            pidx = pidx - node.m_rel_pidx;
-        }
+    t_index phandle = m_nodes.parent(m_nodes.handle_at(nidx));
+    while (phandle != INVALID_INDEX) {
+        ancestors.push_back(m_nodes.position(phandle));
+        phandle = m_nodes.parent(phandle);
     }
 }
 
 void
 t_traversal::get_expanded(std::vector<t_index>& expanded_tidx) const {
     // Ancestors of expanded nodes
-    std::set<t_index> ancestors;
+    tsl::hopscotch_set<t_index> ancestors;
     std::vector<t_index> expanded;
 
-    if (m_nodes->size() == 0)
+    if (m_nodes.size() == 0)
         return;
 
-    for (t_index i = m_nodes->size() - 1; i > -1; i--) {
-        const t_tvnode& node = (*m_nodes)[i];
+    std::vector<t_index> handles;
+    m_nodes.handles(0, m_nodes.size(), handles);
 
-        if (node.m_expanded && ancestors.find(i) == ancestors.end()) {
-            expanded.push_back(i);
-            std::vector<t_index> node_ancestors;
-            get_node_ancestors(i, node_ancestors);
-            ancestors.insert(node_ancestors.begin(), node_ancestors.end());
-        }
-    }
+    for (t_index i = handles.size() - 1; i > -1; i--) {
+        t_index handle = handles[i];
+        const t_tvnode& node = m_nodes.node(handle);
 
-    std::vector<t_index> rval(expanded.size());
-
-    for (t_index i = 0, loop_end = rval.size(); i < loop_end; i++) {
-        const t_tvnode& node = (*m_nodes)[expanded[i]];
-        rval[i] = node.m_tnid;
+        if (node.m_expanded && ancestors.find(handle) == ancestors.end()) {
+            expanded.push_back(node.m_tnid);
+            t_index phandle = m_nodes.parent(handle);
+            while (phandle != INVALID_INDEX && ancestors.insert(phandle).second) {
+                phandle = m_nodes.parent(phandle);
+            }
+        }
     }
 
-    std::swap(rval, expanded_tidx);
+    std::swap(expanded, expanded_tidx);
 }
 
 void
 t_traversal::drop_tree_indices(const std::vector<t_uindex>& indices) {
     for (auto idx : indices) {
-        t_index tvidx = tree_index_lookup(idx, 0);
+        t_index tvidx = get_traversal_index(idx);
         if (tvidx == INVALID_INDEX) {
             continue;
         }
@@ -666,8 +694,14 @@ t_traversal::get_tree() const {
 
 bool
 t_traversal::get_node_expanded(t_index idx) const {
-    if (idx < 0 || static_cast<t_uindex>(idx) > m_nodes->size())
+    if (idx < 0 || static_cast<t_uindex>(idx) >= m_nodes.size())
         return false;
-    return m_nodes->at(idx).m_expanded;
+    return m_nodes.node(m_nodes.handle_at(idx)).m_expanded;
+}
+
+bool
+t_traversal::is_tree_node_expanded(t_index tnid) const {
+    t_index handle = m_nodes.find(tnid);
+    return handle != INVALID_INDEX && m_nodes.node(handle).m_expanded;
 }
 } // end namespace perspective
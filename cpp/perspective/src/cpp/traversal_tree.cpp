@@ -0,0 +1,307 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/traversal_tree.h>
+
+namespace perspective {
+
+t_tvtree::t_tvtree()
+    : m_root(INVALID_INDEX)
+    , m_seed(0x9E3779B97F4A7C15ULL) {}
+
+t_uindex
+t_tvtree::size() const {
+    return size_of(m_root);
+}
+
+void
+t_tvtree::clear() {
+    m_recs.clear();
+    m_free.clear();
+    m_handles.clear();
+    m_root = INVALID_INDEX;
+}
+
+t_index
+t_tvtree::handle_at(t_index pos) const {
+    PSP_VERBOSE_ASSERT(pos >= 0 && pos < t_index(size()), "Traversal index out of range");
+    t_index handle = m_root;
+    while (true) {
+        const t_rec& rec = m_recs[handle];
+        t_index lsize = size_of(rec.m_left);
+        if (pos < lsize) {
+            handle = rec.m_left;
+        } else if (pos == lsize) {
+            return handle;
+        } else {
+            pos -= lsize + 1;
+            handle = rec.m_right;
+        }
+    }
+}
+
+t_index
+t_tvtree::position(t_index handle) const {
+    t_index pos = size_of(m_recs[handle].m_left);
+    while (m_recs[handle].m_up != INVALID_INDEX) {
+        t_index up = m_recs[handle].m_up;
+        if (m_recs[up].m_right == handle) {
+            pos += size_of(m_recs[up].m_left) + 1;
+        }
+        handle = up;
+    }
+    return pos;
+}
+
+t_index
+t_tvtree::find(t_index tnid) const {
+    auto iter = m_handles.find(tnid);
+    if (iter == m_handles.end())
+        return INVALID_INDEX;
+    return iter->second;
+}
+
+t_tvnode&
+t_tvtree::node(t_index handle) {
+    return m_recs[handle].m_node;
+}
+
+const t_tvnode&
+t_tvtree::node(t_index handle) const {
+    return m_recs[handle].m_node;
+}
+
+t_tvnode
+t_tvtree::get_node(t_index pos) const {
+    t_index handle = handle_at(pos);
+    t_tvnode rval = m_recs[handle].m_node;
+    t_index parent = m_recs[handle].m_parent;
+    rval.m_rel_pidx = parent == INVALID_INDEX ? INVALID_INDEX : pos - position(parent);
+    return rval;
+}
+
+t_index
+t_tvtree::parent(t_index handle) const {
+    return m_recs[handle].m_parent;
+}
+
+t_index
+t_tvtree::next(t_index handle) const {
+    if (m_recs[handle].m_right != INVALID_INDEX) {
+        handle = m_recs[handle].m_right;
+        while (m_recs[handle].m_left != INVALID_INDEX) {
+            handle = m_recs[handle].m_left;
+        }
+        return handle;
+    }
+
+    while (m_recs[handle].m_up != INVALID_INDEX) {
+        t_index up = m_recs[handle].m_up;
+        if (m_recs[up].m_left == handle)
+            return up;
+        handle = up;
+    }
+
+    return INVALID_INDEX;
+}
+
+void
+t_tvtree::handles(t_index bidx, t_index eidx, std::vector<t_index>& out) const {
+    if (bidx >= eidx)
+        return;
+
+    out.reserve(out.size() + (eidx - bidx));
+    t_index handle = handle_at(bidx);
+    for (t_index idx = bidx; idx < eidx; ++idx) {
+        out.push_back(handle);
+        handle = next(handle);
+    }
+}
+
+void
+t_tvtree::insert(t_index pos, const std::vector<t_tvnode>& nodes, t_index parent) {
+    if (nodes.empty())
+        return;
+
+    std::vector<t_index> inserted(nodes.size());
+    for (t_uindex idx = 0, loop_end = nodes.size(); idx < loop_end; ++idx) {
+        t_index handle;
+        if (m_free.empty()) {
+            handle = m_recs.size();
+            m_recs.push_back(t_rec());
+        } else {
+            handle = m_free.back();
+            m_free.pop_back();
+        }
+
+        t_rec& rec = m_recs[handle];
+        rec.m_node = nodes[idx];
+        rec.m_parent = parent;
+        m_handles[nodes[idx].m_tnid] = handle;
+        inserted[idx] = handle;
+    }
+
+    t_index left;
+    t_index right;
+    split(m_root, pos, left, right);
+    m_root = merge(merge(left, build(inserted.data(), inserted.size())), right);
+    m_recs[m_root].m_up = INVALID_INDEX;
+}
+
+void
+t_tvtree::erase(t_index bidx, t_index eidx) {
+    if (bidx >= eidx)
+        return;
+
+    t_index left;
+    t_index mid;
+    t_index right;
+    split(m_root, bidx, left, mid);
+    split(mid, eidx - bidx, mid, right);
+    release(mid);
+    m_root = merge(left, right);
+    if (m_root != INVALID_INDEX) {
+        m_recs[m_root].m_up = INVALID_INDEX;
+    }
+}
+
+void
+t_tvtree::reorder(t_index bidx, const std::vector<t_index>& handles) {
+    if (handles.empty())
+        return;
+
+    t_index left;
+    t_index mid;
+    t_index right;
+    split(m_root, bidx, left, mid);
+    split(mid, handles.size(), mid, right);
+    m_root = merge(merge(left, build(handles.data(), handles.size())), right);
+    m_recs[m_root].m_up = INVALID_INDEX;
+}
+
+t_index
+t_tvtree::size_of(t_index handle) const {
+    return handle == INVALID_INDEX ? 0 : m_recs[handle].m_size;
+}
+
+void
+t_tvtree::update(t_index handle) {
+    t_rec& rec = m_recs[handle];
+    rec.m_size = 1 + size_of(rec.m_left) + size_of(rec.m_right);
+    if (rec.m_left != INVALID_INDEX)
+        m_recs[rec.m_left].m_up = handle;
+    if (rec.m_right != INVALID_INDEX)
+        m_recs[rec.m_right].m_up = handle;
+}
+
+// Joins two trees, every node of `left` preceding every node of `right`.
+// Choosing the root with probability proportional to subtree size keeps
+// the tree balanced in expectation without storing priorities.
+t_index
+t_tvtree::merge(t_index left, t_index right) {
+    if (left == INVALID_INDEX)
+        return right;
+    if (right == INVALID_INDEX)
+        return left;
+
+    t_index lsize = size_of(left);
+    t_index rsize = size_of(right);
+    if (t_index(random() % std::uint64_t(lsize + rsize)) < lsize) {
+        t_index child = merge(m_recs[left].m_right, right);
+        m_recs[left].m_right = child;
+        update(left);
+        return left;
+    }
+
+    t_index child = merge(left, m_recs[right].m_left);
+    m_recs[right].m_left = child;
+    update(right);
+    return right;
+}
+
+// Splits the tree at `handle` into its first `k` nodes and the rest.
+void
+t_tvtree::split(t_index handle, t_index k, t_index& left, t_index& right) {
+    if (handle == INVALID_INDEX) {
+        left = INVALID_INDEX;
+        right = INVALID_INDEX;
+        return;
+    }
+
+    t_index lsize = size_of(m_recs[handle].m_left);
+    if (k <= lsize) {
+        t_index child;
+        split(m_recs[handle].m_left, k, left, child);
+        m_recs[handle].m_left = child;
+        update(handle);
+        right = handle;
+    } else {
+        t_index child;
+        split(m_recs[handle].m_right, k - lsize - 1, child, right);
+        m_recs[handle].m_right = child;
+        update(handle);
+        left = handle;
+    }
+
+    if (left != INVALID_INDEX)
+        m_recs[left].m_up = INVALID_INDEX;
+    if (right != INVALID_INDEX)
+        m_recs[right].m_up = INVALID_INDEX;
+}
+
+t_index
+t_tvtree::build(const t_index* handles, t_index n) {
+    if (n <= 0)
+        return INVALID_INDEX;
+
+    t_index mid = n / 2;
+    t_index handle = handles[mid];
+    t_index left = build(handles, mid);
+    t_index right = build(handles + mid + 1, n - mid - 1);
+    m_recs[handle].m_left = left;
+    m_recs[handle].m_right = right;
+    m_recs[handle].m_up = INVALID_INDEX;
+    update(handle);
+    return handle;
+}
+
+void
+t_tvtree::release(t_index handle) {
+    std::vector<t_index> stack;
+    if (handle != INVALID_INDEX)
+        stack.push_back(handle);
+
+    while (!stack.empty()) {
+        t_index curr = stack.back();
+        stack.pop_back();
+        const t_rec& rec = m_recs[curr];
+        if (rec.m_left != INVALID_INDEX)
+            stack.push_back(rec.m_left);
+        if (rec.m_right != INVALID_INDEX)
+            stack.push_back(rec.m_right);
+
+        auto iter = m_handles.find(rec.m_node.m_tnid);
+        if (iter != m_handles.end() && iter->second == curr) {
+            m_handles.erase(iter);
+        }
+        m_free.push_back(curr);
+    }
+}
+
+// xorshift64*
+std::uint64_t
+t_tvtree::random() {
+    m_seed ^= m_seed >> 12;
+    m_seed ^= m_seed << 25;
+    m_seed ^= m_seed >> 27;
+    return m_seed * 0x2545F4914F6CDD1DULL;
+}
+
+} // end namespace perspective
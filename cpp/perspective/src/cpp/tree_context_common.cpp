@@ -17,17 +17,18 @@
 #include <perspective/env_vars.h>
 #include <perspective/dense_tree.h>
 #include <perspective/dense_tree_context.h>
+#include <perspective/tree_context_common.h>
 #include <tsl/hopscotch_set.h>
+#include <memory>
 
 namespace perspective {
 
-void
-notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
+t_sparse_tree_update
+update_sparse_tree_common(std::shared_ptr<t_data_table> strands,
     std::shared_ptr<t_data_table> strand_deltas, std::shared_ptr<t_stree> tree,
-    std::shared_ptr<t_traversal> traversal, bool process_traversal,
     const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
-    const std::vector<t_sortspec>& ctx_sortby, const t_gstate& gstate) {
+    const t_gstate& gstate) {
     t_filter fltr;
     if (t_env::log_data_nsparse_strands()) {
         std::cout << "nsparse_strands" << std::endl;
@@ -39,50 +40,54 @@ notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
         strand_deltas->pprint();
     }
 
-    auto pivots = tree->get_pivots();
-
-    t_dtree dtree(strands, pivots, tree_sortby);
-    dtree.init();
+    // Resolve each strand's path in the tree directly where the aggregates
+    // allow it, rather than grouping the strands into a `t_dtree` first.
+    std::unique_ptr<t_dtree> dtree;
+    std::unique_ptr<t_dtree_ctx> dctx;
+    std::shared_ptr<t_data_table> aggtable;
 
-    dtree.check_pivot(fltr, pivots.size() + 1);
+    if (strands->size() <= PSP_SPARSE_TREE_DIRECT_MAX_STRANDS
+        && tree->can_update_shape_from_strands(*strand_deltas, aggregates)) {
+        aggtable = tree->update_shape_from_strands(
+            *strands, *strand_deltas, aggregates, tree_sortby);
+    } else {
+        auto pivots = tree->get_pivots();
 
-    if (t_env::log_data_nsparse_dtree()) {
-        std::cout << "nsparse_dtree" << std::endl;
-        dtree.pprint(fltr);
-    }
+        dtree.reset(new t_dtree(strands, pivots, tree_sortby));
+        dtree->init();
 
-    t_dtree_ctx dctx(strands, strand_deltas, dtree, aggregates);
+        dtree->check_pivot(fltr, pivots.size() + 1);
 
-    dctx.init();
+        if (t_env::log_data_nsparse_dtree()) {
+            std::cout << "nsparse_dtree" << std::endl;
+            dtree->pprint(fltr);
+        }
 
-    tree->update_shape_from_static(dctx);
+        dctx.reset(new t_dtree_ctx(strands, strand_deltas, *dtree, aggregates));
 
-    auto zero_strands = tree->zero_strands();
+        dctx->init();
 
-    t_uindex t_osize = process_traversal ? traversal->size() : 0;
-    if (process_traversal)
-        traversal->drop_tree_indices(zero_strands);
-    t_uindex t_nsize = process_traversal ? traversal->size() : 0;
-    if (t_osize != t_nsize)
-        tree->set_has_deltas(true);
+        tree->update_shape_from_static(*dctx);
+    }
 
-    auto non_zero_ids = tree->non_zero_ids(zero_strands);
-    auto non_zero_leaves = tree->non_zero_leaves(zero_strands);
+    t_sparse_tree_update update;
+    update.m_zero_strands = tree->zero_strands();
+    update.m_non_zero_ids = tree->non_zero_ids(update.m_zero_strands);
+    auto non_zero_leaves = tree->non_zero_leaves(update.m_zero_strands);
 
     tree->drop_zero_strands();
 
     tree->populate_leaf_index(non_zero_leaves);
 
-    tree->update_aggs_from_static(dctx, gstate);
-
-    std::set<t_uindex> visited;
-
-    struct t_leaf_path {
-        std::vector<t_tscalar> m_path;
-        t_uindex m_lfidx;
-    };
+    if (dctx) {
+        tree->update_aggs_from_static(*dctx, gstate);
+    } else {
+        tree->update_aggs(*aggtable, aggregates, gstate);
+    }
+    update.m_updated_ids = tree->updated_ids();
 
-    std::vector<t_leaf_path> leaf_paths(non_zero_leaves.size());
+    auto& leaf_paths = update.m_leaf_paths;
+    leaf_paths.resize(non_zero_leaves.size());
 
     t_uindex count = 0;
 
@@ -94,7 +99,28 @@ notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
     }
 
     std::sort(leaf_paths.begin(), leaf_paths.end(),
-        [](const t_leaf_path& a, const t_leaf_path& b) { return a.m_path < b.m_path; });
+        [](const t_sparse_tree_update::t_leaf_path& a,
+            const t_sparse_tree_update::t_leaf_path& b) { return a.m_path < b.m_path; });
+
+    return update;
+}
+
+void
+update_sparse_traversal(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> traversal,
+    bool process_traversal, const t_sparse_tree_update& update,
+    const std::vector<t_sortspec>& ctx_sortby) {
+    t_uindex t_osize = process_traversal ? traversal->size() : 0;
+    if (process_traversal)
+        traversal->drop_tree_indices(update.m_zero_strands);
+    t_uindex t_nsize = process_traversal ? traversal->size() : 0;
+    if (t_osize != t_nsize)
+        tree->set_has_deltas(true);
+    if (process_traversal)
+        traversal->mark_unsorted(update.m_updated_ids);
+
+    const auto& leaf_paths = update.m_leaf_paths;
+    const auto& non_zero_ids = update.m_non_zero_ids;
+    std::set<t_uindex> visited;
 
     if (!leaf_paths.empty() && traversal.get() && traversal->size() == 1) {
         if (traversal->get_node(0).m_expanded) {
@@ -128,21 +154,44 @@ notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
 }
 
 void
-notify_sparse_tree(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> traversal,
-    bool process_traversal, const std::vector<t_aggspec>& aggregates,
+notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
+    std::shared_ptr<t_data_table> strand_deltas, std::shared_ptr<t_stree> tree,
+    std::shared_ptr<t_traversal> traversal, bool process_traversal,
+    const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
-    const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
-    const t_data_table& delta, const t_data_table& prev, const t_data_table& current,
-    const t_data_table& transitions, const t_data_table& existed, const t_config& config,
-    const t_gstate& gstate) {
+    const std::vector<t_sortspec>& ctx_sortby, const t_gstate& gstate) {
+    auto update
+        = update_sparse_tree_common(strands, strand_deltas, tree, aggregates, tree_sortby, gstate);
+    update_sparse_traversal(tree, traversal, process_traversal, update, ctx_sortby);
+}
+
+t_sparse_tree_update
+update_sparse_tree(std::shared_ptr<t_stree> tree, const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const t_data_table& flattened, const t_data_table& delta, const t_data_table& prev,
+    const t_data_table& current, const t_data_table& transitions, const t_data_table& existed,
+    const t_config& config, const t_gstate& gstate, const t_mask* prev_mask,
+    const t_mask* curr_mask) {
+    auto strand_values = tree->build_strand_table(flattened, delta, prev, current, transitions,
+        aggregates, config, prev_mask, curr_mask);
 
-    auto strand_values = tree->build_strand_table(
-        flattened, delta, prev, current, transitions, aggregates, config);
+    auto strands = strand_values.first;
+    auto strand_deltas = strand_values.second;
+    return update_sparse_tree_common(
+        strands, strand_deltas, tree, aggregates, tree_sortby, gstate);
+}
+
+t_sparse_tree_update
+update_sparse_tree(std::shared_ptr<t_stree> tree, const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const t_data_table& flattened, const t_config& config, const t_gstate& gstate,
+    const t_mask* mask) {
+    auto strand_values = tree->build_strand_table(flattened, aggregates, config, mask);
 
     auto strands = strand_values.first;
     auto strand_deltas = strand_values.second;
-    notify_sparse_tree_common(strands, strand_deltas, tree, traversal, process_traversal,
-        aggregates, tree_sortby, ctx_sortby, gstate);
+    return update_sparse_tree_common(
+        strands, strand_deltas, tree, aggregates, tree_sortby, gstate);
 }
 
 void
@@ -150,13 +199,23 @@ notify_sparse_tree(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> t
     bool process_traversal, const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
-    const t_config& config, const t_gstate& gstate) {
-    auto strand_values = tree->build_strand_table(flattened, aggregates, config);
+    const t_data_table& delta, const t_data_table& prev, const t_data_table& current,
+    const t_data_table& transitions, const t_data_table& existed, const t_config& config,
+    const t_gstate& gstate, const t_mask* prev_mask, const t_mask* curr_mask) {
+    auto update = update_sparse_tree(tree, aggregates, tree_sortby, flattened, delta, prev,
+        current, transitions, existed, config, gstate, prev_mask, curr_mask);
+    update_sparse_traversal(tree, traversal, process_traversal, update, ctx_sortby);
+}
 
-    auto strands = strand_values.first;
-    auto strand_deltas = strand_values.second;
-    notify_sparse_tree_common(strands, strand_deltas, tree, traversal, process_traversal,
-        aggregates, tree_sortby, ctx_sortby, gstate);
+void
+notify_sparse_tree(std::shared_ptr<t_stree> tree, std::shared_ptr<t_traversal> traversal,
+    bool process_traversal, const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
+    const t_config& config, const t_gstate& gstate, const t_mask* mask) {
+    auto update
+        = update_sparse_tree(tree, aggregates, tree_sortby, flattened, config, gstate, mask);
+    update_sparse_traversal(tree, traversal, process_traversal, update, ctx_sortby);
 }
 
 std::vector<t_path>
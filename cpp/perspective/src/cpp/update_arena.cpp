@@ -0,0 +1,64 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#include <perspective/first.h>
+#include <perspective/update_arena.h>
+
+namespace perspective {
+
+t_update_arena::t_update_arena() {}
+
+std::shared_ptr<t_data_table>
+t_update_arena::get_table(t_uindex slot, const t_schema& schema) {
+    if (slot >= m_slots.size()) {
+        m_slots.resize(slot + 1);
+    }
+
+    auto& tables = m_slots[slot];
+    std::shared_ptr<t_data_table>* unused = nullptr;
+
+    for (auto& table : tables) {
+        if (table.use_count() != 1) {
+            continue;
+        }
+
+        if (table->get_schema() == schema) {
+            table->clear();
+            table->clear_vocabularies();
+            return table;
+        }
+
+        unused = &table;
+    }
+
+    auto table = std::make_shared<t_data_table>(
+        "", "", schema, DEFAULT_EMPTY_CAPACITY, BACKING_STORE_MEMORY);
+    table->init();
+
+    if (unused) {
+        *unused = table;
+        return table;
+    }
+
+    // Every table of the slot is still in use - keep the newest ones.
+    if (tables.size() == PSP_UPDATE_ARENA_TABLES_PER_SLOT) {
+        tables.erase(tables.begin());
+    }
+
+    tables.push_back(table);
+
+    return table;
+}
+
+void
+t_update_arena::clear() {
+    m_slots.clear();
+}
+
+} // end namespace perspective
@@ -575,12 +575,6 @@ View<CTX_T>::_get_deltas_enabled() const {
     return m_ctx->get_deltas_enabled();
 }
 
-template <>
-bool
-View<t_ctx0>::_get_deltas_enabled() const {
-    return true;
-}
-
 template <typename CTX_T>
 void
 View<CTX_T>::_set_deltas_enabled(bool enabled_state) {
@@ -589,7 +583,14 @@ View<CTX_T>::_set_deltas_enabled(bool enabled_state) {
 
 template <>
 void
-View<t_ctx0>::_set_deltas_enabled(bool enabled_state) {}
+View<t_ctx1>::_set_deltas_enabled(bool enabled_state) {
+    // Deltas live on the tree, so a view that reads them cannot share its
+    // tree with other views.
+    if (enabled_state) {
+        m_table->get_gnode()->unshare_context_tree(m_name);
+    }
+    m_ctx->set_deltas_enabled(enabled_state);
+}
 
 // Pivot table operations
 template <typename CTX_T>
@@ -759,6 +760,14 @@ View<CTX_T>::is_column_only() const {
     return m_view_config->is_column_only();
 }
 
+template <typename CTX_T>
+std::map<std::string, std::map<std::string, double>>
+View<CTX_T>::get_stats() const {
+    std::map<std::string, std::map<std::string, double>> rval;
+    m_ctx->get_stats().summarize("", rval);
+    return rval;
+}
+
 /******************************************************************************
  *
  * Private
@@ -773,6 +782,7 @@ View<CTX_T>::_map_aggregate_types(
         if (agg.name() == name) {
             switch (agg.agg()) {
                 case AGGTYPE_DISTINCT_COUNT:
+                case AGGTYPE_APPROX_DISTINCT_COUNT:
                 case AGGTYPE_COUNT: {
                     return "integer";
                 } break;
@@ -780,7 +790,10 @@ View<CTX_T>::_map_aggregate_types(
                 case AGGTYPE_MEAN_BY_COUNT:
                 case AGGTYPE_WEIGHTED_MEAN:
                 case AGGTYPE_PCT_SUM_PARENT:
-                case AGGTYPE_PCT_SUM_GRAND_TOTAL: {
+                case AGGTYPE_PCT_SUM_GRAND_TOTAL:
+                case AGGTYPE_APPROX_MEDIAN:
+                case AGGTYPE_APPROX_P95:
+                case AGGTYPE_APPROX_P99: {
                     return "float";
                 } break;
                 default: { return typestring; } break;
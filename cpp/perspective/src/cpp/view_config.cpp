@@ -31,6 +31,7 @@ t_view_config::t_view_config(
     , m_computed_columns(computed_columns)
     , m_row_pivot_depth(-1)
     , m_column_pivot_depth(-1)
+    , m_lazy_aggregates(false)
     , m_filter_op(filter_op)
     , m_column_only(column_only) {}
 
@@ -62,6 +63,12 @@ t_view_config::set_column_pivot_depth(std::int32_t depth) {
     m_column_pivot_depth = depth;
 }
 
+void
+t_view_config::set_lazy_aggregates(bool lazy_aggregates) {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    m_lazy_aggregates = lazy_aggregates;
+}
+
 std::vector<std::string>
 t_view_config::get_row_pivots() const {
     PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
@@ -134,6 +141,12 @@ t_view_config::get_column_pivot_depth() const {
     return m_column_pivot_depth;
 }
 
+bool
+t_view_config::get_lazy_aggregates() const {
+    PSP_VERBOSE_ASSERT(m_init, "touching uninited object");
+    return m_lazy_aggregates;
+}
+
 // PRIVATE
 void
 t_view_config::fill_aggspecs(std::shared_ptr<t_schema> schema) {
@@ -10,9 +10,79 @@
 #include <perspective/first.h>
 #include <perspective/vocab.h>
 #include <tsl/hopscotch_set.h>
+#include <cstring>
+#ifdef PSP_PARALLEL_FOR
+#include <tbb/parallel_for.h>
+#endif
 
 namespace perspective {
 
+t_vocab_index::t_vocab_index()
+    : m_size(0) {}
+
+void
+t_vocab_index::insert(std::size_t hash, t_uindex id) {
+    // Stay at most half full, so probes for absent strings end quickly
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        rehash(std::max(static_cast<t_uindex>(16), static_cast<t_uindex>(m_slots.size()) * 2));
+    }
+
+    t_uindex mask = m_slots.size() - 1;
+    t_uindex slot = hash & mask;
+    while (m_slots[slot].m_id != PSP_VOCAB_ABSENT) {
+        slot = (slot + 1) & mask;
+    }
+
+    m_slots[slot].m_hash = hash;
+    m_slots[slot].m_id = id;
+    ++m_size;
+}
+
+void
+t_vocab_index::reserve(t_uindex size) {
+    t_uindex capacity = 16;
+    while (capacity < size * 2) {
+        capacity *= 2;
+    }
+
+    if (capacity > m_slots.size()) {
+        rehash(capacity);
+    }
+}
+
+void
+t_vocab_index::clear() {
+    t_slot empty = {0, PSP_VOCAB_ABSENT};
+    std::fill(m_slots.begin(), m_slots.end(), empty);
+    m_size = 0;
+}
+
+t_uindex
+t_vocab_index::size() const {
+    return m_size;
+}
+
+void
+t_vocab_index::rehash(t_uindex capacity) {
+    t_slot empty = {0, PSP_VOCAB_ABSENT};
+    std::vector<t_slot> slots(capacity, empty);
+    t_uindex mask = capacity - 1;
+
+    for (const t_slot& existing : m_slots) {
+        if (existing.m_id == PSP_VOCAB_ABSENT)
+            continue;
+
+        t_uindex slot = existing.m_hash & mask;
+        while (slots[slot].m_id != PSP_VOCAB_ABSENT) {
+            slot = (slot + 1) & mask;
+        }
+
+        slots[slot] = existing;
+    }
+
+    std::swap(m_slots, slots);
+}
+
 t_vocab::t_vocab()
     : m_vlenidx(0) {
     m_vlendata.reset(new t_lstore);
@@ -38,10 +108,13 @@ t_vocab::t_vocab(const t_lstore_recipe& vlendata_recipe, const t_lstore_recipe&
 
 void
 t_vocab::rebuild_map() {
-    m_map.clear();
-    m_map.reserve((size_t)m_vlenidx);
+    m_index.clear();
+    m_index.reserve(m_vlenidx);
     for (t_uindex idx = 0; idx < m_vlenidx; ++idx) {
-        m_map[unintern_c(idx)] = idx;
+        const std::pair<t_uindex, t_uindex>* p
+            = m_extents->get_nth<std::pair<t_uindex, t_uindex>>(idx);
+        // Extents include the trailing zero byte
+        m_index.insert(hash_string(unintern_c(idx), p->second - p->first - 1), idx);
     }
 }
 
@@ -49,17 +122,27 @@ void
 t_vocab::reserve(size_t total_string_size, size_t string_count) {
     m_vlendata->reserve(total_string_size);
     m_extents->reserve(sizeof(std::pair<t_uindex, t_uindex>) * string_count);
-    rebuild_map();
+    m_index.reserve(string_count);
+}
+
+bool
+t_vocab::is_interned_as(t_uindex idx, const char* s, t_uindex size) const {
+    const std::pair<t_uindex, t_uindex>* p
+        = m_extents->get_nth<std::pair<t_uindex, t_uindex>>(idx);
+    return p->second - p->first == size + 1
+        && std::memcmp(m_vlendata->get_ptr(p->first), s, size) == 0;
 }
 
 bool
 t_vocab::string_exists(const char* c, t_uindex& interned) const {
-    auto iter = m_map.find(c);
+    t_uindex size = strlen(c);
+    t_uindex idx = m_index.find(hash_string(c, size),
+        [this, c, size](t_uindex candidate) { return is_interned_as(candidate, c, size); });
 
-    if (iter == m_map.end())
+    if (idx == PSP_VOCAB_ABSENT)
         return false;
 
-    interned = iter->second;
+    interned = idx;
     return true;
 }
 
@@ -68,33 +151,144 @@ t_vocab::get_interned(const char* s) {
 #ifdef PSP_COLUMN_VERIFY
     PSP_VERBOSE_ASSERT(s != 0, "Null string");
 #endif
+    t_uindex size = strlen(s);
+    return get_interned(s, size, hash_string(s, size));
+}
+
+t_uindex
+t_vocab::get_interned(const char* s, t_uindex size, std::size_t hash) {
+    t_uindex idx = m_index.find(
+        hash, [this, s, size](t_uindex candidate) { return is_interned_as(candidate, s, size); });
+
+    if (idx != PSP_VOCAB_ABSENT)
+        return idx;
+
+    idx = genidx();
+
+    // Store the string with a trailing zero byte, so `unintern_c` can
+    // return it as is.
+    t_uindex bidx = m_vlendata->size();
+    char* dest = m_vlendata->extend<char>(size + 1);
+    std::memcpy(dest, s, size);
+    dest[size] = '\0';
+    m_extents->push_back(std::pair<t_uindex, t_uindex>(bidx, bidx + size + 1));
+    m_index.insert(hash, idx);
+    return idx;
+}
 
-    t_sidxmap::iterator iter = m_map.find(s);
-
-    t_uindex idx, bidx, eidx;
-    t_uindex len = strlen(s) + 1;
-
-    if (iter == m_map.end()) {
-        idx = genidx();
-
-        bidx = m_vlendata->size();
-        eidx = bidx + len;
-        const void* obase = m_vlendata->get_nth<const char>(0);
-        const void* oebase = m_extents->get_nth<std::pair<t_uindex, t_uindex>>(0);
-        m_vlendata->push_back(static_cast<const void*>(s), len);
-        m_extents->push_back(std::pair<t_uindex, t_uindex>(bidx, eidx));
-        const void* nbase = m_vlendata->get_nth<const char>(0);
-        const void* nebase = m_extents->get_nth<std::pair<t_uindex, t_uindex>>(0);
-        if ((obase == nbase) && (oebase == nebase)) {
-            m_map[unintern_c(idx)] = idx;
-        } else {
-            rebuild_map();
+void
+t_vocab::get_interned_bulk(const std::vector<t_vocab_string>& strings, t_uindex* ids) {
+    t_uindex nstrings = strings.size();
+
+#ifdef PSP_PARALLEL_FOR
+    if (nstrings >= 2 * PSP_VOCAB_BULK_CHUNK_SIZE) {
+        t_uindex nchunks = (nstrings + PSP_VOCAB_BULK_CHUNK_SIZE - 1) / PSP_VOCAB_BULK_CHUNK_SIZE;
+
+        // For each chunk, the position of the first occurrence of each of its
+        // distinct strings, while `ids` holds each string's index in there.
+        std::vector<std::vector<t_uindex>> distinct(nchunks);
+
+        tbb::parallel_for(0, int(nchunks), 1,
+            [&strings, &distinct, ids, nstrings](int chunk) {
+                t_uindex bidx = chunk * PSP_VOCAB_BULK_CHUNK_SIZE;
+                t_uindex eidx = std::min(bidx + PSP_VOCAB_BULK_CHUNK_SIZE, nstrings);
+                std::vector<t_uindex>& chunk_distinct = distinct[chunk];
+                t_vocab_index chunk_index;
+
+                for (t_uindex idx = bidx; idx < eidx; ++idx) {
+                    const t_vocab_string& s = strings[idx];
+                    t_uindex local = chunk_index.find(
+                        s.m_hash, [&strings, &chunk_distinct, &s](t_uindex candidate) {
+                            const t_vocab_string& other = strings[chunk_distinct[candidate]];
+                            return other.m_size == s.m_size
+                                && std::memcmp(other.m_data, s.m_data, s.m_size) == 0;
+                        });
+
+                    if (local == PSP_VOCAB_ABSENT) {
+                        local = chunk_distinct.size();
+                        chunk_index.insert(s.m_hash, local);
+                        chunk_distinct.push_back(idx);
+                    }
+
+                    ids[idx] = local;
+                }
+            });
+
+        // Intern each chunk's distinct strings in order, which gives out ids
+        // in the same order as interning every string in turn.
+        for (std::vector<t_uindex>& chunk_distinct : distinct) {
+            for (t_uindex& position : chunk_distinct) {
+                const t_vocab_string& s = strings[position];
+                position = get_interned(s.m_data, s.m_size, s.m_hash);
+            }
         }
-    } else {
-        idx = iter->second;
+
+        tbb::parallel_for(0, int(nchunks), 1, [&distinct, ids, nstrings](int chunk) {
+            t_uindex bidx = chunk * PSP_VOCAB_BULK_CHUNK_SIZE;
+            t_uindex eidx = std::min(bidx + PSP_VOCAB_BULK_CHUNK_SIZE, nstrings);
+            const std::vector<t_uindex>& chunk_ids = distinct[chunk];
+            for (t_uindex idx = bidx; idx < eidx; ++idx) {
+                ids[idx] = chunk_ids[ids[idx]];
+            }
+        });
+
+        return;
     }
+#endif
 
-    return idx;
+    for (t_uindex idx = 0; idx < nstrings; ++idx) {
+        const t_vocab_string& s = strings[idx];
+
+        // Runs of the same string reuse the previous id without a lookup
+        if (idx > 0) {
+            const t_vocab_string& prev = strings[idx - 1];
+            if (prev.m_hash == s.m_hash && prev.m_size == s.m_size
+                && std::memcmp(prev.m_data, s.m_data, s.m_size) == 0) {
+                ids[idx] = ids[idx - 1];
+                continue;
+            }
+        }
+
+        ids[idx] = get_interned(s.m_data, s.m_size, s.m_hash);
+    }
+}
+
+std::size_t
+t_vocab::hash_string(const char* s, t_uindex size) {
+    // Mix 8 bytes at a time, rather than hashing byte by byte
+    const std::uint64_t k0 = 0x9e3779b97f4a7c15ULL;
+    const std::uint64_t k1 = 0xbf58476d1ce4e5b9ULL;
+    std::uint64_t h = static_cast<std::uint64_t>(size) * k0;
+    t_uindex idx = 0;
+
+    for (; idx + 8 <= size; idx += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, s + idx, 8);
+        word *= k1;
+        word ^= word >> 31;
+        h = (h ^ word) * k0;
+    }
+
+    if (idx < size) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, s + idx, size - idx);
+        word *= k1;
+        word ^= word >> 31;
+        h = (h ^ word) * k0;
+    }
+
+    h ^= h >> 32;
+    h *= k1;
+    h ^= h >> 29;
+    return static_cast<std::size_t>(h);
+}
+
+void
+t_vocab::clear() {
+    m_index.clear();
+    m_vlendata->clear();
+    m_extents->clear();
+    m_vlenidx = 0;
 }
 
 t_uindex
@@ -118,30 +312,25 @@ t_vocab::get_interned(const std::string& s) {
 
 void
 t_vocab::verify() const {
-    std::map<t_uindex, const char*> rlookup;
-
-    for (const auto& kv : m_map) {
-        rlookup[kv.second] = kv.first;
-    }
-
     tsl::hopscotch_set<std::string> seen;
 
     for (t_uindex idx = 1; idx < m_vlenidx; ++idx) {
+        std::string curstr = std::string(unintern_c(idx));
+        t_uindex interned;
+
         std::stringstream ss;
         ss << "idx => " << idx << " not found";
-        PSP_VERBOSE_ASSERT(rlookup.find(idx) != rlookup.end(), ss.str());
-
-        std::string curstr = std::string(rlookup.at(idx));
+        PSP_VERBOSE_ASSERT(string_exists(curstr.c_str(), interned), ss.str());
 
         PSP_VERBOSE_ASSERT(seen.find(curstr) == seen.end(), "string encountered again");
 
-        PSP_VERBOSE_ASSERT(std::string(unintern_c(idx)) == curstr, "String mismatch");
+        PSP_VERBOSE_ASSERT(interned == idx, "String mismatch");
     }
 }
 
 void
 t_vocab::verify_size() const {
-    PSP_VERBOSE_ASSERT(m_vlenidx == m_map.size(), "Size and vlenidx size dont line up");
+    PSP_VERBOSE_ASSERT(m_vlenidx == m_index.size(), "Size and vlenidx size dont line up");
 
     PSP_VERBOSE_ASSERT(
         m_vlenidx * sizeof(std::pair<t_uindex, t_uindex>) <= m_extents->capacity(),
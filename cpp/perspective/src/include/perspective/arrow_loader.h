@@ -58,11 +58,33 @@ namespace arrow {
         std::vector<t_dtype> m_types;
     };
 
-    template <typename T, typename V>
+    /**
+     * @brief Point a `t_vocab_string` at each string of `src` in place,
+     * hashing them in parallel where available.
+     *
+     * @param src
+     * @return std::vector<t_vocab_string>
+     */
+    std::vector<t_vocab_string>
+    get_vocab_strings(std::shared_ptr<::arrow::StringArray> src);
+
+    /**
+     * @brief Write the vocab id of each dictionary index in `src` into `dest`,
+     * through `remap` from dictionary index to vocab id.
+     *
+     * @tparam T the Arrow array type of the indices
+     * @param dest
+     * @param src
+     * @param remap
+     * @param offset
+     * @param len
+     */
+    template <typename T>
     void
-    iter_col_copy(
+    gather_dictionary_indices(
         std::shared_ptr<t_column> dest,
         std::shared_ptr<::arrow::Array> src,
+        const std::vector<t_uindex>& remap,
         const int64_t offset,
         const int64_t len);
 
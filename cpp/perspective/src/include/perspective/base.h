@@ -312,7 +312,11 @@ enum t_aggtype {
     AGGTYPE_DISTINCT_COUNT,
     AGGTYPE_DISTINCT_LEAF,
     AGGTYPE_PCT_SUM_PARENT,
-    AGGTYPE_PCT_SUM_GRAND_TOTAL
+    AGGTYPE_PCT_SUM_GRAND_TOTAL,
+    AGGTYPE_APPROX_DISTINCT_COUNT,
+    AGGTYPE_APPROX_MEDIAN,
+    AGGTYPE_APPROX_P95,
+    AGGTYPE_APPROX_P99
 };
 
 PERSPECTIVE_EXPORT t_aggtype str_to_aggtype(const std::string& str);
@@ -371,6 +375,7 @@ enum t_ctx_feature {
     CTX_FEAT_DELTA,
     CTX_FEAT_ALERT,
     CTX_FEAT_ENABLED,
+    CTX_FEAT_LAZY_AGGREGATES,
     CTX_FEAT_LAST_FEATURE
 };
 
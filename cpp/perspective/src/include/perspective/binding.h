@@ -226,6 +226,7 @@ namespace binding {
      * @param index
      * @param is_update
      * @param is_arrow
+     * @param is_csv whether `accessor` is a string of CSV
      * @return std::shared_ptr<t_gnode>
      */
     template <typename T>
@@ -237,6 +238,7 @@ namespace binding {
         t_op op,
         bool is_update,
         bool is_arrow,
+        bool is_csv,
         t_uindex port_id);
 
     /******************************************************************************
@@ -173,6 +173,12 @@ public:
 
     void copy_vocabulary(const t_column* other);
 
+    /**
+     * @brief Empty the vocabulary of a string column - a borrowed vocabulary
+     * is replaced rather than cleared.
+     */
+    void clear_vocabulary();
+
     void pprint_vocabulary() const;
 
     template <typename DATA_T>
@@ -203,6 +209,15 @@ public:
     t_uindex get_interned(const char* s);
     void _rebuild_map();
 
+    /**
+     * @brief Intern `strings` as a batch, and set them as the valid values
+     * of consecutive rows starting at `offset`.
+     *
+     * @param offset
+     * @param strings
+     */
+    void set_strings(t_uindex offset, const std::vector<t_vocab_string>& strings);
+
     void borrow_vocabulary(const t_column& o);
 
 private:
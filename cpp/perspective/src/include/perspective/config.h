@@ -132,6 +132,15 @@ public:
 
     std::string repr() const;
 
+    /**
+     * @brief Returns a string which is equal for two configs exactly when
+     * their filters, filter combiner and computed columns are equal, for
+     * use in keys identifying state that can be shared between contexts.
+     *
+     * @return std::string
+     */
+    std::string get_filter_signature() const;
+
     t_uindex get_num_aggregates() const;
 
     t_uindex get_num_columns() const;
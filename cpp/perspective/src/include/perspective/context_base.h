@@ -21,6 +21,8 @@
 #include <perspective/slice.h>
 #include <perspective/range.h>
 #include <perspective/gnode_state.h>
+#include <perspective/filter_cache.h>
+#include <perspective/stats.h>
 
 namespace perspective {
 
@@ -53,6 +55,15 @@ public:
     std::string get_name() const;
     std::int64_t get_ptr() const;
     void set_state(std::shared_ptr<t_gstate> gstate);
+
+    /**
+     * @brief The masks of the filter terms of every context of the gnode
+     * over the update being notified, which the gnode fills in before
+     * notifying its contexts and empties afterwards.
+     *
+     * @param filter_cache
+     */
+    void set_filter_cache(std::shared_ptr<const t_filter_cache> filter_cache);
     const t_config& get_config() const;
     t_config& get_config();
     std::vector<t_pivot> get_pivots() const;
@@ -81,6 +92,15 @@ public:
 
     std::vector<t_tscalar> get_data() const;
 
+    /**
+     * @brief The timing counters for this context's `notify` and `step_end`,
+     * recorded by the gnode that owns it.
+     *
+     * @return t_stats&
+     */
+    t_stats& get_stats();
+    const t_stats& get_stats() const;
+
 protected:
     t_schema m_schema;
     t_config m_config;
@@ -88,9 +108,11 @@ protected:
     bool m_columns_changed;
     std::string m_name;
     std::shared_ptr<t_gstate> m_gstate;
+    std::shared_ptr<const t_filter_cache> m_filter_cache;
     bool m_init;
     std::vector<bool> m_features;
     std::vector<t_minmax> m_minmax;
+    t_stats m_stats;
 };
 
 template <typename DERIVED_T>
@@ -146,6 +168,12 @@ t_ctxbase<DERIVED_T>::set_state(std::shared_ptr<t_gstate> gstate) {
     m_gstate = gstate;
 }
 
+template <typename DERIVED_T>
+void
+t_ctxbase<DERIVED_T>::set_filter_cache(std::shared_ptr<const t_filter_cache> filter_cache) {
+    m_filter_cache = filter_cache;
+}
+
 template <typename DERIVED_T>
 t_config&
 t_ctxbase<DERIVED_T>::get_config() {
@@ -188,6 +216,18 @@ t_ctxbase<DERIVED_T>::get_minmax_enabled() const {
     return m_features[CTX_FEAT_MINMAX];
 }
 
+template <typename DERIVED_T>
+t_stats&
+t_ctxbase<DERIVED_T>::get_stats() {
+    return m_stats;
+}
+
+template <typename DERIVED_T>
+const t_stats&
+t_ctxbase<DERIVED_T>::get_stats() const {
+    return m_stats;
+}
+
 template <typename DERIVED_T>
 bool
 t_ctxbase<DERIVED_T>::failed() const {
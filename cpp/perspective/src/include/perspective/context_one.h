@@ -15,6 +15,8 @@
 #include <perspective/sort_specification.h>
 #include <perspective/traversal.h>
 #include <perspective/data_table.h>
+#include <perspective/tree_context_common.h>
+#include <functional>
 
 namespace perspective {
 
@@ -44,9 +46,64 @@ public:
 
     t_depth get_trav_depth(t_index idx) const;
 
+    std::vector<t_path> get_expansion_state() const;
+    void set_expansion_state(const std::vector<t_path>& paths);
+
+    /**
+     * @brief Returns a key that is equal for any two contexts over the same
+     * gnode whose `t_stree`s would be identical, i.e. which have the same
+     * row pivots, aggregates, filters and computed columns. Such contexts
+     * may differ in sort, depth and expansion, which only affect their
+     * `t_traversal`, and can share one tree.
+     *
+     * @return std::string
+     */
+    std::string get_tree_signature() const;
+
+    std::shared_ptr<t_stree> get_tree() const;
+
+    /**
+     * @brief Replace this context's tree with `tree`, which must have been
+     * built from a config with the same `get_tree_signature()`, and reset
+     * the traversal to the top level of the new tree.
+     *
+     * @param tree
+     */
+    void set_tree(std::shared_ptr<t_stree> tree);
+
+    /**
+     * @brief Update this context's tree, but not its traversal, returning
+     * the changes that `notify_traversal` needs. `notify` is equivalent to
+     * `notify_traversal(notify_tree(...))`.
+     */
+    t_sparse_tree_update notify_tree(const t_data_table& flattened, const t_data_table& delta,
+        const t_data_table& prev, const t_data_table& current, const t_data_table& transitions,
+        const t_data_table& existed);
+
+    void notify_traversal(const t_sparse_tree_update& update);
+
+    /**
+     * @brief Defer aggregates that are recomputed from each node's pkeys,
+     * such as median and distinct count, on nodes collapsed out of the
+     * traversal, until they are shown by `open`, `set_depth` or
+     * `get_agg_min_max`. Has no effect while min/max is enabled, or on a
+     * tree shared with other contexts.
+     *
+     * @param enabled_state
+     */
+    void set_lazy_aggregates_enabled(bool enabled_state);
+
     using t_ctxbase<t_ctx1>::get_data;
 
 private:
+    /**
+     * @brief When lazy aggregates are enabled, whether a tree node will be
+     * in the traversal once the current update is applied - the root, the
+     * children of expanded nodes, and any node within the depth that
+     * `step_end` expands to.
+     */
+    std::function<bool(t_uindex)> get_agg_visibility() const;
+
     std::shared_ptr<t_traversal> m_traversal;
     std::shared_ptr<t_stree> m_tree;
     std::vector<t_sortspec> m_sortby;
@@ -71,6 +71,30 @@ protected:
 
     t_uindex calc_translated_colidx(t_uindex n_aggs, t_uindex cidx) const;
 
+    /**
+     * @brief The cells in rows [bidx, eidx) whose node has deltas, in row
+     * then column order, resolved as `resolve_cells` would resolve them -
+     * but found from each tree's deltas, rather than by resolving every
+     * cell in the view.
+     *
+     * @param bidx
+     * @param eidx
+     * @return std::vector<t_cellinfo>
+     */
+    std::vector<t_cellinfo> get_changed_cells(t_index bidx, t_index eidx) const;
+
+    /**
+     * @brief Re-sort the row traversal by `m_sortby` after an update, only
+     * moving the rows whose sort values changed where possible.
+     */
+    void update_row_sort();
+
+    /**
+     * @brief Call `notify_tree` with the index of each tree in `m_trees`,
+     * concurrently when parallel notification is enabled.
+     */
+    void notify_trees(const std::function<void(t_uindex)>& notify_tree);
+
 private:
     std::shared_ptr<t_traversal> m_rtraversal;
     std::shared_ptr<t_traversal> m_ctraversal;
@@ -41,6 +41,35 @@ public:
     void sort_by();
     std::vector<t_sortspec> get_sort_by() const;
 
+    /**
+     * @brief Returns a key that is equal for any two contexts over the same
+     * gnode whose traversals would hold the same rows in the same order,
+     * i.e. which sort by the same columns and have the same filters. Such
+     * contexts can share one `t_ftrav`, regardless of visible columns.
+     *
+     * @return std::string
+     */
+    std::string get_traversal_signature() const;
+
+    std::shared_ptr<t_ftrav> get_traversal() const;
+
+    /**
+     * @brief Read through `traversal`, which is owned (and updated) by
+     * another context with the same `get_traversal_signature()`.
+     *
+     * @param traversal
+     */
+    void set_traversal(std::shared_ptr<t_ftrav> traversal);
+
+    /**
+     * @brief Set whether this context updates its traversal when notified.
+     * Of the contexts sharing a traversal exactly one must own it, and be
+     * notified before the others; the rest only calculate their deltas.
+     *
+     * @param owner
+     */
+    void set_traversal_owner(bool owner);
+
     using t_ctxbase<t_ctx0>::get_data;
 
 protected:
@@ -54,13 +83,34 @@ protected:
 
     void add_delta_pkey(t_tscalar pkey);
 
+    /**
+     * @brief Fold the rows of an update into the tracked column extrema. A
+     * column whose current min or max is removed is marked stale, and is
+     * recomputed by the next `get_min_max`.
+     *
+     * @param flattened
+     * @param prev
+     * @param curr
+     * @param existed
+     */
+    void update_min_max(const t_data_table& flattened, const t_data_table& prev,
+        const t_data_table& curr, const t_data_table& existed);
+
+    void invalidate_min_max();
+
+    void recompute_min_max(t_uindex colidx) const;
+
 private:
     std::shared_ptr<t_ftrav> m_traversal;
     std::shared_ptr<t_zcdeltas> m_deltas;
     tsl::hopscotch_set<t_tscalar> m_delta_pkeys;
-    std::vector<t_minmax> m_minmax;
+    // Column extrema are only tracked once `get_min_max` has been called.
+    mutable std::vector<t_minmax> m_minmax;
+    mutable std::vector<bool> m_minmax_stale;
+    mutable bool m_minmax_tracked;
     t_symtable m_symtable;
     bool m_has_delta;
+    bool m_owns_traversal;
 };
 
 } // end namespace perspective
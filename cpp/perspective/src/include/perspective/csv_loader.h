@@ -0,0 +1,146 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/data_table.h>
+#include <perspective/date_parser.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace perspective {
+namespace csv {
+
+    // Rows sampled to infer each column's type.
+    const t_uindex PSP_CSV_INFER_ROWS = 1000;
+
+    // Bytes of text, and rows, handled by each task when parsing in parallel.
+    const t_uindex PSP_CSV_SPLIT_CHUNK_SIZE = 1 << 20;
+    const t_uindex PSP_CSV_PARSE_CHUNK_SIZE = 1 << 14;
+
+    /**
+     * @brief A field of a CSV row, pointing into the loaded text. Quoted
+     * fields point inside their quotes, and `m_escaped` marks fields with
+     * doubled quotes, which must be unescaped before use.
+     */
+    struct t_csv_field {
+        const char* m_data;
+        t_uindex m_size;
+        bool m_escaped;
+    };
+
+    /**
+     * @brief Parses CSV text straight into typed columns.
+     *
+     * The first row names the columns. Each column's type is inferred from
+     * the first `PSP_CSV_INFER_ROWS` rows, and promoted with
+     * `t_data_table::promote_column` if a later value does not fit. Empty
+     * fields are null. Where `PSP_PARALLEL_FOR` is defined, rows are split
+     * and parsed in parallel chunks.
+     */
+    class PERSPECTIVE_EXPORT CsvLoader {
+    public:
+        CsvLoader();
+        ~CsvLoader();
+
+        /**
+         * @brief Split `data` into rows, read the column names, and parse
+         * every column into the type inferred for it.
+         *
+         * @param data
+         */
+        void initialize(std::string data);
+
+        /**
+         * @brief Fill the columns of `tbl` that the CSV has. Columns already
+         * parsed into the dtype `tbl` wants are moved into it, and the rest
+         * are parsed again into that dtype, with values that do not fit left
+         * null.
+         *
+         * @param tbl
+         * @param index
+         * @param offset
+         * @param limit
+         * @param is_update
+         */
+        void fill_table(
+            t_data_table& tbl,
+            const std::string& index,
+            std::uint32_t offset,
+            std::uint32_t limit,
+            bool is_update);
+
+        std::vector<std::string> names() const;
+        std::vector<t_dtype> types() const;
+        std::uint32_t row_count() const;
+
+    private:
+        void split_rows();
+        void infer_types();
+
+        void fill_column(t_data_table& tbl, std::shared_ptr<t_column> col,
+            const std::string& name, t_uindex cidx, bool is_update);
+
+        /**
+         * @brief Parse the CSV columns at `cidxs` into `cols`, in the dtypes
+         * of `cols`.
+         *
+         * @param cidxs
+         * @param cols
+         * @param formats the datestring format of each column
+         * @param promote whether to report values that do not fit, rather
+         * than leave them null
+         * @return std::vector<t_dtype> the dtype each column must be promoted
+         * to in order to fit every value, or `DTYPE_NONE`
+         */
+        std::vector<t_dtype> parse_columns(const std::vector<t_uindex>& cidxs,
+            const std::vector<std::shared_ptr<t_column>>& cols,
+            const std::vector<t_date_format>& formats, bool promote) const;
+
+        /**
+         * @brief Read the fields of row `ridx` into `fields`, stopping after
+         * `max_fields`.
+         *
+         * @param ridx
+         * @param max_fields
+         * @param fields
+         */
+        void read_row(t_uindex ridx, t_uindex max_fields, std::vector<t_csv_field>& fields) const;
+
+        t_date_format detect_date_format(t_uindex cidx) const;
+
+        std::string m_data;
+        std::vector<std::string> m_names;
+        std::vector<t_dtype> m_types;
+        std::vector<t_date_format> m_date_formats;
+
+        // The offsets into `m_data` of each data row, excluding its line
+        // ending.
+        std::vector<t_uindex> m_row_starts;
+        std::vector<t_uindex> m_row_ends;
+
+        std::shared_ptr<t_data_table> m_table;
+    };
+
+    /**
+     * @brief The narrowest dtype that both `a` and `b` fit in - integers
+     * widen to `DTYPE_INT64` and then `DTYPE_FLOAT64`, dates to
+     * `DTYPE_TIME`, and anything else to `DTYPE_STR`.
+     *
+     * @param a
+     * @param b
+     * @return t_dtype
+     */
+    t_dtype join_dtypes(t_dtype a, t_dtype b);
+
+} // namespace csv
+} // namespace perspective
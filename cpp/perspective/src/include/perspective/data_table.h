@@ -110,6 +110,13 @@ public:
 
     std::shared_ptr<t_data_table> flatten() const;
 
+    /**
+     * @brief Flatten into `flattened`, an empty table with the same schema.
+     *
+     * @param flattened
+     */
+    void flatten(t_data_table& flattened) const;
+
     bool is_pkey_table() const;
     bool is_same_shape(t_data_table& tbl) const;
 
@@ -123,6 +130,12 @@ public:
     void clear();
     void reset();
 
+    /**
+     * @brief Empty the vocabularies of the string columns, so that strings
+     * from rows that have been cleared do not accumulate.
+     */
+    void clear_vocabularies();
+
     t_mask filter_cpp(
         t_filter_op combiner, const std::vector<t_fterm>& fops) const;
     t_data_table* clone_(const t_mask& mask) const;
@@ -291,6 +304,10 @@ t_data_table::flatten_helper_2(ROWPACK_VEC_T& sorted, std::vector<t_flatten_reco
 
         if (added) {
             dcol->set_nth<DATA_T>(rec.m_store_idx, *(scol->get_nth<DATA_T>(fragidx)), status);
+        } else {
+            // `flattened` may be reused, so its storage is not known to be
+            // zeroed.
+            dcol->clear(rec.m_store_idx);
         }
     }
 }
@@ -9,20 +9,100 @@
 
 #pragma once
 #include <memory>
-#include <locale>
+#include <string>
+#include <vector>
 #include <perspective/base.h>
 #include <perspective/first.h>
 #include <perspective/exports.h>
+#include <perspective/date.h>
 
 namespace perspective {
 
+/**
+ * @brief The datestring layouts `t_date_parser` understands, in the order
+ * they are tried.
+ */
+enum t_date_format {
+    // YYYY-MM-DD or YYYY/MM/DD, then optionally a `T` or space and a time
+    DATE_FORMAT_ISO,
+    // YYYYMMDDTHHMMSS
+    DATE_FORMAT_ISO_BASIC,
+    // [Weekday, ]DD Mon YYYY[ HH:MM[:SS]][ zone]
+    DATE_FORMAT_RFC822,
+    // MM/DD/YYYY, MM-DD-YYYY, MM DD YYYY or MM/DD/YY, then optionally a time
+    DATE_FORMAT_US,
+    // DD MM YYYY
+    DATE_FORMAT_DMY,
+    DATE_FORMAT_NONE
+};
+
+/**
+ * @brief The fields of a parsed datestring - `m_month` is 1 - 12. Times may
+ * end in a fraction of a second, and in `Z` or an offset from UTC, which
+ * sets `m_has_offset`.
+ */
+struct PERSPECTIVE_EXPORT t_parsed_date {
+    std::int32_t m_year;
+    std::int32_t m_month;
+    std::int32_t m_day;
+    std::int32_t m_hour;
+    std::int32_t m_minute;
+    std::int32_t m_second;
+    std::int32_t m_millisecond;
+    std::int32_t m_offset_minutes;
+    bool m_has_time;
+    bool m_has_offset;
+};
+
+/**
+ * @brief Parses datestrings without allocating, and without `std::get_time`.
+ *
+ * A parser settles on one format for a column with `detect_format`, and
+ * then parses every value of that column in that format only.
+ */
 class PERSPECTIVE_EXPORT t_date_parser {
 public:
     t_date_parser();
 
     bool is_valid(std::string const& datestring);
 
+    /**
+     * @brief Use the first format that every non-empty string of `sample`
+     * parses in, for every later `parse`.
+     *
+     * @param sample
+     * @return t_date_format `DATE_FORMAT_NONE` if no format fits
+     */
+    t_date_format detect_format(const std::vector<std::string>& sample);
+
+    t_date_format get_format() const;
+
+    /**
+     * @brief Parse the `size` bytes at `s` in the detected format, or in the
+     * first format that fits if none has been detected.
+     *
+     * @param s
+     * @param size
+     * @param out
+     * @return true
+     * @return false
+     */
+    bool parse(const char* s, t_uindex size, t_parsed_date& out) const;
+
+    static bool parse(const char* s, t_uindex size, t_date_format format, t_parsed_date& out);
+
+    /**
+     * @brief Milliseconds since epoch - in UTC if the datestring had an
+     * offset, otherwise in local time, as for a naive `datetime`.
+     *
+     * @param parsed
+     * @return std::int64_t
+     */
+    static std::int64_t to_timestamp(const t_parsed_date& parsed);
+
+    static t_date to_date(const t_parsed_date& parsed);
+
 private:
-    static const std::string VALID_FORMATS[12];
+    t_date_format m_format;
 };
-} // end namespace perspective
\ No newline at end of file
+} // end namespace perspective
@@ -152,6 +152,15 @@ struct PERSPECTIVE_EXPORT t_fterm {
 
     std::string get_expr() const;
 
+    /**
+     * @brief Returns a string which is equal for two terms exactly when
+     * their column, operator, negation and values are equal. Unlike
+     * `get_expr`, floating point values are written exactly.
+     *
+     * @return std::string
+     */
+    std::string get_signature() const;
+
     void coerce_numeric(t_dtype dtype);
 
     std::string m_colname;
@@ -0,0 +1,71 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/config.h>
+#include <perspective/data_table.h>
+#include <perspective/filter.h>
+#include <perspective/mask.h>
+#include <tsl/hopscotch_map.h>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief The masks of the filter terms of a gnode's contexts over the
+ * tables of a single update, so that a term used by several contexts is
+ * evaluated once rather than once per context.
+ *
+ * Terms are keyed by their column, operator, negation and values, and by
+ * the combiner of the config using them, as `filter_cpp` treats invalid
+ * values differently under `AND` and `OR`.
+ */
+class PERSPECTIVE_EXPORT t_filter_cache {
+public:
+    /**
+     * @brief Evaluate every distinct filter term of `configs` on each of
+     * `tables`, replacing anything previously cached.
+     *
+     * String terms intern their threshold into the vocabulary of the column
+     * they filter, so the terms of each column are evaluated in sequence -
+     * afterwards, filtering these tables with these configs no longer
+     * writes to them.
+     *
+     * @param configs
+     * @param tables
+     */
+    void build(const std::vector<const t_config*>& configs,
+        const std::vector<const t_data_table*>& tables);
+
+    void clear();
+
+    /**
+     * @brief Write the mask of the rows of `tbl` which pass the filters of
+     * `config` to `mask`, combining the cached masks of its terms. Returns
+     * false, leaving `mask` untouched, if `tbl` is not cached.
+     *
+     * @param tbl
+     * @param config
+     * @param mask
+     * @return true
+     * @return false
+     */
+    bool filter(const t_data_table& tbl, const t_config& config, t_mask& mask) const;
+
+private:
+    static std::string get_term_key(t_filter_op combiner, const t_fterm& fterm);
+
+    tsl::hopscotch_map<const t_data_table*, tsl::hopscotch_map<std::string, t_mask>> m_masks;
+};
+
+} // end namespace perspective
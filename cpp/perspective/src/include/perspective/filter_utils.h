@@ -11,15 +11,21 @@
 #include <perspective/first.h>
 #include <perspective/config.h>
 #include <perspective/data_table.h>
+#include <perspective/filter_cache.h>
 #include <perspective/mask.h>
 
 namespace perspective {
 
 inline t_mask
-filter_table_for_config(const t_data_table& tbl, const t_config& config) {
+filter_table_for_config(
+    const t_data_table& tbl, const t_config& config, const t_filter_cache* cache = nullptr) {
 
     switch (config.get_fmode()) {
         case FMODE_SIMPLE_CLAUSES: {
+            t_mask mask;
+            if (cache && cache->filter(tbl, config, mask)) {
+                return mask;
+            }
             return tbl.filter_cpp(config.get_combiner(), config.get_fterms());
         } break;
         default: {}
@@ -35,6 +35,25 @@ public:
 
     void init();
 
+    /**
+     * @brief Returns a deep copy of this traversal, whose index and interned
+     * strings are independent of this one. Used to give a context that
+     * shares its traversal a private one when its sort diverges.
+     *
+     * @return std::shared_ptr<t_ftrav>
+     */
+    std::shared_ptr<t_ftrav> clone() const;
+
+    /**
+     * @brief Returns the name of the `m_gstate` column that `sort` orders
+     * rows by under `config`.
+     *
+     * @param config
+     * @param sort
+     * @return std::string
+     */
+    static std::string get_sortby_colname(const t_config& config, const t_sortspec& sort);
+
     std::vector<t_tscalar> get_all_pkeys(
         const std::vector<std::pair<t_uindex, t_uindex>>& cells) const;
 
@@ -19,17 +19,24 @@
 #include <perspective/custom_column.h>
 #include <perspective/rlookup.h>
 #include <perspective/gnode_state.h>
+#include <perspective/filter_cache.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/process_state.h>
 #include <perspective/computed.h>
 #include <perspective/computed_column_map.h>
 #include <perspective/computed_function.h>
+#include <perspective/stats.h>
+#include <perspective/update_arena.h>
 #include <tsl/ordered_map.h>
 #ifdef PSP_PARALLEL_FOR
 #include <tbb/parallel_sort.h>
 #include <tbb/tbb.h>
 #endif
+#ifdef PSP_PARALLEL_NOTIFY
+#include <tbb/parallel_for.h>
+#endif
 #include <chrono>
+#include <set>
 
 namespace perspective {
 
@@ -131,6 +138,16 @@ public:
     void _register_context(const std::string& name, t_ctx_type type, std::int64_t ptr);
     void _unregister_context(const std::string& name);
 
+    /**
+     * @brief Give the one-sided context registered as `name` a private
+     * `t_stree` if it currently shares one with other contexts, preserving
+     * its expansion state. Must be called before enabling deltas on a
+     * context, as deltas are stored on (and cleared from) the tree.
+     *
+     * @param name
+     */
+    void unshare_context_tree(const std::string& name);
+
     const t_data_table* get_table() const;
     t_data_table* get_table();
 
@@ -190,6 +207,34 @@ public:
     void pprint() const;
     std::string repr() const;
 
+    /**
+     * @brief Returns the timing counters for each stage of `process` on this
+     * gnode, along with those of every registered context keyed by
+     * `<context name>.<stage>`.
+     *
+     * @return std::map<std::string, std::map<std::string, double>>
+     */
+    std::map<std::string, std::map<std::string, double>> get_stats() const;
+
+    void reset_stats();
+
+    /**
+     * @brief Start or stop recording individual trace events on this gnode
+     * and its contexts, including contexts registered later.
+     *
+     * @param enabled
+     */
+    void set_trace_enabled(bool enabled);
+
+    /**
+     * @brief Write the trace events recorded on this gnode and its contexts
+     * as Chrome trace-event JSON objects, using the gnode id as the pid.
+     *
+     * @param os
+     * @param first whether no event has been written to `os` yet.
+     */
+    void write_trace_events(std::ostream& os, bool& first) const;
+
 protected:
     /**
      * @brief Given `tbl`, notify each registered context with `tbl`.
@@ -214,6 +259,60 @@ protected:
     template <typename CTX_T>
     void update_context_from_state(CTX_T* ctx, std::shared_ptr<t_data_table> tbl);
 
+    /**
+     * @brief Add the one-sided context `name` to the group of contexts that
+     * share its tree signature. If the group already has a tree, `ctx` is
+     * switched over to it and true is returned, in which case `ctx` is
+     * already up to date and must not be notified from state. Otherwise
+     * the context's own tree becomes the group's tree.
+     *
+     * Contexts with deltas enabled are never shared.
+     *
+     * @param name
+     * @param ctx
+     * @return bool
+     */
+    bool _share_context_tree(const std::string& name, t_ctx1* ctx);
+
+    void _release_context_tree(const std::string& name);
+
+    /**
+     * @brief If a registered zero-sided context has the same traversal
+     * signature as `ctx`, make `ctx` read through its traversal and return
+     * true, in which case `ctx` must not be notified from state.
+     *
+     * @param ctx
+     * @return bool
+     */
+    bool _share_flat_traversal(t_ctx0* ctx);
+
+    /**
+     * @brief Make the first zero-sided context (in notification order) that
+     * reads each traversal its owner.
+     */
+    void _assign_traversal_owners();
+
+    /**
+     * @brief The columns of the transitional tables that some registered
+     * context reads - its pivots and their sort columns, aggregate inputs,
+     * filters and visible columns - together with the computed columns and
+     * their inputs, which are computed on the transitional tables.
+     *
+     * @return std::set<std::string>
+     */
+    std::set<std::string> _get_transitional_columns() const;
+
+    /**
+     * @brief Notify contexts which share a tree or traversal. The tree of
+     * one-sided contexts is updated once through the first context, then
+     * each context's traversal; zero-sided contexts are notified in order,
+     * so that the traversal's owner updates it before the rest read it.
+     *
+     * @param flattened
+     * @param ctxhs
+     */
+    void notify_shared_contexts(const t_data_table& flattened, const std::vector<t_ctx_handle>& ctxhs);
+
     /**
      * @brief Provide the registered `t_ctx*` with a pointer to this gnode's
      * `m_gstate` object. `t_ctx*` are assumed to access/mutate this state
@@ -228,6 +327,17 @@ protected:
     bool have_context(const std::string& name) const;
     void notify_contexts(const t_data_table& flattened);
 
+    /**
+     * @brief Intern the thresholds of every context's string equality
+     * filters into the vocabs of the tables contexts filter on notify, so
+     * that filtering them concurrently only reads the vocabs.
+     *
+     * @param flattened
+     */
+    void intern_filter_thresholds(const t_data_table& flattened);
+
+    t_stats* _get_context_stats(const t_ctx_handle& ctxh) const;
+
     template <typename CTX_T>
     void notify_context(const t_data_table& flattened, const t_ctx_handle& ctxh);
 
@@ -385,11 +495,28 @@ private:
     // `t_gnode_port` enum.
     std::vector<std::shared_ptr<t_port>> m_oports;
     std::map<std::string, t_ctx_handle> m_contexts;
+
+    // One-sided contexts with equal `get_tree_signature()`s share a single
+    // `t_stree`, so it is built and updated once rather than per view.
+    struct t_shared_tree {
+        std::shared_ptr<t_stree> m_tree;
+        std::vector<std::string> m_contexts;
+    };
+
+    std::map<std::string, t_shared_tree> m_shared_trees;
+
+    // Context name to its key in `m_shared_trees`
+    std::map<std::string, std::string> m_shared_tree_keys;
     std::shared_ptr<t_gstate> m_gstate;
+    std::shared_ptr<t_filter_cache> m_filter_cache;
     std::chrono::high_resolution_clock::time_point m_epoch;
     std::vector<t_custom_column> m_custom_columns;
     std::function<void()> m_pool_cleanup;
     bool m_was_updated;
+    t_stats m_stats;
+
+    // Recycles the flattened table between updates.
+    t_update_arena m_arena;
 };
 
 /**
@@ -435,12 +562,19 @@ t_gnode::notify_context(CTX_T* ctx, const t_data_table& flattened, const t_data_
     const t_data_table& existed) {
     auto ctx_config = ctx->get_config();
     auto computed_columns = ctx_config.get_computed_columns();
+    t_stats& stats = ctx->get_stats();
 
     ctx->step_begin();
-    // Flattened has the computed columns at this point, as it has
-    // passed through the body of `process_table`.
-    ctx->notify(flattened, delta, prev, current, transitions, existed);
-    ctx->step_end();
+    {
+        // Flattened has the computed columns at this point, as it has
+        // passed through the body of `process_table`.
+        t_stats_timer timer(stats, STATS_STAGE_NOTIFY, flattened.size());
+        ctx->notify(flattened, delta, prev, current, transitions, existed);
+    }
+    {
+        t_stats_timer timer(stats, STATS_STAGE_STEP_END);
+        ctx->step_end();
+    }
 }
 
 /**
@@ -479,10 +613,17 @@ t_gnode::update_context_from_state(
     // reference is valid as `notify` is not async
     const t_data_table& const_flattened = 
         const_cast<const t_data_table&>(*flattened);
+    t_stats& stats = ctx->get_stats();
 
     ctx->step_begin();
-    ctx->notify(const_flattened);
-    ctx->step_end();
+    {
+        t_stats_timer timer(stats, STATS_STAGE_NOTIFY, const_flattened.size());
+        ctx->notify(const_flattened);
+    }
+    {
+        t_stats_timer timer(stats, STATS_STAGE_STEP_END);
+        ctx->step_end();
+    }
 }
 
 template <>
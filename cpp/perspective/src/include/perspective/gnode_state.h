@@ -17,17 +17,13 @@
 #include <perspective/mask.h>
 #include <perspective/sym_table.h>
 #include <perspective/rlookup.h>
+#include <perspective/pkey_mapping.h>
 
 namespace perspective {
 
 std::pair<t_tscalar, t_tscalar> get_vec_min_max(const std::vector<t_tscalar>& vec);
 
 class PERSPECTIVE_EXPORT t_gstate {
-    /**
-     * @brief A mapping of `t_tscalar` primary keys to `t_uindex` row indices.
-     */
-    typedef tsl::hopscotch_map<t_tscalar, t_uindex> t_mapping;
-
     typedef tsl::hopscotch_set<t_uindex> t_free_items;
 
 public:
@@ -218,7 +214,7 @@ public:
 protected:
     /**
      * @brief If the pkey exists in the state, return its row index. Otherwise,
-     * add a new row to the mapping and return its index.
+     * add a new row holding the pkey to the mapping and return its index.
      * 
      * @param pkey 
      * @return t_uindex 
@@ -260,9 +256,8 @@ private:
     t_schema m_output_schema; // tblschema
     bool m_init;
     std::shared_ptr<t_data_table> m_table;
-    t_mapping m_mapping;
+    t_pkey_mapping m_mapping;
     t_free_items m_free;
-    t_symtable m_symtable;
     std::shared_ptr<t_column> m_pkcol;
     std::shared_ptr<t_column> m_opcol;
 };
@@ -0,0 +1,268 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <perspective/sym_table.h>
+#include <perspective/vocab.h>
+#include <tsl/hopscotch_map.h>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief A mapping of `t_tscalar` primary keys to `t_uindex` row indices.
+ *
+ * While every primary key is a valid integer of the same dtype, and the
+ * keys span at most `PSP_DENSE_PKEY_SPARSITY` times as many values as there
+ * are keys (or `PSP_DENSE_PKEY_MIN_SPAN`), rows are found by indexing an
+ * array with the key's offset from the smallest key. While every primary key
+ * is a valid string, rows are found by indexing the same array with the
+ * key's id in the vocabulary set by `set_vocab` - that of the column the keys
+ * are stored in. Once a key breaks these conditions, or erasing integer keys
+ * leaves them twice too sparse, every key is moved into a hash map, which
+ * the mapping keeps using until it is cleared.
+ *
+ * The array of string ids is as long as the vocabulary, which keeps every
+ * string it was given - an erased string keeps its id, and finds it again if
+ * it is added back. String keys in the hash map are interned into the
+ * mapping's own symbol table.
+ */
+class PERSPECTIVE_EXPORT t_pkey_mapping {
+public:
+    t_pkey_mapping();
+
+    /**
+     * @brief Map string keys by their id in `vocab`, which must outlive the
+     * mapping, or last until the next call. Clears the mapping, as the ids
+     * of the previous vocabulary mean nothing in `vocab`.
+     *
+     * @param vocab
+     */
+    void set_vocab(t_vocab* vocab);
+
+    /**
+     * @brief Whether `pkey` would be mapped by its id in the vocabulary, in
+     * which case `find_id` and `set_id` can be called with that id instead
+     * of `find` and `set` with the string.
+     *
+     * @param pkey
+     * @return true
+     * @return false
+     */
+    bool is_keyed_by_id(const t_tscalar& pkey) const;
+
+    bool find_id(t_uindex id, t_uindex& idx) const;
+    void set_id(t_uindex id, t_uindex idx);
+
+    /**
+     * @brief Look up `pkey`, writing its row index into `idx` if it exists.
+     *
+     * @param pkey
+     * @param idx
+     * @return true
+     * @return false
+     */
+    bool find(const t_tscalar& pkey, t_uindex& idx) const;
+
+    bool contains(const t_tscalar& pkey) const;
+
+    /**
+     * @brief Map `pkey` to `idx`, replacing any existing row index.
+     *
+     * @param pkey
+     * @param idx
+     */
+    void set(const t_tscalar& pkey, t_uindex idx);
+
+    /**
+     * @brief Remove `pkey`, writing the row index it mapped to into `idx`.
+     *
+     * @param pkey
+     * @param idx
+     * @return true if `pkey` existed
+     * @return false
+     */
+    bool erase(const t_tscalar& pkey, t_uindex& idx);
+
+    void clear();
+    t_uindex size() const;
+    bool empty() const;
+
+    /**
+     * @brief Whether rows are found by direct indexing, either by integer
+     * key or by string id.
+     *
+     * @return true
+     * @return false
+     */
+    bool is_dense() const;
+
+    /**
+     * @brief The dtype of the primary keys - the mapping must not be empty.
+     *
+     * @return t_dtype
+     */
+    t_dtype get_pkey_dtype() const;
+
+    /**
+     * @brief Call `fn(pkey, idx)` for every primary key, in no particular
+     * order. String keys mapped by id point into the vocabulary, so are only
+     * valid until it next grows.
+     *
+     * @tparam FN_T
+     * @param fn
+     */
+    template <typename FN_T>
+    void for_each(FN_T fn) const;
+
+private:
+    bool is_dense_key(const t_tscalar& pkey) const;
+    std::int64_t get_dense_key(const t_tscalar& pkey) const;
+
+    /**
+     * @brief The offset of `pkey` into `m_rows`, or `PSP_PKEY_MAPPING_ABSENT`
+     * if a string has no id yet.
+     *
+     * @param pkey
+     * @return t_uindex
+     */
+    t_uindex get_dense_offset(const t_tscalar& pkey) const;
+    t_tscalar get_string_key(t_uindex id) const;
+    t_tscalar make_dense_key(std::int64_t key) const;
+
+    /**
+     * @brief Make room in the array for `key`, returning false if that would
+     * leave the array too sparse.
+     *
+     * @param key
+     * @return true
+     * @return false
+     */
+    bool reserve_dense(std::int64_t key);
+
+    void to_sparse();
+
+    bool m_dense;
+    t_dtype m_dense_dtype;
+
+    // The key of `m_rows[0]`, and the row index for each key from there,
+    // or `PSP_PKEY_MAPPING_ABSENT`. For string keys, `m_rows` is indexed by
+    // id in `m_vocab` instead.
+    std::int64_t m_base;
+    std::vector<t_uindex> m_rows;
+    t_uindex m_size;
+    t_vocab* m_vocab;
+
+    tsl::hopscotch_map<t_tscalar, t_uindex> m_map;
+    t_symtable m_symtable;
+};
+
+const t_uindex PSP_PKEY_MAPPING_ABSENT = std::numeric_limits<t_uindex>::max();
+const t_uindex PSP_DENSE_PKEY_SPARSITY = 4;
+const t_uindex PSP_DENSE_PKEY_MIN_SPAN = 1 << 16;
+
+inline bool
+t_pkey_mapping::is_dense_key(const t_tscalar& pkey) const {
+    return pkey.get_dtype() == m_dense_dtype && pkey.m_status == STATUS_VALID;
+}
+
+inline std::int64_t
+t_pkey_mapping::get_dense_key(const t_tscalar& pkey) const {
+    return m_dense_dtype == DTYPE_INT64 ? pkey.get<std::int64_t>()
+                                        : pkey.get<std::int32_t>();
+}
+
+inline bool
+t_pkey_mapping::is_keyed_by_id(const t_tscalar& pkey) const {
+    return m_dense && m_vocab != nullptr && pkey.get_dtype() == DTYPE_STR
+        && pkey.m_status == STATUS_VALID && (m_dense_dtype == DTYPE_STR || m_size == 0);
+}
+
+inline bool
+t_pkey_mapping::find_id(t_uindex id, t_uindex& idx) const {
+    if (m_dense_dtype != DTYPE_STR || id >= m_rows.size()
+        || m_rows[id] == PSP_PKEY_MAPPING_ABSENT)
+        return false;
+
+    idx = m_rows[id];
+    return true;
+}
+
+inline t_uindex
+t_pkey_mapping::get_dense_offset(const t_tscalar& pkey) const {
+    if (m_dense_dtype == DTYPE_STR) {
+        t_uindex id;
+        return m_vocab->string_exists(pkey.get_char_ptr(), id) ? id : PSP_PKEY_MAPPING_ABSENT;
+    }
+
+    // Keys below `m_base` wrap around to offsets past the end.
+    return static_cast<std::uint64_t>(get_dense_key(pkey)) - static_cast<std::uint64_t>(m_base);
+}
+
+inline bool
+t_pkey_mapping::find(const t_tscalar& pkey, t_uindex& idx) const {
+    if (!m_dense) {
+        auto iter = m_map.find(pkey);
+        if (iter == m_map.end())
+            return false;
+        idx = iter->second;
+        return true;
+    }
+
+    if (!is_dense_key(pkey))
+        return false;
+
+    t_uindex offset = get_dense_offset(pkey);
+    if (offset >= m_rows.size() || m_rows[offset] == PSP_PKEY_MAPPING_ABSENT)
+        return false;
+
+    idx = m_rows[offset];
+    return true;
+}
+
+inline bool
+t_pkey_mapping::contains(const t_tscalar& pkey) const {
+    t_uindex idx;
+    return find(pkey, idx);
+}
+
+template <typename FN_T>
+void
+t_pkey_mapping::for_each(FN_T fn) const {
+    if (!m_dense) {
+        for (const auto& kv : m_map) {
+            fn(kv.first, kv.second);
+        }
+        return;
+    }
+
+    if (m_dense_dtype == DTYPE_STR) {
+        for (t_uindex id = 0, loop_end = m_rows.size(); id < loop_end; ++id) {
+            if (m_rows[id] != PSP_PKEY_MAPPING_ABSENT) {
+                fn(get_string_key(id), m_rows[id]);
+            }
+        }
+        return;
+    }
+
+    for (t_uindex offset = 0, loop_end = m_rows.size(); offset < loop_end; ++offset) {
+        if (m_rows[offset] != PSP_PKEY_MAPPING_ABSENT) {
+            fn(make_dense_key(m_base + static_cast<std::int64_t>(offset)), m_rows[offset]);
+        }
+    }
+}
+
+} // end namespace perspective
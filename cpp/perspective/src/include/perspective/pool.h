@@ -91,6 +91,39 @@ public:
     std::vector<t_uindex> get_gnodes_last_updated();
     t_gnode* get_gnode(t_uindex gnode_id);
 
+    /**
+     * @brief Returns the timing counters of every registered gnode and its
+     * contexts, keyed by `gnode_<id>.<stage>` and
+     * `gnode_<id>.<context name>.<stage>`.
+     *
+     * @return std::map<std::string, std::map<std::string, double>>
+     */
+    std::map<std::string, std::map<std::string, double>> get_stats();
+
+    /**
+     * @brief Reset the counters and trace events of every registered gnode
+     * and its contexts.
+     */
+    void reset_stats();
+
+    /**
+     * @brief Start or stop recording individual trace events on every
+     * registered gnode and its contexts, in addition to the counters which
+     * are always recorded.
+     *
+     * @param enabled
+     */
+    void set_trace_enabled(bool enabled);
+
+    /**
+     * @brief Returns the trace events recorded since the last
+     * `reset_stats` as Chrome trace-event JSON, which can be loaded into
+     * `chrome://tracing` or Perfetto.
+     *
+     * @return std::string
+     */
+    std::string get_trace_json();
+
 protected:
 
     // Unused methods
@@ -11,15 +11,40 @@
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/data_table.h>
+#include <perspective/sym_table.h>
+#include <tsl/hopscotch_map.h>
 
 namespace perspective {
 
+/**
+ * @brief Incoming batches with at most this many rows are coalesced into the
+ * port's staging table as they arrive. Larger batches (i.e. the initial load
+ * of a `Table`) are appended as-is and flattened in bulk on `process`.
+ */
+const t_uindex PSP_PORT_COALESCE_MAX_ROWS = 1024;
+
 enum t_port_mode {
     PORT_MODE_RAW,    // no pkeys in incoming
     PORT_MODE_PKEYED, // pkeys and op present
 };
 
+/**
+ * @brief The rows held in the staging table of a coalescing `t_port` for a
+ * single primary key - an optional `OP_DELETE` row, which always precedes the
+ * optional `OP_INSERT` row that accumulates the latest value of each cell.
+ */
+struct t_port_staged_rows {
+    t_port_staged_rows();
+
+    t_uindex m_delete_idx;
+    t_uindex m_insert_idx;
+    bool m_has_delete;
+    bool m_has_insert;
+};
+
 class PERSPECTIVE_EXPORT t_port {
+    typedef tsl::hopscotch_map<t_tscalar, t_port_staged_rows> t_staged_map;
+
 public:
     t_port(t_port_mode mode, const t_schema& schema);
     ~t_port();
@@ -31,6 +56,27 @@ public:
     void send(std::shared_ptr<const t_data_table> tbl);
     void send(const t_data_table& tbl);
 
+    /**
+     * @brief Fill `flattened` - an empty table with the schema of
+     * `get_table()` - with at most one `OP_DELETE` and one `OP_INSERT` row
+     * per primary key, sorted by primary key. If every batch sent since the
+     * last release was coalesced on arrival, this gathers the staged rows
+     * without re-sorting the fragments, otherwise it falls back to
+     * `t_data_table::flatten`.
+     *
+     * @param flattened
+     */
+    void get_flattened(t_data_table& flattened) const;
+
+    /**
+     * @brief Promote a column of the staging table, disabling coalescing
+     * until the next release if the primary key column changes type.
+     *
+     * @param name
+     * @param new_type
+     */
+    void promote_column(const std::string& name, t_dtype new_type);
+
     t_schema get_schema() const;
 
     void release();
@@ -38,11 +84,39 @@ public:
     void clear();
 
 private:
-    // t_port_mode m_mode;
+    /**
+     * @brief Merge `tbl` into the staging table - new primary keys are
+     * appended, and valid cells for already staged primary keys overwrite
+     * the staged values in place (latest value wins).
+     *
+     * @param tbl
+     */
+    void coalesce(const t_data_table& tbl);
+
+    /**
+     * @brief Whether `tbl` can be merged into the staging table by
+     * `coalesce` instead of being appended.
+     *
+     * @param tbl
+     * @return true
+     * @return false
+     */
+    bool can_coalesce(const t_data_table& tbl) const;
+
+    void reset_staged();
+
+    t_port_mode m_mode;
     t_schema m_schema;
     bool m_init;
     std::shared_ptr<t_data_table> m_table;
     t_uindex m_prevsize;
+
+    // Whether every row in `m_table` is tracked by `m_staged`.
+    bool m_coalesced;
+    t_staged_map m_staged;
+
+    // Owns string primary keys used as keys into `m_staged`.
+    std::unique_ptr<t_symtable> m_symtable;
 };
 
 } // end namespace perspective
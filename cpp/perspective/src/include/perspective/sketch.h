@@ -0,0 +1,108 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief A HyperLogLog sketch of the distinct values added to it, which
+ * estimates their number to within about 2% using at most 4KB, and merges
+ * with other sketches by taking the larger of each register.
+ *
+ * Sketches of few values keep only their set registers, sorted by index,
+ * and switch to the full register array once that would be smaller.
+ */
+class PERSPECTIVE_EXPORT t_hll {
+public:
+    t_hll();
+
+    void add(const t_tscalar& value);
+    void merge(const t_hll& other);
+    void clear();
+
+    /**
+     * @brief Whether each register is at least that of `other` - so that
+     * merging `other` would not change this sketch.
+     *
+     * @param other
+     * @return bool
+     */
+    bool covers(const t_hll& other) const;
+
+    /**
+     * @brief The estimated number of distinct values added.
+     *
+     * @return double
+     */
+    double estimate() const;
+
+private:
+    void add_hash(std::uint64_t hash);
+    std::uint8_t get_register(std::uint32_t idx) const;
+    void set_register(std::uint32_t idx, std::uint8_t rank);
+    void to_dense();
+
+    // (index << 8) | rank of each set register, while sparse
+    std::vector<std::uint32_t> m_sparse;
+    std::vector<std::uint8_t> m_registers;
+};
+
+/**
+ * @brief A t-digest of the numeric values added to it, which estimates
+ * their quantiles - most accurately towards the tails - from a bounded
+ * number of weighted centroids, and merges with other digests by
+ * combining their centroids.
+ *
+ * Values and merged centroids are buffered, and folded into the centroids
+ * when the buffer fills, or by `compress`.
+ */
+class PERSPECTIVE_EXPORT t_tdigest {
+public:
+    t_tdigest();
+
+    void add(double value);
+    void merge(const t_tdigest& other);
+    void clear();
+
+    /**
+     * @brief Fold the buffered values into the centroids.
+     */
+    void compress();
+
+    bool empty() const;
+
+    /**
+     * @brief The estimated value at quantile `q`, in [0, 1], of the values
+     * added, or NaN if there are none.
+     *
+     * @param q
+     * @return double
+     */
+    double quantile(double q) const;
+
+private:
+    typedef std::pair<double, double> t_centroid;
+
+    void add_centroid(const t_centroid& centroid);
+
+    std::vector<t_centroid> m_centroids;
+    std::vector<t_centroid> m_buffer;
+    double m_min;
+    double m_max;
+};
+
+} // end namespace perspective
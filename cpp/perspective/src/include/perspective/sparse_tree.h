@@ -14,13 +14,9 @@ SUPPRESS_WARNINGS_VC(4503)
 #include <perspective/first.h>
 #include <perspective/base.h>
 #include <perspective/exports.h>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/composite_key.hpp>
 #include <perspective/sort_specification.h>
 #include <perspective/sparse_tree_node.h>
+#include <perspective/sparse_tree_nodes.h>
 #include <perspective/pivot.h>
 #include <perspective/aggspec.h>
 #include <perspective/step_delta.h>
@@ -29,6 +25,11 @@ SUPPRESS_WARNINGS_VC(4503)
 #include <perspective/sym_table.h>
 #include <perspective/data_table.h>
 #include <perspective/dense_tree.h>
+#include <perspective/sketch.h>
+#include <perspective/update_arena.h>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <functional>
 #include <vector>
 #include <algorithm>
 #include <deque>
@@ -42,26 +43,9 @@ class t_dtree_ctx;
 class t_config;
 class t_ctx2;
 
-using boost::multi_index_container;
-using namespace boost::multi_index;
-
 typedef std::pair<t_depth, t_index> t_dptipair;
 typedef std::vector<t_dptipair> t_dptipairvec;
 
-struct by_idx {};
-
-struct by_depth {};
-
-struct by_pidx {};
-
-struct by_pidx_hash {};
-
-struct by_nstrands {};
-
-struct by_idx_pkey {};
-
-struct by_idx_lfidx {};
-
 PERSPECTIVE_EXPORT t_tscalar get_dominant(std::vector<t_tscalar>& values);
 
 struct t_build_strand_table_common_rval {
@@ -73,44 +57,16 @@ struct t_build_strand_table_common_rval {
     t_uindex m_pivsize;
 };
 
-typedef multi_index_container<t_stnode,
-    indexed_by<ordered_unique<tag<by_idx>, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_idx)>,
-        hashed_non_unique<tag<by_depth>,
-            BOOST_MULTI_INDEX_MEMBER(t_stnode, std::uint8_t, m_depth)>,
-        hashed_non_unique<tag<by_nstrands>,
-            BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_nstrands)>,
-        ordered_unique<tag<by_pidx>,
-            composite_key<t_stnode, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_pidx),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_sort_value),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_value)>>,
-        ordered_unique<tag<by_pidx_hash>,
-            composite_key<t_stnode, BOOST_MULTI_INDEX_MEMBER(t_stnode, t_uindex, m_pidx),
-                BOOST_MULTI_INDEX_MEMBER(t_stnode, t_tscalar, m_value)>>>>
-    t_treenodes;
-
-typedef multi_index_container<t_stpkey,
-    indexed_by<ordered_unique<tag<by_idx_pkey>,
-        composite_key<t_stpkey, BOOST_MULTI_INDEX_MEMBER(t_stpkey, t_uindex, m_idx),
-            BOOST_MULTI_INDEX_MEMBER(t_stpkey, t_tscalar, m_pkey)>>>>
-    t_idxpkey;
-
-typedef multi_index_container<t_stleaves,
-    indexed_by<ordered_unique<tag<by_idx_lfidx>,
-        composite_key<t_stleaves, BOOST_MULTI_INDEX_MEMBER(t_stleaves, t_uindex, m_idx),
-            BOOST_MULTI_INDEX_MEMBER(t_stleaves, t_uindex, m_lfidx)>>>>
-    t_idxleaf;
-
-typedef t_treenodes::index<by_idx>::type index_by_idx;
-typedef t_treenodes::index<by_pidx>::type index_by_pidx;
-
-typedef t_treenodes::index<by_idx>::type::iterator iter_by_idx;
-typedef t_treenodes::index<by_pidx>::type::iterator iter_by_pidx;
-typedef t_treenodes::index<by_pidx_hash>::type::iterator iter_by_pidx_hash;
-typedef std::pair<iter_by_pidx, iter_by_pidx> t_by_pidx_ipair;
-
-typedef t_idxpkey::index<by_idx_pkey>::type::iterator iter_by_idx_pkey;
-
-typedef std::pair<iter_by_idx_pkey, iter_by_idx_pkey> t_by_idx_pkey_ipair;
+// Below this many (node, aggregate) updates, `update_aggs_from_static`
+// does not bother partitioning aggregate columns across threads.
+const t_uindex PSP_PARALLEL_AGG_MIN_UPDATES = 4096;
+
+// Strand tables of at most this many rows are applied to a `t_stree` with
+// `update_shape_from_strands`, rather than through a `t_dtree`. Resolving
+// each row's path measured faster than building the dense tree at every
+// size up to this one; larger tables keep the dense tree, which holds its
+// groups in columns rather than per-group maps.
+const t_uindex PSP_SPARSE_TREE_DIRECT_MAX_STRANDS = 1 << 20;
 
 struct PERSPECTIVE_EXPORT t_agg_update_info {
     std::vector<const t_column*> m_src;
@@ -169,18 +125,68 @@ public:
         std::vector<t_column*>& agg_acols, t_column* agg_scount, t_column* spkey,
         t_uindex& insert_count, const std::vector<std::string>& pivot_like) const;
 
+    /**
+     * @brief Build the strand tables for an update. If `config` has
+     * filters, `prev_mask` and `curr_mask` may be passed as the filter
+     * already applied to `prev` and `current`, so that several trees over
+     * the same config can share it.
+     */
     std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>> build_strand_table(
         const t_data_table& flattened, const t_data_table& delta, const t_data_table& prev,
         const t_data_table& current, const t_data_table& transitions,
-        const std::vector<t_aggspec>& aggspecs, const t_config& config) const;
+        const std::vector<t_aggspec>& aggspecs, const t_config& config,
+        const t_mask* prev_mask = nullptr, const t_mask* curr_mask = nullptr);
 
     std::pair<std::shared_ptr<t_data_table>, std::shared_ptr<t_data_table>> build_strand_table(
         const t_data_table& flattened, const std::vector<t_aggspec>& aggspecs,
-        const t_config& config) const;
+        const t_config& config, const t_mask* mask = nullptr);
 
     void update_shape_from_static(const t_dtree_ctx& ctx);
     void update_aggs_from_static(const t_dtree_ctx& ctx, const t_gstate& gstate);
 
+    /**
+     * @brief Whether `update_shape_from_strands` can stand in for a
+     * `t_dtree_ctx` over `strand_deltas` with `aggspecs` - which it cannot
+     * for aggregates read from the strands rather than their deltas, nor
+     * for sums of columns `t_aggregate` cannot sum.
+     *
+     * @param strand_deltas
+     * @param aggspecs
+     * @return true
+     * @return false
+     */
+    bool can_update_shape_from_strands(
+        const t_data_table& strand_deltas, const std::vector<t_aggspec>& aggspecs) const;
+
+    /**
+     * @brief Apply a strand table to the shape of the tree as
+     * `update_shape_from_static` would, resolving each strand's path
+     * through a hash of the tree's children rather than by building a
+     * `t_dtree` over the strands.
+     *
+     * @param strands
+     * @param strand_deltas
+     * @param aggspecs
+     * @param tree_sortby
+     * @return std::shared_ptr<t_data_table> the summed strand deltas of
+     * each path, to pass to `update_aggs` with `aggspecs`.
+     */
+    std::shared_ptr<t_data_table> update_shape_from_strands(const t_data_table& strands,
+        const t_data_table& strand_deltas, const std::vector<t_aggspec>& aggspecs,
+        const std::vector<std::pair<std::string, std::string>>& tree_sortby);
+
+    /**
+     * @brief Apply the unification records of the last shape update to the
+     * aggregate table, reading the deltas of each node from `src_aggtable`
+     * by the name of each of `aggspecs`.
+     *
+     * @param src_aggtable
+     * @param aggspecs
+     * @param gstate
+     */
+    void update_aggs(const t_data_table& src_aggtable, const std::vector<t_aggspec>& aggspecs,
+        const t_gstate& gstate);
+
     t_uindex size() const;
 
     t_uindex get_num_children(t_uindex idx) const;
@@ -194,6 +200,14 @@ public:
     std::set<t_uindex> non_zero_ids(
         const std::set<t_uindex>& ptiset, const std::vector<t_uindex>& zero_strands) const;
 
+    /**
+     * @brief Returns the nodes whose aggregates were recalculated by the last
+     * update, and which still exist in the tree.
+     *
+     * @return std::vector<t_uindex>
+     */
+    std::vector<t_uindex> updated_ids() const;
+
     t_uindex get_parent_idx(t_uindex idx) const;
     std::vector<t_uindex> get_ancestry(t_uindex idx) const;
 
@@ -218,7 +232,7 @@ public:
     void add_leaf(t_uindex nidx, t_uindex lfidx);
     void remove_leaf(t_uindex nidx, t_uindex lfidx);
 
-    t_by_idx_pkey_ipair get_pkeys_for_leaf(t_uindex idx) const;
+    const std::vector<t_tscalar>& get_pkeys_for_leaf(t_uindex idx) const;
     t_depth get_depth(t_uindex ptidx) const;
     void get_drd_indices(t_uindex ridx, t_depth rel_depth, std::vector<t_uindex>& leaves) const;
     std::vector<t_uindex> get_leaves(t_uindex idx) const;
@@ -250,6 +264,52 @@ public:
 
     void set_feature_state(t_ctx_feature feature, bool state);
 
+    /**
+     * @brief Defer the aggregates that are recomputed from a node's pkeys,
+     * such as median, join and distinct count, on nodes for which
+     * `is_visible` is false - marking them dirty until `clean_aggregates`
+     * reaches them, rather than evaluating them on every update. An empty
+     * function evaluates every node.
+     *
+     * Nothing is deferred while min/max is enabled, as it reads every
+     * node, nor in a tree with a scaled aggregate, which reads the other
+     * aggregates of its node.
+     *
+     * @param is_visible
+     */
+    void set_lazy_aggregates(std::function<bool(t_uindex)> is_visible);
+
+    /**
+     * @brief Evaluate the deferred aggregates of those of `nidxs` that are
+     * dirty.
+     *
+     * @param nidxs
+     * @param gstate
+     */
+    void clean_aggregates(const std::vector<t_uindex>& nidxs, const t_gstate& gstate);
+
+    /**
+     * @brief Evaluate the deferred aggregates of the dirty children of
+     * `nidx`, before they are shown by expanding it.
+     *
+     * @param nidx
+     * @param gstate
+     */
+    void clean_child_aggregates(t_uindex nidx, const t_gstate& gstate);
+
+    /**
+     * @brief Evaluate the deferred aggregates of every dirty node at or
+     * above `depth`.
+     *
+     * @param depth
+     * @param gstate
+     */
+    void clean_aggregates_to_depth(t_depth depth, const t_gstate& gstate);
+
+    /**
+     * @brief The minimum and maximum of aggregate `aggidx` over the nodes
+     * whose ids are in [biter, eiter), other than the root.
+     */
     template <typename ITER_T>
     t_minmax get_agg_min_max(ITER_T biter, ITER_T eiter, t_uindex aggidx) const;
     t_minmax get_agg_min_max(t_uindex aggidx, t_depth depth) const;
@@ -270,7 +330,7 @@ public:
 
     void clear_aggregates(const std::vector<t_uindex>& indices);
 
-    std::pair<iter_by_idx, bool> insert_node(const t_tnode& node);
+    bool insert_node(const t_tnode& node);
     bool has_deltas() const;
     void set_has_deltas(bool v);
 
@@ -294,25 +354,102 @@ protected:
     void update_agg_table(t_uindex nidx, t_agg_update_info& info, t_uindex src_ridx,
         t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate);
 
+    /**
+     * @brief The columns of `m_aggregates` to update, in update order, with
+     * their sources in `src_aggtable` if it is given.
+     */
+    t_agg_update_info get_agg_update_info(
+        const t_data_table* src_aggtable, const std::vector<t_aggspec>& aggspecs) const;
+
+    /**
+     * @brief The columns of `info` that `set_lazy_aggregates` may defer, in
+     * update order - none if any aggregate is scaled.
+     */
+    std::vector<t_uindex> get_lazy_agg_columns(const t_agg_update_info& info) const;
+
+    void apply_unification_records(t_agg_update_info& info,
+        const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate);
+
+    /**
+     * @brief Update the aggregate in column `idx` of `info` for the node at
+     * `nidx`, writing the previous and updated values to `old_value` and
+     * `new_value`. Only touches the destination column, and the tree's
+     * symtable for aggregates that intern strings, so distinct columns can be
+     * updated concurrently.
+     */
+    void update_agg_column(t_uindex nidx, const t_agg_update_info& info, t_uindex idx,
+        t_uindex src_ridx, t_uindex dst_ridx, t_index nstrands, const t_gstate& gstate,
+        t_tscalar& old_value, t_tscalar& new_value);
+
+#if defined PSP_PARALLEL_FOR || defined PSP_PARALLEL_NOTIFY
+    /**
+     * @brief Apply `records` to the aggregate table one column at a time,
+     * with independent columns updated in parallel.
+     */
+    void update_aggs_parallel(const t_agg_update_info& info,
+        const std::vector<const t_tree_unify_rec*>& records, const t_gstate& gstate);
+#endif
+
     bool is_leaf(t_uindex nidx) const;
 
     t_build_strand_table_common_rval build_strand_table_common(const t_data_table& flattened,
         const std::vector<t_aggspec>& aggspecs, const t_config& config) const;
 
     void populate_pkey_idx(const t_dtree_ctx& ctx, const t_dtree& dtree, t_uindex dptidx,
-        t_uindex sptidx, t_uindex ndepth, t_idxpkey& new_idx_pkey);
+        t_uindex sptidx, t_uindex ndepth);
+
+    void begin_shape_update(t_index root_nstrands);
+
+    /**
+     * @brief Add `nstrands` strands to the child of `pidx` with `value`,
+     * creating it if it does not exist, and record it against row
+     * `src_ridx` of the source aggregates. Returns the id of the child, or
+     * `INVALID_INDEX` if it does not exist and `nstrands` is negative.
+     */
+    t_index update_child_shape(t_uindex pidx, const t_tscalar& value,
+        const t_tscalar& sortby_value, t_depth depth, bool is_leaf, std::int64_t nstrands,
+        t_uindex src_ridx);
+
+    void end_shape_update();
+
+    /**
+     * @brief Note the pkeys of `flattened` whose values in a column of the
+     * sketch aggregates among `aggspecs` differ between `prev` and `current`.
+     */
+    void record_sketch_changes(const t_data_table& flattened, const t_data_table& prev,
+        const t_data_table& current, const std::vector<t_aggspec>& aggspecs);
+
+    /**
+     * @brief Note the pkeys `added` to the leaf `sptidx` by the current
+     * update, for the sketch aggregates - or that its sketches must be
+     * rebuilt, if it lost any of the pkeys `removed`, or `changed` the
+     * sketched values of pkeys it keeps.
+     */
+    void record_sketch_update(t_uindex sptidx, const std::vector<t_tscalar>& added,
+        const std::vector<t_tscalar>& removed, bool changed);
+
+    /**
+     * @brief Bring the sketch of each node touched by the current update up
+     * to date, for the sketch aggregates in `info`. Nodes that only gained
+     * pkeys add their values, and leaves that lost or changed pkeys are
+     * rebuilt from their pkeys. Their ancestors are rebuilt by merging their
+     * children's sketches, which are updated first - unless the leaves only
+     * changed pkeys, and their distinct count sketches lost no register, in
+     * which case the ancestors merge just the changed children.
+     */
+    void update_sketches(const t_agg_update_info& info, const t_gstate& gstate);
 
 private:
     std::vector<t_pivot> m_pivots;
     bool m_init;
-    std::shared_ptr<t_treenodes> m_nodes;
-    std::shared_ptr<t_idxpkey> m_idxpkey;
-    std::shared_ptr<t_idxleaf> m_idxleaf;
+    t_stnode_store m_nodes;
+    t_stmembership m_members;
     t_uindex m_curidx;
     std::shared_ptr<t_data_table> m_aggregates;
     std::vector<t_aggspec> m_aggspecs;
     t_schema m_schema;
     std::vector<t_uindex> m_agg_freelist;
+    std::vector<t_uindex> m_node_freelist;
     t_uindex m_cur_aggidx;
     std::set<t_uindex> m_newids;
     std::set<t_uindex> m_newleaves;
@@ -325,6 +462,29 @@ private:
     t_symtable m_symtable;
     bool m_has_delta;
     std::string m_grand_agg_str;
+    std::function<bool(t_uindex)> m_agg_visible;
+
+    // By depth, the nodes whose deferred aggregates are stale
+    std::vector<tsl::hopscotch_set<t_uindex>> m_dirty_aggs;
+
+    bool m_has_sketches;
+
+    // The leaves the current update only added pkeys to, with those pkeys,
+    // the nodes under which it removed pkeys, and the leaves whose pkeys it
+    // changed the sketched values of
+    tsl::hopscotch_map<t_uindex, std::vector<t_tscalar>> m_sketch_appends;
+    tsl::hopscotch_set<t_uindex> m_sketch_rebuilds;
+    tsl::hopscotch_set<t_uindex> m_sketch_changes;
+
+    // The pkeys whose sketched values the current update changed
+    tsl::hopscotch_set<t_tscalar, t_stvalue_hash, t_stvalue_equal> m_sketch_changed_pkeys;
+
+    // By aggregate column, the sketch behind each aggregate row
+    std::vector<std::vector<t_hll>> m_hlls;
+    std::vector<std::vector<t_tdigest>> m_tdigests;
+
+    // Recycles the strand tables between updates.
+    t_update_arena m_arena;
 };
 
 template <typename ITER_T>
@@ -335,9 +495,9 @@ t_stree::get_agg_min_max(ITER_T biter, ITER_T eiter, t_uindex aggidx) const {
     t_minmax minmax;
 
     for (auto iter = biter; iter != eiter; ++iter) {
-        if (iter->m_idx == 0)
+        if (*iter == 0)
             continue;
-        t_uindex aggidx = iter->m_aggidx;
+        t_uindex aggidx = m_nodes.get_aggidx(*iter);
         t_tscalar v = col->get_scalar(aggidx);
 
         if (minmax.m_min.is_none()) {
@@ -0,0 +1,384 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/scalar.h>
+#include <perspective/sparse_tree_node.h>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief The nodes of a `t_stree`, stored column-wise in arrays indexed by
+ * node id rather than as `t_stnode` records in a multi-index container.
+ *
+ * Each parent keeps the ids of its children ordered by sort value, then
+ * value, and children are resolved by value through a hash map keyed by
+ * parent id and value. Children inserted, or whose sort value changes, are
+ * only merged into their parent's order when that order is next read, or
+ * `sort_children` is called - a tree should call it once it has finished
+ * updating, so that reading it never writes.
+ *
+ * Node ids are assigned by the tree, which reuses the ids of erased nodes,
+ * so the arrays are sized by the most nodes the store has held at once.
+ * The ids in the store are also kept in a dense list, so that visiting
+ * every node does not scan the free slots.
+ */
+class PERSPECTIVE_EXPORT t_stnode_store {
+public:
+    t_stnode_store();
+
+    /**
+     * @brief The number of nodes in the store.
+     *
+     * @return t_uindex
+     */
+    t_uindex size() const;
+
+    /**
+     * @brief The ids of the nodes in the store, in no particular order.
+     *
+     * @return const std::vector<t_uindex>&
+     */
+    const std::vector<t_uindex>& get_ids() const;
+
+    void clear();
+
+    bool exists(t_uindex idx) const;
+
+    /**
+     * @brief Insert `node`, returning false without inserting it if its id,
+     * or its value under its parent, is already in the store.
+     *
+     * @param node
+     * @return true
+     * @return false
+     */
+    bool insert(const t_stnode& node);
+
+    /**
+     * @brief Remove the nodes in `indices`, which must all exist. Their
+     * children are not removed.
+     *
+     * @param indices
+     */
+    void erase(const std::vector<t_uindex>& indices);
+
+    t_stnode get(t_uindex idx) const;
+
+    t_uindex get_parent(t_uindex idx) const;
+    std::uint8_t get_depth(t_uindex idx) const;
+    const t_tscalar& get_value(t_uindex idx) const;
+    const t_tscalar& get_sort_value(t_uindex idx) const;
+    t_uindex get_nstrands(t_uindex idx) const;
+    t_uindex get_aggidx(t_uindex idx) const;
+
+    void set_nstrands(t_uindex idx, t_uindex nstrands);
+    void set_sort_value(t_uindex idx, const t_tscalar& sort_value);
+
+    /**
+     * @brief Returns the id of the child of `pidx` with value `value`, or
+     * `INVALID_INDEX` if there is none.
+     *
+     * @param pidx
+     * @param value
+     * @return t_index
+     */
+    t_index find_child(t_uindex pidx, const t_tscalar& value) const;
+
+    /**
+     * @brief Returns the ids of the children of `pidx`, ordered by sort
+     * value, then value.
+     *
+     * @param pidx
+     * @return const std::vector<t_uindex>&
+     */
+    const std::vector<t_uindex>& get_children(t_uindex pidx) const;
+
+    /**
+     * @brief Returns the position of `idx` among the children of its parent.
+     *
+     * @param idx
+     * @return t_uindex
+     */
+    t_uindex get_sibling_idx(t_uindex idx) const;
+
+    /**
+     * @brief Returns the ids of the nodes with no strands, in ascending
+     * order.
+     *
+     * @return std::vector<t_uindex>
+     */
+    std::vector<t_uindex> get_zero_strands() const;
+
+    /**
+     * @brief Merge every child inserted or re-sorted since the last call
+     * into the order of its parent's children.
+     */
+    void sort_children() const;
+
+private:
+    typedef std::pair<t_uindex, t_tscalar> t_child_key;
+
+    // Equality of values is that of the ordered index this replaced, under
+    // which 0.0 and -0.0 are the same value.
+    struct t_child_key_hash {
+        std::size_t operator()(const t_child_key& key) const;
+    };
+
+    struct t_child_key_equal {
+        bool operator()(const t_child_key& lhs, const t_child_key& rhs) const;
+    };
+
+    bool child_precedes(t_uindex lhs, t_uindex rhs) const;
+    void sort_children(t_uindex pidx, const std::vector<t_uindex>& unsorted) const;
+    void mark_unsorted(t_uindex pidx, t_uindex idx);
+    void set_zero(t_uindex idx, bool zero);
+
+    std::vector<std::uint8_t> m_exists;
+    std::vector<t_uindex> m_pidx;
+    std::vector<std::uint8_t> m_depth;
+    std::vector<t_tscalar> m_value;
+    std::vector<t_tscalar> m_sort_value;
+    std::vector<t_uindex> m_nstrands;
+    std::vector<t_uindex> m_aggidx;
+    t_uindex m_size;
+
+    // The live ids, and the position of each in `m_ids`
+    std::vector<t_uindex> m_ids;
+    std::vector<t_uindex> m_id_pos;
+
+    tsl::hopscotch_map<t_child_key, t_uindex, t_child_key_hash, t_child_key_equal> m_child_index;
+    mutable tsl::hopscotch_map<t_uindex, std::vector<t_uindex>> m_children;
+
+    // Parent id to the children out of place in its order
+    mutable tsl::hopscotch_map<t_uindex, std::vector<t_uindex>> m_unsorted;
+    tsl::hopscotch_set<t_uindex> m_zero_strands;
+};
+
+/**
+ * @brief Hashing and equality of node values consistent with their order,
+ * under which 0.0 and -0.0 are the same value.
+ */
+struct PERSPECTIVE_EXPORT t_stvalue_hash {
+    std::size_t operator()(const t_tscalar& value) const;
+    std::size_t operator()(t_uindex value) const;
+};
+
+struct t_stvalue_equal {
+    template <typename T>
+    bool
+    operator()(const T& lhs, const T& rhs) const {
+        return !(lhs < rhs) && !(rhs < lhs);
+    }
+};
+
+/**
+ * @brief An ordered set which defers keeping its order. Removing a value
+ * only marks it removed, and a value added out of order waits in a hash
+ * set, until the set is next read or the deferred values outnumber those
+ * in order - so each update costs O(log n), and reading the set after k
+ * of them costs O(n + k log k), once.
+ */
+template <typename T>
+class t_stmember_set {
+public:
+    t_stmember_set();
+
+    void insert(const T& value);
+    void erase(const T& value);
+    bool contains(const T& value) const;
+
+    /**
+     * @brief The values in the set, in ascending order.
+     *
+     * @return const std::vector<T>&
+     */
+    const std::vector<T>& get() const;
+
+private:
+    void compact_if_sparse();
+    void compact() const;
+
+    mutable std::vector<T> m_values;
+    mutable std::vector<std::uint8_t> m_removed;
+    mutable t_uindex m_nremoved;
+    mutable tsl::hopscotch_set<T, t_stvalue_hash, t_stvalue_equal> m_pending;
+};
+
+/**
+ * @brief The primary keys under each leaf of a `t_stree`, and the leaves
+ * under each of its inner nodes, as arrays indexed by node id.
+ *
+ * Each leaf's pkeys are read in ascending order, and each node's leaves in
+ * ascending id order, so that reading a node's pkeys visits them in the
+ * same order as the ordered index this replaced.
+ */
+class PERSPECTIVE_EXPORT t_stmembership {
+public:
+    void clear();
+
+    /**
+     * @brief Add `pkey` to the leaf `idx`, if it is not already there.
+     *
+     * @param idx
+     * @param pkey
+     */
+    void add_pkey(t_uindex idx, const t_tscalar& pkey);
+
+    /**
+     * @brief Remove `removed` from, then add `added` to, the pkeys of leaf
+     * `idx`.
+     *
+     * @param idx
+     * @param added
+     * @param removed
+     */
+    void update_pkeys(t_uindex idx, const std::vector<t_tscalar>& added,
+        const std::vector<t_tscalar>& removed);
+
+    const std::vector<t_tscalar>& get_pkeys(t_uindex idx) const;
+
+    bool has_pkey(t_uindex idx, const t_tscalar& pkey) const;
+
+    void add_leaf(t_uindex nidx, t_uindex lfidx);
+    void remove_leaves(t_uindex nidx, const std::vector<t_uindex>& lfidxs);
+
+    const std::vector<t_uindex>& get_leaves(t_uindex nidx) const;
+
+    /**
+     * @brief Release the pkeys and leaves of the nodes in `indices`.
+     *
+     * @param indices
+     */
+    void erase(const std::vector<t_uindex>& indices);
+
+private:
+    std::vector<t_stmember_set<t_tscalar>> m_pkeys;
+    std::vector<t_stmember_set<t_uindex>> m_leaves;
+};
+
+template <typename T>
+t_stmember_set<T>::t_stmember_set()
+    : m_nremoved(0) {}
+
+template <typename T>
+void
+t_stmember_set<T>::insert(const T& value) {
+    if (m_pending.find(value) != m_pending.end())
+        return;
+
+    if (m_values.empty() || m_values.back() < value) {
+        m_values.push_back(value);
+        m_removed.push_back(0);
+        return;
+    }
+
+    auto iter = std::lower_bound(m_values.begin(), m_values.end(), value);
+    if (iter != m_values.end() && !(value < *iter)) {
+        auto& removed = m_removed[std::distance(m_values.begin(), iter)];
+        if (removed) {
+            removed = 0;
+            --m_nremoved;
+        }
+        return;
+    }
+
+    m_pending.insert(value);
+    compact_if_sparse();
+}
+
+template <typename T>
+void
+t_stmember_set<T>::erase(const T& value) {
+    if (m_pending.erase(value) > 0)
+        return;
+
+    auto iter = std::lower_bound(m_values.begin(), m_values.end(), value);
+    if (iter == m_values.end() || value < *iter)
+        return;
+
+    auto& removed = m_removed[std::distance(m_values.begin(), iter)];
+    if (!removed) {
+        removed = 1;
+        ++m_nremoved;
+        compact_if_sparse();
+    }
+}
+
+template <typename T>
+bool
+t_stmember_set<T>::contains(const T& value) const {
+    if (m_pending.find(value) != m_pending.end())
+        return true;
+
+    auto iter = std::lower_bound(m_values.begin(), m_values.end(), value);
+    return iter != m_values.end() && !(value < *iter)
+        && !m_removed[std::distance(m_values.begin(), iter)];
+}
+
+template <typename T>
+const std::vector<T>&
+t_stmember_set<T>::get() const {
+    if (m_nremoved > 0 || !m_pending.empty()) {
+        compact();
+    }
+
+    return m_values;
+}
+
+// Compacting once the deferred values outnumber the rest keeps its cost
+// amortized over the updates which deferred them.
+template <typename T>
+void
+t_stmember_set<T>::compact_if_sparse() {
+    t_uindex nlive = m_values.size() - m_nremoved;
+    if (m_nremoved + m_pending.size() > nlive) {
+        compact();
+    }
+}
+
+template <typename T>
+void
+t_stmember_set<T>::compact() const {
+    if (m_nremoved > 0) {
+        t_uindex out = 0;
+        for (t_uindex idx = 0, loop_end = m_values.size(); idx < loop_end; ++idx) {
+            if (!m_removed[idx]) {
+                m_values[out++] = m_values[idx];
+            }
+        }
+
+        m_values.resize(out);
+        m_nremoved = 0;
+    }
+
+    if (!m_pending.empty()) {
+        std::vector<T> added(m_pending.begin(), m_pending.end());
+        std::sort(added.begin(), added.end());
+        m_pending.clear();
+
+        t_uindex nvalues = m_values.size();
+        m_values.insert(m_values.end(), added.begin(), added.end());
+        std::inplace_merge(m_values.begin(), m_values.begin() + nvalues, m_values.end());
+    }
+
+    m_removed.assign(m_values.size(), 0);
+}
+
+} // end namespace perspective
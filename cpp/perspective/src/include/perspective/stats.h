@@ -0,0 +1,160 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief The stages of an update that are timed by `t_stats`. Gnode-level
+ * stages are recorded on the `t_gnode`, and context-level stages on the
+ * context being notified.
+ */
+enum t_stats_stage {
+    STATS_STAGE_PROCESS,
+    STATS_STAGE_FLATTEN,
+    STATS_STAGE_LOOKUP,
+    STATS_STAGE_PROCESS_COLUMNS,
+    STATS_STAGE_COMPUTED_COLUMNS,
+    STATS_STAGE_UPDATE_MASTER,
+    STATS_STAGE_NOTIFY,
+    STATS_STAGE_STEP_END,
+    STATS_STAGE_TRAVERSAL,
+    STATS_STAGE_LAST
+};
+
+PERSPECTIVE_EXPORT std::string stats_stage_to_str(t_stats_stage stage);
+
+// Histogram buckets are powers of two in nanoseconds, so 40 buckets cover
+// everything up to ~18 minutes.
+const t_uindex PSP_STATS_NUM_BUCKETS = 40;
+
+// Upper bound on the trace events kept per `t_stats` between resets.
+const t_uindex PSP_STATS_MAX_TRACE_EVENTS = 65536;
+
+/**
+ * @brief Counters and a log2 latency histogram for a single stage.
+ */
+struct PERSPECTIVE_EXPORT t_stats_record {
+    t_stats_record();
+
+    void record(std::uint64_t ns, t_uindex rows);
+
+    /**
+     * @brief Approximate the `p`th percentile (0 - 1) of recorded latencies
+     * from the histogram, returning the upper bound of the bucket in which it
+     * falls.
+     *
+     * @param p
+     * @return double
+     */
+    double percentile_ns(double p) const;
+
+    std::uint64_t m_count;
+    std::uint64_t m_rows;
+    std::uint64_t m_total_ns;
+    std::uint64_t m_max_ns;
+    std::array<std::uint64_t, PSP_STATS_NUM_BUCKETS> m_histogram;
+};
+
+struct PERSPECTIVE_EXPORT t_stats_event {
+    t_stats_stage m_stage;
+    std::uint64_t m_begin_ns;
+    std::uint64_t m_duration_ns;
+    t_uindex m_rows;
+};
+
+/**
+ * @brief Per-gnode or per-context timing counters. A `t_stats` is only ever
+ * written by the thread that owns its gnode or context for the duration of
+ * a `_process`, so it holds no locks.
+ */
+class PERSPECTIVE_EXPORT t_stats {
+public:
+    typedef std::chrono::steady_clock t_clock;
+
+    t_stats();
+
+    void record(t_stats_stage stage, t_clock::time_point begin, t_uindex rows);
+
+    const t_stats_record& get_record(t_stats_stage stage) const;
+
+    /**
+     * @brief Returns a map of stage name to a map of `count`, `rows`,
+     * `total_ns`, `mean_ns`, `max_ns`, `p50_ns` and `p99_ns` for every stage
+     * that has been recorded at least once. `prefix` is prepended to each
+     * stage name.
+     *
+     * @param prefix
+     * @param summary
+     */
+    void summarize(const std::string& prefix,
+        std::map<std::string, std::map<std::string, double>>& summary) const;
+
+    /**
+     * @brief Write the recorded events as Chrome trace-event JSON objects,
+     * comma separated, without the enclosing array.
+     *
+     * @param os
+     * @param name the thread name shown in the trace viewer
+     * @param pid
+     * @param tid
+     * @param first whether no event has been written to `os` yet, updated
+     * after writing.
+     */
+    void write_trace_events(std::ostream& os, const std::string& name, t_uindex pid,
+        t_uindex tid, bool& first) const;
+
+    void reset();
+
+    /**
+     * @brief Enable or disable the recording of individual trace events.
+     * Counters are always recorded.
+     *
+     * @param enabled
+     */
+    void set_trace_enabled(bool enabled);
+    bool get_trace_enabled() const;
+
+private:
+    std::array<t_stats_record, STATS_STAGE_LAST> m_records;
+    std::vector<t_stats_event> m_events;
+    t_uindex m_dropped_events;
+    bool m_trace_enabled;
+};
+
+/**
+ * @brief Records the time from construction to destruction into a `t_stats`.
+ */
+class PERSPECTIVE_EXPORT t_stats_timer {
+public:
+    t_stats_timer(t_stats& stats, t_stats_stage stage, t_uindex rows = 0);
+    ~t_stats_timer();
+
+    void set_rows(t_uindex rows);
+
+private:
+    PSP_NON_COPYABLE(t_stats_timer);
+    t_stats& m_stats;
+    t_stats_stage m_stage;
+    t_uindex m_rows;
+    t_stats::t_clock::time_point m_begin;
+};
+
+} // end namespace perspective
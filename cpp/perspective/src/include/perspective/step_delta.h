@@ -13,54 +13,208 @@
 #include <perspective/scalar.h>
 #include <perspective/exports.h>
 #include <vector>
-#include <tsl/hopscotch_set.h>
-#include <boost/multi_index_container.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/composite_key.hpp>
-#include <boost/variant/apply_visitor.hpp>
+#include <algorithm>
+#include <numeric>
+#include <utility>
 
 namespace perspective {
 
-using boost::multi_index_container;
-using namespace boost::multi_index;
+/**
+ * @brief The cell deltas a context records between steps, each keyed by a
+ * row - a primary key for `t_ctx0`, a tree node for the pivoted contexts -
+ * and a column or aggregate index.
+ *
+ * Records are appended to flat, columnar buffers as they are calculated,
+ * and only sorted by (key, column) when they are next read, keeping the
+ * first record for each (key, column).
+ */
+template <typename KEY_T>
+class t_step_deltas {
+public:
+    t_step_deltas();
 
-// Deltas for various contexts
+    void insert(const KEY_T& key, t_uindex colidx, const t_tscalar& old_value,
+        const t_tscalar& new_value);
 
-struct t_zcdelta {
-    t_zcdelta(t_tscalar pkey, t_index colidx, t_tscalar old_value, t_tscalar new_value);
+    /**
+     * @brief Append the records of `other`, which follow this container's
+     * own when both record the same (key, column).
+     *
+     * @param other
+     */
+    void insert(const t_step_deltas& other);
 
-    t_tscalar m_pkey;
-    t_index m_colidx;
-    t_tscalar m_old_value;
-    t_tscalar m_new_value;
-};
+    void clear();
+    bool empty() const;
+
+    /**
+     * @brief The number of distinct (key, column) records.
+     *
+     * @return t_uindex
+     */
+    t_uindex size() const;
 
-struct by_zc_pkey_colidx {};
+    /**
+     * @brief The [begin, end) indices of the records for `key`.
+     *
+     * @param key
+     * @return std::pair<t_uindex, t_uindex>
+     */
+    std::pair<t_uindex, t_uindex> equal_range(const KEY_T& key) const;
 
-typedef multi_index_container<t_zcdelta,
-    indexed_by<ordered_unique<tag<by_zc_pkey_colidx>,
-        composite_key<t_zcdelta, BOOST_MULTI_INDEX_MEMBER(t_zcdelta, t_tscalar, m_pkey),
-            BOOST_MULTI_INDEX_MEMBER(t_zcdelta, t_index, m_colidx)>>>>
-    t_zcdeltas;
+    const KEY_T& key(t_uindex idx) const;
+    t_uindex colidx(t_uindex idx) const;
+    const t_tscalar& old_value(t_uindex idx) const;
+    const t_tscalar& new_value(t_uindex idx) const;
 
-struct t_tcdelta {
-    t_tcdelta(t_uindex nidx, t_uindex aggidx, t_tscalar old_value, t_tscalar new_value);
+private:
+    void sort() const;
 
-    t_uindex m_nidx;
-    t_uindex m_aggidx;
-    t_tscalar m_old_value;
-    t_tscalar m_new_value;
+    mutable std::vector<KEY_T> m_keys;
+    mutable std::vector<t_uindex> m_colidxs;
+    mutable std::vector<t_tscalar> m_old_values;
+    mutable std::vector<t_tscalar> m_new_values;
+    mutable bool m_sorted;
 };
 
-struct by_tc_nidx_aggidx {};
+template <typename KEY_T>
+t_step_deltas<KEY_T>::t_step_deltas()
+    : m_sorted(true) {}
+
+template <typename KEY_T>
+void
+t_step_deltas<KEY_T>::insert(const KEY_T& key, t_uindex colidx, const t_tscalar& old_value,
+    const t_tscalar& new_value) {
+    m_keys.push_back(key);
+    m_colidxs.push_back(colidx);
+    m_old_values.push_back(old_value);
+    m_new_values.push_back(new_value);
+    m_sorted = false;
+}
+
+template <typename KEY_T>
+void
+t_step_deltas<KEY_T>::insert(const t_step_deltas& other) {
+    if (other.m_keys.empty()) {
+        return;
+    }
+
+    m_keys.insert(m_keys.end(), other.m_keys.begin(), other.m_keys.end());
+    m_colidxs.insert(m_colidxs.end(), other.m_colidxs.begin(), other.m_colidxs.end());
+    m_old_values.insert(
+        m_old_values.end(), other.m_old_values.begin(), other.m_old_values.end());
+    m_new_values.insert(
+        m_new_values.end(), other.m_new_values.begin(), other.m_new_values.end());
+    m_sorted = false;
+}
+
+template <typename KEY_T>
+void
+t_step_deltas<KEY_T>::clear() {
+    m_keys.clear();
+    m_colidxs.clear();
+    m_old_values.clear();
+    m_new_values.clear();
+    m_sorted = true;
+}
+
+template <typename KEY_T>
+bool
+t_step_deltas<KEY_T>::empty() const {
+    return m_keys.empty();
+}
+
+template <typename KEY_T>
+t_uindex
+t_step_deltas<KEY_T>::size() const {
+    sort();
+    return m_keys.size();
+}
+
+template <typename KEY_T>
+std::pair<t_uindex, t_uindex>
+t_step_deltas<KEY_T>::equal_range(const KEY_T& key) const {
+    sort();
+    auto range = std::equal_range(m_keys.begin(), m_keys.end(), key);
+    return std::make_pair(
+        t_uindex(range.first - m_keys.begin()), t_uindex(range.second - m_keys.begin()));
+}
+
+template <typename KEY_T>
+const KEY_T&
+t_step_deltas<KEY_T>::key(t_uindex idx) const {
+    sort();
+    return m_keys[idx];
+}
+
+template <typename KEY_T>
+t_uindex
+t_step_deltas<KEY_T>::colidx(t_uindex idx) const {
+    sort();
+    return m_colidxs[idx];
+}
+
+template <typename KEY_T>
+const t_tscalar&
+t_step_deltas<KEY_T>::old_value(t_uindex idx) const {
+    sort();
+    return m_old_values[idx];
+}
+
+template <typename KEY_T>
+const t_tscalar&
+t_step_deltas<KEY_T>::new_value(t_uindex idx) const {
+    sort();
+    return m_new_values[idx];
+}
 
-typedef multi_index_container<t_tcdelta,
-    indexed_by<ordered_unique<tag<by_tc_nidx_aggidx>,
-        composite_key<t_tcdelta, BOOST_MULTI_INDEX_MEMBER(t_tcdelta, t_uindex, m_nidx),
-            BOOST_MULTI_INDEX_MEMBER(t_tcdelta, t_uindex, m_aggidx)>>>>
-    t_tcdeltas;
+template <typename KEY_T>
+void
+t_step_deltas<KEY_T>::sort() const {
+    if (m_sorted) {
+        return;
+    }
+
+    std::vector<t_uindex> order(m_keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](t_uindex a, t_uindex b) {
+        if (m_keys[a] < m_keys[b])
+            return true;
+        if (m_keys[b] < m_keys[a])
+            return false;
+        return m_colidxs[a] < m_colidxs[b];
+    });
+
+    std::vector<KEY_T> keys;
+    std::vector<t_uindex> colidxs;
+    std::vector<t_tscalar> old_values;
+    std::vector<t_tscalar> new_values;
+    keys.reserve(order.size());
+    colidxs.reserve(order.size());
+    old_values.reserve(order.size());
+    new_values.reserve(order.size());
+
+    for (auto idx : order) {
+        if (!keys.empty() && !(keys.back() < m_keys[idx]) && colidxs.back() == m_colidxs[idx]) {
+            continue;
+        }
+
+        keys.push_back(m_keys[idx]);
+        colidxs.push_back(m_colidxs[idx]);
+        old_values.push_back(m_old_values[idx]);
+        new_values.push_back(m_new_values[idx]);
+    }
+
+    std::swap(m_keys, keys);
+    std::swap(m_colidxs, colidxs);
+    std::swap(m_old_values, old_values);
+    std::swap(m_new_values, new_values);
+    m_sorted = true;
+}
+
+// Deltas for various contexts
+typedef t_step_deltas<t_tscalar> t_zcdeltas;
+typedef t_step_deltas<t_uindex> t_tcdeltas;
 
 struct PERSPECTIVE_EXPORT t_cellupd {
     t_cellupd(
@@ -15,7 +15,8 @@
 namespace perspective {
 
 class PERSPECTIVE_EXPORT t_symtable {
-    typedef tsl::hopscotch_map<const char*, const char*, t_cchar_umap_hash, t_cchar_umap_cmp>
+    typedef tsl::hopscotch_map<const char*, const char*, t_cchar_umap_hash, t_cchar_umap_cmp,
+        std::allocator<std::pair<const char*, const char*>>, 62, true>
         t_mapping;
 
 public:
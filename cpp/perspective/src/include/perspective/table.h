@@ -139,6 +139,36 @@ public:
      */
     void remove_port(t_uindex port_id);
 
+    /**
+     * @brief Returns the timing counters for each stage of an update on this
+     * table's gnode, and for each of the contexts registered on it.
+     *
+     * @return std::map<std::string, std::map<std::string, double>>
+     */
+    std::map<std::string, std::map<std::string, double>> get_stats() const;
+
+    /**
+     * @brief Reset the counters and trace events of this table's gnode and
+     * its contexts, leaving other tables on the same pool untouched.
+     */
+    void reset_stats();
+
+    /**
+     * @brief Start or stop recording individual trace events for updates
+     * on this table.
+     *
+     * @param enabled
+     */
+    void set_trace_enabled(bool enabled);
+
+    /**
+     * @brief Returns the trace events recorded on this table since the last
+     * `reset_stats` as Chrome trace-event JSON.
+     *
+     * @return std::string
+     */
+    std::string get_trace_json() const;
+
     /**
      * @brief The offset determines where we begin to write data into the Table. 
      * Using `m_offset`, `m_limit`, and the length of the dataset, calculate the new position at which we write data.
@@ -15,11 +15,15 @@
 #include <perspective/exports.h>
 #include <perspective/multi_sort.h>
 #include <perspective/traversal_nodes.h>
+#include <perspective/traversal_tree.h>
 #include <perspective/sort_specification.h>
 #include <perspective/sparse_tree_node.h>
 #include <perspective/sparse_tree.h>
 #include <perspective/arg_sort.h>
+#include <tsl/hopscotch_map.h>
+#include <tsl/hopscotch_set.h>
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <queue>
 
@@ -44,10 +48,6 @@ public:
     void add_node(const std::vector<t_sortspec>& sortby, const std::vector<t_uindex>& indices,
         t_index insert_level_idx, t_ctx2* ctx2 = nullptr);
 
-    t_index update_ancestors(t_index nidx, t_index n_changed);
-
-    t_index update_sucessors(t_index nidx, t_index n_changed);
-
     t_index get_tree_index(t_index idx) const;
 
     t_uindex size() const;
@@ -76,6 +76,40 @@ public:
     void sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
         const SRC_T& src, t_ctx2* ctx2 = nullptr);
 
+    /**
+     * @brief Bring the traversal back into `sortby` order after an update,
+     * re-sorting only the children of nodes marked by `mark_unsorted` or
+     * reordered by `add_node` and `expand_node` since the last sort. Falls
+     * back to a full `sort_by` if the traversal has not been sorted by
+     * `sortby` before.
+     *
+     * The result is identical to `sort_by`: children whose sort values
+     * did not change are already in order, so the changed ones are merged
+     * back in among them.
+     *
+     * @param config
+     * @param sortby
+     * @param src
+     * @param ctx2
+     */
+    template <typename SRC_T>
+    void update_sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
+        const SRC_T& src, t_ctx2* ctx2 = nullptr);
+
+    /**
+     * @brief Mark tree nodes whose sort values may have changed, so that
+     * the next `update_sort_by` re-positions them among their siblings.
+     *
+     * @param tnids
+     */
+    void mark_unsorted(const std::vector<t_uindex>& tnids);
+
+    /**
+     * @brief Forget the sort order, so that the next `update_sort_by` does a
+     * full sort.
+     */
+    void invalidate_sort();
+
     void get_child_indices(
         t_index nidx, std::vector<std::pair<t_index, t_index>>& out_data) const;
 
@@ -99,6 +133,15 @@ public:
 
     bool get_node_expanded(t_index idx) const;
 
+    /**
+     * @brief Whether the tree node `tnid` is in the traversal, and expanded.
+     *
+     * @param tnid
+     * @return true
+     * @return false
+     */
+    bool is_tree_node_expanded(t_index tnid) const;
+
     void drop_tree_indices(const std::vector<t_uindex>& indices);
 
     bool is_valid_idx(t_index idx) const;
@@ -109,21 +152,65 @@ public:
     void populate_root_children(std::shared_ptr<const t_stree> tree);
 
 private:
+    /**
+     * @brief Add `n_changed` to the descendant count of every ancestor of
+     * the node at `handle`.
+     */
+    void update_ancestors(t_index handle, t_index n_changed);
+
+    void mark_unsorted(t_index parent_tnid, t_index child_tnid);
+
+    /**
+     * @brief As the public `expand_node`, for a node whose handle is
+     * already known.
+     */
+    t_index expand_node(const std::vector<t_sortspec>& sortby, t_index exp_idx,
+        t_index exp_handle, t_ctx2* ctx2);
+
+    /**
+     * @brief Write the position and handle of each child of the node at
+     * `nidx`, with handle `handle`, to `out_data`, stepping between siblings
+     * by handle where it can rather than looking each up by position.
+     */
+    void get_child_handles(t_index nidx, t_index handle,
+        std::vector<std::pair<t_index, t_index>>& out_data) const;
+
+    /**
+     * @brief Re-sort the children of the expanded node at `nidx`, moving
+     * each child's subtree with it. If `moved` is not null, only the
+     * children in it may be out of order.
+     */
+    template <typename SRC_T>
+    void resort_children(t_index nidx, const std::vector<t_index>& sortby_agg_indices,
+        const std::vector<t_sorttype>& sort_orders, const SRC_T& src, t_ctx2* ctx2,
+        const tsl::hopscotch_set<t_index>* moved);
+
     std::shared_ptr<const t_stree> m_tree;
-    std::shared_ptr<std::vector<t_tvnode>> m_nodes;
+    t_tvtree m_nodes;
+
+    // The sort last applied by `sort_by`, valid while `m_sort_valid`.
+    std::vector<t_sortspec> m_sorted_by;
+    bool m_sort_valid;
+
+    // Tree indices of parents whose children may be out of order, mapped to
+    // those children, and parents whose children may all be out of order.
+    tsl::hopscotch_map<t_index, tsl::hopscotch_set<t_index>> m_unsorted_children;
+    tsl::hopscotch_set<t_index> m_unsorted_parents;
 };
 
 template <typename SRC_T>
 void
 t_traversal::sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
     const SRC_T& src, t_ctx2* ctx2) {
-    std::vector<t_tvnode> new_nodes(m_nodes->size());
+    std::vector<t_index> old_handles;
+    m_nodes.handles(0, m_nodes.size(), old_handles);
+    std::vector<t_index> new_handles(old_handles.size());
 
     // Pair is -> (old tvidx, new tvidx)
     std::vector<std::pair<t_index, t_index>> queue;
 
     // Add root to queue
-    new_nodes[0] = (*m_nodes)[0];
+    new_handles[0] = old_handles[0];
     queue.emplace_back(std::pair<t_index, t_index>(0, 0));
 
     std::vector<t_index> sortby_agg_indices(sortby.size());
@@ -146,10 +233,15 @@ t_traversal::sort_by(const t_config& config, const std::vector<t_sortspec>& sort
         // Heads idx in new traversal
         t_index h_ntvidx = head_info.second;
 
-        const t_tvnode& head = (*m_nodes)[h_ctvidx];
+        const t_tvnode& head = m_nodes.node(old_handles[h_ctvidx]);
 
         std::vector<std::pair<t_index, t_index>> h_children;
-        get_child_indices(h_ctvidx, h_children);
+        t_index c_ctvidx = h_ctvidx + 1;
+        for (t_uindex i = 0; i < head.m_nchild; ++i) {
+            const t_tvnode& child = m_nodes.node(old_handles[c_ctvidx]);
+            h_children.push_back(std::pair<t_index, t_index>(c_ctvidx, child.m_tnid));
+            c_ctvidx += child.m_ndesc + 1;
+        }
 
         if (!h_children.empty()) {
             // Get sorted indices
@@ -187,8 +279,7 @@ t_traversal::sort_by(const t_config& config, const std::vector<t_sortspec>& sort
                 for (t_index idx = bidx; idx < eidx; idx++) {
                     t_index cidx = sorted_idx[idx - bidx];
                     t_index c_otvidx = h_children[cidx].first;
-                    new_nodes[idx] = (*m_nodes)[c_otvidx];
-                    new_nodes[idx].m_rel_pidx = idx - bidx + 1;
+                    new_handles[idx] = old_handles[c_otvidx];
                 }
             } else {
                 t_index c_ntvidx = h_ntvidx + 1;
@@ -198,22 +289,181 @@ t_traversal::sort_by(const t_config& config, const std::vector<t_sortspec>& sort
                     t_index cidx = sorted_idx[idx];
                     t_index c_otvidx = h_children[cidx].first;
 
-                    const t_tvnode& child = (*m_nodes)[c_otvidx];
+                    const t_tvnode& child = m_nodes.node(old_handles[c_otvidx]);
 
                     // Enqueue child if it is expanded
                     if (child.m_expanded) {
                         queue.emplace_back(std::pair<t_index, t_index>(c_otvidx, c_ntvidx));
                     }
 
-                    new_nodes[c_ntvidx] = (*m_nodes)[c_otvidx];
-                    new_nodes[c_ntvidx].m_rel_pidx = c_ntvidx - h_ntvidx;
+                    new_handles[c_ntvidx] = old_handles[c_otvidx];
                     c_ntvidx = c_ntvidx + child.m_ndesc + 1;
                 }
             }
         }
     }
 
-    std::swap(*m_nodes, new_nodes);
+    // Nodes refer to their parents by handle, so reordering them needs no
+    // further fix up.
+    m_nodes.reorder(0, new_handles);
+
+    m_sorted_by = sortby;
+    m_sort_valid = true;
+    m_unsorted_children.clear();
+    m_unsorted_parents.clear();
+}
+
+template <typename SRC_T>
+void
+t_traversal::update_sort_by(const t_config& config, const std::vector<t_sortspec>& sortby,
+    const SRC_T& src, t_ctx2* ctx2) {
+    if (!m_sort_valid || sortby != m_sorted_by) {
+        sort_by(config, sortby, src, ctx2);
+        return;
+    }
+
+    if (m_unsorted_children.empty() && m_unsorted_parents.empty())
+        return;
+
+    std::vector<t_index> sortby_agg_indices(sortby.size());
+    for (t_uindex idx = 0, loop_end = sortby.size(); idx < loop_end; ++idx) {
+        sortby_agg_indices[idx] = sortby[idx].m_agg_index;
+    }
+
+    std::vector<t_sorttype> sort_orders = get_sort_orders(sortby);
+
+    // Positions of the marked parents still in the traversal, with
+    // whether all of their children may be out of order.
+    std::vector<std::pair<t_index, bool>> parents;
+    for (t_index tnid : m_unsorted_parents) {
+        t_index handle = m_nodes.find(tnid);
+        if (handle != INVALID_INDEX) {
+            parents.push_back(std::pair<t_index, bool>(m_nodes.position(handle), true));
+        }
+    }
+
+    for (const auto& kv : m_unsorted_children) {
+        if (m_unsorted_parents.find(kv.first) != m_unsorted_parents.end())
+            continue;
+        t_index handle = m_nodes.find(kv.first);
+        if (handle != INVALID_INDEX) {
+            parents.push_back(std::pair<t_index, bool>(m_nodes.position(handle), false));
+        }
+    }
+
+    // Re-sort from the bottom up, so that reordering a node's children
+    // moves subtrees which are already in order, and never shifts the
+    // position of a node still to be visited.
+    std::sort(parents.begin(), parents.end(),
+        [](const std::pair<t_index, bool>& a, const std::pair<t_index, bool>& b) {
+            return a.first > b.first;
+        });
+
+    for (const auto& parent : parents) {
+        t_index nidx = parent.first;
+        const t_tvnode& node = m_nodes.node(m_nodes.handle_at(nidx));
+        if (!node.m_expanded || node.m_nchild < 2)
+            continue;
+
+        if (parent.second) {
+            resort_children(nidx, sortby_agg_indices, sort_orders, src, ctx2, nullptr);
+        } else {
+            resort_children(nidx, sortby_agg_indices, sort_orders, src, ctx2,
+                &m_unsorted_children.find(node.m_tnid)->second);
+        }
+    }
+
+    m_unsorted_children.clear();
+    m_unsorted_parents.clear();
+}
+
+template <typename SRC_T>
+void
+t_traversal::resort_children(t_index nidx, const std::vector<t_index>& sortby_agg_indices,
+    const std::vector<t_sorttype>& sort_orders, const SRC_T& src, t_ctx2* ctx2,
+    const tsl::hopscotch_set<t_index>* moved) {
+    std::vector<std::pair<t_index, t_index>> children;
+    get_child_indices(nidx, children);
+    t_index nchild = children.size();
+
+    // Sort values are read lazily, as merging only compares each moved
+    // child with O(log n) of the others.
+    std::vector<t_mselem> elems(nchild);
+    std::vector<bool> has_elem(nchild, false);
+    std::vector<t_tscalar> aggregates(sortby_agg_indices.size());
+
+    auto get_elem = [&](t_index cidx) -> const t_mselem& {
+        if (!has_elem[cidx]) {
+            src.get_aggregates_for_sorting(
+                children[cidx].second, sortby_agg_indices, aggregates, ctx2);
+            elems[cidx] = t_mselem(aggregates, static_cast<t_uindex>(cidx));
+            has_elem[cidx] = true;
+        }
+        return elems[cidx];
+    };
+
+    auto cmp = [&](t_index a, t_index b) {
+        return cmp_mselem(get_elem(a), get_elem(b), sort_orders);
+    };
+
+    std::vector<t_index> sorted_idx;
+    sorted_idx.reserve(nchild);
+
+    std::vector<t_index> moved_idx;
+    std::vector<t_index> kept_idx;
+    if (moved) {
+        for (t_index cidx = 0; cidx < nchild; ++cidx) {
+            if (moved->find(children[cidx].second) != moved->end()) {
+                moved_idx.push_back(cidx);
+            } else {
+                kept_idx.push_back(cidx);
+            }
+        }
+    }
+
+    double merge_cost = moved_idx.size() * (std::log2(double(nchild)) + 1);
+    if (!moved || merge_cost >= nchild) {
+        for (t_index cidx = 0; cidx < nchild; ++cidx) {
+            sorted_idx.push_back(cidx);
+        }
+        std::sort(sorted_idx.begin(), sorted_idx.end(), cmp);
+    } else {
+        // Children which did not move are still sorted, so the moved ones
+        // are sorted and merged in among them.
+        std::sort(moved_idx.begin(), moved_idx.end(), cmp);
+        auto kept_iter = kept_idx.begin();
+        for (t_index cidx : moved_idx) {
+            auto bound = std::lower_bound(kept_iter, kept_idx.end(), cidx, cmp);
+            sorted_idx.insert(sorted_idx.end(), kept_iter, bound);
+            sorted_idx.push_back(cidx);
+            kept_iter = bound;
+        }
+        sorted_idx.insert(sorted_idx.end(), kept_iter, kept_idx.end());
+    }
+
+    bool in_order = true;
+    for (t_index cidx = 0; cidx < nchild && in_order; ++cidx) {
+        in_order = sorted_idx[cidx] == cidx;
+    }
+
+    if (in_order)
+        return;
+
+    // Move each child's subtree as a block, in the new order.
+    t_index bidx = nidx + 1;
+    std::vector<t_index> span;
+    m_nodes.handles(bidx, bidx + m_nodes.node(m_nodes.handle_at(nidx)).m_ndesc, span);
+
+    std::vector<t_index> reordered;
+    reordered.reserve(span.size());
+
+    for (t_index cidx : sorted_idx) {
+        auto begin = span.begin() + (children[cidx].first - bidx);
+        auto end = begin + m_nodes.node(*begin).m_ndesc + 1;
+        reordered.insert(reordered.end(), begin, end);
+    }
+
+    m_nodes.reorder(bidx, reordered);
 }
 
 } // end namespace perspective
@@ -0,0 +1,157 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/traversal_nodes.h>
+#include <tsl/hopscotch_map.h>
+#include <cstdint>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief The nodes of a `t_traversal` in traversal order, held in a
+ * randomized binary search tree keyed implicitly by subtree size, so that
+ * inserting, erasing and reordering a range of nodes, and looking up a node
+ * by position or by tree index, are O(log n) rather than O(n).
+ *
+ * Nodes are addressed by position, or by a handle which is stable for as
+ * long as the node is in the traversal. Each node holds the handle of its
+ * parent rather than an offset to it, so the `m_rel_pidx` of a stored
+ * `t_tvnode` is not maintained - `get_node` calculates it.
+ */
+class PERSPECTIVE_EXPORT t_tvtree {
+public:
+    t_tvtree();
+
+    t_uindex size() const;
+
+    void clear();
+
+    /**
+     * @brief Returns the handle of the node at `pos`.
+     *
+     * @param pos
+     * @return t_index
+     */
+    t_index handle_at(t_index pos) const;
+
+    /**
+     * @brief Returns the position of the node at `handle`.
+     *
+     * @param handle
+     * @return t_index
+     */
+    t_index position(t_index handle) const;
+
+    /**
+     * @brief Returns the handle of the node for tree index `tnid`, or
+     * `INVALID_INDEX` if it is not in the traversal.
+     *
+     * @param tnid
+     * @return t_index
+     */
+    t_index find(t_index tnid) const;
+
+    t_tvnode& node(t_index handle);
+    const t_tvnode& node(t_index handle) const;
+
+    /**
+     * @brief Returns a copy of the node at `pos`, with `m_rel_pidx` set.
+     *
+     * @param pos
+     * @return t_tvnode
+     */
+    t_tvnode get_node(t_index pos) const;
+
+    /**
+     * @brief Returns the handle of the parent of `handle`, or
+     * `INVALID_INDEX` for the root.
+     *
+     * @param handle
+     * @return t_index
+     */
+    t_index parent(t_index handle) const;
+
+    /**
+     * @brief Returns the handle of the node after `handle` in traversal
+     * order, or `INVALID_INDEX` for the last node.
+     *
+     * @param handle
+     * @return t_index
+     */
+    t_index next(t_index handle) const;
+
+    /**
+     * @brief Write the handles of the nodes in [bidx, eidx) to `out`, in
+     * traversal order.
+     *
+     * @param bidx
+     * @param eidx
+     * @param out
+     */
+    void handles(t_index bidx, t_index eidx, std::vector<t_index>& out) const;
+
+    /**
+     * @brief Insert `nodes` before position `pos`, each as a child of
+     * `parent`, which is `INVALID_INDEX` only for the root.
+     *
+     * @param pos
+     * @param nodes
+     * @param parent
+     */
+    void insert(t_index pos, const std::vector<t_tvnode>& nodes, t_index parent);
+
+    /**
+     * @brief Remove the nodes in [bidx, eidx). Their handles become invalid.
+     *
+     * @param bidx
+     * @param eidx
+     */
+    void erase(t_index bidx, t_index eidx);
+
+    /**
+     * @brief Replace the order of the nodes starting at `bidx` with
+     * `handles`, which must be a permutation of the handles in
+     * [bidx, bidx + handles.size()).
+     *
+     * @param bidx
+     * @param handles
+     */
+    void reorder(t_index bidx, const std::vector<t_index>& handles);
+
+private:
+    struct t_rec {
+        t_tvnode m_node;
+        t_index m_parent;
+        t_index m_left;
+        t_index m_right;
+        t_index m_up;
+        t_index m_size;
+    };
+
+    t_index size_of(t_index handle) const;
+    void update(t_index handle);
+    t_index merge(t_index left, t_index right);
+    void split(t_index handle, t_index k, t_index& left, t_index& right);
+    t_index build(const t_index* handles, t_index n);
+    void release(t_index handle);
+    std::uint64_t random();
+
+    std::vector<t_rec> m_recs;
+    std::vector<t_index> m_free;
+    tsl::hopscotch_map<t_index, t_index> m_handles;
+    t_index m_root;
+    std::uint64_t m_seed;
+};
+
+} // end namespace perspective
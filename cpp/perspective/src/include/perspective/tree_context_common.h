@@ -13,9 +13,63 @@
 #include <perspective/config.h>
 #include <perspective/gnode_state.h>
 #include <perspective/traversal.h>
+#include <set>
 
 namespace perspective {
 
+/**
+ * @brief The changes made to a `t_stree` by a single update, which are
+ * needed to bring any `t_traversal` over that tree up to date. Computing
+ * this once lets several traversals share one tree.
+ */
+struct PERSPECTIVE_EXPORT t_sparse_tree_update {
+    struct t_leaf_path {
+        std::vector<t_tscalar> m_path;
+        t_uindex m_lfidx;
+    };
+
+    std::vector<t_uindex> m_zero_strands;
+    std::set<t_uindex> m_non_zero_ids;
+
+    // Nodes whose aggregates may have changed, and so may be out of order.
+    std::vector<t_uindex> m_updated_ids;
+
+    // Non-zero leaves, sorted by their sortby path from the root.
+    std::vector<t_leaf_path> m_leaf_paths;
+};
+
+/**
+ * @brief Apply the strands to `tree`, updating its shape and aggregates
+ * without touching any traversal.
+ */
+PERSPECTIVE_EXPORT t_sparse_tree_update update_sparse_tree_common(
+    std::shared_ptr<t_data_table> strands, std::shared_ptr<t_data_table> strand_deltas,
+    std::shared_ptr<t_stree> tree, const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const t_gstate& gstate);
+
+PERSPECTIVE_EXPORT t_sparse_tree_update update_sparse_tree(std::shared_ptr<t_stree> tree,
+    const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const t_data_table& flattened, const t_data_table& delta, const t_data_table& prev,
+    const t_data_table& current, const t_data_table& transitions, const t_data_table& existed,
+    const t_config& config, const t_gstate& gstate, const t_mask* prev_mask = nullptr,
+    const t_mask* curr_mask = nullptr);
+
+PERSPECTIVE_EXPORT t_sparse_tree_update update_sparse_tree(std::shared_ptr<t_stree> tree,
+    const std::vector<t_aggspec>& aggregates,
+    const std::vector<std::pair<std::string, std::string>>& tree_sortby,
+    const t_data_table& flattened, const t_config& config, const t_gstate& gstate,
+    const t_mask* mask = nullptr);
+
+/**
+ * @brief Bring `traversal` up to date with an update already applied to
+ * `tree` by `update_sparse_tree`.
+ */
+PERSPECTIVE_EXPORT void update_sparse_traversal(std::shared_ptr<t_stree> tree,
+    std::shared_ptr<t_traversal> traversal, bool process_traversal,
+    const t_sparse_tree_update& update, const std::vector<t_sortspec>& ctx_sortby);
+
 PERSPECTIVE_EXPORT void notify_sparse_tree_common(std::shared_ptr<t_data_table> strands,
     std::shared_ptr<t_data_table> strand_deltas, std::shared_ptr<t_stree> tree,
     std::shared_ptr<t_traversal> traversal, bool process_traversal,
@@ -30,14 +84,15 @@ PERSPECTIVE_EXPORT void notify_sparse_tree(std::shared_ptr<t_stree> tree,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
     const t_data_table& delta, const t_data_table& prev, const t_data_table& current,
     const t_data_table& transitions, const t_data_table& existed, const t_config& config,
-    const t_gstate& gstate);
+    const t_gstate& gstate, const t_mask* prev_mask = nullptr,
+    const t_mask* curr_mask = nullptr);
 
 PERSPECTIVE_EXPORT void notify_sparse_tree(std::shared_ptr<t_stree> tree,
     std::shared_ptr<t_traversal> traversal, bool process_traversal,
     const std::vector<t_aggspec>& aggregates,
     const std::vector<std::pair<std::string, std::string>>& tree_sortby,
     const std::vector<t_sortspec>& ctx_sortby, const t_data_table& flattened,
-    const t_config& config, const t_gstate& gstate);
+    const t_config& config, const t_gstate& gstate, const t_mask* mask = nullptr);
 
 template <typename CONTEXT_T>
 void
@@ -0,0 +1,61 @@
+/******************************************************************************
+ *
+ * Copyright (c) 2019, the Perspective Authors.
+ *
+ * This file is part of the Perspective library, distributed under the terms of
+ * the Apache License 2.0.  The full license can be found in the LICENSE file.
+ *
+ */
+
+#pragma once
+#include <perspective/first.h>
+#include <perspective/base.h>
+#include <perspective/exports.h>
+#include <perspective/schema.h>
+#include <perspective/data_table.h>
+#include <memory>
+#include <vector>
+
+namespace perspective {
+
+/**
+ * @brief The number of tables kept for each slot of a `t_update_arena`, so
+ * that the table of the previous update can still be held (e.g. by an output
+ * port) while the one before it is reused.
+ */
+const t_uindex PSP_UPDATE_ARENA_TABLES_PER_SLOT = 2;
+
+/**
+ * @brief Recycles the tables that only live for the length of an update, so
+ * that steady-state updates reuse the storage of earlier ones instead of
+ * allocating new tables.
+ *
+ * Each slot names one kind of transient table. A table is only handed out
+ * again once nothing but the arena refers to it, after being cleared with
+ * its storage kept - tables from an arena must not lend their vocabularies
+ * to other columns.
+ */
+class PERSPECTIVE_EXPORT t_update_arena {
+public:
+    t_update_arena();
+
+    /**
+     * @brief An empty table with `schema` for `slot`, reusing one of the
+     * slot's earlier tables if it is no longer referenced elsewhere.
+     *
+     * @param slot
+     * @param schema
+     * @return std::shared_ptr<t_data_table>
+     */
+    std::shared_ptr<t_data_table> get_table(t_uindex slot, const t_schema& schema);
+
+    /**
+     * @brief Release every table held by the arena.
+     */
+    void clear();
+
+private:
+    std::vector<std::vector<std::shared_ptr<t_data_table>>> m_slots;
+};
+
+} // end namespace perspective
@@ -212,6 +212,14 @@ public:
      */
     std::shared_ptr<t_data_slice<CTX_T>> get_row_delta() const;
 
+    /**
+     * @brief Returns the timing counters recorded when this view's context
+     * was notified of updates.
+     *
+     * @return std::map<std::string, std::map<std::string, double>>
+     */
+    std::map<std::string, std::map<std::string, double>> get_stats() const;
+
     // Getters
     std::shared_ptr<CTX_T> get_context() const;
     std::vector<std::string> get_row_pivots() const;
@@ -72,6 +72,15 @@ public:
     void set_row_pivot_depth(std::int32_t depth);
     void set_column_pivot_depth(std::int32_t depth);
 
+    /**
+     * @brief Set whether a one-sided view defers the aggregates it computes
+     * from each row's pkeys, such as mean or median, on rows hidden under a
+     * collapsed row until they are shown.
+     *
+     * @param lazy_aggregates
+     */
+    void set_lazy_aggregates(bool lazy_aggregates);
+
     std::vector<std::string> get_row_pivots() const;
 
     std::vector<std::string> get_column_pivots() const;
@@ -95,6 +104,8 @@ public:
     std::int32_t get_row_pivot_depth() const;
     std::int32_t get_column_pivot_depth() const;
 
+    bool get_lazy_aggregates() const;
+
 private:
     bool m_init;
 
@@ -181,6 +192,12 @@ private:
     std::int32_t m_row_pivot_depth;
     std::int32_t m_column_pivot_depth;
 
+    /**
+     * @brief Whether hidden rows of a one-sided view defer their pkey-derived
+     * aggregates. Defaults to false.
+     */
+    bool m_lazy_aggregates;
+
     /**
      * @brief the `t_filter_op` used to return data in the case of multiple filters being applied.
      *
@@ -17,14 +17,69 @@
 #include <functional>
 #include <limits>
 #include <cmath>
+#include <vector>
 #include <tsl/hopscotch_map.h>
 
 namespace perspective {
 
-class PERSPECTIVE_EXPORT t_vocab {
-    typedef tsl::hopscotch_map<const char*, t_uindex, t_cchar_umap_hash, t_cchar_umap_cmp>
-        t_sidxmap;
+/**
+ * @brief A string to intern in bulk - `m_hash` must come from
+ * `t_vocab::hash_string(m_data, m_size)`.
+ */
+struct PERSPECTIVE_EXPORT t_vocab_string {
+    const char* m_data;
+    t_uindex m_size;
+    std::size_t m_hash;
+};
+
+const t_uindex PSP_VOCAB_ABSENT = std::numeric_limits<t_uindex>::max();
+const t_uindex PSP_VOCAB_BULK_CHUNK_SIZE = 1 << 16;
+
+/**
+ * @brief An open-addressed table of string ids, which stores each id's hash
+ * beside it, so that probing and growing compare hashes and never touch the
+ * strings themselves until the hashes match.
+ */
+class PERSPECTIVE_EXPORT t_vocab_index {
+public:
+    t_vocab_index();
+
+    /**
+     * @brief Find the id with hash `hash` for which `is_match(id)` holds.
+     *
+     * @tparam MATCH_T
+     * @param hash
+     * @param is_match
+     * @return t_uindex the id, or `PSP_VOCAB_ABSENT`
+     */
+    template <typename MATCH_T>
+    t_uindex find(std::size_t hash, MATCH_T is_match) const;
+
+    /**
+     * @brief Add `id`, which must not already be in the index.
+     *
+     * @param hash
+     * @param id
+     */
+    void insert(std::size_t hash, t_uindex id);
+
+    void reserve(t_uindex size);
+    void clear();
+    t_uindex size() const;
+
+private:
+    struct t_slot {
+        std::size_t m_hash;
+        t_uindex m_id;
+    };
 
+    void rehash(t_uindex capacity);
+
+    std::vector<t_slot> m_slots;
+    t_uindex m_size;
+};
+
+class PERSPECTIVE_EXPORT t_vocab {
 public:
     t_vocab();
     t_vocab(const t_column_recipe& r);
@@ -46,6 +101,36 @@ public:
 
     t_uindex get_interned(const std::string& s);
     t_uindex get_interned(const char* s);
+
+    /**
+     * @brief Intern the `size` bytes at `s`, whose hash is already known.
+     *
+     * @param s
+     * @param size
+     * @param hash from `hash_string(s, size)`
+     * @return t_uindex
+     */
+    t_uindex get_interned(const char* s, t_uindex size, std::size_t hash);
+
+    /**
+     * @brief Intern `strings`, writing the id of each into `ids`. Ids are
+     * given out in the order strings first appear, exactly as if each were
+     * interned in turn - large batches are deduplicated in parallel chunks
+     * and only each chunk's distinct strings are interned.
+     *
+     * @param strings
+     * @param ids
+     */
+    void get_interned_bulk(const std::vector<t_vocab_string>& strings, t_uindex* ids);
+
+    /**
+     * @brief The hash `t_vocab` uses for the `size` bytes at `s`.
+     *
+     * @param s
+     * @param size
+     * @return std::size_t
+     */
+    static std::size_t hash_string(const char* s, t_uindex size);
     void copy_vocabulary(const t_vocab& other);
     const char* unintern_c(t_uindex idx) const;
 
@@ -53,20 +138,27 @@ public:
 
     void reserve(size_t total_string_size, size_t string_count);
 
+    /**
+     * @brief Forget every interned string, keeping the storage.
+     */
+    void clear();
+
 protected:
     // vlen interface
     t_uindex genidx();
 
+    bool is_interned_as(t_uindex idx, const char* s, t_uindex size) const;
+
 private:
     // Max string id currently in use
     t_uindex m_vlenidx;
     // varlen
 
-    // Maps a char* to its encoded id
-    // Does not own the char* stored in
-    // it. value is a t_uindex that maps
-    // into m_extents
-    t_sidxmap m_map;
+    // Finds a string's id by its hash,
+    // comparing candidates against their
+    // bytes in m_vlendata, so it is not
+    // invalidated when m_vlendata moves
+    t_vocab_index m_index;
 
     // Stores the vlen as is. for string
     // the trailing zero byte is stored
@@ -82,4 +174,21 @@ private:
     std::shared_ptr<t_lstore> m_extents;
 };
 
+template <typename MATCH_T>
+t_uindex
+t_vocab_index::find(std::size_t hash, MATCH_T is_match) const {
+    if (m_slots.empty())
+        return PSP_VOCAB_ABSENT;
+
+    t_uindex mask = m_slots.size() - 1;
+    for (t_uindex slot = hash & mask;; slot = (slot + 1) & mask) {
+        const t_slot& candidate = m_slots[slot];
+        if (candidate.m_id == PSP_VOCAB_ABSENT)
+            return PSP_VOCAB_ABSENT;
+
+        if (candidate.m_hash == hash && is_match(candidate.m_id))
+            return candidate.m_id;
+    }
+}
+
 } // end namespace perspective
@@ -28,6 +28,10 @@ declare module "@finos/perspective" {
 
     enum NUMBER_AGGREGATES {
         ANY = "any",
+        APPROX_DISTINCT_COUNT = "approx distinct count",
+        APPROX_MEDIAN = "approx median",
+        APPROX_P95 = "approx p95",
+        APPROX_P99 = "approx p99",
         AVERAGE = "avg",
         COUNT = "count",
         DISTINCT_COUNT = "distinct count",
@@ -48,6 +52,7 @@ declare module "@finos/perspective" {
 
     enum STRING_AGGREGATES {
         ANY = "any",
+        APPROX_DISTINCT_COUNT = "approx distinct count",
         COUNT = "count",
         DISTINCT_COUNT = "distinct count",
         DISTINCT_LEAF = "distinct leaf",
@@ -60,6 +65,7 @@ declare module "@finos/perspective" {
     enum BOOLEAN_AGGREGATES {
         AND = "and",
         ANY = "any",
+        APPROX_DISTINCT_COUNT = "approx distinct count",
         COUNT = "count",
         DISTINCT_COUNT = "distinct count",
         DISTINCT_LEAF = "distinct leaf",
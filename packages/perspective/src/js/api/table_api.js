@@ -99,6 +99,14 @@ table.prototype.is_valid_filter = async_queue("is_valid_filter", "table_method")
 
 table.prototype.size = async_queue("size", "table_method");
 
+table.prototype.get_stats = async_queue("get_stats", "table_method");
+
+table.prototype.reset_stats = async_queue("reset_stats", "table_method");
+
+table.prototype.set_trace_enabled = async_queue("set_trace_enabled", "table_method");
+
+table.prototype.get_trace = async_queue("get_trace", "table_method");
+
 table.prototype.columns = async_queue("columns", "table_method");
 
 table.prototype.clear = async_queue("clear", "table_method");
@@ -20,10 +20,14 @@ export const CONFIG_ALIASES = {
     sorts: "sort"
 };
 
-export const CONFIG_VALID_KEYS = ["viewport", "row_pivots", "column_pivots", "aggregates", "columns", "filter", "sort", "computed_columns", "row_pivot_depth", "filter_op"];
+export const CONFIG_VALID_KEYS = ["viewport", "row_pivots", "column_pivots", "aggregates", "columns", "filter", "sort", "computed_columns", "row_pivot_depth", "filter_op", "lazy_aggregates"];
 
 const NUMBER_AGGREGATES = [
     "any",
+    "approx distinct count",
+    "approx median",
+    "approx p95",
+    "approx p99",
     "avg",
     "count",
     "distinct count",
@@ -43,9 +47,9 @@ const NUMBER_AGGREGATES = [
     "unique"
 ];
 
-const STRING_AGGREGATES = ["any", "count", "distinct count", "distinct leaf", "dominant", "first by index", "last by index", "last", "unique"];
+const STRING_AGGREGATES = ["any", "approx distinct count", "count", "distinct count", "distinct leaf", "dominant", "first by index", "last by index", "last", "unique"];
 
-const BOOLEAN_AGGREGATES = ["any", "count", "distinct count", "distinct leaf", "dominant", "first by index", "last by index", "last", "unique", "and", "or"];
+const BOOLEAN_AGGREGATES = ["any", "approx distinct count", "count", "distinct count", "distinct leaf", "dominant", "first by index", "last by index", "last", "unique", "and", "or"];
 
 export const SORT_ORDERS = ["none", "asc", "desc", "col asc", "col desc", "asc abs", "desc abs", "col asc abs", "col desc abs"];
 
@@ -35,6 +35,24 @@ export const extract_map = function(map) {
     return extracted;
 };
 
+/**
+ * Extract a C++ map of maps, e.g. `std::map<std::string, std::map<...>>`,
+ * into a nested Javascript object.
+ *
+ * @param {*} map the `std::map` to be extracted
+ *
+ * @private
+ */
+export const extract_nested_map = function(map) {
+    const extracted = extract_map(map);
+    for (const key in extracted) {
+        if (extracted.hasOwnProperty(key)) {
+            extracted[key] = extract_map(extracted[key]);
+        }
+    }
+    return extracted;
+};
+
 /**
  * Given a C++ vector constructed in Emscripten, fill it with data. Assume that
  * data types are already validated, thus Emscripten will throw an error if the
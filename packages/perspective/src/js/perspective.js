@@ -11,12 +11,11 @@ import * as defaults from "./config/constants.js";
 import {get_type_config} from "./config/index.js";
 import {DataAccessor} from "./data_accessor";
 import {DateParser} from "./data_accessor/date_parser.js";
-import {extract_vector, extract_map, fill_vector} from "./emscripten.js";
+import {extract_vector, extract_map, extract_nested_map, fill_vector} from "./emscripten.js";
 import {bindall, get_column_type} from "./utils.js";
 import {Server} from "./api/server.js";
 
 import formatters from "./view_formatters";
-import papaparse from "papaparse";
 
 // IE fix - chrono::steady_clock depends on performance.now() which does not
 // exist in IE workers
@@ -85,14 +84,16 @@ export default function(Module) {
      * @param {boolean} is_update - true if we are updating an already-created
      * table
      * @param {boolean} is_arrow - true if the dataset is in the Arrow format
+     * @param {boolean} is_csv - true if the dataset is a CSV string, which is
+     * parsed in C++
      * @param {Number} port_id - an integer indicating the internal `t_port`
      * which should receive this update.
      *
      * @private
      * @returns {Table} An `std::shared_ptr<Table>` to a `Table` inside C++.
      */
-    function make_table(accessor, _Table, index, limit, op, is_update, is_arrow, port_id) {
-        _Table = __MODULE__.make_table(_Table, accessor, limit || 4294967295, index, op, is_update, is_arrow, port_id);
+    function make_table(accessor, _Table, index, limit, op, is_update, is_arrow, is_csv, port_id) {
+        _Table = __MODULE__.make_table(_Table, accessor, limit || 4294967295, index, op, is_update, is_arrow, is_csv, port_id);
 
         const pool = _Table.get_pool();
         const table_id = _Table.get_id();
@@ -678,6 +679,20 @@ export default function(Module) {
         return ncols - (ncols / (this.config.columns.length + nhidden)) * nhidden;
     };
 
+    /**
+     * Timing counters recorded when this {@link module:perspective~view} was
+     * notified of updates, keyed by stage (e.g. "notify", "step_end"). Each
+     * stage contains `count`, `rows`, `total_ns`, `mean_ns`, `max_ns`,
+     * `p50_ns` and `p99_ns`.
+     *
+     * @async
+     *
+     * @returns {Promise<Object>} The counters for each recorded stage.
+     */
+    view.prototype.get_stats = function() {
+        return extract_nested_map(this._View.get_stats());
+    };
+
     /**
      * Whether this row at index `idx` is in an expanded or collapsed state.
      *
@@ -903,6 +918,7 @@ export default function(Module) {
         this.filter_op = config.filter_op || "and";
         this.row_pivot_depth = config.row_pivot_depth;
         this.column_pivot_depth = config.column_pivot_depth;
+        this.lazy_aggregates = config.lazy_aggregates;
     }
 
     /**
@@ -1082,6 +1098,57 @@ export default function(Module) {
         console.assert(initial_length > this._delete_callbacks.length, `"callback" does not match a registered delete callbacks`);
     };
 
+    /**
+     * Timing counters for each stage of an update on this
+     * {@link module:perspective~table} (e.g. "flatten", "lookup",
+     * "process_columns"), followed by those of every view on it, keyed by
+     * "<view name>.<stage>". Each stage contains `count`, `rows`, `total_ns`,
+     * `mean_ns`, `max_ns`, `p50_ns` and `p99_ns`.
+     *
+     * @async
+     *
+     * @returns {Promise<Object>} The counters for each recorded stage.
+     */
+    table.prototype.get_stats = function() {
+        _call_process(this._Table.get_id());
+        return extract_nested_map(this._Table.get_stats());
+    };
+
+    /**
+     * Reset the counters and trace events returned by `get_stats()` and
+     * `get_trace()`. Other tables are not affected.
+     *
+     * @async
+     */
+    table.prototype.reset_stats = function() {
+        this._Table.reset_stats();
+    };
+
+    /**
+     * Start or stop recording a trace event for every timed stage of an
+     * update, which can be retrieved with `get_trace()`.
+     *
+     * @async
+     *
+     * @param {boolean} enabled
+     */
+    table.prototype.set_trace_enabled = function(enabled) {
+        this._Table.set_trace_enabled(enabled);
+    };
+
+    /**
+     * The trace events recorded since `set_trace_enabled(true)`, in the Chrome
+     * trace-event format which can be loaded into `chrome://tracing`.
+     *
+     * @async
+     *
+     * @returns {Promise<Object>} An object with a `traceEvents` array.
+     */
+    table.prototype.get_trace = function() {
+        _call_process(this._Table.get_id());
+        return JSON.parse(this._Table.get_trace_json());
+    };
+
     /**
      * The number of accumulated rows in this {@link module:perspective~table}.
      * This is affected by the "index" configuration parameter supplied to this
@@ -1257,6 +1324,10 @@ export default function(Module) {
      * apply. A sort configuration is an array of 2 elements: A column name, and
      * a sort direction, which are: "none", "asc", "desc", "col asc", "col
      * desc", "asc abs", "desc abs", "col asc abs", "col desc abs".
+     * @param {boolean} [config.lazy_aggregates=false] If true, a view with
+     * `row_pivots` and no `column_pivots` only computes the aggregates which
+     * read every underlying row, such as "mean" or "median", for the rows it
+     * shows, and computes the rest as they are expanded.
      *
      * @example
      * var view = table.view({
@@ -1378,6 +1449,7 @@ export default function(Module) {
         let schema = this._Table.get_schema();
         let types = schema.types();
         let is_arrow = false;
+        let is_csv = false;
 
         pdata = accessor;
 
@@ -1385,16 +1457,8 @@ export default function(Module) {
             pdata = new Uint8Array(data);
             is_arrow = true;
         } else if (typeof data === "string") {
-            if (data[0] === ",") {
-                data = "_" + data;
-            }
-            accessor.init(papaparse.parse(data.trim(), {header: true}).data);
-            accessor.names = cols.concat(accessor.names.filter(x => x === "__INDEX__"));
-            accessor.types = extract_vector(types).slice(0, accessor.names.length);
-
-            if (meter) {
-                meter(accessor.row_count);
-            }
+            pdata = data;
+            is_csv = true;
         } else {
             accessor.init(data);
             accessor.names = cols.concat(accessor.names.filter(x => x === "__INDEX__"));
@@ -1405,7 +1469,7 @@ export default function(Module) {
             }
         }
 
-        if (!is_arrow) {
+        if (!is_arrow && !is_csv) {
             if (pdata.row_count === 0) {
                 console.warn("table.update called with no data - ignoring");
                 return;
@@ -1429,7 +1493,7 @@ export default function(Module) {
             const op = __MODULE__.t_op.OP_INSERT;
             // update the Table in C++, but don't keep the returned Table
             // reference as it is identical
-            make_table(pdata, this._Table, this.index || "", this.limit, op, true, is_arrow, options.port_id);
+            make_table(pdata, this._Table, this.index || "", this.limit, op, true, is_arrow, is_csv, options.port_id);
             this.initialized = true;
         } catch (e) {
             console.error(`Update failed: ${e}`);
@@ -1471,7 +1535,7 @@ export default function(Module) {
             const op = __MODULE__.t_op.OP_DELETE;
             // update the Table in C++, but don't keep the returned Table
             // reference as it is identical
-            make_table(pdata, this._Table, this.index || "", this.limit, op, false, is_arrow, options.port_id);
+            make_table(pdata, this._Table, this.index || "", this.limit, op, false, is_arrow, false, options.port_id);
             this.initialized = true;
         } catch (e) {
             console.error(`Remove failed`, e);
@@ -1592,19 +1656,16 @@ export default function(Module) {
 
             let data_accessor;
             let is_arrow = false;
+            let is_csv = false;
             let overridden_types = {};
 
             if (data instanceof ArrayBuffer || (typeof Buffer !== "undefined" && data instanceof Buffer)) {
                 data_accessor = new Uint8Array(data);
                 is_arrow = true;
+            } else if (typeof data === "string") {
+                data_accessor = data;
+                is_csv = true;
             } else {
-                if (typeof data === "string") {
-                    if (data[0] === ",") {
-                        data = "_" + data;
-                    }
-                    data = papaparse.parse(data.trim(), {dynamicTyping: true, header: true}).data;
-                }
-
                 accessor.clean();
                 overridden_types = accessor.init(data);
                 data_accessor = accessor;
@@ -1619,7 +1680,7 @@ export default function(Module) {
             try {
                 const op = __MODULE__.t_op.OP_INSERT;
                 // Always create new tables using port 0
-                _Table = make_table(data_accessor, undefined, options.index, options.limit, op, false, is_arrow, 0);
+                _Table = make_table(data_accessor, undefined, options.index, options.limit, op, false, is_arrow, is_csv, 0);
                 return new table(_Table, options.index, undefined, options.limit, overridden_types);
             } catch (e) {
                 if (_Table) {
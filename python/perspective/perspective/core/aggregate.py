@@ -18,6 +18,10 @@ class Aggregate(Enum):
     '''
     AND = 'and'
     ANY = 'any'
+    APPROX_DISTINCT_COUNT = 'approx distinct count'
+    APPROX_MEDIAN = 'approx median'
+    APPROX_P95 = 'approx p95'
+    APPROX_P99 = 'approx p99'
     AVG = 'avg'
     COUNT = 'count'
     DISTINCT_COUNT = 'distinct count'
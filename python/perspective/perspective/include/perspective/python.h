@@ -79,6 +79,10 @@ PYBIND11_MODULE(libbinding, m)
         .def("remove_port", &Table::remove_port)
         .def("get_id", &Table::get_id)
         .def("get_pool", &Table::get_pool)
+        .def("get_stats", &Table::get_stats)
+        .def("reset_stats", &Table::reset_stats)
+        .def("set_trace_enabled", &Table::set_trace_enabled)
+        .def("get_trace_json", &Table::get_trace_json)
         .def("get_gnode", &Table::get_gnode);
 
     /******************************************************************************
@@ -108,7 +112,8 @@ PYBIND11_MODULE(libbinding, m)
         .def("get_sort", &View<t_ctx0>::get_sort)
         .def("get_step_delta", &View<t_ctx0>::get_step_delta)
         .def("get_column_dtype", &View<t_ctx0>::get_column_dtype)
-        .def("is_column_only", &View<t_ctx0>::is_column_only);
+        .def("is_column_only", &View<t_ctx0>::is_column_only)
+        .def("get_stats", &View<t_ctx0>::get_stats);
 
     py::class_<View<t_ctx1>, std::shared_ptr<View<t_ctx1>>>(m, "View_ctx1")
         .def(py::init<std::shared_ptr<Table>, std::shared_ptr<t_ctx1>, std::string, std::string,
@@ -134,7 +139,8 @@ PYBIND11_MODULE(libbinding, m)
         .def("get_sort", &View<t_ctx1>::get_sort)
         .def("get_step_delta", &View<t_ctx1>::get_step_delta)
         .def("get_column_dtype", &View<t_ctx1>::get_column_dtype)
-        .def("is_column_only", &View<t_ctx1>::is_column_only);
+        .def("is_column_only", &View<t_ctx1>::is_column_only)
+        .def("get_stats", &View<t_ctx1>::get_stats);
 
     py::class_<View<t_ctx2>, std::shared_ptr<View<t_ctx2>>>(m, "View_ctx2")
         .def(py::init<std::shared_ptr<Table>, std::shared_ptr<t_ctx2>, std::string, std::string,
@@ -161,7 +167,8 @@ PYBIND11_MODULE(libbinding, m)
         .def("get_row_path", &View<t_ctx2>::get_row_path)
         .def("get_step_delta", &View<t_ctx2>::get_step_delta)
         .def("get_column_dtype", &View<t_ctx2>::get_column_dtype)
-        .def("is_column_only", &View<t_ctx2>::is_column_only);
+        .def("is_column_only", &View<t_ctx2>::is_column_only)
+        .def("get_stats", &View<t_ctx2>::get_stats);
 
     /******************************************************************************
      *
@@ -255,7 +262,11 @@ PYBIND11_MODULE(libbinding, m)
         .def(py::init<>())
         .def("set_update_delegate", &t_pool::set_update_delegate)
         .def("unregister_gnode", &t_pool::unregister_gnode)
-        .def("_process", &t_pool::_process);
+        .def("_process", &t_pool::_process)
+        .def("get_stats", &t_pool::get_stats)
+        .def("reset_stats", &t_pool::reset_stats)
+        .def("set_trace_enabled", &t_pool::set_trace_enabled)
+        .def("get_trace_json", &t_pool::get_trace_json);
 
     /******************************************************************************
      *
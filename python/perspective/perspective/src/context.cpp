@@ -61,6 +61,7 @@ make_context(std::shared_ptr<Table> table, std::shared_ptr<t_schema> schema,
 
     ctx1->init();
     ctx1->sort_by(sortspec);
+    ctx1->set_lazy_aggregates_enabled(view_config->get_lazy_aggregates());
 
     auto pool = table->get_pool();
     auto gnode = table->get_gnode();
@@ -10,6 +10,7 @@
 
 #include <perspective/base.h>
 #include <perspective/binding.h>
+#include <perspective/date_parser.h>
 #include <perspective/python/base.h>
 #include <perspective/python/fill.h>
 #include <perspective/python/utils.h>
@@ -22,16 +23,81 @@ namespace binding {
  * Fill columns with data
  */
 
+/**
+ * @brief If the first value of a column is a string in a format that
+ * `t_date_parser` reads the same way as `dateutil`, detect that format into
+ * `parser`. Day-first dates and two-digit years are left to `dateutil`.
+ *
+ * @param accessor
+ * @param name
+ * @param nrows
+ * @param parser
+ * @return true if strings in this column should be parsed by `parser`
+ * @return false
+ */
+bool
+_detect_date_format(t_data_accessor accessor, const std::string& name, t_uindex nrows,
+    t_date_parser& parser) {
+    for (auto i = 0; i < nrows; ++i) {
+        if (!accessor.attr("_has_column")(i, name).cast<bool>()) {
+            continue;
+        }
+
+        t_val value = accessor.attr("get")(name, i);
+        if (value.is_none()) {
+            continue;
+        }
+
+        if (!py::isinstance<py::str>(value)) {
+            return false;
+        }
+
+        t_date_format format = parser.detect_format({value.cast<std::string>()});
+        return format == DATE_FORMAT_ISO || format == DATE_FORMAT_ISO_BASIC
+            || format == DATE_FORMAT_RFC822;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Parse `value` with `parser` if it is a string, without calling back
+ * into `dateutil`.
+ *
+ * @param value
+ * @param parser
+ * @param parsed
+ * @return true
+ * @return false if `value` should be marshaled instead
+ */
+bool
+_parse_date(t_val value, const t_date_parser& parser, t_parsed_date& parsed) {
+    if (!py::isinstance<py::str>(value)) {
+        return false;
+    }
+
+    std::string datestring = value.cast<std::string>();
+    return parser.parse(datestring.c_str(), datestring.size(), parsed);
+}
+
 void
 _fill_col_time(t_data_accessor accessor, std::shared_ptr<t_column> col, std::string name,
     std::int32_t cidx, t_dtype type, bool is_update) {
     t_uindex nrows = col->size();
+    t_date_parser parser;
+    bool parse_strings = _detect_date_format(accessor, name, nrows, parser);
 
     for (auto i = 0; i < nrows; ++i) {
         if (!accessor.attr("_has_column")(i, name).cast<bool>()) {
             continue;
         }
 
+        t_parsed_date parsed;
+        if (parse_strings && _parse_date(accessor.attr("get")(name, i), parser, parsed)) {
+            col->set_nth(i, t_date_parser::to_timestamp(parsed));
+            continue;
+        }
+
         t_val item = accessor.attr("marshal")(cidx, i, type);
 
         if (item.is_none()) {
@@ -51,12 +117,20 @@ void
 _fill_col_date(t_data_accessor accessor, std::shared_ptr<t_column> col, std::string name,
     std::int32_t cidx, t_dtype type, bool is_update) {
     t_uindex nrows = col->size();
+    t_date_parser parser;
+    bool parse_strings = _detect_date_format(accessor, name, nrows, parser);
 
     for (auto i = 0; i < nrows; ++i) {
         if (!accessor.attr("_has_column")(i, name).cast<bool>()) {
             continue;
         }
 
+        t_parsed_date parsed;
+        if (parse_strings && _parse_date(accessor.attr("get")(name, i), parser, parsed)) {
+            col->set_nth(i, t_date_parser::to_date(parsed));
+            continue;
+        }
+
         t_val item = accessor.attr("marshal")(cidx, i, type);
 
         if (item.is_none()) {
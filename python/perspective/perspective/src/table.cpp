@@ -11,6 +11,7 @@
 #include <perspective/arrow_loader.h>
 #include <perspective/base.h>
 #include <perspective/binding.h>
+#include <perspective/csv_loader.h>
 #include <perspective/python/accessor.h>
 #include <perspective/python/base.h>
 #include <perspective/python/fill.h>
@@ -27,7 +28,7 @@ namespace binding {
  */
 
 std::shared_ptr<Table> make_table_py(t_val table, t_data_accessor accessor,
-        std::uint32_t limit, py::str index, t_op op, bool is_update, bool is_arrow, t_uindex port_id) {
+        std::uint32_t limit, py::str index, t_op op, bool is_update, bool is_arrow, bool is_csv, t_uindex port_id) {
     bool table_initialized = !table.is_none();
     std::shared_ptr<t_pool> pool;
     std::shared_ptr<Table> tbl;
@@ -46,10 +47,11 @@ std::shared_ptr<Table> make_table_py(t_val table, t_data_accessor accessor,
     std::vector<std::string> column_names;
     std::vector<t_dtype> data_types;
     arrow::ArrowLoader arrow_loader;
+    csv::CsvLoader csv_loader;
     numpy::NumpyLoader numpy_loader(accessor);
 
-    // don't call `is_numpy` on an arrow binary
-    bool is_numpy = !is_arrow && accessor.attr("_is_numpy").cast<bool>();
+    // don't call `is_numpy` on an arrow binary or a CSV string
+    bool is_numpy = !is_arrow && !is_csv && accessor.attr("_is_numpy").cast<bool>();
 
     // Determine metadata
     bool is_delete = op == OP_DELETE;
@@ -104,6 +106,19 @@ std::shared_ptr<Table> make_table_py(t_val table, t_data_accessor accessor,
             column_names = arrow_loader.names();
             data_types = arrow_loader.types();
         }
+    } else if (is_csv && !is_delete) {
+        csv_loader.initialize(accessor.cast<std::string>());
+
+        // Always use the `Table` column names and data types on update,
+        // parsing the CSV again into any that differ.
+        if (table_initialized && is_update) {
+            auto schema = gnode->get_output_schema().drop({"psp_okey"});
+            column_names = schema.columns();
+            data_types = schema.types();
+        } else {
+            column_names = csv_loader.names();
+            data_types = csv_loader.types();
+        }
     } else if (is_update || is_delete) {
         /**
          * Use the names and types of the python accessor when updating/deleting.
@@ -177,6 +192,10 @@ std::shared_ptr<Table> make_table_py(t_val table, t_data_accessor accessor,
         data_table.extend(arrow_loader.row_count());
 
         arrow_loader.fill_table(data_table, index, offset, limit, is_update);
+    } else if (is_csv) {
+        row_count = csv_loader.row_count();
+        data_table.extend(row_count);
+        csv_loader.fill_table(data_table, index, offset, limit, is_update);
     } else if (is_numpy) {
         row_count = numpy_loader.row_count();
         data_table.extend(row_count);
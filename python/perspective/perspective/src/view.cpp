@@ -239,6 +239,8 @@ make_view_config(std::shared_ptr<t_schema> schema, t_val date_parser, t_val conf
         view_config->set_column_pivot_depth(config.attr("column_pivot_depth").cast<std::int32_t>());
     }
 
+    view_config->set_lazy_aggregates(config.attr("lazy_aggregates").cast<bool>());
+
     return view_config;
 }
 
@@ -6,6 +6,7 @@
 # the Apache License 2.0.  The full license can be found in the LICENSE file.
 #
 
+import json
 from datetime import date, datetime
 from .view import View
 from ._accessor import _PerspectiveAccessor
@@ -30,7 +31,7 @@ class Table(object):
         conform to the column names and data types provided in the schema.
 
         Args:
-            data (:obj:`dict`/:obj:`list`/:obj:`pandas.DataFrame`): Data or
+            data (:obj:`dict`/:obj:`list`/:obj:`pandas.DataFrame`/:obj:`str`): Data or
                 schema which initializes the :class:`~perspective.Table`.
 
         Keyword Args:
@@ -42,7 +43,8 @@ class Table(object):
                 writing at row 0.
         '''
         self._is_arrow = isinstance(data, (bytes, bytearray))
-        if (self._is_arrow):
+        self._is_csv = isinstance(data, str)
+        if (self._is_arrow or self._is_csv):
             _accessor = data
         else:
             _accessor = _PerspectiveAccessor(data)
@@ -55,7 +57,7 @@ class Table(object):
         # Always create tables on port 0
         self._table = make_table(None, _accessor, self._limit,
                                  self._index, t_op.OP_INSERT, False,
-                                 self._is_arrow, 0)
+                                 self._is_arrow, self._is_csv, 0)
 
         self._gnode_id = self._table.get_gnode().get_id()
         self._callbacks = _PerspectiveCallBackCache()
@@ -129,6 +131,46 @@ class Table(object):
         self._state_manager.call_process(self._table.get_id())
         return self._table.size()
 
+    def get_stats(self):
+        '''Returns timing counters for each stage of an update on this
+        :class:`~perspective.Table`, i.e. ``flatten``, ``lookup``,
+        ``process_columns``, followed by those of every
+        :class:`~perspective.View` on it, keyed by ``<view name>.<stage>``.
+
+        Returns:
+            :obj:`dict`: a mapping of stage name to a :obj:`dict` of
+                ``count``, ``rows``, ``total_ns``, ``mean_ns``, ``max_ns``,
+                ``p50_ns`` and ``p99_ns``.
+        '''
+        self._state_manager.call_process(self._table.get_id())
+        return self._table.get_stats()
+
+    def reset_stats(self):
+        '''Reset the counters and trace events returned by
+        :func:`get_stats` and :func:`get_trace`. Other tables are not
+        affected.'''
+        self._table.reset_stats()
+
+    def set_trace_enabled(self, enabled):
+        '''Start or stop recording a trace event for every timed stage of an
+        update, which can be retrieved with :func:`get_trace`.
+
+        Args:
+            enabled (:obj:`bool`)
+        '''
+        self._table.set_trace_enabled(enabled)
+
+    def get_trace(self):
+        '''Returns the trace events recorded since tracing was enabled, in
+        the Chrome trace-event format which can be loaded into
+        ``chrome://tracing``.
+
+        Returns:
+            :obj:`dict`: a dictionary with a ``traceEvents`` list.
+        '''
+        self._state_manager.call_process(self._table.get_id())
+        return json.loads(self._table.get_trace_json())
+
     def schema(self, as_string=False):
         '''Returns the schema of this :class:`~perspective.Table`, a :obj:`dict`
         mapping of string column names to python data types.
@@ -265,7 +307,7 @@ class Table(object):
         append.
 
         Args:
-            data (:obj:`dict`/:obj:`list`/:obj:`pandas.DataFrame`): The data
+            data (:obj:`dict`/:obj:`list`/:obj:`pandas.DataFrame`/:obj:`str`): The data
                 with which to update the :class:`~perspective.Table`.
 
         Examples:
@@ -278,10 +320,11 @@ class Table(object):
             port_id = 0
 
         _is_arrow = isinstance(data, (bytes, bytearray))
+        _is_csv = isinstance(data, str)
 
-        if (_is_arrow):
+        if (_is_arrow or _is_csv):
             _accessor = data
-            self._table = make_table(self._table, _accessor, self._limit, self._index, t_op.OP_INSERT, True, True, port_id)
+            self._table = make_table(self._table, _accessor, self._limit, self._index, t_op.OP_INSERT, True, _is_arrow, _is_csv, port_id)
             self._state_manager.set_process(
                 self._table.get_pool(), self._table.get_id())
             return
@@ -308,7 +351,8 @@ class Table(object):
                 _accessor._types.append(t_dtype.DTYPE_INT32)
 
         self._table = make_table(self._table, _accessor, self._limit,
-                                 self._index, t_op.OP_INSERT, True, False, port_id)
+                                 self._index, t_op.OP_INSERT, True, False,
+                                 False, port_id)
         self._state_manager.set_process(
             self._table.get_pool(), self._table.get_id())
 
@@ -336,11 +380,13 @@ class Table(object):
         _accessor._names = [self._index]
         _accessor._types = types
         t = make_table(self._table, _accessor,  self._limit,
-                       self._index, t_op.OP_DELETE, True, False, port_id)
+                       self._index, t_op.OP_DELETE, True, False, False,
+                       port_id)
         self._state_manager.set_process(t.get_pool(), t.get_id())
 
     def view(self, columns=None, row_pivots=None, column_pivots=None,
-             aggregates=None, sort=None, filter=None, computed_columns=None):
+             aggregates=None, sort=None, filter=None, computed_columns=None,
+             lazy_aggregates=None):
         ''' Create a new :class:`~perspective.View` from this
         :class:`~perspective.Table` via the supplied keyword arguments.
 
@@ -365,6 +411,10 @@ class Table(object):
             filter (:obj:`list` of :obj:`list` of :obj:`str`):  A list of lists,
                 each list containing a column name, a filter comparator, and a
                 value to filter by.
+            lazy_aggregates (:obj:`bool`): If True, a view with ``row_pivots``
+                and no ``column_pivots`` only computes aggregates that read
+                every underlying row, such as ``mean`` or ``median``, for the
+                rows it shows - the rest are computed when they are expanded.
 
         Returns:
             :class:`~perspective.View`: A new :class:`~perspective.View`
@@ -399,6 +449,8 @@ class Table(object):
             config["filter"] = filter
         if computed_columns is not None:
             config["computed_columns"] = computed_columns
+        if lazy_aggregates is not None:
+            config["lazy_aggregates"] = lazy_aggregates
 
         view = View(self, **config)
         self._views.append(view._name)
@@ -99,6 +99,17 @@ class View(object):
         '''
         return self._view.num_rows()
 
+    def get_stats(self):
+        '''Timing counters recorded when this :class:`~perspective.View` was
+        notified of updates, keyed by stage, i.e. ``notify`` and ``step_end``.
+
+        Returns:
+            :obj:`dict`: a mapping of stage name to a :obj:`dict` of
+                ``count``, ``rows``, ``total_ns``, ``mean_ns``, ``max_ns``,
+                ``p50_ns`` and ``p99_ns``.
+        '''
+        return self._view.get_stats()
+
     def num_columns(self):
         '''The number of aggregated columns in the :class:`~perspective.View`.
         This is affected by the ``column_pivots`` that are applied to the
@@ -31,6 +31,9 @@ class ViewConfig(object):
             filter (:obj:`list` of :obj:`list` of :obj:`str`):  A list of lists,
                 each list containing a column name, a filter comparator, and a
                 value to filter by.
+            lazy_aggregates (:obj:`bool`): Whether aggregates computed from
+                every underlying row, such as ``mean`` or ``median``, are
+                only computed for rows that are shown. Defaults to False.
         '''
         self._config = config
         self._row_pivots = self._config.get('row_pivots', [])
@@ -43,6 +46,7 @@ class ViewConfig(object):
         self._filter_op = self._config.get('filter_op', "and")
         self.row_pivot_depth = self._config.get("row_pivot_depth", None)
         self.column_pivot_depth = self._config.get("column_pivot_depth", None)
+        self.lazy_aggregates = bool(self._config.get("lazy_aggregates", False))
 
     def get_row_pivots(self):
         '''The columns used as
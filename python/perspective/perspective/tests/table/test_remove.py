@@ -28,3 +28,20 @@ class TestRemove(object):
         for i in range(1, 10):
             tbl.remove([i])
         assert tbl.view().to_records() == [{"a": 0, "b": "0"}]
+
+    def test_remove_and_readd_str(self):
+        tbl = Table({"a": str, "b": int}, index="a")
+        tbl.update([{"a": "abc", "b": 1}, {"a": "def", "b": 2}, {"a": "a_longer_primary_key", "b": 3}])
+        view = tbl.view()
+        for i in range(0, 5):
+            tbl.remove(["abc", "a_longer_primary_key"])
+            assert view.num_rows() == 1
+            tbl.update([{"a": "a_longer_primary_key", "b": i}, {"a": "abc", "b": i + 10}])
+            assert view.num_rows() == 3
+        # re-added keys reuse the rows they were removed from
+        assert tbl.size() == 3
+        assert view.to_records() == [
+            {"a": "a_longer_primary_key", "b": 4},
+            {"a": "abc", "b": 14},
+            {"a": "def", "b": 2}
+        ]
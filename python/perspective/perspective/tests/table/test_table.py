@@ -486,6 +486,25 @@ class TestTable(object):
             {"a": 1, "b": 4}
         ]
 
+    def test_table_index_int_becomes_sparse(self):
+        tbl = Table({"a": [0, 1, 2], "b": [1, 2, 3]}, index="a")
+        tbl.update({"a": [-5, 2, 10000000000], "b": [4, 5, 6]})
+        tbl.remove([1])
+        tbl.update({"a": [0, 10000000000], "b": [7, 8]})
+        assert tbl.view().to_dict() == {
+            "a": [-5, 0, 2, 10000000000],
+            "b": [4, 7, 5, 8]
+        }
+
+    def test_table_index_str_remove_and_readd(self):
+        tbl = Table({"a": ["x", "a_longer_primary_key", "z"], "b": [1, 2, 3]}, index="a")
+        tbl.remove(["x", "a_longer_primary_key"])
+        tbl.update({"a": ["a_longer_primary_key", "y"], "b": [4, 5]})
+        assert tbl.view().to_dict() == {
+            "a": ["a_longer_primary_key", "y", "z"],
+            "b": [4, 5, 3]
+        }
+
     # index with None in column
 
     def test_table_index_int_with_none(self):
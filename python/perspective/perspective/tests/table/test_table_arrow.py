@@ -219,6 +219,17 @@ class TestTableArrow(object):
             "a": data[0]
         }
 
+    def test_table_arrow_loads_large_repeated_string_stream(self, util):
+        data = [
+            ["value_{}".format(i % 1000) for i in range(200000)]
+        ]
+        arrow_data = util.make_arrow(["a"], data, types=[pa.string()])
+        tbl = Table(arrow_data)
+        assert tbl.size() == 200000
+        assert tbl.view().to_dict() == {
+            "a": data[0]
+        }
+
     def test_table_arrow_loads_dictionary_stream_int8(self, util):
         data = [
             ([0, 1, 1, None], ["abc", "def"]),
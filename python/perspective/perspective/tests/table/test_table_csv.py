@@ -0,0 +1,122 @@
+# *****************************************************************************
+#
+# Copyright (c) 2019, the Perspective Authors.
+#
+# This file is part of the Perspective library, distributed under the terms of
+# the Apache License 2.0.  The full license can be found in the LICENSE file.
+#
+
+from datetime import date, datetime
+from perspective.table import Table
+
+
+class TestTableCSV(object):
+
+    def test_table_csv_infers_types(self):
+        csv = "a,b,c,d,e\n1,1.5,abc,true,2019-01-01\n2,2.5,def,false,2019-01-02"
+        tbl = Table(csv)
+        assert tbl.size() == 2
+        assert tbl.schema() == {
+            "a": int,
+            "b": float,
+            "c": str,
+            "d": bool,
+            "e": date
+        }
+        assert tbl.view().to_dict() == {
+            "a": [1, 2],
+            "b": [1.5, 2.5],
+            "c": ["abc", "def"],
+            "d": [True, False],
+            "e": [datetime(2019, 1, 1), datetime(2019, 1, 2)]
+        }
+
+    def test_table_csv_datetime(self):
+        csv = "a\n2019-01-01 12:30:00\n2019-01-02 01:00:00"
+        tbl = Table(csv)
+        assert tbl.schema() == {"a": datetime}
+        assert tbl.view().to_dict() == {
+            "a": [datetime(2019, 1, 1, 12, 30), datetime(2019, 1, 2, 1, 0)]
+        }
+
+    def test_table_csv_empty_fields_are_null(self):
+        csv = "a,b\n1,x\n,\n3,z"
+        tbl = Table(csv)
+        assert tbl.view().to_dict() == {
+            "a": [1, None, 3],
+            "b": ["x", None, "z"]
+        }
+
+    def test_table_csv_quoted_fields(self):
+        csv = 'a,b\n"x, y","say ""hi"""\n"line\nbreak",z'
+        tbl = Table(csv)
+        assert tbl.size() == 2
+        assert tbl.view().to_dict() == {
+            "a": ["x, y", "line\nbreak"],
+            "b": ['say "hi"', "z"]
+        }
+
+    def test_table_csv_crlf(self):
+        csv = "a,b\r\n1,2\r\n3,4\r\n"
+        tbl = Table(csv)
+        assert tbl.view().to_dict() == {
+            "a": [1, 3],
+            "b": [2, 4]
+        }
+
+    def test_table_csv_promotes_past_inferred_rows(self):
+        csv = "a\n" + "\n".join(str(i) for i in range(2000)) + "\n2000.5"
+        tbl = Table(csv)
+        assert tbl.schema() == {"a": float}
+        assert tbl.size() == 2001
+        assert tbl.view().to_dict()["a"][-1] == 2000.5
+
+    def test_table_csv_promotes_mixed_column_to_str(self):
+        csv = "a\n" + "\n".join(str(i) for i in range(2000)) + "\nabc"
+        tbl = Table(csv)
+        assert tbl.schema() == {"a": str}
+        result = tbl.view().to_dict()["a"]
+        assert result[0] == "0"
+        assert result[-1] == "abc"
+
+    def test_table_csv_index(self):
+        csv = "a,b\n1,x\n2,y\n1,z"
+        tbl = Table(csv, index="a")
+        assert tbl.view().to_dict() == {
+            "a": [1, 2],
+            "b": ["z", "y"]
+        }
+
+    # update
+
+    def test_update_csv(self):
+        tbl = Table("a,b\n1,x\n2,y")
+        tbl.update("a,b\n3,z")
+        assert tbl.view().to_dict() == {
+            "a": [1, 2, 3],
+            "b": ["x", "y", "z"]
+        }
+
+    def test_update_csv_indexed(self):
+        tbl = Table("a,b\n1,x\n2,y", index="a")
+        tbl.update("a,b\n2,z")
+        assert tbl.view().to_dict() == {
+            "a": [1, 2],
+            "b": ["x", "z"]
+        }
+
+    def test_update_csv_partial_columns(self):
+        tbl = Table("a,b\n1,x\n2,y", index="a")
+        tbl.update("a\n3")
+        assert tbl.view().to_dict() == {
+            "a": [1, 2, 3],
+            "b": ["x", "y", None]
+        }
+
+    def test_update_csv_converts_to_schema(self):
+        tbl = Table({"a": str, "b": float})
+        tbl.update("a,b\n001,1\n002,2")
+        assert tbl.view().to_dict() == {
+            "a": ["001", "002"],
+            "b": [1.0, 2.0]
+        }
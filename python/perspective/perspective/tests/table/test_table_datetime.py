@@ -236,6 +236,65 @@ if os.name != 'nt':
                 datetime(1969, 12, 31, 19, 0)
             ]
 
+        def test_table_should_assume_local_time_datestring(self):
+            table = Table({
+                "a": datetime
+            })
+            table.update({
+                "a": [d.strftime("%Y-%m-%d %H:%M:%S") for d in LOCAL_DATETIMES]
+            })
+            assert table.view().to_dict()["a"] == LOCAL_DATETIMES
+
+        def test_table_should_convert_datestring_with_offset_to_local_time(self):
+            table = Table({
+                "a": datetime
+            })
+            table.update({
+                "a": [
+                    "2019-01-11T05:10:20Z",
+                    "2019-01-11T16:10:20+00:00",
+                    "2019-01-12T09:10:20+09:00"
+                ]
+            })
+            assert table.view().to_dict()["a"] == LOCAL_DATETIMES
+
+        def test_table_datestring_milliseconds(self):
+            table = Table({
+                "a": datetime
+            })
+            table.update({
+                "a": ["2019-01-11 00:10:20.123", "2019-01-11T11:10:20.5"]
+            })
+            assert table.view().to_dict()["a"] == [
+                datetime(2019, 1, 11, 0, 10, 20, 123000),
+                datetime(2019, 1, 11, 11, 10, 20, 500000)
+            ]
+
+        def test_table_datestring_falls_back_to_dateutil(self):
+            table = Table({
+                "a": datetime
+            })
+            table.update({
+                "a": ["2019-01-11 00:10:20", "January 11 2019 11:10:20", None]
+            })
+            assert table.view().to_dict()["a"] == [
+                datetime(2019, 1, 11, 0, 10, 20),
+                datetime(2019, 1, 11, 11, 10, 20),
+                None
+            ]
+
+        def test_table_date_datestring(self):
+            table = Table({
+                "a": date
+            })
+            table.update({
+                "a": ["2019-01-11", "Sat, 12 Jan 2019 23:10:20 GMT"]
+            })
+            assert table.view().to_dict()["a"] == [
+                datetime(2019, 1, 11),
+                datetime(2019, 1, 12)
+            ]
+
     class TestTableDateTimeUTCToLocal(object):
 
         def teardown_method(self):
@@ -317,6 +317,57 @@ class TestUpdate(object):
         }])
         assert view.to_records() == [{"a": 1, "b": 3}, {"a": 2, "b": 3}, {"a": 3, "b": 4}, {"a": 12, "b": 5}]
 
+    def test_update_explicit_index_repeated_partial(self):
+        data = [{"a": 1, "b": 2, "c": "x"}, {"a": 2, "b": 3, "c": "y"}]
+        tbl = Table(data, index="a")
+        view = tbl.view()
+        tbl.update([{"a": 1, "b": 4}])
+        tbl.update([{"a": 1, "c": "z"}])
+        tbl.update([{"a": 1, "b": 5}, {"a": 3, "b": 6}])
+        tbl.update([{"a": 3, "c": "w"}])
+        assert view.to_records() == [
+            {"a": 1, "b": 5, "c": "z"},
+            {"a": 2, "b": 3, "c": "y"},
+            {"a": 3, "b": 6, "c": "w"}
+        ]
+
+    def test_update_explicit_index_str_keeps_arrival_order(self):
+        tbl = Table({"k": str, "g": str, "v": int}, index="k")
+        view = tbl.view(row_pivots=["g"], columns=["v"], aggregates={"v": "last"})
+        tbl.update([{"k": "b", "g": "x", "v": 1}, {"k": "a", "g": "x", "v": 2}])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"]],
+            "v": [2, 2]
+        }
+        tbl.update([{"k": "d", "g": "y", "v": 3}, {"k": "c", "g": "y", "v": 4}])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "v": [4, 2, 4]
+        }
+
+    def test_update_explicit_index_row_pivots_moves_rows(self):
+        tbl = Table({"k": int, "g": str, "h": str, "v": int}, index="k")
+        view = tbl.view(row_pivots=["g", "h"], columns=["v"], aggregates={"v": "sum"})
+        tbl.update([
+            {"k": 1, "g": "x", "h": "a", "v": 1},
+            {"k": 2, "g": "x", "h": "b", "v": 2},
+            {"k": 3, "g": "y", "h": "a", "v": 4}
+        ])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "a"], ["x", "b"], ["y"], ["y", "a"]],
+            "v": [7, 3, 1, 2, 4, 4]
+        }
+        tbl.update([{"k": 2, "g": "y", "h": "a", "v": 8}, {"k": 4, "g": "z", "h": "c", "v": 16}])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "a"], ["y"], ["y", "a"], ["z"], ["z", "c"]],
+            "v": [29, 1, 1, 12, 12, 16, 16]
+        }
+        tbl.update([{"k": 1, "g": "z", "h": "c"}])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["y"], ["y", "a"], ["z"], ["z", "c"]],
+            "v": [29, 12, 12, 17, 17]
+        }
+
     def test_update_explicit_index_multi_append_noindex(self):
         data = [{"a": 1, "b": 2}, {"a": 2, "b": 3}, {"a": 3, "b": 4}]
         tbl = Table(data, index="a")
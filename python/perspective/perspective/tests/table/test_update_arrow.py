@@ -415,6 +415,53 @@ class TestUpdateArrow(object):
             "b": ["x", "y", None, "z", "x", "y", None, "z"]
         }
 
+    def test_update_arrow_updates_append_dictionary_stream_reordered(self, util):
+        tbl = Table(util.make_dictionary_arrow(["a"], [([0, 1, 2], ["x", "y", "z"])]))
+
+        # dictionary order differs from the order `tbl` first saw each value
+        tbl.update(util.make_dictionary_arrow(["a"], [([0, 1, 2, None, 3], ["z", "x", "w", "y"])]))
+
+        assert tbl.size() == 8
+        assert tbl.view().to_dict() == {
+            "a": ["x", "y", "z", "z", "x", "w", None, "y"]
+        }
+
+    def test_update_arrow_updates_append_dictionary_stream_multiple_batches(self):
+        dictionary = pa.array(["x", "y", "z"])
+        data = [
+            ([2, 0, None], ["c", "a", None]),
+            ([1, 1, 0, 2], ["b", "b", "a", "c"])
+        ]
+
+        batches = []
+        for indices, values in data:
+            batches.append(pa.RecordBatch.from_arrays([
+                pa.DictionaryArray.from_arrays(pa.array(indices), dictionary),
+                pa.array(values)
+            ], ["a", "b"]))
+
+        stream = pa.BufferOutputStream()
+        writer = pa.RecordBatchStreamWriter(stream, batches[0].schema)
+        for batch in batches:
+            writer.write_batch(batch)
+        writer.close()
+
+        tbl = Table({
+            "a": str,
+            "b": str
+        })
+        tbl.update({
+            "a": ["y", "w"],
+            "b": ["b", "d"]
+        })
+        tbl.update(stream.getvalue().to_pybytes())
+
+        assert tbl.size() == 9
+        assert tbl.view().to_dict() == {
+            "a": ["y", "w", "z", "x", None, "y", "y", "x", "z"],
+            "b": ["b", "d", "c", "a", None, "b", "b", "a", "c"]
+        }
+
     # indexed
 
     def test_update_arrow_partial_indexed(self, util):
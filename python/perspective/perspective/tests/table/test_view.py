@@ -63,6 +63,52 @@ class TestView(object):
             {"2|a": None, "2|b": None, "4|a": 3, "4|b": 4, "__ROW_PATH__": ["3"]}
         ]
 
+    def test_view_two_filtered_after_update(self):
+        tbl = Table({"a": ["x", "y", "x"], "b": ["p", "p", "q"], "c": [1, 2, 3]})
+        view = tbl.view(row_pivots=["a"], column_pivots=["b"], columns=["c"], filter=[["c", ">", 1]])
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "p|c": [2, None, 2],
+            "q|c": [3, 3, None]
+        }
+        tbl.update({"a": ["x", "y"], "b": ["p", "q"], "c": [5, 1]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "p|c": [7, 5, 2],
+            "q|c": [3, 3, None]
+        }
+
+    def test_view_shared_filters_after_update(self):
+        tbl = Table({"k": [1, 2, 3, 4], "a": ["x", "y", "x", "z"], "c": [1, 2, 3, 4]}, index="k")
+        view = tbl.view(columns=["k", "c"], filter=[["a", "==", "x"], ["c", ">", 1]])
+        pivoted = tbl.view(row_pivots=["a"], columns=["c"], filter=[["a", "==", "x"], ["c", ">", 1]])
+        other = tbl.view(columns=["k"], filter=[["c", ">", 1]])
+        tbl.update({"k": [1, 4, 5], "a": ["x", "x", "w"], "c": [5, 0, 6]})
+        assert view.to_dict() == {"k": [1, 3], "c": [5, 3]}
+        assert pivoted.to_dict() == {"__ROW_PATH__": [[], ["x"]], "c": [8, 8]}
+        assert other.to_dict() == {"k": [1, 2, 3, 5]}
+
+    def test_view_shared_float_filters_differ_past_6_digits(self):
+        tbl = Table({"a": [1234567.0, 1234567.5, 1234568.0]})
+        view = tbl.view(sort=[["a", "asc"]], filter=[["a", ">", 1234567.25]])
+        view2 = tbl.view(sort=[["a", "desc"]], filter=[["a", ">", 1234567.75]])
+        tbl.update({"a": [1234567.625, 1234569.0]})
+        assert view.to_dict() == {"a": [1234567.5, 1234567.625, 1234568.0, 1234569.0]}
+        assert view2.to_dict() == {"a": [1234569.0, 1234568.0]}
+
+    def test_view_unread_columns_after_update(self):
+        tbl = Table({"k": [1, 2, 3], "a": ["x", "y", "x"], "b": ["p", "q", "r"], "c": [1, 2, 3], "d": [1.5, 2.5, 3.5]}, index="k")
+        pivoted = tbl.view(row_pivots=["a"], columns=["c"])
+        tbl.update({"k": [1, 4], "a": ["x", "y"], "b": ["s", "t"], "c": [5, 4], "d": [0.5, 4.5]})
+        assert pivoted.to_dict() == {"__ROW_PATH__": [[], ["x"], ["y"]], "c": [14, 8, 6]}
+        assert tbl.view().to_dict() == {
+            "k": [1, 2, 3, 4],
+            "a": ["x", "y", "x", "y"],
+            "b": ["s", "q", "r", "t"],
+            "c": [5, 2, 3, 4],
+            "d": [0.5, 2.5, 3.5, 4.5]
+        }
+
     def test_view_two_column_only(self):
         data = [{"a": 1, "b": 2}, {"a": 3, "b": 4}]
         tbl = Table(data)
@@ -414,6 +460,67 @@ class TestView(object):
             {"__ROW_PATH__": ["a"], "y": (1 * 200 + (-2) * 100) / (1 - 2)}
         ]
 
+    def test_view_aggregate_approx_after_updates(self):
+        tbl = Table({"id": [1, 2, 3], "a": ["x", "x", "y"], "b": [1, 2, 3]}, index="id")
+        view = tbl.view(
+            aggregates={"a": "approx distinct count", "b": "approx median"},
+            row_pivots=["a"],
+            columns=["a", "b"]
+        )
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "a": [2, 1, 1],
+            "b": [2, 1.5, 3]
+        }
+        tbl.update({"id": [2], "b": [5]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "a": [2, 1, 1],
+            "b": [3, 3, 3]
+        }
+        tbl.update({"id": [4], "a": ["z"], "b": [7]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"], ["z"]],
+            "a": [3, 1, 1, 1],
+            "b": [4, 3, 3, 7]
+        }
+
+    def test_view_aggregate_approx_after_partial_updates(self):
+        tbl = Table({
+            "id": [1, 2, 3, 4],
+            "a": ["x", "x", "x", "y"],
+            "b": [1, 2, 3, 4],
+            "c": ["p", "q", "q", "r"]
+        }, index="id")
+        view = tbl.view(
+            aggregates={"b": "approx median", "c": "approx distinct count"},
+            row_pivots=["a"],
+            columns=["b", "c"]
+        )
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "b": [2.5, 2, 4],
+            "c": [3, 2, 1]
+        }
+        tbl.update({"id": [1], "b": [10]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "b": [3.5, 3, 4],
+            "c": [3, 2, 1]
+        }
+        tbl.update({"id": [2], "c": ["p"]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "b": [3.5, 3, 4],
+            "c": [3, 2, 1]
+        }
+        tbl.update({"id": [3], "c": ["p"]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "b": [3.5, 3, 4],
+            "c": [2, 1, 1]
+        }
+
     # sort
 
     def test_view_sort_int(self):
@@ -751,6 +858,14 @@ class TestView(object):
         view.on_update(cb1, mode="row")
         tbl.update(update_data)
 
+    def test_view_deltas_enabled_zero(self):
+        data = [{"a": 1, "b": 2}, {"a": 3, "b": 4}]
+        tbl = Table(data)
+        view = tbl.view()
+        assert view._view._get_deltas_enabled() is False
+        view.on_update(lambda port_id, delta: None, mode="row")
+        assert view._view._get_deltas_enabled() is True
+
     def test_view_row_delta_one(self, util):
         data = [{"a": 1, "b": 2}, {"a": 3, "b": 4}]
         update_data = {
@@ -838,3 +953,202 @@ class TestView(object):
         tbl = Table(data)
         view = tbl.view(columns=["a"], sort=[["b", "desc"]])
         assert view._num_hidden_cols() == 1
+
+    # stats
+
+    def test_view_get_stats(self):
+        data = [{"a": 1, "b": 2}, {"a": 3, "b": 4}]
+        tbl = Table(data, index="a")
+        view = tbl.view(row_pivots=["a"])
+        tbl.update([{"a": 1, "b": 5}, {"a": 5, "b": 6}])
+        view.to_records()
+        stats = view.get_stats()
+        assert stats["notify"]["count"] >= 1
+        assert stats["notify"]["rows"] >= 2
+        table_stats = tbl.get_stats()
+        # the initial load and the update
+        for stage in ("process", "flatten", "lookup", "update_master"):
+            assert table_stats[stage]["count"] == 2
+        assert table_stats["process_columns"]["count"] == 1
+        assert any(key.endswith(".notify") for key in table_stats)
+
+    def test_view_get_trace(self):
+        tbl = Table([{"a": 1, "b": 2}], index="a")
+        view = tbl.view()
+        tbl.set_trace_enabled(True)
+        tbl.update([{"a": 1, "b": 3}])
+        view.to_records()
+        trace = tbl.get_trace()
+        tbl.set_trace_enabled(False)
+        names = [event["name"] for event in trace["traceEvents"]]
+        assert "flatten" in names
+        assert "notify" in names
+        tbl.reset_stats()
+        assert tbl.get_trace()["traceEvents"] == []
+
+    def test_view_stats_are_per_table(self):
+        tbl = Table([{"a": 1, "b": 2}], index="a")
+        tbl2 = Table([{"a": 1, "b": 2}], index="a")
+        tbl.view()
+        tbl2.view()
+        tbl.set_trace_enabled(True)
+        tbl.update([{"a": 1, "b": 3}])
+        tbl2.update([{"a": 1, "b": 3}])
+        assert len(tbl.get_trace()["traceEvents"]) > 0
+        assert tbl2.get_trace()["traceEvents"] == []
+        tbl.set_trace_enabled(False)
+        tbl2.reset_stats()
+        assert tbl.get_stats()["process"]["count"] == 2
+        assert "process" not in tbl2.get_stats()
+
+    def test_view_get_stats_one_sided_traversal(self):
+        tbl = Table([{"a": 1, "b": "x"}], index="a")
+        view = tbl.view(row_pivots=["b"])
+        tbl.update([{"a": 2, "b": "y"}])
+        view.to_records()
+        table_stats = tbl.get_stats()
+        assert any(key.endswith(".traversal") for key in table_stats)
+
+    # shared trees
+
+    def test_view_shared_tree_different_sort(self):
+        data = {"a": [1, 2, 3, 4], "b": ["x", "y", "x", "y"]}
+        tbl = Table(data)
+        view = tbl.view(row_pivots=["b"], columns=["a"])
+        view2 = tbl.view(row_pivots=["b"], columns=["a"], sort=[["a", "desc"]])
+        tbl.update({"a": [10], "b": ["z"]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"], ["z"]],
+            "a": [20, 4, 6, 10]
+        }
+        assert view2.to_dict() == {
+            "__ROW_PATH__": [[], ["z"], ["y"], ["x"]],
+            "a": [20, 10, 6, 4]
+        }
+        view.delete()
+        tbl.update({"a": [1], "b": ["x"]})
+        assert view2.to_dict() == {
+            "__ROW_PATH__": [[], ["z"], ["y"], ["x"]],
+            "a": [21, 10, 6, 5]
+        }
+
+    def test_view_shared_tree_row_delta(self, util):
+        data = [{"a": 1, "b": 2}, {"a": 3, "b": 4}]
+
+        def cb1(port_id, delta):
+            compare_delta(delta, {
+                "a": [9, 5],
+                "b": [12, 6]
+            })
+
+        tbl = Table(data)
+        view = tbl.view(row_pivots=["a"])
+        view2 = tbl.view(row_pivots=["a"], sort=[["b", "desc"]])
+        view.on_update(cb1, mode="row")
+        tbl.update({"a": [5], "b": [6]})
+        assert view2.to_dict() == {
+            "__ROW_PATH__": [[], ["5"], ["3"], ["1"]],
+            "a": [9, 5, 3, 1],
+            "b": [12, 6, 4, 2]
+        }
+
+    def test_view_shared_flat_sort_different_columns(self):
+        data = {"a": [3, 1, 2], "b": ["x", "y", "z"]}
+        tbl = Table(data, index="b")
+        view = tbl.view(sort=[["a", "asc"]])
+        view2 = tbl.view(columns=["b"], sort=[["a", "asc"]])
+        tbl.update({"a": [0, 4], "b": ["y", "w"]})
+        assert view.to_dict() == {
+            "a": [0, 2, 3, 4],
+            "b": ["y", "z", "x", "w"]
+        }
+        assert view2.to_dict() == {
+            "b": ["y", "z", "x", "w"]
+        }
+        view.delete()
+        tbl.update({"a": [5], "b": ["z"]})
+        assert view2.to_dict() == {
+            "b": ["y", "x", "w", "z"]
+        }
+
+    def test_view_shared_flat_sort_float_filters_differ_past_6_digits(self):
+        tbl = Table({"a": [1234567.0, 1234567.5, 1234568.0]})
+        view = tbl.view(sort=[["a", "asc"]], filter=[["a", ">", 1234567.25]])
+        view2 = tbl.view(sort=[["a", "asc"]], filter=[["a", ">", 1234567.75]])
+        assert view.to_dict() == {"a": [1234567.5, 1234568.0]}
+        assert view2.to_dict() == {"a": [1234568.0]}
+        tbl.update({"a": [1234567.625, 1234569.0]})
+        assert view.to_dict() == {"a": [1234567.5, 1234567.625, 1234568.0, 1234569.0]}
+        assert view2.to_dict() == {"a": [1234568.0, 1234569.0]}
+
+    def test_view_row_pivot_sort_after_updates(self):
+        tbl = Table({"a": ["x", "y", "z"], "b": [1, 2, 3]})
+        view = tbl.view(row_pivots=["a"], columns=["b"], sort=[["b", "desc"]])
+        tbl.update({"a": ["x"], "b": [5]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["z"], ["y"]],
+            "b": [11, 6, 3, 2]
+        }
+        tbl.update({"a": ["w", "y"], "b": [4, 5]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["y"], ["x"], ["w"], ["z"]],
+            "b": [20, 7, 6, 4, 3]
+        }
+
+    def test_view_row_pivot_expand_collapse_after_updates(self):
+        tbl = Table({"a": ["x", "x", "y"], "b": ["p", "q", "p"], "c": [1, 2, 3]})
+        view = tbl.view(row_pivots=["a", "b"], columns=["c"])
+        view.collapse(1)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"], ["y", "p"]],
+            "c": [6, 3, 3, 3]
+        }
+        tbl.update({"a": ["y", "x"], "b": ["a", "r"], "c": [4, 5]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"], ["y", "a"], ["y", "p"]],
+            "c": [15, 8, 7, 4, 3]
+        }
+        view.expand(1)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "p"], ["x", "q"], ["x", "r"], ["y"], ["y", "a"], ["y", "p"]],
+            "c": [15, 8, 1, 2, 5, 7, 4, 3]
+        }
+
+    def test_view_lazy_aggregates_expand_after_updates(self):
+        tbl = Table({"a": ["x", "x", "x", "y"], "b": ["p", "q", "q", "p"], "c": [1.0, 2.0, 6.0, 5.0]})
+        view = tbl.view(row_pivots=["a", "b"], columns=["c"], aggregates={"c": "mean"}, lazy_aggregates=True)
+        view.set_depth(0)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "c": [3.5, 3.0, 5.0]
+        }
+        tbl.update({"a": ["y", "x"], "b": ["q", "q"], "c": [9.0, 4.0]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "c": [4.5, 3.25, 7.0]
+        }
+        view.expand(1)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "p"], ["x", "q"], ["y"]],
+            "c": [4.5, 3.25, 1.0, 4.0, 7.0]
+        }
+        view.expand(4)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "p"], ["x", "q"], ["y"], ["y", "p"], ["y", "q"]],
+            "c": [4.5, 3.25, 1.0, 4.0, 7.0, 5.0, 9.0]
+        }
+
+    def test_view_lazy_aggregates_set_depth_after_updates(self):
+        tbl = Table({"a": ["x", "x", "x", "y"], "b": ["p", "q", "q", "p"], "c": [1.0, 2.0, 6.0, 5.0]})
+        view = tbl.view(row_pivots=["a", "b"], columns=["c"], aggregates={"c": "mean"}, lazy_aggregates=True)
+        view.set_depth(0)
+        tbl.update({"a": ["x", "y"], "b": ["p", "p"], "c": [3.0, 7.0]})
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["y"]],
+            "c": [4.0, 3.0, 6.0]
+        }
+        view.set_depth(1)
+        assert view.to_dict() == {
+            "__ROW_PATH__": [[], ["x"], ["x", "p"], ["x", "q"], ["y"], ["y", "p"]],
+            "c": [4.0, 3.0, 2.0, 4.0, 6.0, 6.0]
+        }